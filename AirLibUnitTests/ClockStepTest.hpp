@@ -0,0 +1,101 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_AirLibUnitTests_ClockStepTest_hpp
+#define msr_AirLibUnitTests_ClockStepTest_hpp
+
+#include <chrono>
+#include <memory>
+#include "TestBase.hpp"
+#include "common/ClockBase.hpp"
+#include "common/ScalableClock.hpp"
+#include "common/SteppableClock.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    /*
+    Checks that nested ClockBase::StepScope give back the enclosing step's time, and reports
+    what the clock reads of a step cost when every object reads the live time compared to
+    reading the step time taken once by the scope.
+    */
+    class ClockStepTest : public TestBase
+    {
+    public:
+        virtual void run() override
+        {
+            testNesting();
+            measureReads();
+        }
+
+        virtual std::string getName() const override
+        {
+            return "ClockStepTest";
+        }
+
+    private:
+        static constexpr TTimeDelta StepSize = 0.004f;
+        static constexpr uint StepCount = 100000;
+        static constexpr uint ReadsPerStep = 32; //roughly one per updatable of a vehicle
+
+        void testNesting()
+        {
+            SteppableClock clock(StepSize);
+            testAssert(clock.stepNanos() == clock.nowNanos(), "outside a step the step time is the current time");
+            {
+                ClockBase::StepScope outer(&clock);
+                const TTimePoint outer_time = clock.stepNanos();
+                testAssert(outer_time == clock.nowNanos(), "the step time is the time the scope stepped to");
+                {
+                    ClockBase::StepScope inner(&clock);
+                    testAssert(clock.stepNanos() == clock.nowNanos() && clock.stepNanos() != outer_time,
+                               "a nested scope should have its own step time");
+                }
+                testAssert(clock.stepNanos() == outer_time, "the enclosing step time should be back after a nested scope");
+            }
+            testAssert(clock.stepNanos() == clock.nowNanos(), "after the outermost scope the step time is the current time again");
+        }
+
+        void measureReads()
+        {
+            ScalableClock clock;
+            //summed so the reads aren't optimized away
+            TTimePoint sum = 0;
+
+            auto start = std::chrono::steady_clock::now();
+            for (uint step = 0; step < StepCount; ++step) {
+                for (uint read = 0; read < ReadsPerStep; ++read)
+                    sum += clock.nowNanos();
+            }
+            const double live_nanos = nanosPerStep(start);
+
+            bool is_step_time = true;
+            start = std::chrono::steady_clock::now();
+            for (uint step = 0; step < StepCount; ++step) {
+                ClockBase::StepScope scope(&clock);
+                const TTimePoint step_time = clock.stepNanos();
+                for (uint read = 0; read < ReadsPerStep; ++read) {
+                    const TTimePoint read_time = clock.stepNanos();
+                    is_step_time &= read_time == step_time;
+                    sum += read_time;
+                }
+            }
+            const double step_nanos = nanosPerStep(start);
+
+            testAssert(is_step_time, "every read of a step should see the step's time");
+            testAssert(sum != 0, "clock reads should be non-zero");
+            report(Utils::stringf("%u clock reads per step: live %.1fns/step, step time %.1fns/step",
+                                  ReadsPerStep, live_nanos, step_nanos));
+        }
+
+        static double nanosPerStep(std::chrono::steady_clock::time_point start)
+        {
+            const auto elapsed = std::chrono::steady_clock::now() - start;
+            return std::chrono::duration<double, std::nano>(elapsed).count() / StepCount;
+        }
+    };
+}
+} //namespace
+#endif
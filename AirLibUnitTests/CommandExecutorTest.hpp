@@ -0,0 +1,195 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_AirLibUnitTests_CommandExecutorTest_hpp
+#define msr_AirLibUnitTests_CommandExecutorTest_hpp
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include "TestBase.hpp"
+#include "common/CommandExecutor.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    /*
+    Checks that started commands return before their steps run and are polled to their outcome,
+    with the executor stepped from a separate thread like the physics tick.
+    */
+    class CommandExecutorTest : public TestBase
+    {
+    public:
+        virtual void run() override
+        {
+            testNotDriven();
+
+            CommandExecutor executor;
+            std::atomic<bool> is_running{ true };
+            std::thread driver([&]() {
+                while (is_running) {
+                    executor.update();
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            });
+            //let the executor see it's being updated
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+            try {
+                testStart(executor);
+                testTimed(executor);
+                testCancel(executor);
+                testError(executor);
+                testWithoutTask(executor);
+            }
+            catch (...) {
+                is_running = false;
+                driver.join();
+                throw;
+            }
+            is_running = false;
+            driver.join();
+        }
+
+        virtual std::string getName() const override
+        {
+            return "CommandExecutorTest";
+        }
+
+    private:
+        static constexpr TTimeDelta Period = 0.001f;
+
+        bool waitDone(CommandExecutor& executor, CommandExecutor::CommandId id)
+        {
+            for (uint i = 0; i < 2000 && !executor.isDone(id); ++i)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            return executor.isDone(id);
+        }
+
+        //the step owns its state, start returns before it ran to the end
+        void testStart(CommandExecutor& executor)
+        {
+            CancelToken token;
+            auto steps = std::make_shared<std::atomic<uint>>(0);
+            auto finished = std::make_shared<std::atomic<bool>>(false);
+
+            const auto id = executor.start([&]() {
+                bool result = executor.runCommand([steps]() {
+                    return ++*steps >= 20 ? CommandExecutor::StepResult::Complete : CommandExecutor::StepResult::Running;
+                },
+                                                  Period,
+                                                  10,
+                                                  token);
+                executor.afterCommand([finished]() { *finished = true; });
+                return result;
+            });
+
+            testAssert(!executor.isDone(id) && *steps < 20, "started command should return before its steps end");
+            testAssert(!*finished, "after command action should wait for the steps");
+            testAssert(waitDone(executor, id), "started command should end");
+            testAssert(*steps == 20, "steps should run until complete");
+            testAssert(*finished, "after command action should run when the steps end");
+            testAssert(executor.getResult(id), "completed command should succeed");
+
+            bool is_unknown = false;
+            try {
+                executor.isDone(id + 1000);
+            }
+            catch (const std::invalid_argument&) {
+                is_unknown = true;
+            }
+            testAssert(is_unknown, "unknown command id should throw");
+        }
+
+        //timed commands succeed when their duration ends
+        void testTimed(CommandExecutor& executor)
+        {
+            CancelToken token;
+            const auto id = executor.start([&]() {
+                return executor.runCommand([]() { return CommandExecutor::StepResult::Running; }, Period, 0.05f, token, true);
+            });
+            testAssert(waitDone(executor, id), "timed command should end");
+            testAssert(executor.getResult(id), "timed command should succeed at the end of its duration");
+
+            //untimed commands fail on timeout
+            const auto timeout_id = executor.start([&]() {
+                return executor.runCommand([]() { return CommandExecutor::StepResult::Running; }, Period, 0.05f, token);
+            });
+            testAssert(waitDone(executor, timeout_id), "command should time out");
+            testAssert(!executor.getResult(timeout_id), "timed out command should fail");
+        }
+
+        //cancel and a new command both end the running one as failed
+        void testCancel(CommandExecutor& executor)
+        {
+            CancelToken token;
+            auto runForever = [&]() {
+                return executor.runCommand([]() { return CommandExecutor::StepResult::Running; }, Period, 100, token);
+            };
+
+            const auto first = executor.start(runForever);
+            const auto second = executor.start(runForever);
+            testAssert(executor.isDone(first) && !executor.getResult(first), "new command should cancel the running one");
+            testAssert(!executor.isDone(second), "new command should be running");
+
+            executor.cancel();
+            testAssert(executor.isDone(second) && !executor.getResult(second), "cancel should end the running command");
+
+            const auto third = executor.start(runForever);
+            token.cancel();
+            testAssert(waitDone(executor, third) && !executor.getResult(third), "cancelled token should end the command");
+        }
+
+        //an exception thrown by a step is rethrown when the outcome is asked for
+        void testError(CommandExecutor& executor)
+        {
+            CancelToken token;
+            const auto id = executor.start([&]() {
+                return executor.runCommand([]() -> CommandExecutor::StepResult { throw std::runtime_error("step failed"); }, Period, 10, token);
+            });
+            testAssert(waitDone(executor, id), "failed command should end");
+
+            bool is_rethrown = false;
+            try {
+                executor.getResult(id);
+            }
+            catch (const std::runtime_error&) {
+                is_rethrown = true;
+            }
+            testAssert(is_rethrown, "step exception should be rethrown from getResult");
+        }
+
+        //commands that return without steps are done right away with their own result
+        void testWithoutTask(CommandExecutor& executor)
+        {
+            const auto succeeded = executor.start([]() { return true; });
+            const auto failed = executor.start([]() { return false; });
+            testAssert(executor.isDone(succeeded) && executor.getResult(succeeded), "command without steps should keep its result");
+            testAssert(executor.isDone(failed) && !executor.getResult(failed), "command without steps should keep its result");
+        }
+
+        //without updates the command is stepped by the starting thread and done when start returns
+        void testNotDriven()
+        {
+            CommandExecutor executor;
+            CancelToken token;
+            uint steps = 0;
+            const auto id = executor.start([&]() {
+                return executor.runCommand([&steps]() {
+                    return ++steps >= 5 ? CommandExecutor::StepResult::Complete : CommandExecutor::StepResult::Running;
+                },
+                                           Period,
+                                           10,
+                                           token);
+            });
+            testAssert(executor.isDone(id) && executor.getResult(id), "command should be done when start returns without updates");
+            testAssert(steps == 5, "steps should run on the starting thread without updates");
+        }
+    };
+}
+} //namespace
+#endif
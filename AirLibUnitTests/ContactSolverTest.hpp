@@ -0,0 +1,223 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_AirLibUnitTests_ContactSolverTest_hpp
+#define msr_AirLibUnitTests_ContactSolverTest_hpp
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+#include "TestBase.hpp"
+#include "common/VectorMath.hpp"
+#include "physics/ContactSolver.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    /*
+    Drops, slides, pushes and rests a box on flat ground with ContactSolver resolving the
+    contacts of its corners, and checks the bounce height follows the restitution, the
+    stopping distance the dynamic friction, that static friction holds a push dynamic friction
+    can't, and that a resting box neither drifts nor jitters.
+    */
+    class ContactSolverTest : public TestBase
+    {
+    public:
+        virtual void run() override
+        {
+            testBounce();
+            testSliding();
+            testStaticFriction();
+            testResting();
+        }
+
+        virtual std::string getName() const override
+        {
+            return "ContactSolverTest";
+        }
+
+    private:
+        static constexpr real_T StepSize = 0.001f;
+        static constexpr real_T Gravity = 9.81f;
+        static constexpr real_T BoxSize = 0.2f;
+        static constexpr real_T BoxMass = 1;
+
+        //box with its center of mass in the middle, ground is z = 0 with z down
+        class Box
+        {
+        public:
+            Vector3r position;
+            Quaternionr orientation = Quaternionr::Identity();
+            Vector3r velocity = Vector3r::Zero();
+            Vector3r angular_velocity = Vector3r::Zero(); //body frame
+            Vector3r force = Vector3r::Zero(); //applied at the center of mass besides gravity
+
+            Box(const ContactMaterial& material, real_T height)
+                : position(0, 0, -BoxSize / 2 - height), material_(material)
+            {
+                inertia_inv_ = Matrix3x3r::Identity() * (6 / (BoxMass * BoxSize * BoxSize));
+            }
+
+            //of the lowest corner above the ground
+            real_T getHeight() const
+            {
+                return -getLowestCorner();
+            }
+
+            void step(uint step_index)
+            {
+                velocity += (Vector3r(0, 0, Gravity) + force / BoxMass) * StepSize;
+
+                //corners on or in the ground, like the engine only when one is approaching
+                contacts_.clear();
+                bool is_approaching = false;
+                for (const Vector3r& corner : getCorners()) {
+                    const Vector3r corner_world = position + VectorMath::rotateVector(corner, orientation, true);
+                    if (corner_world.z() < -kContactDistance)
+                        continue;
+                    ContactSolver::Contact contact;
+                    contact.position = corner;
+                    contact.normal = VectorMath::transformToBodyFrame(Vector3r(0, 0, -1), orientation);
+                    contact.material = material_;
+                    contact.material_id = 0;
+                    contacts_.push_back(contact);
+
+                    const Vector3r corner_velocity = velocity + VectorMath::rotateVector(angular_velocity.cross(corner), orientation, true);
+                    is_approaching |= corner_velocity.z() > 0;
+                }
+
+                if (is_approaching) {
+                    Vector3r velocity_body = VectorMath::transformToBodyFrame(velocity, orientation);
+                    solver_.solve(contacts_, BoxMass, inertia_inv_, static_cast<TTimePoint>(step_index + 1) * 1000000,
+                                  velocity_body, angular_velocity);
+                    velocity = VectorMath::transformToWorldFrame(velocity_body, orientation);
+                }
+
+                position += velocity * StepSize;
+                const Vector3r rotation = angular_velocity * StepSize;
+                if (rotation.norm() > 0)
+                    orientation = (orientation * Quaternionr(AngleAxisr(rotation.norm(), rotation.normalized()))).normalized();
+
+                //push out of the ground
+                const real_T lowest = getLowestCorner();
+                if (lowest > 0)
+                    position.z() -= lowest;
+            }
+
+        private:
+            static constexpr real_T kContactDistance = 1E-4f;
+
+            static std::array<Vector3r, 8> getCorners()
+            {
+                std::array<Vector3r, 8> corners;
+                for (uint i = 0; i < 8; ++i)
+                    corners[i] = Vector3r(i & 1 ? 1.0f : -1.0f, i & 2 ? 1.0f : -1.0f, i & 4 ? 1.0f : -1.0f) * (BoxSize / 2);
+                return corners;
+            }
+
+            //z of the corner furthest down
+            real_T getLowestCorner() const
+            {
+                real_T lowest = -Utils::max<real_T>();
+                for (const Vector3r& corner : getCorners())
+                    lowest = std::max(lowest, (position + VectorMath::rotateVector(corner, orientation, true)).z());
+                return lowest;
+            }
+
+            ContactMaterial material_;
+            Matrix3x3r inertia_inv_;
+            ContactSolver solver_;
+            std::vector<ContactSolver::Contact> contacts_;
+        };
+
+        //dropped from 1m, the box comes back up to restitution squared of that
+        void testBounce()
+        {
+            for (real_T restitution : { 0.3f, 0.6f }) {
+                const real_T drop_height = 1;
+                Box box(ContactMaterial(restitution, 0.5f, 0.5f), drop_height);
+
+                bool has_bounced = false;
+                real_T bounce_height = 0;
+                for (uint step = 0; step < 2000; ++step) {
+                    box.step(step);
+                    if (box.velocity.z() < 0)
+                        has_bounced = true;
+                    if (has_bounced) {
+                        bounce_height = std::max(bounce_height, box.getHeight());
+                        if (box.velocity.z() > 0)
+                            break;
+                    }
+                }
+
+                const real_T expected = restitution * restitution * drop_height;
+                testAssert(has_bounced, Utils::stringf("box should bounce with restitution %.1f", restitution));
+                testAssert(std::abs(bounce_height - expected) < 0.05f * expected,
+                           Utils::stringf("bounce height %.3f with restitution %.1f should be %.3f", bounce_height, restitution, expected));
+                //solving the corners one after the other leaves a little spin, a few mm/s at the corners
+                testAssert(box.angular_velocity.norm() < 0.1f, "a flat drop should hardly make the box spin");
+            }
+        }
+
+        //sliding at 2m/s the box stops after v^2 / (2 dynamic_friction g)
+        void testSliding()
+        {
+            const real_T dynamic_friction = 0.3f, speed = 2;
+            Box box(ContactMaterial(0, 0.6f, dynamic_friction), 0);
+            box.velocity.x() = speed;
+
+            for (uint step = 0; step < 3000; ++step)
+                box.step(step);
+
+            const real_T expected = speed * speed / (2 * dynamic_friction * Gravity);
+            testAssert(box.velocity.norm() < 1E-3f, "sliding box should stop");
+            testAssert(std::abs(box.position.x() - expected) < 0.05f * expected,
+                       Utils::stringf("sliding box stopped after %.3fm, should be %.3fm", box.position.x(), expected));
+        }
+
+        //a push of 0.45 of the weight is held by static friction 0.6, but not by 0.3
+        void testStaticFriction()
+        {
+            for (real_T static_friction : { 0.6f, 0.3f }) {
+                Box box(ContactMaterial(0, static_friction, 0.3f), 0);
+                box.force.x() = 0.45f * BoxMass * Gravity;
+
+                for (uint step = 0; step < 1000; ++step)
+                    box.step(step);
+
+                if (static_friction > 0.45f)
+                    testAssert(std::abs(box.position.x()) < 1E-3f,
+                               Utils::stringf("static friction %.1f should hold the box, it moved %.4fm", static_friction, box.position.x()));
+                else
+                    testAssert(box.position.x() > 0.1f,
+                               Utils::stringf("static friction %.1f should let the box slide, it moved %.4fm", static_friction, box.position.x()));
+            }
+        }
+
+        //five seconds on the ground, the box stays where it was put and still
+        void testResting()
+        {
+            Box box(ContactMaterial(0.5f, 0.5f, 0.5f), 0);
+            const Vector3r start = box.position;
+
+            real_T max_offset = 0;
+            real_T max_speed = 0;
+            for (uint step = 0; step < 5000; ++step) {
+                box.step(step);
+                max_offset = std::max(max_offset, (box.position - start).norm());
+                if (step > 100)
+                    max_speed = std::max(max_speed, box.velocity.norm() + box.angular_velocity.norm() * BoxSize);
+            }
+
+            testAssert(max_offset < 1E-4f, Utils::stringf("resting box should not drift, it moved up to %.6fm", max_offset));
+            testAssert(max_speed < Gravity * StepSize * 1.5f,
+                       Utils::stringf("resting box should not jitter, its corners reached %.4fm/s", max_speed));
+            testAssert(box.orientation.angularDistance(Quaternionr::Identity()) < 1E-4f, "resting box should not tilt");
+        }
+    };
+}
+} //namespace
+#endif
@@ -0,0 +1,210 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_AirLibUnitTests_CpuImageCaptureTest_hpp
+#define msr_AirLibUnitTests_CpuImageCaptureTest_hpp
+
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <thread>
+#include "TestBase.hpp"
+#include "common/CpuImageCapture.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    /*
+    Captures a camera 2m above flat ground looking at a wall 10m ahead with CpuImageCapture and
+    checks pixels of the ground, the wall and the sky against their analytic depth and palette
+    color, then reports the frame rate of a busier scene on one thread and on all of them.
+    */
+    class CpuImageCaptureTest : public TestBase
+    {
+    public:
+        virtual void run() override
+        {
+            testPixels();
+            testViews();
+            measureFrameRate();
+        }
+
+        virtual std::string getName() const override
+        {
+            return "CpuImageCaptureTest";
+        }
+
+    private:
+        typedef ImageCaptureBase::ImageType ImageType;
+        typedef ImageCaptureBase::ImageRequest ImageRequest;
+        typedef ImageCaptureBase::ImageResponse ImageResponse;
+
+        static constexpr uint8_t GroundId = 1;
+        static constexpr uint8_t WallId = 2;
+        static constexpr real_T CameraHeight = 2;
+        static constexpr real_T WallDistance = 10;
+
+        //any palette with distinct colors will do
+        static std::vector<CpuImageCapture::PaletteColor> getPalette()
+        {
+            std::vector<CpuImageCapture::PaletteColor> palette(CpuImageCapture::PaletteSize);
+            for (uint id = 0; id < palette.size(); ++id)
+                palette[id] = CpuImageCapture::PaletteColor{ static_cast<uint8_t>(id), static_cast<uint8_t>(255 - id), static_cast<uint8_t>(id * 7) };
+            return palette;
+        }
+
+        static void addQuad(CpuRasterizer& rasterizer, const Vector3r& a, const Vector3r& b, const Vector3r& c, const Vector3r& d, uint8_t id)
+        {
+            const vector<float> vertices = { a.x(), a.y(), a.z(), b.x(), b.y(), b.z(), c.x(), c.y(), c.z(), d.x(), d.y(), d.z() };
+            rasterizer.addMesh(vertices, { 0, 1, 2, 0, 2, 3 }, id);
+        }
+
+        static void addBox(CpuRasterizer& rasterizer, const Vector3r& center, real_T half_size, uint8_t id)
+        {
+            vector<float> vertices;
+            for (uint i = 0; i < 8; ++i) {
+                vertices.push_back(center.x() + (i & 1 ? half_size : -half_size));
+                vertices.push_back(center.y() + (i & 2 ? half_size : -half_size));
+                vertices.push_back(center.z() + (i & 4 ? half_size : -half_size));
+            }
+            rasterizer.addMesh(vertices, { 0, 1, 3, 0, 3, 2, 4, 5, 7, 4, 7, 6, 0, 1, 5, 0, 5, 4, 2, 3, 7, 2, 7, 6, 0, 2, 6, 0, 6, 4, 1, 3, 7, 1, 7, 5 }, id);
+        }
+
+        //ground is z = 0 out to 100m, the wall is 6m wide and 5m high
+        static std::shared_ptr<CpuRasterizer> createScene()
+        {
+            auto rasterizer = std::make_shared<CpuRasterizer>();
+            addQuad(*rasterizer, Vector3r(-100, -100, 0), Vector3r(100, -100, 0), Vector3r(100, 100, 0), Vector3r(-100, 100, 0), GroundId);
+            addQuad(*rasterizer, Vector3r(WallDistance, -3, 0), Vector3r(WallDistance, 3, 0), Vector3r(WallDistance, 3, -5), Vector3r(WallDistance, -3, -5), WallId);
+            return rasterizer;
+        }
+
+        static CpuRasterizer::Camera getCamera(int width, int height)
+        {
+            CpuRasterizer::Camera camera;
+            camera.pose = Pose(Vector3r(0, 0, -CameraHeight), Quaternionr::Identity());
+            camera.fov_degrees = 90;
+            camera.width = width;
+            camera.height = height;
+            return camera;
+        }
+
+        void testPixels()
+        {
+            const auto palette = getPalette();
+            CpuImageCapture capture(createScene(), palette);
+            capture.setCamera("front", getCamera(64, 48));
+
+            std::vector<ImageResponse> responses;
+            capture.getImages({ ImageRequest("front", ImageType::DepthPlanar, true, false),
+                                ImageRequest("front", ImageType::DepthPerspective, true, false),
+                                ImageRequest("front", ImageType::Segmentation, false, false),
+                                ImageRequest("front", ImageType::DepthPlanar, false, false),
+                                ImageRequest("front", ImageType::Scene, false, false) },
+                              responses);
+            testAssert(responses.size() == 5, "there should be a response per request");
+            for (uint i = 0; i < 4; ++i)
+                testAssert(responses[i].message.empty() && responses[i].width == 64 && responses[i].height == 48,
+                           Utils::stringf("response %u should be a 64x48 image", i));
+            testAssert(!responses[4].message.empty(), "Scene images should be refused");
+
+            //horizontal fov of 90 degrees puts the focal length at half the width
+            const float focal = 32, cx = 32, cy = 24;
+            const float far_plane = getCamera(64, 48).far_plane;
+            struct Pixel
+            {
+                int u, v;
+                float depth;
+                uint8_t id;
+            };
+            const Pixel pixels[] = {
+                { 32, 20, WallDistance, WallId },
+                { 24, 16, WallDistance, WallId },
+                { 5, 10, far_plane, 0 },
+                { 5, 40, CameraHeight * focal / (40.5f - cy), GroundId },
+                { 32, 40, CameraHeight * focal / (40.5f - cy), GroundId },
+                { 60, 30, CameraHeight * focal / (30.5f - cy), GroundId }
+            };
+
+            for (const Pixel& pixel : pixels) {
+                const size_t index = static_cast<size_t>(pixel.v) * 64 + pixel.u;
+                const float planar = responses[0].image_data_float[index];
+                testAssert(std::abs(planar - pixel.depth) < 1E-3f * pixel.depth,
+                           Utils::stringf("planar depth at (%d, %d) is %f, should be %f", pixel.u, pixel.v, planar, pixel.depth));
+
+                const float du = (pixel.u + 0.5f - cx) / focal, dv = (pixel.v + 0.5f - cy) / focal;
+                const float perspective = pixel.depth >= far_plane ? far_plane : pixel.depth * std::sqrt(1 + du * du + dv * dv);
+                testAssert(std::abs(responses[1].image_data_float[index] - perspective) < 1E-3f * perspective,
+                           Utils::stringf("perspective depth at (%d, %d) is %f, should be %f", pixel.u, pixel.v,
+                                          responses[1].image_data_float[index], perspective));
+
+                //BGR like uncompressed Unreal captures
+                const uint8_t* color = &responses[2].image_data_uint8[3 * index];
+                testAssert(color[0] == palette[pixel.id][2] && color[1] == palette[pixel.id][1] && color[2] == palette[pixel.id][0],
+                           Utils::stringf("segmentation color at (%d, %d) should be the color of id %u", pixel.u, pixel.v, pixel.id));
+
+                const uint8_t byte_depth = responses[3].image_data_uint8[index];
+                testAssert(byte_depth == static_cast<uint8_t>(std::min(pixel.depth, 255.0f)),
+                           Utils::stringf("byte depth at (%d, %d) is %u", pixel.u, pixel.v, byte_depth));
+            }
+        }
+
+        //image types of a camera can have their own resolution, like in the capture settings
+        void testViews()
+        {
+            CpuImageCapture capture(createScene(), getPalette());
+            capture.setCamera("front", getCamera(64, 48));
+            capture.setCamera("front", ImageType::Segmentation, getCamera(32, 24));
+            capture.setCameraPose("front", Pose(Vector3r(5, 0, -CameraHeight), Quaternionr::Identity()));
+
+            std::vector<ImageResponse> responses;
+            capture.getImages({ ImageRequest("front", ImageType::DepthPlanar, true, false),
+                                ImageRequest("front", ImageType::Segmentation, false, false),
+                                ImageRequest("back", ImageType::DepthPlanar, true, false) },
+                              responses);
+
+            testAssert(responses[0].width == 64 && responses[0].image_data_float.size() == 64 * 48, "depth should be 64x48");
+            testAssert(responses[1].width == 32 && responses[1].image_data_uint8.size() == 32 * 24 * 3, "segmentation should be 32x24");
+            const float depth = responses[0].image_data_float[20 * 64 + 32];
+            testAssert(std::abs(depth - (WallDistance - 5)) < 1E-3f,
+                       Utils::stringf("moved camera should see the wall at %f, not %f", WallDistance - 5, depth));
+            testAssert(!responses[2].message.empty(), "a camera that isn't set up should get a message");
+        }
+
+        //5000 boxes over the ground, 60k triangles
+        void measureFrameRate()
+        {
+            const uint hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+            std::string results;
+            for (uint thread_count : { 1u, hardware_threads }) {
+                auto rasterizer = std::make_shared<CpuRasterizer>(thread_count);
+                std::mt19937 random(42);
+                std::uniform_real_distribution<float> position(-50, 50);
+                addQuad(*rasterizer, Vector3r(-100, -100, 0), Vector3r(100, -100, 0), Vector3r(100, 100, 0), Vector3r(-100, 100, 0), GroundId);
+                for (uint i = 0; i < 5000; ++i)
+                    addBox(*rasterizer, Vector3r(position(random), position(random), -0.5f), 0.5f, WallId);
+
+                CpuImageCapture capture(rasterizer, getPalette());
+                capture.setCamera("front", getCamera(640, 480));
+                std::vector<ImageResponse> responses;
+                const std::vector<ImageRequest> requests = { ImageRequest("front", ImageType::DepthPlanar, true, false),
+                                                             ImageRequest("front", ImageType::Segmentation, false, false) };
+
+                const uint frame_count = 10;
+                const auto start = std::chrono::steady_clock::now();
+                for (uint frame = 0; frame < frame_count; ++frame)
+                    capture.getImages(requests, responses);
+                const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+                testAssert(responses.size() == 2 && responses[0].message.empty(), "benchmark frames should be captured");
+                results += Utils::stringf(" %u thread(s) %.1f fps", thread_count, frame_count / seconds);
+            }
+            report("depth and segmentation of 60k triangles at 640x480:" + results);
+        }
+    };
+}
+} //namespace
+#endif
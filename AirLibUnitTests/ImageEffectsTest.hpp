@@ -0,0 +1,228 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_AirLibUnitTests_ImageEffectsTest_hpp
+#define msr_AirLibUnitTests_ImageEffectsTest_hpp
+
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <thread>
+#include "TestBase.hpp"
+#include "common/CpuImageCapture.hpp"
+#include "common/ImageEffects.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    /*
+    Captures a striped wall with CpuImageCapture with and without camera effects and checks
+    distorted pixels come from where Brown-Conrady puts them in the clean image, that noise
+    only touches the image types it is enabled for and never float depth, then reports the
+    throughput of ImageEffects on one thread and on all of them.
+    */
+    class ImageEffectsTest : public TestBase
+    {
+    public:
+        virtual void run() override
+        {
+            testDistortion();
+            testNoise();
+            measureThroughput();
+        }
+
+        virtual std::string getName() const override
+        {
+            return "ImageEffectsTest";
+        }
+
+    private:
+        typedef ImageCaptureBase::ImageType ImageType;
+        typedef ImageCaptureBase::ImageRequest ImageRequest;
+        typedef ImageCaptureBase::ImageResponse ImageResponse;
+        typedef AirSimSettings::NoiseSetting NoiseSetting;
+
+        static constexpr int Width = 64;
+        static constexpr int Height = 48;
+        static constexpr float K1 = 0.2f;
+
+        //vertical stripes 1m wide with ids 1 to 20 on a wall 10m ahead, far enough apart in depth
+        //from the ground in front so ids and depth both change across the image
+        static std::shared_ptr<CpuRasterizer> createScene()
+        {
+            auto rasterizer = std::make_shared<CpuRasterizer>(1);
+            for (int stripe = 0; stripe < 20; ++stripe) {
+                const float y0 = stripe - 10.0f, y1 = y0 + 1;
+                rasterizer->addMesh({ 10, y0, 0, 10, y1, 0, 10, y1, -8, 10, y0, -8 }, { 0, 1, 2, 0, 2, 3 }, static_cast<uint8_t>(stripe + 1));
+            }
+            rasterizer->addMesh({ -100, -100, 0, 100, -100, 0, 100, 100, 0, -100, 100, 0 }, { 0, 1, 2, 0, 2, 3 }, 100);
+            return rasterizer;
+        }
+
+        static std::vector<CpuImageCapture::PaletteColor> getPalette()
+        {
+            std::vector<CpuImageCapture::PaletteColor> palette(CpuImageCapture::PaletteSize);
+            for (uint id = 0; id < palette.size(); ++id)
+                palette[id] = CpuImageCapture::PaletteColor{ static_cast<uint8_t>(id * 11), static_cast<uint8_t>(255 - id), static_cast<uint8_t>(id * 5) };
+            return palette;
+        }
+
+        static std::unique_ptr<CpuImageCapture> createCapture()
+        {
+            std::unique_ptr<CpuImageCapture> capture(new CpuImageCapture(createScene(), getPalette(), 1));
+            CpuRasterizer::Camera camera;
+            camera.pose = Pose(Vector3r(0, 0, -2), Quaternionr::Identity());
+            camera.width = Width;
+            camera.height = Height;
+            capture->setCamera("front", camera);
+            return capture;
+        }
+
+        static std::vector<ImageResponse> getImages(const CpuImageCapture& capture)
+        {
+            std::vector<ImageResponse> responses;
+            capture.getImages({ ImageRequest("front", ImageType::Segmentation, false, false),
+                                ImageRequest("front", ImageType::DepthPlanar, true, false),
+                                ImageRequest("front", ImageType::DepthPlanar, false, false) },
+                              responses);
+            return responses;
+        }
+
+        static NoiseSetting getNoise(int image_type, bool enabled)
+        {
+            NoiseSetting noise;
+            noise.ImageType = image_type;
+            noise.Enabled = enabled;
+            noise.RandContrib = 1;
+            noise.HorzWaveContrib = 0;
+            noise.HorzNoiseLinesContrib = 0;
+            noise.HorzDistortionContrib = 0;
+            return noise;
+        }
+
+        //output pixels look up the clean image at the undistorted position of their center
+        void testDistortion()
+        {
+            const auto clean = getImages(*createCapture());
+
+            auto capture = createCapture();
+            ImageEffects::DistortionParams distortion;
+            distortion.K1 = K1;
+            capture->setCameraEffects("front", {}, distortion);
+            const auto distorted = getImages(*capture);
+
+            //90 degree fov puts the focal length at half the width
+            const float focal = Width / 2.0f, cx = Width / 2.0f, cy = Height / 2.0f;
+            uint checked = 0;
+            for (int v = 0; v < Height; ++v) {
+                for (int u = 0; u < Width; ++u) {
+                    //invert r (1 + K1 r^2) by Newton's method on the radius
+                    const float dx = (u + 0.5f - cx) / focal, dy = (v + 0.5f - cy) / focal;
+                    const float distorted_radius = std::sqrt(dx * dx + dy * dy);
+                    float radius = distorted_radius;
+                    for (int i = 0; i < 20; ++i)
+                        radius -= (radius * (1 + K1 * radius * radius) - distorted_radius) / (1 + 3 * K1 * radius * radius);
+                    const float scale = distorted_radius > 0 ? radius / distorted_radius : 1;
+                    const float sx = dx * scale * focal + cx - 0.5f, sy = dy * scale * focal + cy - 0.5f;
+
+                    //pixels whose source is right between two pixels could round either way
+                    if (std::abs(sx - std::floor(sx) - 0.5f) < 0.05f || std::abs(sy - std::floor(sy) - 0.5f) < 0.05f)
+                        continue;
+                    ++checked;
+
+                    const size_t index = static_cast<size_t>(v) * Width + u;
+                    const bool inside = sx > -0.5f && sx < Width - 0.5f && sy > -0.5f && sy < Height - 0.5f;
+                    const size_t source = inside ? static_cast<size_t>(std::lround(sy)) * Width + std::lround(sx) : 0;
+                    for (uint c = 0; c < 3; ++c) {
+                        const uint8_t expected = inside ? clean[0].image_data_uint8[3 * source + c] : 0;
+                        testAssert(distorted[0].image_data_uint8[3 * index + c] == expected,
+                                   Utils::stringf("distorted segmentation at (%d, %d) should come from (%.2f, %.2f)", u, v, sx, sy));
+                    }
+                    const float expected_depth = inside ? clean[1].image_data_float[source] : 0;
+                    testAssert(distorted[1].image_data_float[index] == expected_depth,
+                               Utils::stringf("distorted depth at (%d, %d) is %f, should be %f", u, v, distorted[1].image_data_float[index], expected_depth));
+                }
+            }
+            testAssert(checked > Width * Height / 2, "most pixels should have an unambiguous source");
+
+            const size_t center = static_cast<size_t>(Height / 2) * Width + Width / 2;
+            testAssert(distorted[1].image_data_float[center] == clean[1].image_data_float[center], "the center should not move");
+        }
+
+        void testNoise()
+        {
+            const auto clean = getImages(*createCapture());
+
+            //noise on depth only, which leaves segmentation alone and float depth too
+            auto capture = createCapture();
+            const int depth_type = static_cast<int>(ImageType::DepthPlanar);
+            const int segmentation_type = static_cast<int>(ImageType::Segmentation);
+            capture->setCameraEffects("front", { { depth_type, getNoise(depth_type, true) }, { segmentation_type, getNoise(segmentation_type, false) } },
+                                      ImageEffects::DistortionParams());
+            const auto noisy = getImages(*capture);
+
+            testAssert(noisy[0].image_data_uint8 == clean[0].image_data_uint8, "segmentation without noise enabled should be unchanged");
+            testAssert(noisy[1].image_data_float == clean[1].image_data_float, "float depth should never get noise");
+
+            //with RandContrib of 1 the pixels are the noise, whatever they were
+            uint changed = 0;
+            for (size_t i = 0; i < clean[2].image_data_uint8.size(); ++i)
+                changed += noisy[2].image_data_uint8[i] != clean[2].image_data_uint8[i];
+            testAssert(changed > clean[2].image_data_uint8.size() / 2,
+                       Utils::stringf("noise should change most depth pixels, it changed %u", changed));
+
+            //cameras without any effects get the clean image again
+            capture->setCameraEffects("front", {}, ImageEffects::DistortionParams());
+            const auto cleared = getImages(*capture);
+            testAssert(cleared[2].image_data_uint8 == clean[2].image_data_uint8, "clearing effects should give the clean image");
+        }
+
+        //distortion and noise on 1280x720 color
+        void measureThroughput()
+        {
+            ImageResponse source;
+            source.image_type = ImageType::Scene;
+            source.width = 1280;
+            source.height = 720;
+            source.compress = false;
+            source.time_stamp = 1000000000;
+            source.image_data_uint8.resize(static_cast<size_t>(source.width) * source.height * 3);
+            for (size_t i = 0; i < source.image_data_uint8.size(); ++i)
+                source.image_data_uint8[i] = static_cast<uint8_t>(i * 31);
+
+            NoiseSetting noise;
+            noise.Enabled = true;
+            ImageEffects::DistortionParams distortion;
+            distortion.K1 = K1;
+            distortion.P1 = 0.01f;
+
+            const uint hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+            std::string results;
+            for (uint thread_count : { 1u, hardware_threads }) {
+                ImageEffects effects(thread_count);
+                effects.setNoiseSettings({ { static_cast<int>(ImageType::Scene), noise } });
+                effects.setDistortion(distortion);
+
+                //first one builds the remap table
+                ImageResponse response = source;
+                effects.apply(response);
+
+                const uint image_count = 20;
+                const auto start = std::chrono::steady_clock::now();
+                for (uint i = 0; i < image_count; ++i) {
+                    response.image_data_uint8 = source.image_data_uint8;
+                    effects.apply(response);
+                }
+                const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+                testAssert(response.message.empty(), "effects should apply to the benchmark image");
+                results += Utils::stringf(" %u thread(s) %.2fms", thread_count, 1000 * seconds / image_count);
+            }
+            report("distortion and noise at 1280x720:" + results);
+        }
+    };
+}
+} //namespace
+#endif
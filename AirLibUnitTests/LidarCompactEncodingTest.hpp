@@ -0,0 +1,98 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_AirLibUnitTests_LidarCompactEncodingTest_hpp
+#define msr_AirLibUnitTests_LidarCompactEncodingTest_hpp
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include "TestBase.hpp"
+#include "sensors/lidar/LidarCompactEncoding.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    /*
+    Encodes random point clouds with LidarCompactEncoding and decodes them again, checking
+    every coordinate is within half a quantization step of where it was, segmentation and
+    the scan's time and pose come back exactly, and each point takes 6 bytes.
+    */
+    class LidarCompactEncodingTest : public TestBase
+    {
+    public:
+        virtual void run() override
+        {
+            std::mt19937 random(7);
+
+            //a scan around the vehicle, one far from the origin, and a flat one with no z extent
+            testRoundTrip(random, 20000, Vector3r(0, 0, 0), Vector3r(100, 100, 20), false);
+            testRoundTrip(random, 5000, Vector3r(3000, -1200, -150), Vector3r(40, 60, 10), false);
+            testRoundTrip(random, 5000, Vector3r(10, 10, -2), Vector3r(50, 50, 0), false);
+            testRoundTrip(random, 1, Vector3r(5, -5, 1), Vector3r(0, 0, 0), true);
+            testRoundTrip(random, 0, Vector3r(0, 0, 0), Vector3r(0, 0, 0), true);
+        }
+
+        virtual std::string getName() const override
+        {
+            return "LidarCompactEncodingTest";
+        }
+
+    private:
+        void testRoundTrip(std::mt19937& random, size_t point_count, const Vector3r& center, const Vector3r& half_extent,
+                           bool is_degenerate)
+        {
+            LidarData data;
+            data.time_stamp = 123456789;
+            data.pose = Pose(Vector3r(1, 2, -3), VectorMath::toQuaternion(0.1f, 0.2f, 0.3f));
+
+            std::uniform_real_distribution<float> unit(-1, 1);
+            std::uniform_int_distribution<int> run_length(1, 40);
+            std::uniform_int_distribution<int> object(0, 255);
+            for (size_t i = 0; i < point_count; ++i) {
+                for (uint axis = 0; axis < 3; ++axis)
+                    data.point_cloud.push_back(center[axis] + half_extent[axis] * unit(random));
+            }
+            while (data.segmentation.size() < point_count)
+                data.segmentation.insert(data.segmentation.end(), std::min<size_t>(run_length(random), point_count - data.segmentation.size()), object(random));
+
+            LidarCompactData compact;
+            LidarCompactEncoding::encode(data, compact);
+            LidarData decoded;
+            LidarCompactEncoding::decode(compact, decoded);
+
+            const std::string name = Utils::stringf("%u points around (%.0f, %.0f, %.0f)", static_cast<uint>(point_count),
+                                                    center.x(), center.y(), center.z());
+            testAssert(compact.points.size() == 6 * point_count, name + ": each point should take 6 bytes");
+            testAssert(decoded.point_cloud.size() == data.point_cloud.size(), name + ": point count should be kept");
+            testAssert(decoded.segmentation == data.segmentation, name + ": segmentation should be kept");
+            testAssert(decoded.time_stamp == data.time_stamp, name + ": time stamp should be kept");
+            testAssert(decoded.pose.position == data.pose.position && decoded.pose.orientation.coeffs() == data.pose.orientation.coeffs(),
+                       name + ": pose should be kept");
+
+            //half a step per axis, plus float rounding of coordinates the size of the center
+            real_T max_error[3] = { 0, 0, 0 };
+            real_T tolerance[3];
+            for (uint axis = 0; axis < 3; ++axis)
+                tolerance[axis] = compact.scale[axis] / 2 + 4 * std::numeric_limits<real_T>::epsilon() * (std::abs(center[axis]) + half_extent[axis]);
+            for (size_t i = 0; i < data.point_cloud.size(); ++i) {
+                const uint axis = i % 3;
+                max_error[axis] = std::max(max_error[axis], std::abs(decoded.point_cloud[i] - data.point_cloud[i]));
+            }
+            for (uint axis = 0; axis < 3; ++axis) {
+                testAssert(max_error[axis] <= tolerance[axis],
+                           Utils::stringf("%s: axis %u error %g should be at most %g", name.c_str(), axis, max_error[axis], tolerance[axis]));
+                //the scale covers the extent actually seen, at most the range points were drawn from
+                testAssert(compact.scale[axis] <= half_extent[axis] / 32767 * 1.0001f,
+                           Utils::stringf("%s: axis %u scale %g is coarser than the extent needs", name.c_str(), axis, compact.scale[axis]));
+            }
+            if (is_degenerate)
+                testAssert(compact.scale == Vector3r::Zero(), name + ": a cloud without extent should have no scale");
+        }
+    };
+}
+} //namespace
+#endif
@@ -0,0 +1,176 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_AirLibUnitTests_LockStepTest_hpp
+#define msr_AirLibUnitTests_LockStepTest_hpp
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include "TestBase.hpp"
+#include "physics/LockStepCoordinator.hpp"
+#include "physics/LoopbackAutopilot.hpp"
+#include "physics/PhysicsWorld.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    class LockStepTest : public TestBase
+    {
+    public:
+        virtual void run() override
+        {
+            testGate();
+            testQuorum();
+            testDeadline();
+            testDetach();
+            testLoopback();
+        }
+
+        virtual std::string getName() const override
+        {
+            return "LockStepTest";
+        }
+
+    private:
+        //the world is held while any participant is outstanding and released by the last reply
+        void testGate()
+        {
+            common_utils::ScheduledExecutor executor;
+            LockStepCoordinator coordinator(&executor);
+            auto a = coordinator.addParticipant("a");
+            auto b = coordinator.addParticipant("b");
+
+            coordinator.beginWait(a);
+            coordinator.beginWait(b);
+            testAssert(executor.isPaused(), "gate should pause while both are waiting");
+            testAssert(coordinator.getWaitingCount() == 2, "both participants should be waiting");
+
+            testAssert(coordinator.endWait(a) >= 0, "reply from a waiting participant should have a latency");
+            testAssert(executor.isPaused(), "gate should hold until the last reply");
+            testAssert(coordinator.endWait(a) < 0, "second reply to the same frame should be ignored");
+
+            coordinator.endWait(b);
+            testAssert(!executor.isPaused(), "gate should release after all replies");
+
+            //a participant leaving while waiting must not hold the world
+            coordinator.beginWait(a);
+            testAssert(executor.isPaused(), "gate should pause for a waiting participant");
+            coordinator.removeParticipant(a);
+            testAssert(!executor.isPaused(), "removing the waiting participant should release the gate");
+            testAssert(coordinator.getStats().size() == 1, "removed participant should not be reported");
+
+            //slots of removed participants are reused
+            testAssert(coordinator.addParticipant("c") == a, "new participant should take the free slot");
+        }
+
+        void testQuorum()
+        {
+            common_utils::ScheduledExecutor executor;
+            LockStepCoordinator coordinator(&executor);
+            auto a = coordinator.addParticipant("a");
+            auto b = coordinator.addParticipant("b");
+
+            coordinator.setQuorum(0.5f);
+            coordinator.beginWait(a);
+            testAssert(!executor.isPaused(), "half the participants may be outstanding at quorum 0.5");
+            coordinator.beginWait(b);
+            testAssert(executor.isPaused(), "gate should pause when less than the quorum replied");
+            coordinator.endWait(b);
+            testAssert(!executor.isPaused(), "gate should release once the quorum replied");
+            coordinator.endWait(a);
+
+            //quorum is in (0, 1], at or below 0 one reply is still needed
+            coordinator.setQuorum(0);
+            testAssert(coordinator.getQuorum() > 0, "quorum should stay above 0");
+            coordinator.beginWait(a);
+            coordinator.beginWait(b);
+            testAssert(executor.isPaused(), "gate should wait for at least one reply");
+            coordinator.endWait(a);
+            testAssert(!executor.isPaused(), "one reply should be enough at the lowest quorum");
+            coordinator.endWait(b);
+
+            coordinator.setQuorum(2);
+            testAssert(coordinator.getQuorum() == 1, "quorum should be clipped to 1");
+        }
+
+        //a stalled participant only holds the world until its deadline
+        void testDeadline()
+        {
+            common_utils::ScheduledExecutor executor;
+            LockStepCoordinator coordinator(&executor);
+            auto stalled = coordinator.addParticipant("stalled", 0.01f);
+
+            coordinator.beginWait(stalled);
+            testAssert(!coordinator.hasExpired(stalled), "deadline should not have passed yet");
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            testAssert(coordinator.hasExpired(stalled), "deadline should have passed");
+
+            coordinator.cancelWait(stalled, true);
+            testAssert(!executor.isPaused(), "cancelled wait should release the gate");
+            testAssert(coordinator.getStats()[0].latency.timeouts == 1, "timeout should be counted");
+            testAssert(coordinator.getStats()[0].latency.count == 0, "timeout should not count as a reply");
+        }
+
+        //participants may outlive the world, the coordinator then stops pausing anything
+        void testDetach()
+        {
+            common_utils::ScheduledExecutor executor;
+            LockStepCoordinator coordinator(&executor);
+            auto a = coordinator.addParticipant("a");
+
+            coordinator.detachExecutor();
+            coordinator.beginWait(a);
+            testAssert(!executor.isPaused(), "detached coordinator should not pause");
+            coordinator.endWait(a);
+            coordinator.removeParticipant(a);
+        }
+
+        //one responsive and one silent autopilot in a running world: the silent one must not
+        //stop the world for more than its deadline at a time
+        void testLoopback()
+        {
+            constexpr TTimeDelta deadline = 0.02f;
+            std::unique_ptr<LoopbackAutopilot> fast(new LoopbackAutopilot("fast", 1E-4f));
+            std::unique_ptr<LoopbackAutopilot> silent(new LoopbackAutopilot("silent", 1E-4f, 0, 1, deadline));
+
+            std::unique_ptr<PhysicsWorld> world(new PhysicsWorld(std::unique_ptr<PhysicsEngineBase>(new PhysicsEngineBase()),
+                                                                 { fast.get(), silent.get() }));
+            std::shared_ptr<LockStepCoordinator> coordinator = world->getLockStepCoordinator();
+            testAssert(coordinator->getStats().size() == 2, "both autopilots should register on reset");
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+            world->pause(true);
+            world->waitForPause();
+
+            testAssert(fast->getRepliesSent() > 0, "fast autopilot should have replied");
+            testAssert(silent->getRepliesSent() == 0, "silent autopilot should never reply");
+            testAssert(silent->getFramesSent() > 1, "world should have moved on after the silent deadline");
+
+            uint64_t timeouts = 0, replies = 0;
+            for (const auto& stats : coordinator->getStats()) {
+                if (stats.name == "silent")
+                    timeouts = stats.latency.timeouts;
+                else
+                    replies = stats.latency.count;
+            }
+            testAssert(timeouts > 0, "silent autopilot should have timed out");
+            testAssert(replies > 0, "fast autopilot replies should be recorded");
+            report(Utils::stringf("fast frames=%llu replies=%llu, silent frames=%llu timeouts=%llu",
+                                  static_cast<unsigned long long>(fast->getFramesSent()),
+                                  static_cast<unsigned long long>(fast->getRepliesSent()),
+                                  static_cast<unsigned long long>(silent->getFramesSent()),
+                                  static_cast<unsigned long long>(timeouts)));
+
+            //the world goes first like at the end of play, autopilots then leave the detached coordinator
+            world.reset();
+            fast.reset();
+            silent.reset();
+            testAssert(coordinator->getStats().empty(), "autopilots should leave the coordinator when destroyed");
+        }
+    };
+}
+} //namespace
+#endif
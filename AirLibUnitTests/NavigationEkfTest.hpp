@@ -0,0 +1,148 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_AirLibUnitTests_NavigationEkfTest_hpp
+#define msr_AirLibUnitTests_NavigationEkfTest_hpp
+
+#include <cmath>
+#include <memory>
+#include "TestBase.hpp"
+#include "common/ClockFactory.hpp"
+#include "common/ScalableClock.hpp"
+#include "common/SteppableClock.hpp"
+#include "physics/Environment.hpp"
+#include "sensors/NavigationEkf.hpp"
+#include "sensors/SensorCollection.hpp"
+#include "sensors/barometer/BarometerSimple.hpp"
+#include "sensors/gps/GpsSimple.hpp"
+#include "sensors/imu/ImuSimple.hpp"
+#include "sensors/magnetometer/MagnetometerSimple.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    /*
+    Runs NavigationEkf on the simulated IMU, GPS, barometer and magnetometer of a body flying
+    circles while climbing, descending and rocking, and checks the filter is consistent: the
+    average NEES of samples far enough apart to be independent must be within the two-sided 95%
+    chi-square bounds for kNeesDof degrees of freedom per sample.
+    */
+    class NavigationEkfTest : public TestBase
+    {
+    public:
+        virtual void run() override
+        {
+            ClockFactory::get(std::make_shared<SteppableClock>(StepSize));
+
+            const GeoPoint home(47.641468, -122.140165, 122);
+            Kinematics::State state = getState(0);
+            Environment environment(Environment::State(state.pose.position, home));
+
+            ImuSimple imu;
+            GpsSimple gps;
+            BarometerSimple baro;
+            MagnetometerSimple mag;
+            SensorCollection sensors;
+            sensors.insert(&imu, SensorBase::SensorType::Imu);
+            sensors.insert(&gps, SensorBase::SensorType::Gps);
+            sensors.insert(&baro, SensorBase::SensorType::Barometer);
+            sensors.insert(&mag, SensorBase::SensorType::Magnetometer);
+            sensors.initialize(&state, &environment);
+
+            NavigationEkf ekf(&sensors);
+            environment.reset();
+            sensors.reset();
+            ekf.reset();
+
+            const uint steps_per_sample = static_cast<uint>(SampleInterval / StepSize + 0.5f);
+            const uint warmup_steps = static_cast<uint>(WarmupTime / StepSize + 0.5f);
+            double nees_sum = 0;
+            uint sample_count = 0;
+            real_T max_position_error = 0;
+
+            for (uint step = 1; step <= warmup_steps + SampleCount * steps_per_sample; ++step) {
+                ClockBase::StepScope scope(ClockFactory::get());
+                state = getState(step * StepSize);
+                environment.setPosition(state.pose.position);
+                environment.update();
+                sensors.update();
+                ekf.update(state, home);
+
+                if (step > warmup_steps) {
+                    max_position_error = std::max(max_position_error, (ekf.getKinematics().pose.position - state.pose.position).norm());
+                    if ((step - warmup_steps) % steps_per_sample == 0) {
+                        nees_sum += ekf.getMetrics().last_nees;
+                        ++sample_count;
+                    }
+                }
+            }
+
+            const double mean_nees = nees_sum / sample_count;
+            const double dof = static_cast<double>(NavigationEkf::kNeesDof) * sample_count;
+            const double lower = chiSquareQuantile(dof, -1.959964) / sample_count;
+            const double upper = chiSquareQuantile(dof, 1.959964) / sample_count;
+            report(Utils::stringf("mean NEES %.2f of %u samples, bounds [%.2f, %.2f], max position error %.3fm, %llu gated",
+                                  mean_nees, sample_count, lower, upper, max_position_error,
+                                  static_cast<unsigned long long>(ekf.getMetrics().rejected_count)));
+
+            testAssert(mean_nees >= lower, "the filter is underconfident, its covariance is larger than its errors");
+            testAssert(mean_nees <= upper, "the filter is overconfident, its errors are larger than its covariance");
+
+            ClockFactory::get(std::make_shared<ScalableClock>());
+        }
+
+        virtual std::string getName() const override
+        {
+            return "NavigationEkfTest";
+        }
+
+    private:
+        static constexpr TTimeDelta StepSize = 0.003f;
+        //GPS needs a few seconds for a 3D fix and the filter some more to settle
+        static constexpr TTimeDelta WarmupTime = 30;
+        //errors are correlated over a few seconds, so samples are taken further apart
+        static constexpr TTimeDelta SampleInterval = 5;
+        static constexpr uint SampleCount = 40;
+
+        //circles of radius 20m at 4m/s heading along the velocity, climbing and descending
+        //3m while rolling and pitching by up to 0.15 and 0.1 rad
+        static Kinematics::State getState(double t)
+        {
+            const double radius = 20, w = 0.2, climb = 3, climb_w = 0.25;
+            const double roll_amp = 0.15, roll_w = 0.7, pitch_amp = 0.1, pitch_w = 0.5;
+
+            Kinematics::State state = Kinematics::State::zero();
+            state.pose.position = Vector3r(static_cast<real_T>(radius * std::sin(w * t)),
+                                           static_cast<real_T>(radius * (1 - std::cos(w * t))),
+                                           static_cast<real_T>(-20 - climb * std::sin(climb_w * t)));
+            state.twist.linear = Vector3r(static_cast<real_T>(radius * w * std::cos(w * t)),
+                                          static_cast<real_T>(radius * w * std::sin(w * t)),
+                                          static_cast<real_T>(-climb * climb_w * std::cos(climb_w * t)));
+            state.accelerations.linear = Vector3r(static_cast<real_T>(-radius * w * w * std::sin(w * t)),
+                                                  static_cast<real_T>(radius * w * w * std::cos(w * t)),
+                                                  static_cast<real_T>(climb * climb_w * climb_w * std::sin(climb_w * t)));
+
+            const double roll = roll_amp * std::sin(roll_w * t), roll_rate = roll_amp * roll_w * std::cos(roll_w * t);
+            const double pitch = pitch_amp * std::sin(pitch_w * t), pitch_rate = pitch_amp * pitch_w * std::cos(pitch_w * t);
+            const double yaw = w * t, yaw_rate = w;
+            state.pose.orientation = VectorMath::toQuaternion(static_cast<real_T>(pitch), static_cast<real_T>(roll), static_cast<real_T>(yaw));
+            //body rates from the ZYX Euler angle rates
+            state.twist.angular = Vector3r(static_cast<real_T>(roll_rate - yaw_rate * std::sin(pitch)),
+                                           static_cast<real_T>(pitch_rate * std::cos(roll) + yaw_rate * std::cos(pitch) * std::sin(roll)),
+                                           static_cast<real_T>(-pitch_rate * std::sin(roll) + yaw_rate * std::cos(pitch) * std::cos(roll)));
+            return state;
+        }
+
+        //Wilson-Hilferty approximation of the chi-square quantile at the standard normal quantile z
+        static double chiSquareQuantile(double dof, double z)
+        {
+            const double c = 2 / (9 * dof);
+            const double cube = 1 - c + z * std::sqrt(c);
+            return dof * cube * cube * cube;
+        }
+    };
+}
+} //namespace
+#endif
@@ -0,0 +1,134 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_AirLibUnitTests_PidIntegratorTest_hpp
+#define msr_AirLibUnitTests_PidIntegratorTest_hpp
+
+#include <cmath>
+#include <stdexcept>
+#include "TestBase.hpp"
+//the firmware is compiled in the context the multirotor api sets up, like SimpleFlightApi does
+#include "vehicles/multirotor/api/MultirotorApiBase.hpp"
+#include "vehicles/multirotor/firmwares/simple_flight/firmware/interfaces/IBoardClock.hpp"
+#include "vehicles/multirotor/firmwares/simple_flight/firmware/interfaces/IUpdatable.hpp"
+#include "vehicles/multirotor/firmwares/simple_flight/firmware/PidController.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    /*
+    Runs simple_flight's PID integrators at two step sizes and checks that the integral term
+    and its discount come out the same, and that unsupported Runge-Kutta orders are rejected.
+    */
+    class PidIntegratorTest : public TestBase
+    {
+    public:
+        virtual void run() override
+        {
+            typedef simple_flight::PidConfig<float>::IntegratorType IntegratorType;
+
+            //rectangle rule is first order, so its error grows with the step
+            testIntegral(IntegratorType::Standard, 4, 5E-3f);
+            testIntegral(IntegratorType::RungKutta, 2, 1E-4f);
+            testIntegral(IntegratorType::RungKutta, 4, 1E-4f);
+
+            testDiscount();
+
+            bool rejected = false;
+            try {
+                simple_flight::PidConfig<float> config;
+                config.integrator_type = IntegratorType::RungKutta;
+                config.integrator_order = 3;
+                simple_flight::PidController<float> pid(&clock_, config);
+            }
+            catch (const std::invalid_argument&) {
+                rejected = true;
+            }
+            testAssert(rejected, "Runge-Kutta order 3 should be rejected");
+        }
+
+        virtual std::string getName() const override
+        {
+            return "PidIntegratorTest";
+        }
+
+    private:
+        class TestClock : public simple_flight::IBoardClock
+        {
+        public:
+            virtual uint64_t micros() const override
+            {
+                return millis_ * 1000;
+            }
+            virtual uint64_t millis() const override
+            {
+                return millis_;
+            }
+
+            uint64_t millis_ = 0;
+        };
+
+        //integral term only, of sin(t) over a second
+        float integrate(simple_flight::PidConfig<float>::IntegratorType type, unsigned int order, uint64_t step_millis)
+        {
+            simple_flight::PidConfig<float> config(0, 1, 0, -10, 10);
+            config.integrator_type = type;
+            config.integrator_order = order;
+            simple_flight::PidController<float> pid(&clock_, config);
+
+            clock_.millis_ = 0;
+            pid.reset();
+            while (clock_.millis_ < 1000) {
+                clock_.millis_ += step_millis;
+                pid.setGoal(std::sin(clock_.millis_ / 1000.0f));
+                pid.update();
+            }
+            return pid.getOutput();
+        }
+
+        void testIntegral(simple_flight::PidConfig<float>::IntegratorType type, unsigned int order, float tolerance)
+        {
+            const float fine = integrate(type, order, 1);
+            const float coarse = integrate(type, order, 5);
+            const float expected = 1 - std::cos(1.0f);
+
+            const std::string name = type == simple_flight::PidConfig<float>::IntegratorType::Standard
+                                         ? std::string("standard")
+                                         : Utils::stringf("order %u", order);
+            testAssert(std::abs(fine - coarse) < tolerance,
+                       Utils::stringf("%s integral at 1ms %f and 5ms %f steps should match", name.c_str(), fine, coarse));
+            testAssert(std::abs(fine - expected) < tolerance,
+                       Utils::stringf("%s integral %f should be close to %f", name.c_str(), fine, expected));
+        }
+
+        //with no error the integral term decays by iterm_discount per period whatever the steps are
+        void testDiscount()
+        {
+            simple_flight::PidConfig<float> config(0, 1, 0, -10, 10);
+            config.iterm_discount = 0.99f;
+            const float expected = std::pow(0.99f, 300 / 3.0f);
+
+            //fixed steps, and steps alternating in size so the cached discount has to be redone
+            const uint64_t step_sizes[][2] = { { 1, 1 }, { 5, 5 }, { 1, 2 } };
+            for (const auto& steps : step_sizes) {
+                simple_flight::StdPidIntegrator<float> integrator(config);
+                integrator.set(1);
+                uint64_t elapsed = 0;
+                for (uint i = 0; elapsed < 300; ++i) {
+                    const uint64_t step = steps[i % 2];
+                    integrator.update(step / 1000.0f, 0, elapsed);
+                    elapsed += step;
+                }
+                testAssert(std::abs(integrator.getOutput() - expected) < 1E-4f,
+                           Utils::stringf("discounted integral %f for %llu and %llu ms steps should be %f", integrator.getOutput(),
+                                          static_cast<unsigned long long>(steps[0]), static_cast<unsigned long long>(steps[1]), expected));
+            }
+        }
+
+        TestClock clock_;
+    };
+}
+} //namespace
+#endif
@@ -0,0 +1,135 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_AirLibUnitTests_RenderStateTest_hpp
+#define msr_AirLibUnitTests_RenderStateTest_hpp
+
+#include <memory>
+#include "TestBase.hpp"
+#include "common/ClockFactory.hpp"
+#include "common/ScalableClock.hpp"
+#include "common/SteppableClock.hpp"
+#include "physics/FastPhysicsEngine.hpp"
+#include "physics/World.hpp"
+#include "vehicles/multirotor/MultiRotorPhysicsBody.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    /*
+    Steps a falling multirotor in a world and checks that the render state published in each step
+    is stamped with that step's time and holds the pose the step ended with.
+    */
+    class RenderStateTest : public TestBase
+    {
+    public:
+        virtual void run() override
+        {
+            ClockFactory::get(std::make_shared<SteppableClock>(StepSize));
+
+            AirSimSettings::VehicleSetting vehicle_setting;
+            QuadParams params;
+            params.initialize(&vehicle_setting);
+            IdleApi api;
+            Kinematics::State initial = Kinematics::State::zero();
+            initial.pose.position = Vector3r(0, 0, -100);
+            Kinematics kinematics(initial);
+            Environment environment(Environment::State(Vector3r(0, 0, -100), GeoPoint(47.641468, -122.140165, 122)));
+
+            {
+                MultiRotorPhysicsBody body(&params, &api, &kinematics, &environment);
+                World world(std::unique_ptr<PhysicsEngineBase>(new FastPhysicsEngine()));
+                world.insert(&body);
+                //like the vehicle's sim api does
+                kinematics.reset();
+                api.reset();
+                world.reset();
+
+                Vector3r last_position = body.getKinematics().pose.position;
+                for (uint step = 0; step < 20; ++step) {
+                    world.update();
+                    const TTimePoint step_time = ClockFactory::get()->nowNanos();
+
+                    MultiRotorPhysicsBody::RenderStates::State state;
+                    testAssert(body.getRenderStates().getState(step_time, false, state), "a state should be published in each step");
+                    testAssert(state.time == step_time, Utils::stringf("state of step %u should have the step's time", step));
+
+                    const Vector3r& position = body.getKinematics().pose.position;
+                    testAssert(state.kinematics.pose.position == position, Utils::stringf("state of step %u should have the pose the step ended with", step));
+                    //it starts at rest, so the first step doesn't move it yet
+                    testAssert(step == 0 || position != last_position, "the body should be falling");
+                    last_position = position;
+                }
+
+                world.erase_remove(&body);
+            }
+
+            ClockFactory::get(std::make_shared<ScalableClock>());
+        }
+
+        virtual std::string getName() const override
+        {
+            return "RenderStateTest";
+        }
+
+    private:
+        static constexpr TTimeDelta StepSize = 0.003f;
+
+        class QuadParams : public MultiRotorParams
+        {
+        public:
+            virtual std::unique_ptr<MultirotorApiBase> createMultirotorApi() override
+            {
+                return nullptr;
+            }
+
+        protected:
+            virtual void setupParams() override
+            {
+                setupFrameGenericQuad(getParams());
+            }
+            virtual const SensorFactory* getSensorFactory() const override
+            {
+                return &sensor_factory_;
+            }
+
+        private:
+            SensorFactory sensor_factory_;
+        };
+
+        //rotors off, so the body falls
+        class IdleApi : public VehicleApiBase
+        {
+        public:
+            virtual void enableApiControl(bool is_enabled) override
+            {
+                unused(is_enabled);
+            }
+            virtual bool isApiControlEnabled() const override
+            {
+                return false;
+            }
+            virtual bool armDisarm(bool arm) override
+            {
+                unused(arm);
+                return true;
+            }
+            virtual GeoPoint getHomeGeoPoint() const override
+            {
+                return GeoPoint();
+            }
+            virtual real_T getActuation(unsigned int actuator_index) const override
+            {
+                unused(actuator_index);
+                return 0;
+            }
+
+        protected:
+            virtual void resetImplementation() override {}
+        };
+    };
+}
+} //namespace
+#endif
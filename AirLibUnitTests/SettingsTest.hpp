@@ -0,0 +1,66 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_AirLibUnitTests_SettingsTest_hpp
+#define msr_AirLibUnitTests_SettingsTest_hpp
+
+#include <utility>
+#include "TestBase.hpp"
+#include "common/Settings.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    /*
+    Moves Settings that own their document and children that view into their parent's, and
+    checks the moved to object reads the same values and the moved from one is left empty.
+    */
+    class SettingsTest : public TestBase
+    {
+    public:
+        virtual void run() override
+        {
+            Settings& settings = Settings::loadJSonString(R"({"ClockSpeed": 2, "Vehicles": {"Drone1": {"X": 3}}})");
+
+            Settings vehicles;
+            testAssert(settings.getChild("Vehicles", vehicles), "Vehicles should be a child");
+
+            //a view moves over and still reads the parent's document
+            Settings moved(std::move(vehicles));
+            checkVehicles(moved, "move constructed child");
+            testAssert(vehicles.size() == 0, "moved from child should be empty");
+
+            Settings assigned;
+            assigned = std::move(moved);
+            checkVehicles(assigned, "move assigned child");
+            testAssert(moved.size() == 0, "moved from child should be empty after assignment");
+
+            //a moved from view that is modified owns a document of its own, not the parent's
+            moved.setDouble("ClockSpeed", 5);
+            testAssert(settings.getDouble("ClockSpeed", 0) == 2, "modifying a moved from child should not touch the parent");
+
+            //an owning document moves over as well
+            Settings owned = settings;
+            Settings owned_moved(std::move(owned));
+            testAssert(owned_moved.getDouble("ClockSpeed", 0) == 2, "moved document should keep its values");
+            testAssert(!owned.hasKey("ClockSpeed"), "moved from document should be empty");
+        }
+
+        virtual std::string getName() const override
+        {
+            return "SettingsTest";
+        }
+
+    private:
+        void checkVehicles(const Settings& vehicles, const std::string& what)
+        {
+            Settings drone;
+            testAssert(vehicles.getChild("Drone1", drone), what + " should have Drone1");
+            testAssert(drone.getInt("X", 0) == 3, what + " should read Drone1's values");
+        }
+    };
+}
+} //namespace
+#endif
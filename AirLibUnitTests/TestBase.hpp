@@ -0,0 +1,37 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_AirLibUnitTests_TestBase_hpp
+#define msr_AirLibUnitTests_TestBase_hpp
+
+#include <exception>
+#include <iostream>
+#include <string>
+#include "common/common_utils/Utils.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    class TestBase
+    {
+    public:
+        virtual ~TestBase() = default;
+        virtual void run() = 0;
+        virtual std::string getName() const = 0;
+
+        void testAssert(bool condition, const std::string& message)
+        {
+            if (!condition)
+                throw std::runtime_error(getName() + ": " + message);
+        }
+
+        void report(const std::string& message)
+        {
+            std::cout << getName() << ": " << message << std::endl;
+        }
+    };
+}
+} //namespace
+#endif
@@ -0,0 +1,139 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_AirLibUnitTests_VersionedBufferTest_hpp
+#define msr_AirLibUnitTests_VersionedBufferTest_hpp
+
+#include <atomic>
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+#include "TestBase.hpp"
+#include "common/VersionedBuffer.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    /*
+    One writer publishes values filled with their own sequence number while several readers
+    read them, some holding on to a few snapshots. Readers check they never see a value
+    that is torn or changes while held and that sequences never go backwards.
+    */
+    class VersionedBufferTest : public TestBase
+    {
+    public:
+        virtual void run() override
+        {
+            VersionedBuffer<Value> buffer;
+            std::atomic<uint> readers_started{ 0 };
+            std::atomic<bool> writer_done{ false };
+            std::vector<std::string> errors(ReaderCount);
+            std::vector<uint64_t> reads(ReaderCount, 0);
+
+            std::vector<std::thread> readers;
+            for (uint reader_index = 0; reader_index < ReaderCount; ++reader_index) {
+                readers.emplace_back([&, reader_index]() {
+                    //odd readers keep their last few snapshots so the writer has to work around them
+                    const size_t held_count = reader_index % 2 == 0 ? 0 : reader_index + 1;
+                    std::deque<VersionedBuffer<Value>::Snapshot> held;
+                    uint64_t last_sequence = 0;
+
+                    ++readers_started;
+                    while (errors[reader_index].empty()) {
+                        const bool done = writer_done.load();
+                        const uint64_t published = buffer.getSequence();
+
+                        VersionedBuffer<Value>::Snapshot snapshot = buffer.read();
+                        const uint64_t sequence = snapshot.getSequence();
+                        if (sequence < last_sequence || sequence < published)
+                            errors[reader_index] = Utils::stringf("read sequence %llu after %llu with %llu published",
+                                                                  toULL(sequence), toULL(last_sequence), toULL(published));
+                        else if (!isWhole(*snapshot, sequence))
+                            errors[reader_index] = Utils::stringf("value of sequence %llu is torn", toULL(sequence));
+                        last_sequence = sequence;
+                        ++reads[reader_index];
+
+                        if (held_count > 0) {
+                            held.push_back(std::move(snapshot));
+                            if (held.size() > held_count) {
+                                if (!isWhole(*held.front(), held.front().getSequence()))
+                                    errors[reader_index] = Utils::stringf("held value of sequence %llu changed", toULL(held.front().getSequence()));
+                                held.pop_front();
+                            }
+                        }
+
+                        //done was loaded before the last read, so that read saw the final value
+                        if (done)
+                            break;
+                    }
+                });
+            }
+
+            //publishing only once everyone reads, so they overlap with the writer
+            while (readers_started.load() < ReaderCount)
+                std::this_thread::yield();
+
+            Value value(ValueSize);
+            for (uint64_t sequence = 1; sequence <= PublishCount; ++sequence) {
+                value.assign(ValueSize, sequence);
+                //publishSwap hands back a stale value, which is refilled next time around
+                if (sequence % 2 == 0)
+                    buffer.publish(value);
+                else
+                    buffer.publishSwap(value);
+            }
+            writer_done = true;
+
+            for (auto& reader : readers)
+                reader.join();
+
+            for (uint reader_index = 0; reader_index < ReaderCount; ++reader_index) {
+                testAssert(errors[reader_index].empty(), Utils::stringf("reader %u: ", reader_index) + errors[reader_index]);
+                testAssert(reads[reader_index] > 0, Utils::stringf("reader %u should have read", reader_index));
+            }
+            testAssert(buffer.getSequence() == PublishCount, "the last sequence should be the number of publishes");
+            testAssert(isWhole(*buffer.read(), PublishCount), "the last value should be published");
+
+            uint64_t read_count = 0;
+            for (uint64_t reader_reads : reads)
+                read_count += reader_reads;
+            report(Utils::stringf("%llu publishes, %llu reads, %u slots", toULL(PublishCount), toULL(read_count), buffer.getSlotCount()));
+        }
+
+        virtual std::string getName() const override
+        {
+            return "VersionedBufferTest";
+        }
+
+    private:
+        typedef std::vector<uint64_t> Value;
+
+        static constexpr uint ReaderCount = 4;
+        static constexpr uint64_t PublishCount = 2000000;
+        static constexpr size_t ValueSize = 64;
+
+        static bool isWhole(const Value& value, uint64_t sequence)
+        {
+            //sequence 0 is the default constructed value
+            if (sequence == 0)
+                return value.empty();
+            if (value.size() != ValueSize)
+                return false;
+            for (uint64_t element : value) {
+                if (element != sequence)
+                    return false;
+            }
+            return true;
+        }
+
+        static unsigned long long toULL(uint64_t value)
+        {
+            return static_cast<unsigned long long>(value);
+        }
+    };
+}
+} //namespace
+#endif
@@ -0,0 +1,148 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_AirLibUnitTests_WorldStepTest_hpp
+#define msr_AirLibUnitTests_WorldStepTest_hpp
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include "TestBase.hpp"
+#include "common/ClockFactory.hpp"
+#include "common/ScalableClock.hpp"
+#include "common/SteppableClock.hpp"
+#include "physics/PhysicsWorld.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    /*
+    Checks that continueForTime and continueForFrames stop after exactly the steps asked for,
+    and reports how long a paused world takes to do one step and pause again.
+    */
+    class WorldStepTest : public TestBase
+    {
+    public:
+        virtual void run() override
+        {
+            ClockFactory::get(std::make_shared<SteppableClock>(StepSize));
+
+            StepCounter counter;
+            std::unique_ptr<PhysicsWorld> world(new PhysicsWorld(std::unique_ptr<PhysicsEngineBase>(new PhysicsEngineBase()),
+                                                                 { &counter },
+                                                                 UpdatePeriodNanos,
+                                                                 false,
+                                                                 false));
+            counter.world = world.get();
+            world->startAsyncUpdator();
+            world->pause(true);
+            world->waitForPause();
+
+            testContinueForTime(*world, counter);
+            testContinueForFrames(*world, counter);
+            measureOverhead(*world, counter);
+
+            world.reset();
+            ClockFactory::get(std::make_shared<ScalableClock>());
+        }
+
+        virtual std::string getName() const override
+        {
+            return "WorldStepTest";
+        }
+
+    private:
+        static constexpr TTimeDelta StepSize = 0.004f;
+        static constexpr uint64_t UpdatePeriodNanos = 100000; //100us
+
+        //counts physics steps and, when asked to, renders one frame per step like a
+        //lock-stepped game thread so frame counts are exact
+        class StepCounter : public UpdatableObject
+        {
+        public:
+            PhysicsWorld* world = nullptr;
+            std::atomic<uint64_t> steps{ 0 };
+            std::atomic<bool> is_rendering{ false };
+            uint32_t frame = 0;
+
+            virtual void update() override
+            {
+                UpdatableObject::update();
+                ++steps;
+                if (is_rendering)
+                    world->setFrameNumber(++frame);
+            }
+
+        protected:
+            virtual void resetImplementation() override {}
+        };
+
+        void testContinueForTime(PhysicsWorld& world, StepCounter& counter)
+        {
+            for (uint steps : { 1u, 2u, 7u, 50u }) {
+                const uint64_t start = counter.steps;
+                world.continueForTime(steps * StepSize);
+                world.waitForPause();
+                testAssert(counter.steps - start == steps,
+                           Utils::stringf("continueForTime(%u steps) took %llu steps", steps,
+                                          static_cast<unsigned long long>(counter.steps - start)));
+            }
+
+            //the world stays paused after the fence
+            const uint64_t paused_at = counter.steps;
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            testAssert(counter.steps == paused_at, "world should not step while paused");
+        }
+
+        void testContinueForFrames(PhysicsWorld& world, StepCounter& counter)
+        {
+            counter.is_rendering = true;
+            for (uint frames : { 1u, 3u, 20u }) {
+                const uint64_t start = counter.steps;
+                world.setFrameNumber(counter.frame);
+                world.continueForFrames(frames);
+                world.waitForPause();
+                testAssert(counter.steps - start == frames,
+                           Utils::stringf("continueForFrames(%u) took %llu steps", frames,
+                                          static_cast<unsigned long long>(counter.steps - start)));
+            }
+            counter.is_rendering = false;
+        }
+
+        //wall time from asking a paused world for one step until it is paused again
+        void measureOverhead(PhysicsWorld& world, StepCounter& counter)
+        {
+            constexpr uint iterations = 500;
+            std::vector<double> micros;
+            micros.reserve(iterations);
+
+            const uint64_t start = counter.steps;
+            for (uint i = 0; i < iterations; ++i) {
+                const auto begin = std::chrono::high_resolution_clock::now();
+                world.continueForTime(StepSize);
+                world.waitForPause();
+                const auto end = std::chrono::high_resolution_clock::now();
+                micros.push_back(std::chrono::duration<double, std::micro>(end - begin).count());
+            }
+            testAssert(counter.steps - start == iterations, "every single step continue should take one step");
+
+            std::sort(micros.begin(), micros.end());
+            double total = 0;
+            for (double value : micros)
+                total += value;
+            report(Utils::stringf("single step pause/resume over %u steps: mean=%.1fus p50=%.1fus p99=%.1fus max=%.1fus (executor period %.1fus)",
+                                  iterations,
+                                  total / iterations,
+                                  micros[iterations / 2],
+                                  micros[iterations * 99 / 100],
+                                  micros.back(),
+                                  UpdatePeriodNanos / 1000.0));
+        }
+    };
+}
+} //namespace
+#endif
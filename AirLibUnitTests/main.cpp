@@ -0,0 +1,45 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <memory>
+#include "ClockStepTest.hpp"
+#include "CommandExecutorTest.hpp"
+#include "ContactSolverTest.hpp"
+#include "CpuImageCaptureTest.hpp"
+#include "ImageEffectsTest.hpp"
+#include "LidarCompactEncodingTest.hpp"
+#include "LockStepTest.hpp"
+#include "NavigationEkfTest.hpp"
+#include "PidIntegratorTest.hpp"
+#include "RenderStateTest.hpp"
+#include "SettingsTest.hpp"
+#include "VersionedBufferTest.hpp"
+#include "WorldStepTest.hpp"
+
+int main()
+{
+    using namespace msr::airlib;
+
+    std::unique_ptr<TestBase> tests[] = {
+        std::unique_ptr<TestBase>(new LockStepTest()),
+        std::unique_ptr<TestBase>(new WorldStepTest()),
+        std::unique_ptr<TestBase>(new CommandExecutorTest()),
+        std::unique_ptr<TestBase>(new RenderStateTest()),
+        std::unique_ptr<TestBase>(new PidIntegratorTest()),
+        std::unique_ptr<TestBase>(new VersionedBufferTest()),
+        std::unique_ptr<TestBase>(new ClockStepTest()),
+        std::unique_ptr<TestBase>(new NavigationEkfTest()),
+        std::unique_ptr<TestBase>(new ContactSolverTest()),
+        std::unique_ptr<TestBase>(new SettingsTest()),
+        std::unique_ptr<TestBase>(new CpuImageCaptureTest()),
+        std::unique_ptr<TestBase>(new ImageEffectsTest()),
+        std::unique_ptr<TestBase>(new LidarCompactEncodingTest())
+    };
+
+    for (auto& test : tests) {
+        test->run();
+        test->report("passed");
+    }
+
+    return 0;
+}
@@ -0,0 +1,276 @@
+#include "AabbTree.h"
+
+AabbTree::AabbTree(float margin)
+    : margin_(margin)
+{
+}
+
+int32 AabbTree::createLeaf(const FBox& box, int32 user_data)
+{
+    const int32 leaf = allocateNode();
+    Node& node = nodes_[leaf];
+    node.box = box.ExpandBy(margin_);
+    node.user_data = user_data;
+    node.height = 0;
+
+    insertLeaf(leaf);
+    ++leaf_count_;
+    return leaf;
+}
+
+void AabbTree::destroyLeaf(int32 leaf)
+{
+    check(nodes_[leaf].isLeaf());
+
+    removeLeaf(leaf);
+    freeNode(leaf);
+    --leaf_count_;
+}
+
+bool AabbTree::moveLeaf(int32 leaf, const FBox& box)
+{
+    check(nodes_[leaf].isLeaf());
+
+    if (nodes_[leaf].box.IsInside(box))
+        return false;
+
+    removeLeaf(leaf);
+    nodes_[leaf].box = box.ExpandBy(margin_);
+    insertLeaf(leaf);
+    return true;
+}
+
+int32 AabbTree::getUserData(int32 leaf) const
+{
+    return nodes_[leaf].user_data;
+}
+
+void AabbTree::setUserData(int32 leaf, int32 user_data)
+{
+    nodes_[leaf].user_data = user_data;
+}
+
+int32 AabbTree::getLeafCount() const
+{
+    return leaf_count_;
+}
+
+void AabbTree::clear()
+{
+    nodes_.Reset();
+    root_ = kNullNode;
+    free_list_ = kNullNode;
+    leaf_count_ = 0;
+}
+
+int32 AabbTree::allocateNode()
+{
+    int32 index;
+    if (free_list_ != kNullNode) {
+        index = free_list_;
+        free_list_ = nodes_[index].parent;
+    }
+    else
+        index = nodes_.AddDefaulted();
+
+    Node& node = nodes_[index];
+    node.parent = kNullNode;
+    node.child1 = kNullNode;
+    node.child2 = kNullNode;
+    node.height = 0;
+    node.user_data = 0;
+    return index;
+}
+
+void AabbTree::freeNode(int32 node)
+{
+    nodes_[node].parent = free_list_;
+    nodes_[node].height = -1;
+    free_list_ = node;
+}
+
+float AabbTree::getCost(const FBox& box)
+{
+    //half the surface area, the chance a random query touches the box
+    const FVector size = box.GetSize();
+    return size.X * size.Y + size.Y * size.Z + size.Z * size.X;
+}
+
+void AabbTree::insertLeaf(int32 leaf)
+{
+    if (root_ == kNullNode) {
+        root_ = leaf;
+        nodes_[leaf].parent = kNullNode;
+        return;
+    }
+
+    //walk down to the sibling that grows the tree's total cost least
+    const FBox leaf_box = nodes_[leaf].box;
+    int32 index = root_;
+    while (!nodes_[index].isLeaf()) {
+        const Node& node = nodes_[index];
+        const float area = getCost(node.box);
+        const float combined_area = getCost(node.box + leaf_box);
+
+        //cost of a new parent for this node and the leaf, and what descending pushes onto this node
+        const float cost = 2 * combined_area;
+        const float inheritance_cost = 2 * (combined_area - area);
+
+        auto getDescendCost = [&](int32 child) {
+            const FBox& child_box = nodes_[child].box;
+            const float child_cost = getCost(child_box + leaf_box) + inheritance_cost;
+            return nodes_[child].isLeaf() ? child_cost : child_cost - getCost(child_box);
+        };
+        const float cost1 = getDescendCost(node.child1);
+        const float cost2 = getDescendCost(node.child2);
+
+        if (cost < cost1 && cost < cost2)
+            break;
+        index = cost1 < cost2 ? node.child1 : node.child2;
+    }
+
+    const int32 sibling = index;
+    const int32 old_parent = nodes_[sibling].parent;
+    const int32 new_parent = allocateNode();
+    nodes_[new_parent].parent = old_parent;
+    nodes_[new_parent].box = leaf_box + nodes_[sibling].box;
+    nodes_[new_parent].height = nodes_[sibling].height + 1;
+    nodes_[new_parent].child1 = sibling;
+    nodes_[new_parent].child2 = leaf;
+    nodes_[sibling].parent = new_parent;
+    nodes_[leaf].parent = new_parent;
+
+    if (old_parent != kNullNode) {
+        if (nodes_[old_parent].child1 == sibling)
+            nodes_[old_parent].child1 = new_parent;
+        else
+            nodes_[old_parent].child2 = new_parent;
+    }
+    else
+        root_ = new_parent;
+
+    refitUp(new_parent);
+}
+
+void AabbTree::removeLeaf(int32 leaf)
+{
+    if (leaf == root_) {
+        root_ = kNullNode;
+        return;
+    }
+
+    //the leaf's parent goes away and the sibling takes its place
+    const int32 parent = nodes_[leaf].parent;
+    const int32 grand_parent = nodes_[parent].parent;
+    const int32 sibling = nodes_[parent].child1 == leaf ? nodes_[parent].child2 : nodes_[parent].child1;
+
+    if (grand_parent != kNullNode) {
+        if (nodes_[grand_parent].child1 == parent)
+            nodes_[grand_parent].child1 = sibling;
+        else
+            nodes_[grand_parent].child2 = sibling;
+        nodes_[sibling].parent = grand_parent;
+        freeNode(parent);
+        refitUp(grand_parent);
+    }
+    else {
+        root_ = sibling;
+        nodes_[sibling].parent = kNullNode;
+        freeNode(parent);
+    }
+}
+
+void AabbTree::refitUp(int32 index)
+{
+    while (index != kNullNode) {
+        index = balance(index);
+
+        Node& node = nodes_[index];
+        node.height = 1 + FMath::Max(nodes_[node.child1].height, nodes_[node.child2].height);
+        node.box = nodes_[node.child1].box + nodes_[node.child2].box;
+
+        index = node.parent;
+    }
+}
+
+int32 AabbTree::balance(int32 index_a)
+{
+    //rotates the taller grandchild up if a's subtrees differ in height by more than one,
+    //returns the node now at a's place
+    Node& a = nodes_[index_a];
+    if (a.isLeaf() || a.height < 2)
+        return index_a;
+
+    const int32 index_b = a.child1;
+    const int32 index_c = a.child2;
+    Node& b = nodes_[index_b];
+    Node& c = nodes_[index_c];
+    const int32 height_difference = c.height - b.height;
+
+    auto replaceInParent = [this, index_a](int32 parent, int32 replacement) {
+        if (parent == kNullNode)
+            root_ = replacement;
+        else if (nodes_[parent].child1 == index_a)
+            nodes_[parent].child1 = replacement;
+        else
+            nodes_[parent].child2 = replacement;
+    };
+
+    if (height_difference > 1) {
+        //c goes up, a keeps b and the shorter of c's children
+        const int32 index_f = c.child1;
+        const int32 index_g = c.child2;
+        Node& f = nodes_[index_f];
+        Node& g = nodes_[index_g];
+
+        c.child1 = index_a;
+        c.parent = a.parent;
+        a.parent = index_c;
+        replaceInParent(c.parent, index_c);
+
+        const bool f_taller = f.height > g.height;
+        const int32 index_kept = f_taller ? index_f : index_g;
+        const int32 index_moved = f_taller ? index_g : index_f;
+        Node& kept = nodes_[index_kept];
+        Node& moved = nodes_[index_moved];
+
+        c.child2 = index_kept;
+        a.child2 = index_moved;
+        moved.parent = index_a;
+        a.box = b.box + moved.box;
+        c.box = a.box + kept.box;
+        a.height = 1 + FMath::Max(b.height, moved.height);
+        c.height = 1 + FMath::Max(a.height, kept.height);
+        return index_c;
+    }
+
+    if (height_difference < -1) {
+        //b goes up, a keeps c and the shorter of b's children
+        const int32 index_d = b.child1;
+        const int32 index_e = b.child2;
+        Node& d = nodes_[index_d];
+        Node& e = nodes_[index_e];
+
+        b.child1 = index_a;
+        b.parent = a.parent;
+        a.parent = index_b;
+        replaceInParent(b.parent, index_b);
+
+        const bool d_taller = d.height > e.height;
+        const int32 index_kept = d_taller ? index_d : index_e;
+        const int32 index_moved = d_taller ? index_e : index_d;
+        Node& kept = nodes_[index_kept];
+        Node& moved = nodes_[index_moved];
+
+        b.child2 = index_kept;
+        a.child1 = index_moved;
+        moved.parent = index_a;
+        a.box = c.box + moved.box;
+        b.box = a.box + kept.box;
+        a.height = 1 + FMath::Max(c.height, moved.height);
+        b.height = 1 + FMath::Max(a.height, kept.height);
+        return index_b;
+    }
+
+    return index_a;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/*
+    Dynamic bounding volume tree over boxes that move, after the one in Box2D. Each leaf stores
+    its box grown by a margin, so an object moving a little stays inside its leaf and costs
+    nothing; only objects leaving their grown box are taken out and reinserted. Insertion picks
+    the sibling that adds least surface area and rotations keep the tree balanced, so queries
+    visit O(log n) nodes plus the ones they report.
+
+    Leaves carry an int32 the caller chooses, e.g. an index into its own array of objects.
+*/
+class AabbTree
+{
+public:
+    static constexpr int32 kNullNode = -1;
+
+    explicit AabbTree(float margin = 50.0f);
+
+    //returns the leaf id for box
+    int32 createLeaf(const FBox& box, int32 user_data);
+    void destroyLeaf(int32 leaf);
+    //returns true if the leaf had to be reinserted because box left its grown box
+    bool moveLeaf(int32 leaf, const FBox& box);
+
+    int32 getUserData(int32 leaf) const;
+    void setUserData(int32 leaf, int32 user_data);
+    int32 getLeafCount() const;
+    void clear();
+
+    //calls leaf_func(user_data) for each leaf whose grown box passes box_test; box_test(const FBox&)
+    //should be conservative, it also decides which subtrees are skipped
+    template <typename TBoxTest, typename TLeafFunc>
+    void query(TBoxTest box_test, TLeafFunc leaf_func) const
+    {
+        if (root_ == kNullNode)
+            return;
+
+        TArray<int32, TInlineAllocator<64>> stack;
+        stack.Add(root_);
+        while (stack.Num() > 0) {
+            const Node& node = nodes_[stack.Pop(false)];
+            if (!box_test(node.box))
+                continue;
+            if (node.isLeaf())
+                leaf_func(node.user_data);
+            else {
+                stack.Add(node.child1);
+                stack.Add(node.child2);
+            }
+        }
+    }
+
+private:
+    struct Node
+    {
+        FBox box;
+        int32 parent; //next free node while on the free list
+        int32 child1;
+        int32 child2;
+        int32 height; //-1 for free nodes, 0 for leaves
+        int32 user_data;
+
+        bool isLeaf() const
+        {
+            return child1 == kNullNode;
+        }
+    };
+
+    int32 allocateNode();
+    void freeNode(int32 node);
+    void insertLeaf(int32 leaf);
+    void removeLeaf(int32 leaf);
+    int32 balance(int32 a);
+    void refitUp(int32 node);
+
+    static float getCost(const FBox& box);
+
+private:
+    float margin_;
+    TArray<Node> nodes_;
+    int32 root_ = kNullNode;
+    int32 free_list_ = kNullNode;
+    int32 leaf_count_ = 0;
+};
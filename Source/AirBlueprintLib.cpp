@@ -21,12 +21,14 @@
 #include "Misc/ObjectThumbnail.h"
 #include "Engine/Engine.h"
 #include "Engine/World.h"
+#include "GameFramework/Pawn.h"
 #include <exception>
 #include "common/common_utils/Utils.hpp"
 #include "Modules/ModuleManager.h"
 #include "ARFilter.h"
 #include "AssetRegistryModule.h"
 #include "DetectionComponent.h"
+#include "ObjectNameIndex.h"
 
 /*
 //TODO: change naming conventions to same as other files?
@@ -371,76 +373,67 @@ void UAirBlueprintLib::InitializeMeshStencilIDs(bool override_existing)
     }
 }
 
-bool UAirBlueprintLib::SetMeshStencilID(const std::string& mesh_name, int object_id,
+bool UAirBlueprintLib::SetMeshStencilID(const UObject* context, const std::string& mesh_name, int object_id,
                                         bool is_name_regex)
 {
-    std::regex name_regex;
-
-    if (is_name_regex)
-        name_regex.assign(mesh_name, std::regex_constants::icase);
+    //exact names match case sensitively, regexes ignore case
+    const auto pattern = msr::airlib::NamePattern::compile(mesh_name,
+                                                           is_name_regex ? msr::airlib::NamePattern::Syntax::Regex : msr::airlib::NamePattern::Syntax::Exact,
+                                                           is_name_regex);
 
     int changes = 0;
-    for (TObjectIterator<UStaticMeshComponent> comp; comp; ++comp) {
-        SetObjectStencilIDIfMatch(*comp, object_id, mesh_name, is_name_regex, name_regex, changes);
-    }
-    for (TObjectIterator<USkinnedMeshComponent> comp; comp; ++comp) {
-        SetObjectStencilIDIfMatch(*comp, object_id, mesh_name, is_name_regex, name_regex, changes);
-    }
-    for (TObjectIterator<ALandscapeProxy> comp; comp; ++comp) {
-        SetObjectStencilIDIfMatch(*comp, object_id, mesh_name, is_name_regex, name_regex, changes);
-    }
+    auto setComponentID = [object_id, &changes](UPrimitiveComponent* mesh) {
+        ++changes;
+        SetObjectStencilID(mesh, object_id);
+    };
+    auto setLandscapeID = [object_id, &changes](ALandscapeProxy* mesh) {
+        ++changes;
+        SetObjectStencilID(mesh, object_id);
+    };
+    ObjectNameIndex::get(context->GetWorld()).forEachMesh(*pattern, setComponentID, setLandscapeID);
 
     return changes > 0;
 }
 
-int UAirBlueprintLib::GetMeshStencilID(const std::string& mesh_name)
+int UAirBlueprintLib::GetMeshStencilID(const UObject* context, const std::string& mesh_name)
 {
-    // Takes a UStaticMeshComponent, USkinnedMeshComponent or ALandscapeProxy and returns their custom stencil ID if
-    // their meshes's name or their owner's name (depending on the naming method in mesh_naming_method_) equals mesh_name
-    auto getCustomStencilForMesh = [&mesh_name](auto mesh) -> int {
-        const std::string component_mesh_name = common_utils::Utils::toLower(GetMeshName(mesh));
-        if (component_mesh_name.compare(mesh_name) == 0) {
-            return mesh->CustomDepthStencilValue;
-        }
-        return -1;
-    };
+    // Returns the custom stencil ID of a UStaticMeshComponent, USkinnedMeshComponent or ALandscapeProxy whose
+    // meshes's name or owner's name (depending on the naming method in mesh_naming_method_) equals mesh_name ignoring case
+    const auto pattern = msr::airlib::NamePattern::compile(mesh_name, msr::airlib::NamePattern::Syntax::Exact, true);
 
-    for (TObjectIterator<UStaticMeshComponent> comp; comp; ++comp) {
-        int id = getCustomStencilForMesh(*comp);
-        if (id != -1)
-            return id;
-    }
-    for (TObjectIterator<USkinnedMeshComponent> comp; comp; ++comp) {
-        int id = getCustomStencilForMesh(*comp);
-        if (id != -1)
-            return id;
-    }
-    for (TObjectIterator<ALandscapeProxy> comp; comp; ++comp) {
-        int id = getCustomStencilForMesh(*comp);
-        if (id != -1)
-            return id;
-    }
+    int id = -1;
+    auto getComponentID = [&id](UPrimitiveComponent* mesh) {
+        if (id == -1)
+            id = mesh->CustomDepthStencilValue;
+    };
+    auto getLandscapeID = [&id](ALandscapeProxy* mesh) {
+        if (id == -1)
+            id = mesh->CustomDepthStencilValue;
+    };
+    ObjectNameIndex::get(context->GetWorld()).forEachMesh(*pattern, getComponentID, getLandscapeID);
 
-    return -1;
+    return id;
 }
 
 std::vector<std::string> UAirBlueprintLib::ListMatchingActors(const UObject* context, const std::string& name_regex)
 {
+    const auto pattern = msr::airlib::NamePattern::compile(name_regex, msr::airlib::NamePattern::Syntax::Regex, false);
+
+    TSet<AActor*> actors;
+    ObjectNameIndex::get(context->GetWorld()).findActors(*pattern, false, actors);
+
     std::vector<std::string> results;
-    auto world = context->GetWorld();
-    std::regex compiledRegex(name_regex, std::regex::optimize);
-    for (TActorIterator<AActor> actorIterator(world); actorIterator; ++actorIterator) {
-        AActor* actor = *actorIterator;
-        auto name = std::string(TCHAR_TO_UTF8(*actor->GetName()));
-        bool match = std::regex_match(name, compiledRegex);
-        if (match)
-            results.push_back(name);
-    }
+    for (AActor* actor : actors)
+        results.push_back(std::string(TCHAR_TO_UTF8(*actor->GetName())));
     return results;
 }
 
-std::vector<msr::airlib::MeshPositionVertexBuffersResponse> UAirBlueprintLib::GetStaticMeshComponents()
+std::vector<msr::airlib::MeshPositionVertexBuffersResponse> UAirBlueprintLib::GetStaticMeshComponents(bool skip_pawns,
+                                                                                                    std::vector<int>* custom_depth_stencil_values)
 {
+    if (custom_depth_stencil_values)
+        custom_depth_stencil_values->clear();
+
     std::vector<msr::airlib::MeshPositionVertexBuffersResponse> meshes;
     int num_meshes = 0;
     for (TObjectIterator<UStaticMeshComponent> comp; comp; ++comp) {
@@ -452,6 +445,9 @@ std::vector<msr::airlib::MeshPositionVertexBuffersResponse> UAirBlueprintLib::Ge
             continue;
         }
 
+        if (skip_pawns && Cast<APawn>(comp->GetOwner()) != nullptr)
+            continue;
+
         //Various checks if there is even a valid mesh
         if (!comp->GetStaticMesh()) continue;
         if (!comp->GetStaticMesh()->RenderData) continue;
@@ -550,6 +546,8 @@ std::vector<msr::airlib::MeshPositionVertexBuffersResponse> UAirBlueprintLib::Ge
         }
 
         meshes.push_back(mesh);
+        if (custom_depth_stencil_values)
+            custom_depth_stencil_values->push_back(comp->CustomDepthStencilValue);
     }
 
     return meshes;
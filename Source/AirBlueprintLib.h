@@ -98,9 +98,9 @@ public:
                                         FHitResult& hit, const AActor* ignore_actor = nullptr, ECollisionChannel collision_channel = ECC_Visibility);
     static void FollowActor(AActor* follower, const AActor* followee, const FVector& offset, bool fixed_z = false, float fixed_z_val = 2.0f);
 
-    static bool SetMeshStencilID(const std::string& mesh_name, int object_id,
+    static bool SetMeshStencilID(const UObject* context, const std::string& mesh_name, int object_id,
                                  bool is_name_regex = false);
-    static int GetMeshStencilID(const std::string& mesh_name);
+    static int GetMeshStencilID(const UObject* context, const std::string& mesh_name);
     static void InitializeMeshStencilIDs(bool override_existing);
 
     static bool IsInGameThread();
@@ -178,6 +178,10 @@ public:
     {
         mesh_naming_method_ = method;
     }
+    static msr::airlib::AirSimSettings::SegmentationSetting::MeshNamingMethodType GetMeshNamingMethod()
+    {
+        return mesh_naming_method_;
+    }
 
     static void enableWorldRendering(AActor* context, bool enable);
     static void enableViewportRendering(AActor* context, bool enable);
@@ -191,7 +195,10 @@ public:
     static void setUnrealClockSpeed(const AActor* context, float clock_speed);
     static IImageWrapperModule* getImageWrapperModule();
     static void CompressImageArray(int32 width, int32 height, const TArray<FColor>& src, TArray<uint8>& dest);
-    static std::vector<msr::airlib::MeshPositionVertexBuffersResponse> GetStaticMeshComponents();
+    //skip_pawns leaves out meshes that move with vehicles, custom_depth_stencil_values gets the
+    //segmentation id of each mesh returned
+    static std::vector<msr::airlib::MeshPositionVertexBuffersResponse> GetStaticMeshComponents(bool skip_pawns = false,
+                                                                                               std::vector<int>* custom_depth_stencil_values = nullptr);
 
 private:
     template <typename T>
@@ -221,20 +228,6 @@ private:
         SetObjectStencilID(mesh, hash % 256);
     }
 
-    template <typename T>
-    static void SetObjectStencilIDIfMatch(T* mesh, int object_id,
-                                          const std::string& mesh_name, bool is_name_regex, const std::regex& name_regex, int& changes)
-    {
-        std::string comp_mesh_name = GetMeshName(mesh);
-        if (comp_mesh_name == "")
-            return;
-        bool is_match = (!is_name_regex && (comp_mesh_name == mesh_name)) || (is_name_regex && std::regex_match(comp_mesh_name, name_regex));
-        if (is_match) {
-            ++changes;
-            SetObjectStencilID(mesh, object_id);
-        }
-    }
-
     template <typename T>
     static void SetObjectStencilID(T* mesh, int object_id)
     {
@@ -298,3 +291,6 @@ private:
 
     static IImageWrapperModule* image_wrapper_module_;
 };
+
+template <>
+std::string UAirBlueprintLib::GetMeshName<USkinnedMeshComponent>(USkinnedMeshComponent* mesh);
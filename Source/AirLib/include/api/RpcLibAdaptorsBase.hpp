@@ -6,9 +6,11 @@
 
 #include "common/Common.hpp"
 #include "common/CommonStructs.hpp"
+#include "sensors/lidar/LidarCompactEncoding.hpp"
 #include "physics/Kinematics.hpp"
 #include "physics/Environment.hpp"
 #include "common/ImageCaptureBase.hpp"
+#include "common/UpdateProfiler.hpp"
 #include "safety/SafetyEval.hpp"
 #include "api/WorldSimApiBase.hpp"
 
@@ -365,6 +367,64 @@ namespace airlib_rpclib
             }
         };
 
+        struct ProfileSectionStats
+        {
+            std::string name;
+            uint64_t steps = 0;
+            uint64_t calls = 0;
+            uint64_t total_nanos = 0;
+            uint64_t max_nanos = 0;
+            std::vector<uint64_t> histogram;
+
+            MSGPACK_DEFINE_MAP(name, steps, calls, total_nanos, max_nanos, histogram);
+
+            ProfileSectionStats()
+            {
+            }
+
+            ProfileSectionStats(const msr::airlib::UpdateProfiler::SectionStats& s)
+            {
+                name = s.name;
+                steps = s.steps;
+                calls = s.calls;
+                total_nanos = s.total_nanos;
+                max_nanos = s.max_nanos;
+                histogram = s.histogram;
+            }
+
+            msr::airlib::UpdateProfiler::SectionStats to() const
+            {
+                msr::airlib::UpdateProfiler::SectionStats s;
+                s.name = name;
+                s.steps = steps;
+                s.calls = calls;
+                s.total_nanos = total_nanos;
+                s.max_nanos = max_nanos;
+                s.histogram = histogram;
+
+                return s;
+            }
+
+            static std::vector<ProfileSectionStats> from(
+                const std::vector<msr::airlib::UpdateProfiler::SectionStats>& stats)
+            {
+                std::vector<ProfileSectionStats> stats_adaptor;
+                for (const auto& item : stats)
+                    stats_adaptor.push_back(ProfileSectionStats(item));
+
+                return stats_adaptor;
+            }
+            static std::vector<msr::airlib::UpdateProfiler::SectionStats> to(
+                const std::vector<ProfileSectionStats>& stats_adaptor)
+            {
+                std::vector<msr::airlib::UpdateProfiler::SectionStats> stats;
+                for (const auto& item : stats_adaptor)
+                    stats.push_back(item.to());
+
+                return stats;
+            }
+        };
+
         struct CameraInfo
         {
             Pose pose;
@@ -638,7 +698,16 @@ namespace airlib_rpclib
                 segmentation = s.segmentation;
             }
 
-            msr::airlib::LidarData to() const
+            //point clouds are big, move them when the source is a temporary
+            LidarData(msr::airlib::LidarData&& s)
+            {
+                time_stamp = s.time_stamp;
+                point_cloud = std::move(s.point_cloud);
+                pose = s.pose;
+                segmentation = std::move(s.segmentation);
+            }
+
+            msr::airlib::LidarData to() const&
             {
                 msr::airlib::LidarData d;
 
@@ -649,6 +718,58 @@ namespace airlib_rpclib
 
                 return d;
             }
+
+            msr::airlib::LidarData to() &&
+            {
+                msr::airlib::LidarData d;
+
+                d.time_stamp = time_stamp;
+                d.point_cloud = std::move(point_cloud);
+                d.pose = pose.to();
+                d.segmentation = std::move(segmentation);
+
+                return d;
+            }
+        };
+
+        struct LidarDataCompact
+        {
+            msr::airlib::TTimePoint time_stamp;
+            Pose pose;
+            Vector3r center;
+            Vector3r scale;
+            std::vector<uint8_t> points;
+            std::vector<int> segmentation_runs;
+
+            MSGPACK_DEFINE_MAP(time_stamp, pose, center, scale, points, segmentation_runs);
+
+            LidarDataCompact()
+            {
+            }
+
+            LidarDataCompact(msr::airlib::LidarCompactData&& s)
+            {
+                time_stamp = s.time_stamp;
+                pose = s.pose;
+                center = s.center;
+                scale = s.scale;
+                points = std::move(s.points);
+                segmentation_runs = std::move(s.segmentation_runs);
+            }
+
+            msr::airlib::LidarCompactData to() &&
+            {
+                msr::airlib::LidarCompactData d;
+
+                d.time_stamp = time_stamp;
+                d.pose = pose.to();
+                d.center = center.to();
+                d.scale = scale.to();
+                d.points = std::move(points);
+                d.segmentation_runs = std::move(segmentation_runs);
+
+                return d;
+            }
         };
 
         struct ImuData
@@ -7,6 +7,7 @@
 #include "common/Common.hpp"
 #include "common/CommonStructs.hpp"
 #include "common/ImageCaptureBase.hpp"
+#include "common/UpdateProfiler.hpp"
 #include "sensors/imu/ImuBase.hpp"
 #include "sensors/barometer/BarometerBase.hpp"
 #include "sensors/magnetometer/MagnetometerBase.hpp"
@@ -99,6 +100,8 @@ namespace airlib
 
         // sensor APIs
         msr::airlib::LidarData getLidarData(const std::string& lidar_name = "", const std::string& vehicle_name = "") const;
+        //same data quantized to int16 per axis on the wire, about a third of the bandwidth, see LidarCompactEncoding
+        msr::airlib::LidarData getLidarDataCompact(const std::string& lidar_name = "", const std::string& vehicle_name = "") const;
         msr::airlib::ImuBase::Output getImuData(const std::string& imu_name = "", const std::string& vehicle_name = "") const;
         msr::airlib::BarometerBase::Output getBarometerData(const std::string& barometer_name = "", const std::string& vehicle_name = "") const;
         msr::airlib::MagnetometerBase::Output getMagnetometerData(const std::string& magnetometer_name = "", const std::string& vehicle_name = "") const;
@@ -142,6 +145,11 @@ namespace airlib
         void simSetWind(const Vector3r& wind) const;
         vector<string> listVehicles();
 
+        // Profiling APIs, see UpdateProfiler
+        void simEnableProfiler(bool is_enabled, bool clear = false);
+        std::vector<UpdateProfiler::SectionStats> simGetProfilerStats() const;
+        std::string simGetProfilerTrace() const;
+
         std::string getSettingsString() const;
 
     protected:
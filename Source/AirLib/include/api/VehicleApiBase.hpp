@@ -114,64 +114,67 @@ Some methods may not be applicable to specific vehicle in which case an exceptio
             throw VehicleCommandNotImplementedException("getSensors API is not supported for this vehicle");
         }
 
+        // Sensor data getters below return copies of each sensor's last published output
+        // so they are safe to call from RPC threads while physics keeps updating sensors
+
         // Lidar APIs
-        virtual const LidarData& getLidarData(const std::string& lidar_name) const
+        virtual LidarData getLidarData(const std::string& lidar_name) const
         {
             auto* lidar = static_cast<const LidarBase*>(findSensorByName(lidar_name, SensorBase::SensorType::Lidar));
             if (lidar == nullptr)
                 throw VehicleControllerException(Utils::stringf("No lidar with name %s exist on vehicle", lidar_name.c_str()));
 
-            return lidar->getOutput();
+            return *lidar->getOutputSnapshot();
         }
 
         // IMU API
-        virtual const ImuBase::Output& getImuData(const std::string& imu_name) const
+        virtual ImuBase::Output getImuData(const std::string& imu_name) const
         {
             auto* imu = static_cast<const ImuBase*>(findSensorByName(imu_name, SensorBase::SensorType::Imu));
             if (imu == nullptr)
                 throw VehicleControllerException(Utils::stringf("No IMU with name %s exist on vehicle", imu_name.c_str()));
 
-            return imu->getOutput();
+            return *imu->getOutputSnapshot();
         }
 
         // Barometer API
-        virtual const BarometerBase::Output& getBarometerData(const std::string& barometer_name) const
+        virtual BarometerBase::Output getBarometerData(const std::string& barometer_name) const
         {
             auto* barometer = static_cast<const BarometerBase*>(findSensorByName(barometer_name, SensorBase::SensorType::Barometer));
             if (barometer == nullptr)
                 throw VehicleControllerException(Utils::stringf("No barometer with name %s exist on vehicle", barometer_name.c_str()));
 
-            return barometer->getOutput();
+            return *barometer->getOutputSnapshot();
         }
 
         // Magnetometer API
-        virtual const MagnetometerBase::Output& getMagnetometerData(const std::string& magnetometer_name) const
+        virtual MagnetometerBase::Output getMagnetometerData(const std::string& magnetometer_name) const
         {
             auto* magnetometer = static_cast<const MagnetometerBase*>(findSensorByName(magnetometer_name, SensorBase::SensorType::Magnetometer));
             if (magnetometer == nullptr)
                 throw VehicleControllerException(Utils::stringf("No magnetometer with name %s exist on vehicle", magnetometer_name.c_str()));
 
-            return magnetometer->getOutput();
+            return *magnetometer->getOutputSnapshot();
         }
 
         // Gps API
-        virtual const GpsBase::Output& getGpsData(const std::string& gps_name) const
+        virtual GpsBase::Output getGpsData(const std::string& gps_name) const
         {
             auto* gps = static_cast<const GpsBase*>(findSensorByName(gps_name, SensorBase::SensorType::Gps));
             if (gps == nullptr)
                 throw VehicleControllerException(Utils::stringf("No gps with name %s exist on vehicle", gps_name.c_str()));
 
-            return gps->getOutput();
+            return *gps->getOutputSnapshot();
         }
 
         // Distance Sensor API
-        virtual const DistanceSensorData& getDistanceSensorData(const std::string& distance_sensor_name) const
+        virtual DistanceSensorData getDistanceSensorData(const std::string& distance_sensor_name) const
         {
             auto* distance_sensor = static_cast<const DistanceBase*>(findSensorByName(distance_sensor_name, SensorBase::SensorType::Distance));
             if (distance_sensor == nullptr)
                 throw VehicleControllerException(Utils::stringf("No distance sensor with name %s exist on vehicle", distance_sensor_name.c_str()));
 
-            return distance_sensor->getOutput();
+            return *distance_sensor->getOutputSnapshot();
         }
 
         // Airspeed API
@@ -181,7 +184,7 @@ Some methods may not be applicable to specific vehicle in which case an exceptio
             if (airspeed_sens == nullptr)
                 throw VehicleControllerException(Utils::stringf("No airspeed sensor with name %s exist on vehicle", airspeed_name.c_str()));
 
-            return airspeed_sens->getOutput();
+            return *airspeed_sens->getOutputSnapshot();
         }
 
         virtual ~VehicleApiBase() = default;
@@ -7,7 +7,9 @@
 #include "CommonStructs.hpp"
 #include "ImageCaptureBase.hpp"
 #include "Settings.hpp"
+#include "TerrainModel.hpp"
 #include "common_utils/Utils.hpp"
+#include "common_utils/Timer.hpp"
 #include "sensors/SensorBase.hpp"
 #include <exception>
 #include <functional>
@@ -61,6 +63,28 @@ namespace airlib
             }
         };
 
+        struct TerrainTileSetting
+        {
+            std::string file_path;
+            //used unless the file is a GeoTIFF
+            TerrainModel::RawTileFormat raw_format;
+
+            bool isGeoTiff() const
+            {
+                const std::string extension = Utils::toLower(Utils::getFileExtension(file_path));
+                return extension == ".tif" || extension == ".tiff";
+            }
+        };
+
+        //renders depth and segmentation images on the CPU from the level's static meshes instead
+        //of with Unreal, see CpuImageCapture
+        struct CpuImageCaptureSetting
+        {
+            bool enabled = false;
+            uint thread_count = 0; //0 uses all hardware threads
+            std::string segmentation_palette = ""; //seg_rgbs.txt with the color of each segmentation id
+        };
+
         struct RecordingSetting
         {
             bool record_on_move = false;
@@ -100,6 +124,22 @@ namespace airlib
             bool allow_api_when_disconnected = false;
         };
 
+        struct SafetySetting
+        {
+            bool enabled = false; //attach a SafetyEval so the API checks and setSafety calls work
+            float obs_clearance = 2; //meters kept from obstacles
+
+            //3D obstacle checks from the vehicle's lidars and distance sensors
+            bool occupancy_map = false;
+            float occupancy_resolution = 0.2f; //voxel edge in meters
+            float occupancy_max_range = 50;
+            float occupancy_cone_half_angle = 22.5f; //degrees around the direction of travel
+
+            //keep destinations this many meters above the terrain tiles, when there are any
+            bool check_terrain = false;
+            float terrain_clearance = 2;
+        };
+
         struct Rotation
         {
             float yaw = 0;
@@ -249,6 +289,7 @@ namespace airlib
             //optional
             std::string default_vehicle_state;
             std::string pawn_path;
+            std::string state_estimator; //GroundTruth or Ekf, for the simple firmwares
             bool allow_api_always = true;
             bool auto_create = true;
             bool enable_collision_passthrough = false;
@@ -264,6 +305,7 @@ namespace airlib
             std::map<std::string, std::shared_ptr<SensorSetting>> sensors;
 
             RCSettings rc;
+            SafetySetting safety;
 
             VehicleSetting()
             {
@@ -291,6 +333,7 @@ namespace airlib
 
             // Used to accept connections from drone over TCP: needed only if use_tcp = true
             bool lock_step = true;
+            float lock_step_timeout = 1.0f; // seconds to wait for actuator controls before lock step is reset
             bool use_tcp = false;
             int tcp_port = 4560;
 
@@ -388,6 +431,9 @@ namespace airlib
 
         std::string clock_type = "";
         float clock_speed = 1.0f;
+        float lock_step_quorum = 1.0f; //fraction of lock-stepped vehicles that must reply before physics advances
+        int image_cache_max_frame_age = 0; //frames a captured image is reused for identical requests, -1 disables sharing captures
+        float debug_draw_rate = 0; //times per second lidar points and traces are redrawn, 0 for every frame
         bool engine_sound = false;
         bool log_messages_visible = true;
         bool show_los_debug_lines_ = false;
@@ -400,9 +446,16 @@ namespace airlib
         std::string speed_unit_label = "m\\s";
         std::map<std::string, std::shared_ptr<SensorSetting>> sensor_defaults;
         Vector3r wind = Vector3r::Zero();
+        std::vector<TerrainTileSetting> terrain_tiles;
+        CpuImageCaptureSetting cpu_image_capture;
+        float environment_tolerance = 0.1f; //meters a vehicle climbs or descends before its air is recomputed
 
         std::string settings_text_ = "";
 
+        //milliseconds spent parsing settings text and in each stage of the last load(), for diagnosing slow startup
+        double parse_milliseconds = 0;
+        std::vector<std::pair<std::string, double>> load_timings;
+
     public: //methods
         static AirSimSettings& singleton()
         {
@@ -421,32 +474,60 @@ namespace airlib
         {
             warning_messages.clear();
             error_messages.clear();
+            load_timings.clear();
+            common_utils::Timer timer;
+            timer.start();
+
             const Settings& settings_json = Settings::singleton();
             checkSettingsVersion(settings_json);
 
             loadCoreSimModeSettings(settings_json, simmode_getter);
             loadLevelSettings(settings_json);
+            recordLoadTiming("Core", timer);
             loadDefaultCameraSetting(settings_json, camera_defaults);
             loadCameraDirectorSetting(settings_json, camera_director, simmode_name);
             loadSubWindowsSettings(settings_json, subwindow_settings);
             loadViewModeSettings(settings_json);
+            recordLoadTiming("Cameras", timer);
             loadSegmentationSetting(settings_json, segmentation_setting);
             loadPawnPaths(settings_json, pawn_paths);
             loadOtherSettings(settings_json);
+            recordLoadTiming("Other", timer);
             loadDefaultSensorSettings(simmode_name, settings_json, sensor_defaults);
+            recordLoadTiming("DefaultSensors", timer);
             loadVehicleSettings(simmode_name, settings_json, vehicles, sensor_defaults);
+            recordLoadTiming("Vehicles", timer);
 
             //this should be done last because it depends on vehicles (and/or their type) we have
             loadRecordingSetting(settings_json);
             loadClockSettings(settings_json);
+            recordLoadTiming("Recording+Clock", timer);
+        }
+
+        std::string getLoadTimingReport() const
+        {
+            double total = parse_milliseconds;
+            std::stringstream ss;
+            ss << std::fixed << std::setprecision(2) << "Parse=" << parse_milliseconds << "ms";
+            for (const auto& stage : load_timings) {
+                ss << " " << stage.first << "=" << stage.second << "ms";
+                total += stage.second;
+            }
+            ss << " Total=" << total << "ms";
+            return ss.str();
         }
 
         static void initializeSettings(const std::string& json_settings_text)
         {
+            common_utils::Timer timer;
+            timer.start();
+
             singleton().settings_text_ = json_settings_text;
             Settings& settings_json = Settings::loadJSonString(json_settings_text);
             if (!settings_json.isLoadSuccess())
                 throw std::invalid_argument("Cannot parse JSON settings_json string.");
+
+            singleton().parse_milliseconds = timer.milliseconds();
         }
 
         static void createDefaultSettingsFile()
@@ -502,6 +583,12 @@ namespace airlib
         }
 
     private:
+        void recordLoadTiming(const std::string& stage, common_utils::Timer& timer)
+        {
+            load_timings.emplace_back(stage, timer.milliseconds());
+            timer.start();
+        }
+
         void checkSettingsVersion(const Settings& settings_json)
         {
             bool has_default_settings = hasDefaultSettings(settings_json, settings_version_actual);
@@ -638,6 +725,23 @@ namespace airlib
             }
         }
 
+        static void loadSafetySetting(const Settings& settings_json, SafetySetting& safety_setting)
+        {
+            Settings safety_json;
+            if (settings_json.getChild("Safety", safety_json)) {
+                safety_setting.enabled = safety_json.getBool("Enabled", safety_setting.enabled);
+                safety_setting.obs_clearance = safety_json.getFloat("ObsClearance", safety_setting.obs_clearance);
+
+                safety_setting.occupancy_map = safety_json.getBool("OccupancyMap", safety_setting.occupancy_map);
+                safety_setting.occupancy_resolution = safety_json.getFloat("OccupancyResolution", safety_setting.occupancy_resolution);
+                safety_setting.occupancy_max_range = safety_json.getFloat("OccupancyMaxRange", safety_setting.occupancy_max_range);
+                safety_setting.occupancy_cone_half_angle = safety_json.getFloat("OccupancyConeHalfAngle", safety_setting.occupancy_cone_half_angle);
+
+                safety_setting.check_terrain = safety_json.getBool("CheckTerrain", safety_setting.check_terrain);
+                safety_setting.terrain_clearance = safety_json.getFloat("TerrainClearance", safety_setting.terrain_clearance);
+            }
+        }
+
         static std::string getCameraName(const Settings& settings_json)
         {
             return settings_json.getString("CameraName",
@@ -768,6 +872,7 @@ namespace airlib
             connection_info.udp_port = settings_json.getInt("UdpPort", connection_info.udp_port);
             connection_info.use_tcp = settings_json.getBool("UseTcp", connection_info.use_tcp);
             connection_info.lock_step = settings_json.getBool("LockStep", connection_info.lock_step);
+            connection_info.lock_step_timeout = settings_json.getFloat("LockStepTimeout", connection_info.lock_step_timeout);
             connection_info.tcp_port = settings_json.getInt("TcpPort", connection_info.tcp_port);
             connection_info.serial_port = settings_json.getString("SerialPort", connection_info.serial_port);
             connection_info.baud_rate = settings_json.getInt("SerialBaudRate", connection_info.baud_rate);
@@ -812,6 +917,7 @@ namespace airlib
             //optional settings_json
             vehicle_setting->pawn_path = settings_json.getString("PawnPath", "");
             vehicle_setting->default_vehicle_state = settings_json.getString("DefaultVehicleState", "");
+            vehicle_setting->state_estimator = settings_json.getString("StateEstimator", "");
             vehicle_setting->allow_api_always = settings_json.getBool("AllowAPIAlways",
                                                                       vehicle_setting->allow_api_always);
             vehicle_setting->auto_create = settings_json.getBool("AutoCreate",
@@ -826,6 +932,7 @@ namespace airlib
                                                                     vehicle_setting->is_fpv_vehicle);
 
             loadRCSetting(simmode_name, settings_json, vehicle_setting->rc);
+            loadSafetySetting(settings_json, vehicle_setting->safety);
 
             vehicle_setting->position = createVectorSetting(settings_json, vehicle_setting->position);
             vehicle_setting->rotation = createRotationSetting(settings_json, vehicle_setting->rotation);
@@ -1134,6 +1241,9 @@ namespace airlib
             speed_unit_label = settings_json.getString("SpeedUnitLabel", "m\\s");
             log_messages_visible = settings_json.getBool("LogMessagesVisible", true);
             show_los_debug_lines_ = settings_json.getBool("ShowLosDebugLines", false);
+            lock_step_quorum = settings_json.getFloat("LockStepQuorum", lock_step_quorum);
+            image_cache_max_frame_age = settings_json.getInt("ImageCacheMaxFrameAge", image_cache_max_frame_age);
+            debug_draw_rate = settings_json.getFloat("DebugDrawRate", debug_draw_rate);
 
             { //load origin geopoint
                 Settings origin_geopoint_json;
@@ -1165,6 +1275,57 @@ namespace airlib
                     wind = createVectorSetting(child_json, wind);
                 }
             }
+
+            loadTerrainSettings(settings_json, terrain_tiles);
+
+            {
+                Settings child_json;
+                if (settings_json.getChild("CpuImageCapture", child_json)) {
+                    cpu_image_capture.enabled = child_json.getBool("Enabled", cpu_image_capture.enabled);
+                    cpu_image_capture.thread_count = static_cast<uint>(child_json.getInt("ThreadCount", cpu_image_capture.thread_count));
+                    cpu_image_capture.segmentation_palette = child_json.getString("SegmentationPalette", cpu_image_capture.segmentation_palette);
+                }
+            }
+            environment_tolerance = settings_json.getFloat("EnvironmentTolerance", environment_tolerance);
+        }
+
+        static void loadTerrainSettings(const Settings& settings_json, std::vector<TerrainTileSetting>& terrain_tiles)
+        {
+            terrain_tiles.clear();
+
+            Settings terrain_json, tiles_json;
+            if (settings_json.getChild("Terrain", terrain_json) && terrain_json.getChild("Tiles", tiles_json)) {
+                for (size_t child_index = 0; child_index < tiles_json.size(); ++child_index) {
+                    Settings tile_json;
+                    if (tiles_json.getChild(child_index, tile_json)) {
+                        TerrainTileSetting tile;
+                        tile.file_path = tile_json.getString("FilePath", "");
+
+                        TerrainModel::RawTileFormat& format = tile.raw_format;
+                        format.columns = tile_json.getInt("Columns", 0);
+                        format.rows = tile_json.getInt("Rows", 0);
+                        const std::string sample_type = tile_json.getString("SampleType", "Int16");
+                        if (sample_type == "Int16")
+                            format.sample_type = TerrainModel::SampleType::Int16;
+                        else if (sample_type == "UInt16")
+                            format.sample_type = TerrainModel::SampleType::UInt16;
+                        else if (sample_type == "Float32")
+                            format.sample_type = TerrainModel::SampleType::Float32;
+                        else
+                            throw std::invalid_argument(std::string("SampleType of a terrain tile must be Int16, UInt16 or Float32, not ") + sample_type);
+                        format.north = tile_json.getDouble("North", format.north);
+                        format.west = tile_json.getDouble("West", format.west);
+                        format.latitude_spacing = tile_json.getDouble("LatitudeSpacing", format.latitude_spacing);
+                        format.longitude_spacing = tile_json.getDouble("LongitudeSpacing", format.longitude_spacing);
+                        format.height_scale = tile_json.getFloat("HeightScale", format.height_scale);
+                        format.height_offset = tile_json.getFloat("HeightOffset", format.height_offset);
+                        format.has_no_data = tile_json.hasKey("NoData");
+                        format.no_data = tile_json.getDouble("NoData", format.no_data);
+
+                        terrain_tiles.push_back(tile);
+                    }
+                }
+            }
         }
 
         static void loadDefaultCameraSetting(const Settings& settings_json, CameraSetting& camera_defaults)
@@ -6,6 +6,8 @@
 
 #include <thread>
 #include <chrono>
+#include <cmath>
+#include <cstdint>
 #include "Common.hpp"
 
 namespace msr
@@ -26,26 +28,53 @@ namespace airlib
             wall_clock_start_ = Utils::getTimeSinceEpochNanos();
         }
 
+        /*
+        Time of the step being updated on this thread, i.e. inside World::update(). The clock is
+        read once per step and every object updated in it sees the same time, so dt computed from
+        it is the same for all of them. Outside a step this is nowNanos().
+        */
+        TTimePoint stepNanos() const
+        {
+            const TTimePoint step_time = stepTime();
+            return step_time != 0 ? step_time : nowNanos();
+        }
+
         TTimeDelta elapsedSince(TTimePoint since) const
         {
             return elapsedBetween(nowNanos(), since);
         }
         static TTimeDelta elapsedBetween(TTimePoint second, TTimePoint first)
         {
-            return (second - first) / 1.0E9;
+            return toSeconds(elapsedNanosBetween(second, first));
+        }
+        //negative if second is before first
+        static int64_t elapsedNanosBetween(TTimePoint second, TTimePoint first)
+        {
+            return static_cast<int64_t>(second - first);
         }
-        TTimePoint addTo(TTimePoint t, TTimeDelta dt)
+        static TTimePoint addTo(TTimePoint t, TTimeDelta dt)
         {
-            return static_cast<TTimePoint>(t + dt * 1.0E9);
+            return t + static_cast<TTimePoint>(toNanos(dt));
         }
+        //seconds since the last call, as of the current step
         TTimeDelta updateSince(TTimePoint& since) const
         {
-            TTimePoint cur = nowNanos();
+            TTimePoint cur = stepNanos();
             TTimeDelta elapsed = elapsedBetween(cur, since);
             since = cur;
             return elapsed;
         }
 
+        //rounded, so steps given as floats like 20E-3f come out whole
+        static int64_t toNanos(TTimeDelta seconds)
+        {
+            return std::llround(seconds * 1.0E9);
+        }
+        static TTimeDelta toSeconds(int64_t nanos)
+        {
+            return static_cast<TTimeDelta>(nanos) * 1.0E-9;
+        }
+
         virtual TTimePoint step()
         {
             //by default step doesn't do anything
@@ -56,6 +85,28 @@ namespace airlib
             return nowNanos();
         }
 
+        //steps the clock and makes the new time this thread's stepNanos() until destroyed,
+        //then gives back the step time of an enclosing scope, if any
+        class StepScope
+        {
+        public:
+            StepScope(ClockBase* clock)
+                : outer_step_time_(stepTime())
+            {
+                stepTime() = clock->step();
+            }
+            ~StepScope()
+            {
+                stepTime() = outer_step_time_;
+            }
+
+            StepScope(const StepScope&) = delete;
+            StepScope& operator=(const StepScope&) = delete;
+
+        private:
+            const TTimePoint outer_step_time_;
+        };
+
         uint64_t getStepCount() const
         {
             return step_count_;
@@ -88,6 +139,12 @@ namespace airlib
         template <typename T>
         using duration = std::chrono::duration<T>;
 
+        static TTimePoint& stepTime()
+        {
+            static thread_local TTimePoint step_time = 0;
+            return step_time;
+        }
+
         uint64_t step_count_ = 0;
         TTimePoint wall_clock_start_;
     };
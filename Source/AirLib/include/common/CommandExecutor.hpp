@@ -0,0 +1,379 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef air_CommandExecutor_hpp
+#define air_CommandExecutor_hpp
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "common/Common.hpp"
+#include "common/ClockFactory.hpp"
+#include "common/CancelToken.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    /*
+    Runs a vehicle command as a step function called from the vehicle's update, i.e. on the physics
+    tick, instead of a loop on the calling thread that sleeps between commands. Steps are spaced
+    at least the command period apart and the task ends when the step says so, on timeout or on
+    cancel. Timed tasks, like move for a duration, complete on timeout instead.
+
+    A command called through start() doesn't wait for its task at all: the task is only submitted
+    and start() returns an id right away, which is polled with isDone() and getResult(). Nothing
+    waits for the command meanwhile, so any number of vehicles can run commands without holding
+    a thread each. Only the last wait of a command, runCommand(), is handed over like this. Other
+    waits, e.g. the ones a command does before it starts moving, block as with run().
+
+    One task runs at a time: submitting a task cancels the one running. A task is never stepped
+    again once it ended, so steps run by run() may refer to the caller's locals. Steps of tasks
+    submitted from start() outlive the command call and must own what they use.
+
+    If update isn't being called, e.g. the vehicle isn't attached to a physics engine, run()
+    steps the task from the waiting thread and start() waits like run() so commands still complete.
+    */
+    class CommandExecutor
+    {
+    public:
+        enum class StepResult
+        {
+            Running,
+            Complete,
+            Failed
+        };
+        typedef std::function<StepResult()> StepFunction;
+        typedef std::function<bool()> CommandFunction;
+        typedef uint64_t CommandId;
+
+        class Result
+        {
+        public:
+            enum class Status
+            {
+                Complete,
+                Failed,
+                Timeout,
+                Cancelled
+            };
+
+            Result(Status status = Status::Cancelled)
+                : status_(status)
+            {
+            }
+
+            Status getStatus() const
+            {
+                return status_;
+            }
+            bool isComplete() const
+            {
+                return status_ == Status::Complete;
+            }
+            bool isTimeout() const
+            {
+                return status_ == Status::Timeout;
+            }
+            bool isCancelled() const
+            {
+                return status_ == Status::Cancelled;
+            }
+
+        private:
+            Status status_;
+        };
+
+    public:
+        std::future<Result> submit(StepFunction step, TTimeDelta period, TTimeDelta timeout_sec, CancelToken& token, bool is_timed = false)
+        {
+            std::lock_guard<std::recursive_mutex> lock(mutex_);
+            submitTask(std::move(step), period, timeout_sec, token, is_timed);
+            return task_->promise.get_future();
+        }
+
+        //submits the task and waits for its outcome
+        Result run(StepFunction step, TTimeDelta period, TTimeDelta timeout_sec, CancelToken& token, bool is_timed = false)
+        {
+            auto future = submit(std::move(step), period, timeout_sec, token, is_timed);
+
+            const auto step_wait = std::chrono::duration<double>(std::max<TTimeDelta>(period, 0));
+            while (true) {
+                const bool is_driven = isDriven();
+                if (!is_driven)
+                    stepTask();
+                if (future.wait_for(is_driven ? kDriverCheckInterval : step_wait) == std::future_status::ready)
+                    break;
+            }
+            return future.get();
+        }
+
+        //the last wait of a command: within start() this submits the task and returns false right
+        //away, the outcome is then polled with the id start() returns. Otherwise same as run().
+        bool runCommand(StepFunction step, TTimeDelta period, TTimeDelta timeout_sec, CancelToken& token, bool is_timed = false)
+        {
+            StartScope& scope = startScope();
+            if (scope.executor != this || !isDriven())
+                return run(std::move(step), period, timeout_sec, token, is_timed).isComplete();
+
+            std::lock_guard<std::recursive_mutex> lock(mutex_);
+            scope.id = submitTask(std::move(step), period, timeout_sec, token, is_timed);
+            return false;
+        }
+
+        //calls command without waiting for the task its runCommand() submits. Returns the id to poll,
+        //commands that end without submitting a task, e.g. on invalid arguments, are done right away.
+        CommandId start(const CommandFunction& command)
+        {
+            if (isInStep())
+                throw std::logic_error("Vehicle command can't be started from within another command's step");
+
+            StartScope& scope = startScope();
+            const StartScope outer = scope;
+            scope = StartScope{ this, 0 };
+            bool result;
+            try {
+                result = command();
+            }
+            catch (...) {
+                scope = outer;
+                throw;
+            }
+            const CommandId id = scope.id;
+            scope = outer;
+            if (id != 0)
+                return id;
+
+            std::lock_guard<std::recursive_mutex> lock(mutex_);
+            const CommandId done_id = ++last_id_;
+            addOutcome(done_id, result ? Result::Status::Complete : Result::Status::Failed, nullptr);
+            return done_id;
+        }
+
+        bool isDone(CommandId id)
+        {
+            std::lock_guard<std::recursive_mutex> lock(mutex_);
+            if (task_ != nullptr && task_->id == id)
+                return false;
+            findOutcome(id);
+            return true;
+        }
+
+        //true if the command completed, rethrows the exception a step threw
+        bool getResult(CommandId id)
+        {
+            std::lock_guard<std::recursive_mutex> lock(mutex_);
+            if (task_ != nullptr && task_->id == id)
+                throw std::logic_error(Utils::stringf("Vehicle command %llu is still running", static_cast<unsigned long long>(id)));
+            const Outcome& outcome = findOutcome(id);
+            if (outcome.error != nullptr)
+                std::rethrow_exception(outcome.error);
+            return outcome.status == Result::Status::Complete;
+        }
+
+        //calls action once the task submitted by this thread's start() ends, or right away if there is no
+        //such task, e.g. outside start() or when the task already ended
+        void afterCommand(const std::function<void()>& action)
+        {
+            {
+                std::lock_guard<std::recursive_mutex> lock(mutex_);
+                const StartScope& scope = startScope();
+                if (scope.executor == this && task_ != nullptr && task_->id == scope.id) {
+                    task_->finish_actions.push_back(action);
+                    return;
+                }
+            }
+            action();
+        }
+
+        //steps the running task if it's due, call from the vehicle's update
+        void update()
+        {
+            last_update_ = std::chrono::steady_clock::now().time_since_epoch().count();
+            stepTask();
+        }
+
+        //ends the running task, if any, as cancelled
+        void cancel()
+        {
+            std::lock_guard<std::recursive_mutex> lock(mutex_);
+            finish(Result::Status::Cancelled);
+        }
+
+    private:
+        struct Task
+        {
+            CommandId id;
+            StepFunction step;
+            TTimeDelta period;
+            TTimeDelta timeout_sec;
+            CancelToken& token;
+            bool is_timed;
+            TTimePoint start_time;
+            TTimePoint last_step_time = 0;
+            uint step_count = 0;
+            std::promise<Result> promise;
+            std::vector<std::function<void()>> finish_actions;
+
+            Task(CommandId id_val, StepFunction step_val, TTimeDelta period_val, TTimeDelta timeout_sec_val, CancelToken& token_val, bool is_timed_val)
+                : id(id_val), step(std::move(step_val)), period(period_val), timeout_sec(timeout_sec_val), token(token_val), is_timed(is_timed_val)
+            {
+                start_time = clock()->nowNanos();
+            }
+        };
+
+        struct Outcome
+        {
+            CommandId id;
+            Result::Status status;
+            std::exception_ptr error;
+        };
+
+        //the executor whose start() is running on this thread and the task that call submitted
+        struct StartScope
+        {
+            CommandExecutor* executor;
+            CommandId id;
+        };
+
+        //must hold mutex_
+        CommandId submitTask(StepFunction step, TTimeDelta period, TTimeDelta timeout_sec, CancelToken& token, bool is_timed)
+        {
+            //the step's thread would wait on itself
+            if (isInStep())
+                throw std::logic_error("Vehicle command can't be started from within another command's step");
+
+            finish(Result::Status::Cancelled);
+
+            task_.reset(new Task(++last_id_, std::move(step), period, timeout_sec, token, is_timed));
+            const CommandId id = task_->id;
+            if (timeout_sec <= 0)
+                finish(is_timed ? Result::Status::Complete : Result::Status::Timeout);
+            return id;
+        }
+
+        void stepTask()
+        {
+            std::lock_guard<std::recursive_mutex> lock(mutex_);
+            if (task_ == nullptr)
+                return;
+
+            if (task_->token.isCancelled()) {
+                finish(Result::Status::Cancelled);
+                return;
+            }
+            //like Waiter, the first step always runs
+            if (task_->step_count > 0 && clock()->elapsedSince(task_->start_time) >= task_->timeout_sec) {
+                finish(task_->is_timed ? Result::Status::Complete : Result::Status::Timeout);
+                return;
+            }
+            if (task_->step_count > 0 && clock()->elapsedSince(task_->last_step_time) < task_->period)
+                return;
+
+            task_->last_step_time = clock()->nowNanos();
+            ++task_->step_count;
+
+            StepResult step_result;
+            isInStep() = true;
+            try {
+                step_result = task_->step();
+            }
+            catch (...) {
+                isInStep() = false;
+                finish(Result::Status::Failed, std::current_exception());
+                return;
+            }
+            isInStep() = false;
+
+            if (step_result == StepResult::Complete)
+                finish(Result::Status::Complete);
+            else if (step_result == StepResult::Failed)
+                finish(Result::Status::Failed);
+        }
+
+        //must hold mutex_
+        void finish(Result::Status status, std::exception_ptr error = nullptr)
+        {
+            if (task_ == nullptr)
+                return;
+
+            //the finish actions may call back into the executor
+            std::unique_ptr<Task> task = std::move(task_);
+            if (error != nullptr)
+                task->promise.set_exception(error);
+            else
+                task->promise.set_value(Result(status));
+            addOutcome(task->id, status, error);
+
+            for (const auto& action : task->finish_actions)
+                action();
+        }
+
+        //must hold mutex_
+        void addOutcome(CommandId id, Result::Status status, std::exception_ptr error)
+        {
+            outcomes_.push_back(Outcome{ id, status, error });
+            if (outcomes_.size() > kMaxOutcomes)
+                outcomes_.pop_front();
+        }
+
+        //must hold mutex_
+        const Outcome& findOutcome(CommandId id) const
+        {
+            for (const auto& outcome : outcomes_) {
+                if (outcome.id == id)
+                    return outcome;
+            }
+            throw std::invalid_argument(Utils::stringf("Vehicle command %llu is unknown or too old", static_cast<unsigned long long>(id)));
+        }
+
+        bool isDriven() const
+        {
+            const auto last_update = std::chrono::steady_clock::duration(last_update_);
+            return last_update.count() != 0 &&
+                   std::chrono::steady_clock::now().time_since_epoch() - last_update < kMaxUpdateGap;
+        }
+
+        static bool& isInStep()
+        {
+            static thread_local bool in_step = false;
+            return in_step;
+        }
+
+        static StartScope& startScope()
+        {
+            static thread_local StartScope scope{ nullptr, 0 };
+            return scope;
+        }
+
+        static ClockBase* clock()
+        {
+            return ClockFactory::get();
+        }
+
+    private:
+        //how long run() sleeps between checks that update is still being called
+        static constexpr std::chrono::milliseconds kDriverCheckInterval{ 100 };
+        //longer than this without an update and run() steps the task itself
+        static constexpr std::chrono::milliseconds kMaxUpdateGap{ 500 };
+        //outcomes kept for polling, only one task runs at a time so only the last few are ever asked for
+        static constexpr size_t kMaxOutcomes = 16;
+
+        std::recursive_mutex mutex_;
+        std::unique_ptr<Task> task_;
+        CommandId last_id_ = 0;
+        std::deque<Outcome> outcomes_;
+        std::atomic<std::chrono::steady_clock::rep> last_update_{ 0 };
+    };
+}
+} //namespace
+#endif
@@ -229,6 +229,23 @@ namespace airlib
         }
     };
 
+    struct ContactPoint
+    {
+        Vector3r normal = Vector3r::Zero();
+        Vector3r impact_point = Vector3r::Zero();
+        real_T penetration_depth = 0;
+        int material_id = -1;
+
+        ContactPoint()
+        {
+        }
+
+        ContactPoint(const Vector3r& normal_val, const Vector3r& impact_point_val, real_T penetration_depth_val, int material_id_val)
+            : normal(normal_val), impact_point(impact_point_val), penetration_depth(penetration_depth_val), material_id(material_id_val)
+        {
+        }
+    };
+
     struct CollisionInfo
     {
         bool has_collided = false;
@@ -240,6 +257,9 @@ namespace airlib
         unsigned int collision_count = 0;
         std::string object_name;
         int object_id = -1;
+        int material_id = -1;
+        //every point touching at the time of the latest hit, the fields above describe one of them
+        std::vector<ContactPoint> contacts;
 
         CollisionInfo()
         {
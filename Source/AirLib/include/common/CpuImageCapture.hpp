@@ -0,0 +1,260 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef air_CpuImageCapture_hpp
+#define air_CpuImageCapture_hpp
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include "common/Common.hpp"
+#include "common/ClockFactory.hpp"
+#include "common/ImageCaptureBase.hpp"
+#include "common/CpuRasterizer.hpp"
+#include "common/ImageEffects.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    /*
+    ImageCaptureBase that renders DepthPlanar, DepthPerspective and Segmentation images with
+    CpuRasterizer, so geometry-only image workloads can run headless without Unreal or a GPU.
+    Each view of a camera is rasterized at most once per getImages() call however many of these
+    image types are requested from it.
+
+    Responses are never compressed since no image codec is available here. Depth images are
+    meant to be requested with pixels_as_float, otherwise they come back as one byte per pixel
+    with the depth in meters clamped to 255. Segmentation is three bytes per pixel, the color
+    of the segmentation id in the same palette Unreal's segmentation material uses, so clients
+    decode ids the same way whichever capture made the image. Other image types return an error
+    message.
+
+    Cameras can have the noise and lens distortion APIPCamera puts on its captures applied with
+    ImageEffects, see setCameraEffects().
+    */
+    class CpuImageCapture : public ImageCaptureBase
+    {
+    public:
+        typedef std::array<uint8_t, 3> PaletteColor;
+        static constexpr size_t PaletteSize = 256;
+
+        //palette has the RGB color of each segmentation id, see loadSegmentationPalette().
+        //effects_thread_count is for the ImageEffects of each camera, 0 uses all hardware threads.
+        CpuImageCapture(std::shared_ptr<CpuRasterizer> rasterizer, const std::vector<PaletteColor>& palette, uint effects_thread_count = 0)
+            : rasterizer_(rasterizer), palette_(palette), effects_thread_count_(effects_thread_count)
+        {
+            if (palette_.size() != PaletteSize)
+                throw std::invalid_argument(Utils::stringf("Segmentation palette must have %u colors, not %u",
+                                                           static_cast<uint>(PaletteSize), static_cast<uint>(palette_.size())));
+        }
+
+        /*
+        Reads the palette from AirSim's seg_rgbs.txt, which lists the colors of
+        seg_color_palette.png one id per line as "id<tab>[r, g, b]". Throws std::invalid_argument
+        if the file can't be read or doesn't give a color for every id.
+        */
+        static std::vector<PaletteColor> loadSegmentationPalette(const std::string& file_path)
+        {
+            std::ifstream file(file_path);
+            if (!file)
+                throw std::invalid_argument("Cannot open segmentation palette " + file_path);
+
+            std::vector<PaletteColor> palette(PaletteSize);
+            std::vector<bool> is_set(PaletteSize, false);
+            std::string line;
+            while (std::getline(file, line)) {
+                for (char& c : line) {
+                    if (c == '[' || c == ']' || c == ',')
+                        c = ' ';
+                }
+
+                std::istringstream values(line);
+                int id, r, g, b;
+                if (!(values >> id >> r >> g >> b))
+                    continue;
+                if (id < 0 || id >= static_cast<int>(PaletteSize) || r < 0 || r > 255 || g < 0 || g > 255 || b < 0 || b > 255)
+                    throw std::invalid_argument("Bad segmentation palette line in " + file_path + ": " + line);
+
+                palette[id] = PaletteColor{ static_cast<uint8_t>(r), static_cast<uint8_t>(g), static_cast<uint8_t>(b) };
+                is_set[id] = true;
+            }
+
+            for (size_t id = 0; id < PaletteSize; ++id) {
+                if (!is_set[id])
+                    throw std::invalid_argument(Utils::stringf("Segmentation palette %s has no color for id %u", file_path.c_str(), static_cast<uint>(id)));
+            }
+            return palette;
+        }
+
+        //same view for every image type of the camera
+        void setCamera(const std::string& camera_name, const CpuRasterizer::Camera& camera)
+        {
+            for (ImageType image_type : { ImageType::DepthPlanar, ImageType::DepthPerspective, ImageType::Segmentation })
+                setCamera(camera_name, image_type, camera);
+        }
+
+        //view for one image type, like the per image type capture settings of a camera
+        void setCamera(const std::string& camera_name, ImageType image_type, const CpuRasterizer::Camera& camera)
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            cameras_[std::make_pair(camera_name, image_type)] = camera;
+        }
+
+        void setCameraPose(const std::string& camera_name, const Pose& pose)
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            for (auto& camera : cameras_) {
+                if (camera.first.first == camera_name)
+                    camera.second.pose = pose;
+            }
+        }
+
+        //noise keyed by image type like CameraSetting::noise_settings. The distortion is relative
+        //to the field of view of each image type's view, so its fov_degrees is not used.
+        void setCameraEffects(const std::string& camera_name, const std::map<int, AirSimSettings::NoiseSetting>& noise_settings,
+                              const ImageEffects::DistortionParams& distortion)
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+
+            bool has_noise = false;
+            for (const auto& noise : noise_settings)
+                has_noise |= noise.second.Enabled;
+            //cameras without effects don't keep a worker pool around
+            if (!has_noise && distortion.isIdentity()) {
+                effects_.erase(camera_name);
+                return;
+            }
+
+            CameraEffects& effects = effects_[camera_name];
+            if (effects.image_effects == nullptr)
+                effects.image_effects.reset(new ImageEffects(effects_thread_count_));
+            effects.image_effects->setNoiseSettings(noise_settings);
+            effects.distortion = distortion;
+            effects.image_effects->setDistortion(distortion);
+        }
+
+        static bool isSupported(ImageType image_type)
+        {
+            return image_type == ImageType::DepthPlanar || image_type == ImageType::DepthPerspective ||
+                   image_type == ImageType::Segmentation;
+        }
+
+        virtual void getImages(const std::vector<ImageRequest>& requests, std::vector<ImageResponse>& responses) const override
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+
+            //image types of a camera with the same view share one render
+            typedef std::pair<const CpuRasterizer::Camera*, CpuRasterizer::Frame> RenderedView;
+            std::vector<RenderedView> frames;
+            responses.clear();
+            for (const auto& request : requests) {
+                responses.emplace_back();
+                ImageResponse& response = responses.back();
+                response.camera_name = request.camera_name;
+                response.image_type = request.image_type;
+                response.pixels_as_float = request.pixels_as_float;
+                response.compress = false;
+
+                if (!isSupported(request.image_type)) {
+                    response.message = "Only DepthPlanar, DepthPerspective and Segmentation are supported by CPU capture";
+                    continue;
+                }
+                const auto camera = cameras_.find(std::make_pair(request.camera_name, request.image_type));
+                if (camera == cameras_.end()) {
+                    response.message = "Camera " + request.camera_name + " is not set up for CPU capture";
+                    continue;
+                }
+
+                auto frame = std::find_if(frames.begin(), frames.end(), [&](const RenderedView& rendered) {
+                    return isSameView(*rendered.first, camera->second);
+                });
+                if (frame == frames.end()) {
+                    frames.emplace_back(&camera->second, CpuRasterizer::Frame());
+                    frame = frames.end() - 1;
+                    rasterizer_->render(camera->second, frame->second);
+                }
+                const CpuRasterizer::Frame& image = frame->second;
+
+                response.camera_position = camera->second.pose.position;
+                response.camera_orientation = camera->second.pose.orientation;
+                response.time_stamp = ClockFactory::get()->nowNanos();
+                response.width = image.width;
+                response.height = image.height;
+
+                if (request.image_type == ImageType::Segmentation) {
+                    response.pixels_as_float = false;
+                    response.image_data_uint8.resize(image.segmentation.size() * 3);
+                    for (size_t i = 0; i < image.segmentation.size(); ++i) {
+                        //BGR like uncompressed Unreal captures
+                        const PaletteColor& color = palette_[image.segmentation[i]];
+                        response.image_data_uint8[3 * i] = color[2];
+                        response.image_data_uint8[3 * i + 1] = color[1];
+                        response.image_data_uint8[3 * i + 2] = color[0];
+                    }
+                }
+                else {
+                    vector<float>& depth = response.image_data_float;
+                    if (request.image_type == ImageType::DepthPlanar)
+                        depth = image.depth_planar;
+                    else
+                        image.getDepthPerspective(depth);
+
+                    if (!request.pixels_as_float) {
+                        response.image_data_uint8.resize(depth.size());
+                        for (size_t i = 0; i < depth.size(); ++i)
+                            response.image_data_uint8[i] = static_cast<uint8_t>(std::min(depth[i], 255.0f));
+                        depth.clear();
+                    }
+                }
+
+                applyEffects(camera->second, response);
+            }
+        }
+
+    private:
+        struct CameraEffects
+        {
+            std::unique_ptr<ImageEffects> image_effects;
+            ImageEffects::DistortionParams distortion;
+        };
+
+        void applyEffects(const CpuRasterizer::Camera& view, ImageResponse& response) const
+        {
+            const auto found = effects_.find(response.camera_name);
+            if (found == effects_.end())
+                return;
+
+            //the remap table is only rebuilt when the view's field of view changes
+            ImageEffects& image_effects = *found->second.image_effects;
+            if (image_effects.getDistortion().fov_degrees != view.fov_degrees) {
+                ImageEffects::DistortionParams distortion = found->second.distortion;
+                distortion.fov_degrees = view.fov_degrees;
+                image_effects.setDistortion(distortion);
+            }
+            image_effects.apply(response);
+        }
+
+        static bool isSameView(const CpuRasterizer::Camera& a, const CpuRasterizer::Camera& b)
+        {
+            return a.pose.position == b.pose.position && a.pose.orientation.coeffs() == b.pose.orientation.coeffs() &&
+                   a.fov_degrees == b.fov_degrees && a.width == b.width && a.height == b.height &&
+                   a.near_plane == b.near_plane && a.far_plane == b.far_plane;
+        }
+
+    private:
+        std::shared_ptr<CpuRasterizer> rasterizer_;
+        std::vector<PaletteColor> palette_;
+        std::map<std::pair<std::string, ImageType>, CpuRasterizer::Camera> cameras_;
+        uint effects_thread_count_;
+        //ImageEffects keeps scratch buffers and remap tables, so it changes while capturing
+        mutable std::map<std::string, CameraEffects> effects_;
+        mutable std::mutex mutex_;
+    };
+}
+} //namespace
+#endif
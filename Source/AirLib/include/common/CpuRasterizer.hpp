@@ -0,0 +1,430 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef air_CpuRasterizer_hpp
+#define air_CpuRasterizer_hpp
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <future>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include "common/Common.hpp"
+#include "common/CommonStructs.hpp"
+#include "common/VectorMath.hpp"
+#include "common/common_utils/ctpl_stl.h"
+
+namespace msr
+{
+namespace airlib
+{
+
+    /*
+    Depth and segmentation rasterizer that runs entirely on the CPU, for workloads that only
+    need geometry and have no GPU to run Unreal's render path on.
+
+    The scene is a flat list of triangles in world NED meters, each tagged with a segmentation
+    id. render() transforms and clips triangles against the near plane, bins them into
+    TileSize x TileSize screen tiles and then rasterizes tiles in parallel, each with its own
+    z-buffer so workers never share pixels. 1/depth is affine in screen space so it is
+    interpolated from a plane equation and depth-tested directly. The inner loop handles
+    Lanes pixels at a time with branch-free selects so the compiler can vectorize it for
+    whatever SIMD width the target has.
+    */
+    class CpuRasterizer
+    {
+    public: //types
+        static constexpr int TileSize = 32;
+        static constexpr int Lanes = 8;
+
+        struct Camera
+        {
+            Pose pose; //world NED, camera looks along its body x axis with z down like AirSim cameras
+            real_T fov_degrees = 90; //horizontal
+            int width = 256, height = 144;
+            real_T near_plane = 0.1f;
+            real_T far_plane = 1000;
+        };
+
+        struct Frame
+        {
+            int width = 0, height = 0;
+            real_T focal_length = 0; //pixels
+            real_T far_plane = 0;
+            vector<float> depth_planar; //meters along camera x axis, far_plane where nothing was hit
+            vector<uint8_t> segmentation; //segmentation id per pixel, background_id where nothing was hit
+
+            //euclidean distance from the camera center instead of distance along the optical axis
+            void getDepthPerspective(vector<float>& depth_perspective) const
+            {
+                depth_perspective.resize(depth_planar.size());
+                const real_T cx = width / 2.0f, cy = height / 2.0f;
+                for (int v = 0; v < height; ++v) {
+                    real_T dv = (v + 0.5f - cy) / focal_length;
+                    for (int u = 0; u < width; ++u) {
+                        real_T du = (u + 0.5f - cx) / focal_length;
+                        size_t index = static_cast<size_t>(v) * width + u;
+                        float depth = depth_planar[index];
+                        depth_perspective[index] = depth >= far_plane ? depth : depth * std::sqrt(1 + du * du + dv * dv);
+                    }
+                }
+            }
+        };
+
+    public: //methods
+        //thread_count of 0 uses all hardware threads
+        explicit CpuRasterizer(uint thread_count = 0)
+        {
+            if (thread_count == 0)
+                thread_count = std::max(1u, std::thread::hardware_concurrency());
+            threads_.resize(static_cast<int>(thread_count));
+        }
+
+        void clear()
+        {
+            triangles_.clear();
+        }
+
+        size_t getTriangleCount() const
+        {
+            return triangles_.size();
+        }
+
+        void setBackgroundId(uint8_t id)
+        {
+            background_id_ = id;
+        }
+
+        //vertices are x, y, z triples in world NED meters, indices are triangle lists
+        void addMesh(const vector<float>& vertices, const vector<uint32_t>& indices, uint8_t segmentation_id)
+        {
+            const size_t vertex_count = vertices.size() / 3;
+            for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+                if (indices[i] >= vertex_count || indices[i + 1] >= vertex_count || indices[i + 2] >= vertex_count)
+                    continue;
+
+                Triangle triangle;
+                for (uint corner = 0; corner < 3; ++corner) {
+                    const float* vertex = &vertices[3 * indices[i + corner]];
+                    triangle.vertices[corner] = Vector3r(vertex[0], vertex[1], vertex[2]);
+                }
+                triangle.segmentation_id = segmentation_id;
+                triangles_.push_back(triangle);
+            }
+        }
+
+        //mesh as returned by simGetMeshPositionVertexBuffers: Unreal world coordinates in cm.
+        //ned_origin is the Unreal location of the NED origin (usually the player start).
+        void addUnrealMesh(const MeshPositionVertexBuffersResponse& mesh, uint8_t segmentation_id,
+                           const Vector3r& ned_origin = Vector3r::Zero())
+        {
+            vector<float> vertices(mesh.vertices.size());
+            for (size_t i = 0; i + 2 < mesh.vertices.size(); i += 3) {
+                vertices[i] = (mesh.vertices[i] - ned_origin.x()) / 100.0f;
+                vertices[i + 1] = (mesh.vertices[i + 1] - ned_origin.y()) / 100.0f;
+                vertices[i + 2] = -(mesh.vertices[i + 2] - ned_origin.z()) / 100.0f;
+            }
+            addMesh(vertices, mesh.indices, segmentation_id);
+        }
+
+        //Wavefront OBJ with vertices already in NED meters, only v and f records are used.
+        //Faces with more than three vertices are fanned into triangles.
+        bool loadObj(const std::string& file_path, uint8_t segmentation_id)
+        {
+            std::ifstream file(file_path);
+            if (!file.is_open())
+                return false;
+
+            vector<float> vertices;
+            vector<uint32_t> indices;
+            std::string line;
+            while (std::getline(file, line)) {
+                std::istringstream record(line);
+                std::string type;
+                record >> type;
+                if (type == "v") {
+                    float x = 0, y = 0, z = 0;
+                    record >> x >> y >> z;
+                    vertices.insert(vertices.end(), { x, y, z });
+                }
+                else if (type == "f") {
+                    vector<uint32_t> face;
+                    std::string corner;
+                    while (record >> corner) {
+                        //v, v/vt, v//vn or v/vt/vn, negative indices are relative to the end
+                        long index = std::strtol(corner.c_str(), nullptr, 10);
+                        if (index < 0)
+                            index += static_cast<long>(vertices.size() / 3) + 1;
+                        if (index > 0)
+                            face.push_back(static_cast<uint32_t>(index - 1));
+                    }
+                    for (size_t i = 2; i < face.size(); ++i)
+                        indices.insert(indices.end(), { face[0], face[i - 1], face[i] });
+                }
+            }
+
+            addMesh(vertices, indices, segmentation_id);
+            return true;
+        }
+
+        //calls are serialized since the worker pool and bins are shared between them, so one
+        //scene can be rendered from the cameras of several vehicles
+        void render(const Camera& camera, Frame& frame)
+        {
+            std::lock_guard<std::mutex> guard(render_mutex_);
+
+            frame.width = camera.width;
+            frame.height = camera.height;
+            frame.far_plane = camera.far_plane;
+            frame.focal_length = camera.width / (2 * std::tan(Utils::degreesToRadians(camera.fov_degrees) / 2));
+            frame.depth_planar.assign(static_cast<size_t>(camera.width) * camera.height, camera.far_plane);
+            frame.segmentation.assign(static_cast<size_t>(camera.width) * camera.height, background_id_);
+            if (camera.width <= 0 || camera.height <= 0)
+                return;
+
+            tiles_x_ = (camera.width + TileSize - 1) / TileSize;
+            tiles_y_ = (camera.height + TileSize - 1) / TileSize;
+
+            //each worker projects and bins its own slice of the scene, so no locks are needed
+            const uint chunk_count = static_cast<uint>(threads_.size());
+            chunks_.resize(chunk_count);
+            runParallel(chunk_count, [&](uint chunk) {
+                size_t begin = triangles_.size() * chunk / chunk_count;
+                size_t end = triangles_.size() * (chunk + 1) / chunk_count;
+                setupChunk(camera, frame, begin, end, chunks_[chunk]);
+            });
+
+            runParallel(static_cast<uint>(tiles_x_ * tiles_y_), [&](uint tile) {
+                rasterizeTile(tile, camera, frame);
+            });
+        }
+
+    private: //types
+        struct Triangle
+        {
+            EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+            Vector3r vertices[3];
+            uint8_t segmentation_id;
+        };
+
+        //edge functions E(u, v) = a*u + b*v + c are >= 0 inside, inv_depth is 1/depth as a plane in screen space
+        struct ScreenTriangle
+        {
+            float edge_a[3], edge_b[3], edge_c[3];
+            float inv_depth_a, inv_depth_b, inv_depth_c;
+            int min_x, min_y, max_x, max_y;
+            uint8_t segmentation_id;
+        };
+
+        struct Chunk
+        {
+            vector<ScreenTriangle> triangles;
+            vector<vector<uint>> bins; //per tile, indices into triangles
+        };
+
+    private: //methods
+        template <typename TFunc>
+        void runParallel(uint count, const TFunc& func)
+        {
+            std::atomic<uint> next{ 0 };
+            vector<std::future<void>> workers;
+            const uint worker_count = std::min(count, static_cast<uint>(threads_.size()));
+            for (uint i = 0; i < worker_count; ++i) {
+                workers.push_back(threads_.push([&](int) {
+                    for (uint item = next++; item < count; item = next++)
+                        func(item);
+                }));
+            }
+            for (auto& worker : workers)
+                worker.get();
+        }
+
+        void setupChunk(const Camera& camera, const Frame& frame, size_t begin, size_t end, Chunk& chunk) const
+        {
+            chunk.triangles.clear();
+            chunk.bins.resize(static_cast<size_t>(tiles_x_) * tiles_y_);
+            for (auto& bin : chunk.bins)
+                bin.clear();
+
+            //world to camera rotation once instead of a quaternion product per vertex
+            const Matrix3x3r world_to_camera = camera.pose.orientation.toRotationMatrix().transpose();
+
+            for (size_t i = begin; i < end; ++i) {
+                const Triangle& triangle = triangles_[i];
+
+                Vector3r view[3];
+                for (uint corner = 0; corner < 3; ++corner)
+                    view[corner] = world_to_camera * (triangle.vertices[corner] - camera.pose.position);
+
+                if (view[0].x() > camera.far_plane && view[1].x() > camera.far_plane && view[2].x() > camera.far_plane)
+                    continue;
+
+                //clip against the near plane, which leaves at most a quad
+                Vector3r clipped[4];
+                uint clipped_count = 0;
+                for (uint corner = 0; corner < 3; ++corner) {
+                    const Vector3r& current = view[corner];
+                    const Vector3r& next = view[(corner + 1) % 3];
+                    bool current_in = current.x() >= camera.near_plane;
+                    bool next_in = next.x() >= camera.near_plane;
+                    if (current_in)
+                        clipped[clipped_count++] = current;
+                    if (current_in != next_in) {
+                        real_T t = (camera.near_plane - current.x()) / (next.x() - current.x());
+                        clipped[clipped_count++] = current + t * (next - current);
+                    }
+                }
+
+                for (uint fan = 2; fan < clipped_count; ++fan)
+                    addScreenTriangle(clipped[0], clipped[fan - 1], clipped[fan], triangle.segmentation_id, frame, chunk);
+            }
+        }
+
+        void addScreenTriangle(const Vector3r& p0, const Vector3r& p1, const Vector3r& p2, uint8_t segmentation_id,
+                               const Frame& frame, Chunk& chunk) const
+        {
+            const float cx = frame.width / 2.0f, cy = frame.height / 2.0f, f = frame.focal_length;
+            const Vector3r* points[3] = { &p0, &p1, &p2 };
+            float u[3], v[3], inv_depth[3];
+            for (uint corner = 0; corner < 3; ++corner) {
+                inv_depth[corner] = 1.0f / points[corner]->x();
+                u[corner] = cx + f * points[corner]->y() * inv_depth[corner];
+                v[corner] = cy + f * points[corner]->z() * inv_depth[corner];
+            }
+
+            float area = (u[1] - u[0]) * (v[2] - v[0]) - (u[2] - u[0]) * (v[1] - v[0]);
+            if (std::abs(area) < 1E-12f)
+                return;
+
+            ScreenTriangle screen;
+            screen.min_x = std::max(0, static_cast<int>(std::floor(std::min({ u[0], u[1], u[2] }))));
+            screen.min_y = std::max(0, static_cast<int>(std::floor(std::min({ v[0], v[1], v[2] }))));
+            screen.max_x = std::min(frame.width - 1, static_cast<int>(std::ceil(std::max({ u[0], u[1], u[2] }))));
+            screen.max_y = std::min(frame.height - 1, static_cast<int>(std::ceil(std::max({ v[0], v[1], v[2] }))));
+            if (screen.min_x > screen.max_x || screen.min_y > screen.max_y)
+                return;
+
+            //orient edges so inside is positive whatever the winding, we don't cull back faces
+            const float sign = area > 0 ? 1.0f : -1.0f;
+            for (uint edge = 0; edge < 3; ++edge) {
+                uint a = (edge + 1) % 3, b = (edge + 2) % 3;
+                screen.edge_a[edge] = sign * (v[a] - v[b]);
+                screen.edge_b[edge] = sign * (u[b] - u[a]);
+                screen.edge_c[edge] = sign * (u[a] * v[b] - u[b] * v[a]);
+            }
+
+            //barycentric weights are edge / area, so the inv_depth plane falls out of the edge equations
+            const float inv_area = sign / area;
+            screen.inv_depth_a = screen.inv_depth_b = screen.inv_depth_c = 0;
+            for (uint edge = 0; edge < 3; ++edge) {
+                float weight = inv_depth[edge] * inv_area;
+                screen.inv_depth_a += screen.edge_a[edge] * weight;
+                screen.inv_depth_b += screen.edge_b[edge] * weight;
+                screen.inv_depth_c += screen.edge_c[edge] * weight;
+            }
+            screen.segmentation_id = segmentation_id;
+
+            const uint index = static_cast<uint>(chunk.triangles.size());
+            chunk.triangles.push_back(screen);
+            for (int tile_y = screen.min_y / TileSize; tile_y <= screen.max_y / TileSize; ++tile_y)
+                for (int tile_x = screen.min_x / TileSize; tile_x <= screen.max_x / TileSize; ++tile_x)
+                    chunk.bins[static_cast<size_t>(tile_y) * tiles_x_ + tile_x].push_back(index);
+        }
+
+        void rasterizeTile(uint tile, const Camera& camera, Frame& frame) const
+        {
+            const int tile_x0 = static_cast<int>(tile % tiles_x_) * TileSize;
+            const int tile_y0 = static_cast<int>(tile / tiles_x_) * TileSize;
+            const int tile_x1 = std::min(tile_x0 + TileSize, frame.width);
+            const int tile_y1 = std::min(tile_y0 + TileSize, frame.height);
+
+            //TileSize is a multiple of Lanes so lane groups never straddle tiles
+            alignas(32) float z_buffer[TileSize * TileSize];
+            alignas(32) uint8_t id_buffer[TileSize * TileSize];
+            std::fill(z_buffer, z_buffer + TileSize * TileSize, 1.0f / camera.far_plane);
+            std::fill(id_buffer, id_buffer + TileSize * TileSize, background_id_);
+            const float max_inv_depth = 1.0f / camera.near_plane;
+
+            for (const Chunk& chunk : chunks_) {
+                for (uint index : chunk.bins[tile]) {
+                    const ScreenTriangle& t = chunk.triangles[index];
+                    const int y_begin = std::max(t.min_y, tile_y0), y_end = std::min(t.max_y + 1, tile_y1);
+                    const int x_begin = std::max(t.min_x, tile_x0) / Lanes * Lanes, x_end = std::min(t.max_x + 1, tile_x1);
+
+                    for (int y = y_begin; y < y_end; ++y) {
+                        const float py = y + 0.5f;
+                        float* z_row = z_buffer + (y - tile_y0) * TileSize - tile_x0;
+                        uint8_t* id_row = id_buffer + (y - tile_y0) * TileSize - tile_x0;
+
+                        //narrow the row to where the edge functions can be positive so thin or
+                        //diagonal triangles don't walk their whole bounding box. The span is
+                        //padded by a pixel, the per lane edge test still decides coverage.
+                        int span_begin = x_begin, span_end = x_end;
+                        for (uint edge = 0; edge < 3 && span_begin < span_end; ++edge) {
+                            const float a = t.edge_a[edge], k = t.edge_b[edge] * py + t.edge_c[edge];
+                            if (a > 0)
+                                span_begin = std::max(span_begin, static_cast<int>(std::floor(-k / a - 0.5f)) - 1);
+                            else if (a < 0)
+                                span_end = std::min(span_end, static_cast<int>(std::ceil(-k / a - 0.5f)) + 2);
+                            else if (k < 0)
+                                span_end = span_begin;
+                        }
+                        if (span_begin >= span_end)
+                            continue;
+                        span_begin = span_begin / Lanes * Lanes;
+
+                        //row constants hoisted so the lane loop is only multiply-adds and selects
+                        const float k0 = t.edge_b[0] * py + t.edge_c[0], a0 = t.edge_a[0];
+                        const float k1 = t.edge_b[1] * py + t.edge_c[1], a1 = t.edge_a[1];
+                        const float k2 = t.edge_b[2] * py + t.edge_c[2], a2 = t.edge_a[2];
+                        const float kz = t.inv_depth_b * py + t.inv_depth_c, az = t.inv_depth_a;
+
+                        for (int x = span_begin; x < span_end; x += Lanes) {
+                            float* z_lanes = z_row + x;
+                            alignas(32) int32_t pass[Lanes];
+                            for (int lane = 0; lane < Lanes; ++lane) {
+                                const float px = static_cast<float>(x + lane) + 0.5f;
+                                const float e0 = a0 * px + k0, e1 = a1 * px + k1, e2 = a2 * px + k2;
+                                const float z = az * px + kz;
+
+                                pass[lane] = (e0 >= 0) & (e1 >= 0) & (e2 >= 0) & (x + lane < span_end) & (z > z_lanes[lane]) & (z <= max_inv_depth);
+                                z_lanes[lane] = pass[lane] ? z : z_lanes[lane];
+                            }
+
+                            //ids are bytes, a separate pass keeps the float lanes above at one width
+                            uint8_t* id_lanes = id_row + x;
+                            for (int lane = 0; lane < Lanes; ++lane)
+                                id_lanes[lane] = pass[lane] ? t.segmentation_id : id_lanes[lane];
+                        }
+                    }
+                }
+            }
+
+            for (int y = tile_y0; y < tile_y1; ++y) {
+                for (int x = tile_x0; x < tile_x1; ++x) {
+                    const int local = (y - tile_y0) * TileSize + (x - tile_x0);
+                    const size_t index = static_cast<size_t>(y) * frame.width + x;
+                    if (z_buffer[local] > 1.0f / camera.far_plane) {
+                        frame.depth_planar[index] = std::min(1.0f / z_buffer[local], camera.far_plane);
+                        frame.segmentation[index] = id_buffer[local];
+                    }
+                }
+            }
+        }
+
+    private:
+        vector<Triangle> triangles_;
+        uint8_t background_id_ = 0;
+
+        std::mutex render_mutex_;
+        ctpl::thread_pool threads_;
+        vector<Chunk> chunks_;
+        int tiles_x_ = 0, tiles_y_ = 0;
+    };
+}
+} //namespace
+#endif
@@ -31,6 +31,7 @@ namespace airlib
         void setDelay(TTimeDelta delay)
         {
             delay_ = delay;
+            delay_nanos_ = ClockBase::toNanos(delay);
         }
         double getDelay() const
         {
@@ -51,7 +52,7 @@ namespace airlib
             UpdatableObject::update();
 
             if (!times_.empty() &&
-                ClockBase::elapsedBetween(clock()->nowNanos(), times_.front()) >= delay_) {
+                ClockBase::elapsedNanosBetween(clock()->stepNanos(), times_.front()) >= delay_nanos_) {
 
                 last_value_ = values_.front();
                 last_time_ = times_.front();
@@ -71,10 +72,18 @@ namespace airlib
             return last_time_;
         }
 
+        //clock time at which update() will next move a value to the output
+        TTimePoint getNextOutputTime() const
+        {
+            if (times_.empty())
+                return std::numeric_limits<TTimePoint>::max();
+            return times_.front() + static_cast<TTimePoint>(delay_nanos_);
+        }
+
         void push_back(const T& val, TTimePoint time_offset = 0)
         {
             values_.push_back(val);
-            times_.push_back(clock()->nowNanos() + time_offset);
+            times_.push_back(clock()->stepNanos() + time_offset);
         }
 
     private:
@@ -84,6 +93,7 @@ namespace airlib
         list<T> values_;
         list<TTimePoint> times_;
         TTimeDelta delay_;
+        int64_t delay_nanos_ = 0;
 
         T last_value_;
         TTimePoint last_time_;
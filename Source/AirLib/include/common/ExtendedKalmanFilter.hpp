@@ -0,0 +1,95 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef air_ExtendedKalmanFilter_hpp
+#define air_ExtendedKalmanFilter_hpp
+
+#include "common/Common.hpp"
+#include "common/VectorMath.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    /*
+    Covariance bookkeeping of an extended Kalman filter with TStateSize states. The caller owns
+    the state itself and linearizes its models, this class propagates and corrects the covariance
+    and turns residuals into state corrections.
+
+    All matrices have sizes fixed at compile time, so predict and update never allocate.
+    */
+    template <int TStateSize>
+    class ExtendedKalmanFilter
+    {
+    public:
+        typedef Eigen::Matrix<real_T, TStateSize, 1> StateVector;
+        typedef Eigen::Matrix<real_T, TStateSize, TStateSize> StateMatrix;
+
+        template <int TMeasurementSize>
+        using MeasurementVector = Eigen::Matrix<real_T, TMeasurementSize, 1>;
+        template <int TMeasurementSize>
+        using MeasurementMatrix = Eigen::Matrix<real_T, TMeasurementSize, TMeasurementSize>;
+        template <int TMeasurementSize>
+        using ObservationMatrix = Eigen::Matrix<real_T, TMeasurementSize, TStateSize>;
+
+    public:
+        //uncorrelated states with the given variances
+        void reset(const StateVector& variance)
+        {
+            covariance_ = variance.asDiagonal();
+        }
+
+        //P = F P F' + Q
+        void predict(const StateMatrix& transition, const StateMatrix& process_noise)
+        {
+            covariance_ = transition * covariance_ * transition.transpose() + process_noise;
+            covariance_ = (covariance_ + covariance_.transpose()) * 0.5f;
+        }
+
+        /*
+        Residual is measured minus predicted measurement, observation is its Jacobian with respect to
+        the state and noise the measurement covariance. Measurements whose normalized innovation
+        squared exceeds gate are rejected as outliers. Returns false if the measurement was rejected,
+        otherwise sets correction to what should be added to the state.
+        */
+        template <int TMeasurementSize>
+        bool update(const MeasurementVector<TMeasurementSize>& residual, const ObservationMatrix<TMeasurementSize>& observation,
+                    const MeasurementMatrix<TMeasurementSize>& noise, real_T gate, StateVector& correction)
+        {
+            const Eigen::Matrix<real_T, TStateSize, TMeasurementSize> covariance_observation = covariance_ * observation.transpose();
+            const MeasurementMatrix<TMeasurementSize> innovation_covariance = observation * covariance_observation + noise;
+            const Eigen::LDLT<MeasurementMatrix<TMeasurementSize>> innovation_ldlt(innovation_covariance);
+
+            if (residual.dot(innovation_ldlt.solve(residual)) > gate)
+                return false;
+
+            const Eigen::Matrix<real_T, TStateSize, TMeasurementSize> gain = innovation_ldlt.solve(covariance_observation.transpose()).transpose();
+            correction = gain * residual;
+
+            //Joseph form keeps P symmetric positive definite with float precision
+            const StateMatrix reduction = StateMatrix::Identity() - gain * observation;
+            covariance_ = reduction * covariance_ * reduction.transpose() + gain * noise * gain.transpose();
+            return true;
+        }
+
+        //e' P^-1 e for the error of TSize states starting at start, i.e. the normalized estimation
+        //error squared; averages TSize if the filter is consistent
+        template <int TSize>
+        real_T getNormalizedErrorSquared(int start, const Eigen::Matrix<real_T, TSize, 1>& error) const
+        {
+            const Eigen::Matrix<real_T, TSize, TSize> covariance = covariance_.template block<TSize, TSize>(start, start);
+            return error.dot(covariance.ldlt().solve(error));
+        }
+
+        const StateMatrix& getCovariance() const
+        {
+            return covariance_;
+        }
+
+    private:
+        StateMatrix covariance_ = StateMatrix::Identity();
+    };
+}
+} //namespace
+#endif
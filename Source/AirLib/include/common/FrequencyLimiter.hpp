@@ -30,7 +30,7 @@ namespace airlib
         //*** Start: UpdatableState implementation ***//
         virtual void resetImplementation() override
         {
-            last_time_ = clock()->nowNanos();
+            last_time_ = clock()->stepNanos();
             first_time_ = last_time_;
 
             if (Utils::isApproximatelyZero(frequency_))
@@ -57,8 +57,9 @@ namespace airlib
         {
             UpdatableObject::update();
 
-            elapsed_total_sec_ = clock()->elapsedSince(first_time_);
-            elapsed_interval_sec_ = clock()->elapsedSince(last_time_);
+            const TTimePoint now = clock()->stepNanos();
+            elapsed_total_sec_ = ClockBase::elapsedBetween(now, first_time_);
+            elapsed_interval_sec_ = ClockBase::elapsedBetween(now, last_time_);
             ++update_count_;
 
             //if startup_delay_ > 0 then we consider startup_delay_ as the first interval
@@ -79,7 +80,7 @@ namespace airlib
             //when any interval is done, reset the state and repeat
             if (interval_complete_) {
                 last_elapsed_interval_sec_ = elapsed_interval_sec_;
-                last_time_ = clock()->nowNanos();
+                last_time_ = now;
                 elapsed_interval_sec_ = 0;
                 startup_complete_ = true;
             }
@@ -116,6 +117,22 @@ namespace airlib
             return update_count_;
         }
 
+        //earliest clock time at which update() may complete the current interval,
+        //calling update() before this is a no-op apart from elapsed time bookkeeping
+        TTimePoint getNextUpdateTime() const
+        {
+            real_T interval = startup_complete_ || !Utils::isDefinitelyGreaterThan(startup_delay_, 0.0f)
+                                  ? interval_size_sec_
+                                  : startup_delay_;
+
+            //truncate so rounding can only make us early, never skip the tick that completes the interval
+            constexpr TTimePoint max_time = std::numeric_limits<TTimePoint>::max();
+            TTimePoint interval_nanos = interval * 1.0E9 >= static_cast<double>(max_time - last_time_)
+                                            ? max_time - last_time_
+                                            : static_cast<TTimePoint>(interval * 1.0E9);
+            return last_time_ + interval_nanos;
+        }
+
     private:
         real_T interval_size_sec_;
         TTimeDelta elapsed_total_sec_;
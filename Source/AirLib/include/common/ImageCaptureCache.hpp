@@ -0,0 +1,184 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef air_ImageCaptureCache_hpp
+#define air_ImageCaptureCache_hpp
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include "common/Common.hpp"
+#include "common/ImageCaptureBase.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    /*
+    Shares image captures between requesters asking for the same image around the same frame,
+    e.g. the recording thread and an RPC client, or several clients polling one camera.
+
+    Captures are keyed by camera, image type, pixels_as_float and compress along with the
+    frame they were taken in. A request for a capture that another thread has in flight waits
+    for it instead of starting its own (a join), and a request for one finished no more than
+    max_frame_age frames ago gets a copy of it (a hit). Everything else is a miss and is
+    captured by the caller's function, all misses of one call in one batch so they still go
+    out as one render request. With max_frame_age 0 only requests in the same frame share,
+    which returns the same images an uncached capture would; -1 disables sharing altogether.
+
+    Each ImageCaptureBase owns one cache, so entries are per vehicle.
+    */
+    class ImageCaptureCache
+    {
+    public:
+        typedef ImageCaptureBase::ImageRequest ImageRequest;
+        typedef ImageCaptureBase::ImageResponse ImageResponse;
+        typedef std::function<void(const vector<ImageRequest>&, vector<ImageResponse>&)> CaptureFunc;
+
+        struct Stats
+        {
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+            uint64_t joins = 0;
+        };
+
+    public:
+        explicit ImageCaptureCache(int max_frame_age = 0)
+            : max_frame_age_(max_frame_age)
+        {
+        }
+
+        void setMaxFrameAge(int max_frame_age)
+        {
+            max_frame_age_ = max_frame_age;
+        }
+
+        //responses are appended in request order, captures not shared are done by calling capture
+        void getImages(uint64_t frame, const vector<ImageRequest>& requests, vector<ImageResponse>& responses, const CaptureFunc& capture)
+        {
+            if (max_frame_age_ < 0) {
+                misses_ += requests.size();
+                capture(requests, responses);
+                return;
+            }
+
+            vector<std::shared_ptr<Entry>> entries(requests.size());
+            vector<ImageRequest> miss_requests;
+            vector<std::shared_ptr<Entry>> miss_entries;
+            {
+                std::lock_guard<std::mutex> guard(mutex_);
+                for (size_t i = 0; i < requests.size(); ++i) {
+                    const ImageRequest& request = requests[i];
+                    const Key key(request.camera_name, static_cast<int>(request.image_type), request.pixels_as_float, request.compress);
+
+                    auto found = entries_.find(key);
+                    if (found != entries_.end() && isFresh(*found->second, frame)) {
+                        entries[i] = found->second;
+                        if (found->second->ready)
+                            ++hits_;
+                        else
+                            ++joins_;
+                        continue;
+                    }
+
+                    auto entry = std::make_shared<Entry>();
+                    entry->key = key;
+                    entry->frame = frame;
+                    entries_[key] = entry;
+                    entries[i] = entry;
+                    miss_requests.push_back(request);
+                    miss_entries.push_back(entry);
+                    ++misses_;
+                }
+            }
+
+            if (miss_requests.size() > 0) {
+                vector<ImageResponse> miss_responses;
+                try {
+                    capture(miss_requests, miss_responses);
+                }
+                catch (...) {
+                    //don't leave joined requesters waiting for a capture that never comes
+                    miss_responses.clear();
+                    finish(miss_entries, miss_responses, "Image capture failed");
+                    throw;
+                }
+                finish(miss_entries, miss_responses, "Image capture returned no response");
+            }
+
+            //joined captures may be finishing on other threads, ours are already done
+            std::unique_lock<std::mutex> lock(mutex_);
+            for (const auto& entry : entries) {
+                entry_ready_.wait(lock, [&entry] { return entry->ready; });
+                responses.push_back(entry->response);
+            }
+        }
+
+        Stats getStats() const
+        {
+            Stats stats;
+            stats.hits = hits_;
+            stats.misses = misses_;
+            stats.joins = joins_;
+            return stats;
+        }
+
+    private:
+        typedef std::tuple<std::string, int, bool, bool> Key;
+
+        struct Entry
+        {
+            Key key;
+            uint64_t frame = 0;
+            bool ready = false;
+            ImageResponse response;
+        };
+
+        bool isFresh(const Entry& entry, uint64_t frame) const
+        {
+            //in flight captures from older frames are still joined, they can only finish later
+            //than a capture started now would
+            if (!entry.ready)
+                return true;
+            const int max_frame_age = max_frame_age_;
+            return max_frame_age >= 0 && frame >= entry.frame && frame - entry.frame <= static_cast<uint64_t>(max_frame_age);
+        }
+
+        void finish(const vector<std::shared_ptr<Entry>>& entries, vector<ImageResponse>& responses, const std::string& missing_message)
+        {
+            {
+                std::lock_guard<std::mutex> guard(mutex_);
+                for (size_t i = 0; i < entries.size(); ++i) {
+                    Entry& entry = *entries[i];
+                    if (i < responses.size())
+                        entry.response = std::move(responses[i]);
+                    else {
+                        //requesters already joined get the error, later ones try again
+                        entry.response.message = missing_message;
+                        auto found = entries_.find(entry.key);
+                        if (found != entries_.end() && found->second == entries[i])
+                            entries_.erase(found);
+                    }
+                    entry.ready = true;
+                }
+            }
+            entry_ready_.notify_all();
+        }
+
+    private:
+        std::atomic<int> max_frame_age_;
+        std::map<Key, std::shared_ptr<Entry>> entries_;
+        std::mutex mutex_;
+        std::condition_variable entry_ready_;
+
+        std::atomic<uint64_t> hits_{ 0 };
+        std::atomic<uint64_t> misses_{ 0 };
+        std::atomic<uint64_t> joins_{ 0 };
+    };
+}
+} //namespace
+#endif
@@ -0,0 +1,454 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef air_ImageEffects_hpp
+#define air_ImageEffects_hpp
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <future>
+#include <map>
+#include <thread>
+#include "common/Common.hpp"
+#include "common/AirSimSettings.hpp"
+#include "common/ImageCaptureBase.hpp"
+#include "common/common_utils/ctpl_stl.h"
+
+namespace msr
+{
+namespace airlib
+{
+
+    /*
+    CPU version of the camera noise and lens distortion that APIPCamera applies with post
+    process materials, so the same effects can be put on images from any ImageCaptureBase
+    or on recorded ImageResponses after the fact.
+
+    Distortion is Brown-Conrady with the K1, K2, K3, P1, P2 coefficients used by the
+    CameraDistortion material, relative to the focal length given by fov_degrees. Inverting
+    the distortion per pixel is iterative, so it is done once per resolution into a remap
+    table and each image afterwards is a table lookup plus bilinear blend. Segmentation,
+    infrared and float images are remapped with nearest neighbour instead so ids and depth
+    edges are not blended. Output pixels that map outside the source image are zero.
+
+    Noise uses the NoiseSetting knobs: RandContrib blends in Perlin noise with RandSize cells
+    across the image width, moving at RandSpeed cells per second and shaped by RandDensity;
+    HorzWave* shifts rows by a sine wave scrolling down the image; HorzDistortion* shifts
+    each row by a random amount; HorzNoiseLines* draws sparse white dashes on random rows.
+    The noise material graph itself is an Unreal asset, so these follow its parameters
+    rather than reproduce it pixel for pixel. Noise is animated from the response time stamp,
+    so reprocessing a recording gives the same result. Only uint8 images get noise.
+
+    Compressed responses can't be processed and are left unchanged with a message set.
+    Not thread safe; rows of each image are processed in parallel on the internal pool.
+    */
+    class ImageEffects
+    {
+    public: //types
+        typedef ImageCaptureBase::ImageType ImageType;
+        typedef ImageCaptureBase::ImageResponse ImageResponse;
+        typedef AirSimSettings::NoiseSetting NoiseSetting;
+
+        struct DistortionParams
+        {
+            float K1 = 0, K2 = 0, K3 = 0, P1 = 0, P2 = 0;
+            float fov_degrees = 90; //horizontal field of view the coefficients are relative to
+
+            bool isIdentity() const
+            {
+                return K1 == 0 && K2 == 0 && K3 == 0 && P1 == 0 && P2 == 0;
+            }
+        };
+
+    public: //methods
+        //thread_count of 0 uses all hardware threads
+        explicit ImageEffects(uint thread_count = 0)
+        {
+            if (thread_count == 0)
+                thread_count = std::max(1u, std::thread::hardware_concurrency());
+            threads_.resize(static_cast<int>(thread_count));
+        }
+
+        //keyed by image type like CameraSetting::noise_settings, disabled entries are ignored
+        void setNoiseSettings(const std::map<int, NoiseSetting>& noise_settings)
+        {
+            noise_settings_ = noise_settings;
+        }
+
+        void setDistortion(const DistortionParams& params)
+        {
+            distortion_ = params;
+            remap_tables_.clear();
+        }
+
+        const DistortionParams& getDistortion() const
+        {
+            return distortion_;
+        }
+
+        void apply(vector<ImageResponse>& responses)
+        {
+            for (auto& response : responses)
+                apply(response);
+        }
+
+        void apply(ImageResponse& response)
+        {
+            const size_t pixel_count = static_cast<size_t>(response.width) * static_cast<size_t>(std::max(response.height, 0));
+            if (pixel_count == 0)
+                return;
+            if (response.compress) {
+                response.message = "Image effects need uncompressed images";
+                return;
+            }
+
+            const bool is_float = response.pixels_as_float;
+            const size_t value_count = is_float ? response.image_data_float.size() : response.image_data_uint8.size();
+            const uint channels = static_cast<uint>(value_count / pixel_count);
+            if (channels == 0 || channels * pixel_count != value_count) {
+                response.message = "Image data size doesn't match its width and height";
+                return;
+            }
+
+            if (!distortion_.isIdentity() && response.width > 1 && response.height > 1) {
+                const RemapTable& table = getRemapTable(response.width, response.height);
+                const bool nearest = is_float || response.image_type == ImageType::Segmentation ||
+                                     response.image_type == ImageType::Infrared;
+                if (is_float)
+                    remap(table, response.image_data_float, float_buffer_, response.width, response.height);
+                else
+                    remap(table, nearest, channels, response.image_data_uint8, uint8_buffer_, response.width, response.height);
+            }
+
+            const auto noise = noise_settings_.find(static_cast<int>(response.image_type));
+            if (!is_float && noise != noise_settings_.end() && noise->second.Enabled)
+                addNoise(noise->second, response.time_stamp, response.width, response.height, channels, response.image_data_uint8);
+        }
+
+    private: //types
+        static constexpr uint RowsPerTask = 16;
+        static constexpr int WeightOne = 256; //fixed point bilinear and blend weights
+        static constexpr uint32_t NoiseLatticeSize = 4096;
+        static constexpr uint NoiseLevels = 256;
+        static constexpr int RowChunk = 64;
+
+        struct RemapTable
+        {
+            //per output pixel: top left source pixel of the bilinear quad and its weights
+            vector<int> bilinear_source;
+            vector<uint16_t> weight_x, weight_y;
+            //per output pixel: closest source pixel
+            vector<int> nearest_source;
+        };
+
+    private: //methods
+        template <typename TFunc>
+        void runParallel(uint count, const TFunc& func)
+        {
+            std::atomic<uint> next{ 0 };
+            vector<std::future<void>> workers;
+            const uint worker_count = std::min(count, static_cast<uint>(threads_.size()));
+            for (uint i = 0; i < worker_count; ++i) {
+                workers.push_back(threads_.push([&](int) {
+                    for (uint item = next++; item < count; item = next++)
+                        func(item);
+                }));
+            }
+            for (auto& worker : workers)
+                worker.get();
+        }
+
+        template <typename TFunc>
+        void forEachRow(int height, const TFunc& func)
+        {
+            const uint task_count = (static_cast<uint>(height) + RowsPerTask - 1) / RowsPerTask;
+            runParallel(task_count, [&](uint task) {
+                const int end = std::min(height, static_cast<int>((task + 1) * RowsPerTask));
+                for (int y = static_cast<int>(task * RowsPerTask); y < end; ++y)
+                    func(y);
+            });
+        }
+
+        const RemapTable& getRemapTable(int width, int height)
+        {
+            auto found = remap_tables_.find(std::make_pair(width, height));
+            if (found != remap_tables_.end())
+                return found->second;
+
+            RemapTable& table = remap_tables_[std::make_pair(width, height)];
+            const size_t pixel_count = static_cast<size_t>(width) * height;
+            table.bilinear_source.resize(pixel_count);
+            table.weight_x.resize(pixel_count);
+            table.weight_y.resize(pixel_count);
+            table.nearest_source.resize(pixel_count);
+
+            const float cx = 0.5f * width, cy = 0.5f * height;
+            const float focal = cx / std::tan(Utils::degreesToRadians(distortion_.fov_degrees) / 2);
+
+            forEachRow(height, [&](int y) {
+                for (int x = 0; x < width; ++x) {
+                    const size_t index = static_cast<size_t>(y) * width + x;
+
+                    //output pixels are in the distorted image, look up where they come from
+                    float ux, uy;
+                    undistort((x + 0.5f - cx) / focal, (y + 0.5f - cy) / focal, ux, uy);
+                    const float sx = ux * focal + cx - 0.5f, sy = uy * focal + cy - 0.5f;
+
+                    if (!(sx > -0.5f && sx < width - 0.5f && sy > -0.5f && sy < height - 0.5f)) {
+                        table.bilinear_source[index] = table.nearest_source[index] = -1;
+                        continue;
+                    }
+
+                    const int nx = std::min(width - 1, static_cast<int>(sx + 0.5f));
+                    const int ny = std::min(height - 1, static_cast<int>(sy + 0.5f));
+                    table.nearest_source[index] = ny * width + nx;
+
+                    const float bx = std::max(0.0f, std::min(sx, width - 1.0f));
+                    const float by = std::max(0.0f, std::min(sy, height - 1.0f));
+                    const int x0 = std::min(width - 2, static_cast<int>(bx));
+                    const int y0 = std::min(height - 2, static_cast<int>(by));
+                    table.bilinear_source[index] = y0 * width + x0;
+                    table.weight_x[index] = static_cast<uint16_t>(std::lround((bx - x0) * WeightOne));
+                    table.weight_y[index] = static_cast<uint16_t>(std::lround((by - y0) * WeightOne));
+                }
+            });
+
+            return table;
+        }
+
+        void distort(float x, float y, float& dx, float& dy) const
+        {
+            const float r2 = x * x + y * y;
+            const float radial = 1 + r2 * (distortion_.K1 + r2 * (distortion_.K2 + r2 * distortion_.K3));
+            dx = x * radial + 2 * distortion_.P1 * x * y + distortion_.P2 * (r2 + 2 * x * x);
+            dy = y * radial + distortion_.P1 * (r2 + 2 * y * y) + 2 * distortion_.P2 * x * y;
+        }
+
+        //fixed point iteration as in OpenCV's undistortPoints, converges well within the
+        //iteration count for the coefficients real lenses have
+        void undistort(float dx, float dy, float& x, float& y) const
+        {
+            x = dx;
+            y = dy;
+            for (int i = 0; i < 20; ++i) {
+                const float r2 = x * x + y * y;
+                const float radial = 1 + r2 * (distortion_.K1 + r2 * (distortion_.K2 + r2 * distortion_.K3));
+                if (radial <= 0)
+                    break;
+                const float tx = 2 * distortion_.P1 * x * y + distortion_.P2 * (r2 + 2 * x * x);
+                const float ty = distortion_.P1 * (r2 + 2 * y * y) + 2 * distortion_.P2 * x * y;
+                x = (dx - tx) / radial;
+                y = (dy - ty) / radial;
+            }
+        }
+
+        void remap(const RemapTable& table, bool nearest, uint channels, vector<uint8_t>& image, vector<uint8_t>& buffer,
+                   int width, int height)
+        {
+            buffer.resize(image.size());
+            const uint8_t* source = image.data();
+            uint8_t* target = buffer.data();
+            const size_t row_values = static_cast<size_t>(width) * channels;
+
+            forEachRow(height, [&](int y) {
+                const size_t begin = static_cast<size_t>(y) * width;
+                uint8_t* out = target + y * row_values;
+                for (size_t index = begin; index < begin + width; ++index, out += channels) {
+                    if (nearest) {
+                        const int from = table.nearest_source[index];
+                        for (uint c = 0; c < channels; ++c)
+                            out[c] = from < 0 ? 0 : source[from * channels + c];
+                        continue;
+                    }
+
+                    const int from = table.bilinear_source[index];
+                    if (from < 0) {
+                        std::fill(out, out + channels, static_cast<uint8_t>(0));
+                        continue;
+                    }
+                    const uint8_t* top = source + static_cast<size_t>(from) * channels;
+                    const uint8_t* bottom = top + row_values;
+                    const int wx = table.weight_x[index], wy = table.weight_y[index];
+                    for (uint c = 0; c < channels; ++c) {
+                        const int upper = top[c] * (WeightOne - wx) + top[c + channels] * wx;
+                        const int lower = bottom[c] * (WeightOne - wx) + bottom[c + channels] * wx;
+                        out[c] = static_cast<uint8_t>((upper * (WeightOne - wy) + lower * wy + WeightOne * WeightOne / 2) >> 16);
+                    }
+                }
+            });
+
+            image.swap(buffer);
+        }
+
+        void remap(const RemapTable& table, vector<float>& image, vector<float>& buffer, int width, int height)
+        {
+            buffer.resize(image.size());
+            forEachRow(height, [&](int y) {
+                const size_t begin = static_cast<size_t>(y) * width;
+                for (size_t index = begin; index < begin + width; ++index) {
+                    const int from = table.nearest_source[index];
+                    buffer[index] = from < 0 ? 0 : image[from];
+                }
+            });
+
+            image.swap(buffer);
+        }
+
+        void addNoise(const NoiseSetting& setting, TTimePoint time_stamp, int width, int height, uint channels, vector<uint8_t>& image)
+        {
+            const double seconds = static_cast<double>(time_stamp) / 1E9;
+            const uint32_t frame_seed = hash(static_cast<uint32_t>(time_stamp), static_cast<uint32_t>(time_stamp >> 32));
+
+            //noise lattice wraps every NoiseLatticeSize cells, keep the offset within it so
+            //float precision doesn't run out for large time stamps
+            const float cells_per_pixel = std::abs(setting.RandSize) / width;
+            float drift = static_cast<float>(std::fmod(seconds * setting.RandSpeed, static_cast<double>(NoiseLatticeSize)));
+            if (drift < 0)
+                drift += NoiseLatticeSize;
+
+            //RandDensity shapes the noise with pow(), tabulated since it is the same for every pixel
+            std::array<uint8_t, NoiseLevels> levels;
+            for (uint i = 0; i < NoiseLevels; ++i)
+                levels[i] = static_cast<uint8_t>(std::lround(255 * std::pow(i / (NoiseLevels - 1.0f), setting.RandDensity)));
+
+            const int rand_contrib = static_cast<int>(std::lround(Utils::clip(setting.RandContrib, 0.0f, 1.0f) * WeightOne));
+            const int lines_contrib = static_cast<int>(std::lround(Utils::clip(setting.HorzNoiseLinesContrib, 0.0f, 1.0f) * WeightOne));
+            const size_t row_values = static_cast<size_t>(width) * channels;
+
+            forEachRow(height, [&](int y) {
+                uint8_t* row = image.data() + y * row_values;
+
+                //row shift from the scrolling wave plus random per row jitter
+                const float v = static_cast<float>(y) / height;
+                float shift = setting.HorzWaveContrib * setting.HorzWaveStrength * setting.HorzWaveScreenSize * width *
+                              std::sin(2 * M_PIf * (v / setting.HorzWaveVertSize - static_cast<float>(std::fmod(seconds, 1.0))));
+                shift += setting.HorzDistortionContrib * setting.HorzDistortionStrength * width *
+                         (2 * hashToUnit(hash(y, frame_seed)) - 1);
+                shiftRow(row, width, channels, static_cast<int>(std::lround(shift)));
+
+                if (rand_contrib > 0) {
+                    uint8_t noise[RowChunk];
+                    for (int begin = 0; begin < width; begin += RowChunk) {
+                        const int count = std::min(RowChunk, width - begin);
+                        perlinRow(begin, count, y * cells_per_pixel + drift, cells_per_pixel, drift, levels, noise);
+                        uint8_t* pixel = row + begin * channels;
+                        for (int x = 0; x < count; ++x, pixel += channels) {
+                            for (uint c = 0; c < channels; ++c)
+                                pixel[c] = static_cast<uint8_t>(pixel[c] + (((noise[x] - pixel[c]) * rand_contrib) >> 8));
+                        }
+                    }
+                }
+
+                if (lines_contrib > 0 && hashToUnit(hash(y, ~frame_seed)) < setting.HorzNoiseLinesDensityY) {
+                    const uint32_t line_seed = hash(y, frame_seed);
+                    uint8_t* pixel = row;
+                    for (int x = 0; x < width; ++x, pixel += channels) {
+                        if (hashToUnit(hash(x, line_seed)) < setting.HorzNoiseLinesDensityXY) {
+                            for (uint c = 0; c < channels; ++c)
+                                pixel[c] = static_cast<uint8_t>(pixel[c] + (((255 - pixel[c]) * lines_contrib) >> 8));
+                        }
+                    }
+                }
+            });
+        }
+
+        //moves a row right by shift pixels (left if negative), repeating the edge pixel
+        static void shiftRow(uint8_t* row, int width, uint channels, int shift)
+        {
+            shift = Utils::clip(shift, -(width - 1), width - 1);
+            if (shift == 0)
+                return;
+
+            const size_t moved = static_cast<size_t>(width - std::abs(shift)) * channels;
+            const size_t offset = static_cast<size_t>(std::abs(shift)) * channels;
+            if (shift > 0) {
+                std::memmove(row + offset, row, moved);
+                for (size_t i = channels; i < offset; ++i)
+                    row[i] = row[i - channels];
+            }
+            else {
+                std::memmove(row, row + offset, moved);
+                for (size_t i = moved; i < moved + offset; ++i)
+                    row[i] = row[i - channels];
+            }
+        }
+
+        //2D gradient noise for RowChunk pixels of one row from begin, mapped through levels.
+        //Hashing is arithmetic rather than a permutation table and the trip count is fixed so
+        //the loop can be vectorized; the caller uses the first count values. Noise coordinates
+        //are never negative so truncation can stand in for floor().
+        static void perlinRow(int begin, int count, float ny, float cells_per_pixel, float drift,
+                              const std::array<uint8_t, NoiseLevels>& levels, uint8_t* out)
+        {
+            const uint32_t iy = static_cast<uint32_t>(ny);
+            const float fy = ny - iy;
+            const float sy = fy * fy * fy * (fy * (fy * 6 - 15) + 10);
+            const uint32_t row0 = hash(iy & (NoiseLatticeSize - 1)), row1 = hash((iy + 1) & (NoiseLatticeSize - 1));
+
+            float values[RowChunk];
+            for (int x = 0; x < RowChunk; ++x) {
+                const float nx = (begin + x + 0.5f) * cells_per_pixel + drift;
+                const uint32_t ix = static_cast<uint32_t>(static_cast<int32_t>(nx));
+                const float fx = nx - static_cast<float>(static_cast<int32_t>(ix));
+                const float sx = fx * fx * fx * (fx * (fx * 6 - 15) + 10);
+                const uint32_t ix0 = ix & (NoiseLatticeSize - 1), ix1 = (ix + 1) & (NoiseLatticeSize - 1);
+
+                const float n00 = gradient(hash(ix0 ^ row0), fx, fy);
+                const float n10 = gradient(hash(ix1 ^ row0), fx - 1, fy);
+                const float n01 = gradient(hash(ix0 ^ row1), fx, fy - 1);
+                const float n11 = gradient(hash(ix1 ^ row1), fx - 1, fy - 1);
+                const float top = n00 + sx * (n10 - n00);
+                const float bottom = n01 + sx * (n11 - n01);
+
+                //gradient noise is within about +-0.7, map it to [0, 1]
+                values[x] = std::max(0.0f, std::min(1.0f, 0.5f + 0.7f * (top + sy * (bottom - top))));
+            }
+
+            for (int x = 0; x < count; ++x)
+                out[x] = levels[static_cast<uint>(values[x] * (NoiseLevels - 1) + 0.5f)];
+        }
+
+        static float gradient(uint32_t h, float x, float y)
+        {
+            //one of 8 directions as in improved Perlin noise, in arithmetic instead of
+            //branches so it vectorizes: swap x and y on bit 0, negate on bits 1 and 2
+            const float swap = static_cast<float>(h & 1);
+            const float u = y + swap * (x - y);
+            const float v = x + swap * (y - x);
+            return u * (1 - static_cast<float>(h & 2)) + v * (2 - static_cast<float>(h & 4));
+        }
+
+        static uint32_t hash(uint32_t x)
+        {
+            x ^= x >> 16;
+            x *= 0x7feb352dU;
+            x ^= x >> 15;
+            x *= 0x846ca68bU;
+            x ^= x >> 16;
+            return x;
+        }
+
+        static uint32_t hash(uint32_t x, uint32_t y)
+        {
+            return hash(x ^ hash(y + 0x9e3779b9U));
+        }
+
+        static float hashToUnit(uint32_t h)
+        {
+            return (h >> 8) * (1.0f / 16777216.0f);
+        }
+
+    private:
+        ctpl::thread_pool threads_;
+        std::map<int, NoiseSetting> noise_settings_;
+        DistortionParams distortion_;
+        std::map<std::pair<int, int>, RemapTable> remap_tables_;
+        vector<uint8_t> uint8_buffer_;
+        vector<float> float_buffer_;
+    };
+}
+} //namespace
+#endif
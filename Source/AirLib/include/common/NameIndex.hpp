@@ -0,0 +1,394 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef air_NameIndex_hpp
+#define air_NameIndex_hpp
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <regex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "common/Common.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    /*
+    A name pattern compiled once: exact name, ECMAScript regex matched against the whole name,
+    or wildcard with * and ? like Unreal's FString::MatchesWildcard.
+
+    Besides the matcher it keeps the literal text every matching name must start with and the
+    longest literal every matching name must contain, found by a conservative scan of the
+    pattern. NameIndex uses them to look at a range of sorted names instead of all of them.
+    */
+    class NamePattern
+    {
+    public:
+        enum class Syntax
+        {
+            Exact,
+            Regex,
+            Wildcard
+        };
+
+    public:
+        NamePattern(const std::string& pattern, Syntax syntax, bool ignore_case)
+            : pattern_(pattern), syntax_(syntax), ignore_case_(ignore_case)
+        {
+            key_ = std::to_string(static_cast<int>(syntax)) + (ignore_case ? "i:" : "s:") + pattern;
+
+            if (syntax == Syntax::Exact) {
+                prefix_ = required_ = toLower(pattern);
+                is_literal_ = true;
+                return;
+            }
+
+            const std::string regex_pattern = syntax == Syntax::Wildcard ? wildcardToRegex(pattern) : pattern;
+            auto flags = std::regex::ECMAScript | std::regex::optimize;
+            if (ignore_case)
+                flags |= std::regex::icase;
+            regex_.assign(regex_pattern, flags);
+
+            analyzeRegex(regex_pattern, prefix_, required_, is_literal_);
+            prefix_ = toLower(prefix_);
+            required_ = toLower(required_);
+        }
+
+        //compiled patterns are shared, so repeated queries with the same pattern don't recompile it
+        static std::shared_ptr<const NamePattern> compile(const std::string& pattern, Syntax syntax, bool ignore_case)
+        {
+            static std::mutex cache_mutex;
+            static std::unordered_map<std::string, std::shared_ptr<const NamePattern>> cache;
+            static constexpr size_t kMaxCached = 256;
+
+            const std::string key = std::to_string(static_cast<int>(syntax)) + (ignore_case ? "i:" : "s:") + pattern;
+            {
+                std::lock_guard<std::mutex> guard(cache_mutex);
+                auto found = cache.find(key);
+                if (found != cache.end())
+                    return found->second;
+            }
+
+            //compile outside the lock, may throw std::regex_error for bad patterns
+            auto compiled = std::make_shared<const NamePattern>(pattern, syntax, ignore_case);
+
+            std::lock_guard<std::mutex> guard(cache_mutex);
+            if (cache.size() >= kMaxCached)
+                cache.clear();
+            cache[key] = compiled;
+            return compiled;
+        }
+
+        //lower_name must be name in lower case
+        bool matches(const std::string& name, const std::string& lower_name) const
+        {
+            if (syntax_ == Syntax::Exact)
+                return ignore_case_ ? lower_name == prefix_ : name == pattern_;
+            return std::regex_match(ignore_case_ ? lower_name : name, regex_);
+        }
+
+        //lower case literal all matches start with, may be empty
+        const std::string& getPrefix() const
+        {
+            return prefix_;
+        }
+        //lower case literal all matches contain, may be empty
+        const std::string& getRequired() const
+        {
+            return required_;
+        }
+        //only names equal to prefix ignoring case can match
+        bool isLiteral() const
+        {
+            return is_literal_;
+        }
+        const std::string& getKey() const
+        {
+            return key_;
+        }
+
+        static std::string toLower(const std::string& str)
+        {
+            return Utils::toLower(str);
+        }
+
+    private:
+        static std::string wildcardToRegex(const std::string& wildcard)
+        {
+            std::string regex;
+            for (char c : wildcard) {
+                if (c == '*')
+                    regex += ".*";
+                else if (c == '?')
+                    regex += '.';
+                else {
+                    if (std::strchr("\\^$.|+()[]{}", c) != nullptr)
+                        regex += '\\';
+                    regex += c;
+                }
+            }
+            return regex;
+        }
+
+        static size_t skipClass(const std::string& re, size_t i)
+        {
+            //i is at '[', returns index after the closing ']'
+            ++i;
+            if (i < re.size() && re[i] == '^')
+                ++i;
+            if (i < re.size() && re[i] == ']')
+                ++i;
+            while (i < re.size() && re[i] != ']')
+                i += re[i] == '\\' ? 2 : 1;
+            return i + 1;
+        }
+
+        static size_t skipGroup(const std::string& re, size_t i)
+        {
+            //i is at '(', returns index after the matching ')'
+            int depth = 0;
+            while (i < re.size()) {
+                const char c = re[i];
+                if (c == '\\')
+                    i += 2;
+                else if (c == '[')
+                    i = skipClass(re, i);
+                else {
+                    if (c == '(')
+                        ++depth;
+                    else if (c == ')' && --depth == 0)
+                        return i + 1;
+                    ++i;
+                }
+            }
+            return i;
+        }
+
+        //literal runs outside groups and classes that every match of the whole pattern contains;
+        //anything not understood ends a run, so the result is safe but may be shorter than possible
+        static void analyzeRegex(const std::string& re, std::string& prefix, std::string& required, bool& is_literal)
+        {
+            prefix.clear();
+            required.clear();
+            is_literal = true;
+
+            //top level alternation means no literal is required at all
+            for (size_t i = 0; i < re.size();) {
+                if (re[i] == '\\')
+                    i += 2;
+                else if (re[i] == '[')
+                    i = skipClass(re, i);
+                else if (re[i] == '(')
+                    i = skipGroup(re, i);
+                else if (re[i] == '|') {
+                    is_literal = false;
+                    return;
+                }
+                else
+                    ++i;
+            }
+
+            std::string run;
+            bool run_at_start = true;
+            auto endRun = [&]() {
+                if (run_at_start)
+                    prefix = run;
+                run_at_start = false;
+                if (run.size() > required.size())
+                    required = run;
+                run.clear();
+            };
+
+            size_t i = 0;
+            if (i < re.size() && re[i] == '^')
+                ++i;
+            while (i < re.size()) {
+                const char c = re[i];
+                size_t next = i + 1;
+                bool is_char = false;
+                char literal = 0;
+                if (c == '\\') {
+                    next = i + 2;
+                    //escaped punctuation is literal, escaped letters and digits are classes or references
+                    if (i + 1 < re.size() && !std::isalnum(static_cast<unsigned char>(re[i + 1]))) {
+                        literal = re[i + 1];
+                        is_char = true;
+                    }
+                }
+                else if (std::strchr(".[]()*+?{}|^$", c) == nullptr) {
+                    literal = c;
+                    is_char = true;
+                }
+
+                if (is_char) {
+                    const char quantifier = next < re.size() ? re[next] : 0;
+                    if (quantifier == '*' || quantifier == '?' || quantifier == '{') {
+                        //optional or counted, skip it and let the quantifier end the run
+                        is_literal = false;
+                        i = next;
+                        continue;
+                    }
+                    run += literal;
+                    if (quantifier == '+') {
+                        //present at least once but what follows is not adjacent
+                        is_literal = false;
+                        endRun();
+                        next += 1;
+                    }
+                    i = next;
+                    continue;
+                }
+
+                is_literal = false;
+                endRun();
+                if (c == '[')
+                    i = skipClass(re, i);
+                else if (c == '(')
+                    i = skipGroup(re, i);
+                else if (c == '{') {
+                    while (i < re.size() && re[i] != '}')
+                        ++i;
+                    ++i;
+                }
+                else
+                    i = next;
+            }
+            endRun();
+        }
+
+    private:
+        std::string pattern_;
+        Syntax syntax_;
+        bool ignore_case_;
+        std::string key_;
+        std::regex regex_;
+        std::string prefix_, required_;
+        bool is_literal_ = false;
+    };
+
+    /*
+    Values, e.g. scene objects, indexed by name for pattern queries that cost time in proportion
+    to the names in the pattern's literal prefix range rather than all values. Names are kept
+    sorted by their lower case form, names differing only in case share a slot.
+
+    The matching names of each pattern are remembered until a name is added, so repeating a query
+    costs only the matches. Values can be removed through the vectors forEachMatch hands out,
+    e.g. to drop dead objects as they are found, without forgetting remembered matches.
+
+    Not thread safe.
+    */
+    template <typename TValue>
+    class NameIndex
+    {
+    public:
+        void add(const std::string& name, const TValue& value, bool skip_duplicate = false)
+        {
+            std::vector<Group>& groups = names_[NamePattern::toLower(name)];
+            for (Group& group : groups) {
+                if (group.name == name) {
+                    if (!skip_duplicate || std::find(group.values.begin(), group.values.end(), value) == group.values.end())
+                        group.values.push_back(value);
+                    return;
+                }
+            }
+
+            //groups may move, matches remembered so far are stale
+            groups.push_back(Group{ name, { value } });
+            ++generation_;
+            ++name_count_;
+        }
+
+        void clear()
+        {
+            names_.clear();
+            matches_.clear();
+            name_count_ = 0;
+            ++generation_;
+        }
+
+        //calls func(name, values) for every name matching pattern, values may be modified
+        template <typename TFunc>
+        void forEachMatch(const NamePattern& pattern, TFunc func)
+        {
+            Matches& matches = matches_[pattern.getKey()];
+            if (matches.generation != generation_) {
+                matches.generation = generation_;
+                matches.names.clear();
+                findMatches(pattern, matches.names);
+
+                if (matches_.size() > kMaxRemembered) {
+                    //keep only this pattern's matches, older ones are rebuilt when used again
+                    Matches kept = std::move(matches);
+                    matches_.clear();
+                    matches_[pattern.getKey()] = std::move(kept);
+                }
+            }
+
+            for (Group* group : matches_[pattern.getKey()].names)
+                func(group->name, group->values);
+        }
+
+        size_t getNameCount() const
+        {
+            return name_count_;
+        }
+
+    private:
+        struct Group
+        {
+            std::string name;
+            std::vector<TValue> values;
+        };
+        typedef std::vector<Group*> MatchList;
+
+        struct Matches
+        {
+            uint64_t generation = Utils::max<uint64_t>();
+            MatchList names;
+        };
+
+        void findMatches(const NamePattern& pattern, MatchList& out)
+        {
+            auto addGroups = [&](const std::string& lower_name, std::vector<Group>& groups) {
+                if (!pattern.getRequired().empty() && lower_name.find(pattern.getRequired()) == std::string::npos)
+                    return;
+                for (Group& group : groups) {
+                    if (pattern.matches(group.name, lower_name))
+                        out.push_back(&group);
+                }
+            };
+
+            if (pattern.isLiteral()) {
+                auto found = names_.find(pattern.getPrefix());
+                if (found != names_.end())
+                    addGroups(found->first, found->second);
+                return;
+            }
+
+            const std::string& prefix = pattern.getPrefix();
+            for (auto it = names_.lower_bound(prefix); it != names_.end(); ++it) {
+                if (it->first.compare(0, prefix.size(), prefix) != 0)
+                    break;
+                addGroups(it->first, it->second);
+            }
+        }
+
+    private:
+        static constexpr size_t kMaxRemembered = 64;
+
+        std::map<std::string, std::vector<Group>> names_;
+        std::unordered_map<std::string, Matches> matches_;
+        uint64_t generation_ = 0;
+        size_t name_count_ = 0;
+    };
+}
+} //namespace
+#endif
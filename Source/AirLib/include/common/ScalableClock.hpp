@@ -20,8 +20,9 @@ namespace airlib
         ScalableClock(double scale = 1, TTimeDelta latency = 0)
             : scale_(scale), latency_(latency)
         {
-            offset_ = latency * (scale_ - 1);
-            start_ = nowNanos();
+            //sim nanoseconds per wall nanosecond in 32.32 fixed point
+            rate_ = static_cast<uint64_t>(std::llround(4294967296.0 / scale_));
+            start_ = wall_start_ = Utils::getTimeSinceEpochNanos();
 
             unused(latency_);
         }
@@ -30,17 +31,13 @@ namespace airlib
 
         virtual TTimePoint nowNanos() const override
         {
-            if (offset_ == 0 && scale_ == 1) //optimized normal route
+            if (scale_ == 1) //optimized normal route
                 return Utils::getTimeSinceEpochNanos();
             else {
-                /*
-                Apply scaling and latency.
-
-                Time point is nanoseconds from some reference r. If latency = 0 then r = 0 .
-                scaled time point is then given by (r + ((now - r) / scale)).
-                This becomes (r*(s-1) + now)/scale or (offset + now / scale).
-            */
-                return static_cast<TTimePoint>((Utils::getTimeSinceEpochNanos() + offset_) / scale_);
+                //sim time starts at wall time and runs 1/scale as fast from there, in integers so
+                //nanoseconds aren't lost to rounding this far from the epoch
+                const TTimePoint wall_now = Utils::getTimeSinceEpochNanos();
+                return wall_now > wall_start_ ? start_ + mulFixed(wall_now - wall_start_, rate_) : start_;
             }
         }
 
@@ -77,10 +74,20 @@ namespace airlib
             return dt / scale_;
         }
 
+    private:
+        //(value * rate) >> 32 without overflowing the intermediate product
+        static uint64_t mulFixed(uint64_t value, uint64_t rate)
+        {
+            const uint64_t value_hi = value >> 32, value_lo = value & 0xFFFFFFFFu;
+            const uint64_t rate_hi = rate >> 32, rate_lo = rate & 0xFFFFFFFFu;
+            return ((value_hi * rate_hi) << 32) + value_hi * rate_lo + value_lo * rate_hi + ((value_lo * rate_lo) >> 32);
+        }
+
     private:
         double scale_;
         TTimeDelta latency_;
-        double offset_;
+        uint64_t rate_;
+        TTimePoint wall_start_;
         TTimePoint start_;
     };
 }
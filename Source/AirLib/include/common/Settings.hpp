@@ -30,6 +30,12 @@ namespace airlib
         nlohmann::json doc_;
         bool load_success_ = false;
 
+        //children returned by getChild() don't copy their sub-document, they just point
+        //into the parent's document. The parent must outlive them, which is the case for
+        //everything that walks the singleton. Copying a Settings or modifying a child makes
+        //it own its document again.
+        const nlohmann::json* view_ = nullptr;
+
     private:
         static std::mutex& getFileAccessMutex()
         {
@@ -37,7 +43,74 @@ namespace airlib
             return file_access;
         }
 
+        const nlohmann::json& doc() const
+        {
+            return view_ != nullptr ? *view_ : doc_;
+        }
+
+        nlohmann::json& mutableDoc()
+        {
+            if (view_ != nullptr) {
+                doc_ = *view_;
+                view_ = nullptr;
+            }
+            return doc_;
+        }
+
+        //returns nullptr if key doesn't exist so callers only do one lookup
+        const nlohmann::json* findValue(const std::string& name) const
+        {
+            const nlohmann::json& d = doc();
+            if (!d.is_object())
+                return nullptr;
+            auto it = d.find(name);
+            return it != d.end() ? &(*it) : nullptr;
+        }
+
     public:
+        Settings() = default;
+
+        //a view points into another Settings' document, never into other's own doc_, so the
+        //view moves over as is; other is left an empty document rather than a second view
+        Settings(Settings&& other)
+            : full_filepath_(std::move(other.full_filepath_)), doc_(std::move(other.doc_)), load_success_(other.load_success_), view_(other.view_)
+        {
+            other.doc_ = nlohmann::json();
+            other.load_success_ = false;
+            other.view_ = nullptr;
+        }
+
+        Settings& operator=(Settings&& other)
+        {
+            if (this != &other) {
+                full_filepath_ = std::move(other.full_filepath_);
+                doc_ = std::move(other.doc_);
+                load_success_ = other.load_success_;
+                view_ = other.view_;
+
+                other.doc_ = nlohmann::json();
+                other.load_success_ = false;
+                other.view_ = nullptr;
+            }
+            return *this;
+        }
+
+        Settings(const Settings& other)
+            : full_filepath_(other.full_filepath_), doc_(other.doc()), load_success_(other.load_success_)
+        {
+        }
+
+        Settings& operator=(const Settings& other)
+        {
+            if (this != &other) {
+                full_filepath_ = other.full_filepath_;
+                doc_ = other.doc();
+                load_success_ = other.load_success_;
+                view_ = nullptr;
+            }
+            return *this;
+        }
+
         static Settings& singleton()
         {
             static Settings instance;
@@ -62,6 +135,7 @@ namespace airlib
         {
             singleton().full_filepath_ = "";
             singleton().load_success_ = false;
+            singleton().view_ = nullptr;
 
             if (json_str.length() > 0) {
                 std::stringstream ss;
@@ -76,7 +150,7 @@ namespace airlib
         {
             std::lock_guard<std::mutex> guard(getFileAccessMutex());
             std::stringstream ss;
-            ss << std::setw(2) << singleton().doc_ << std::endl;
+            ss << std::setw(2) << singleton().doc() << std::endl;
 
             return ss.str();
         }
@@ -87,6 +161,7 @@ namespace airlib
             singleton().full_filepath_ = full_filepath;
 
             singleton().load_success_ = false;
+            singleton().view_ = nullptr;
 
             std::ifstream s;
             common_utils::FileSystem::openTextFile(full_filepath, s);
@@ -114,15 +189,15 @@ namespace airlib
             singleton().full_filepath_ = full_filepath;
             std::ofstream s;
             common_utils::FileSystem::createTextFile(full_filepath, s);
-            s << std::setw(2) << doc_ << std::endl;
+            s << std::setw(2) << doc() << std::endl;
         }
 
         bool getChild(const std::string& name, Settings& child) const
         {
-            if (doc_.count(name) == 1 &&
-                (doc_[name].type() == nlohmann::detail::value_t::object ||
-                 doc_[name].type() == nlohmann::detail::value_t::array)) {
-                child.doc_ = doc_[name].get<nlohmann::json>();
+            const nlohmann::json* value = findValue(name);
+            if (value != nullptr && (value->is_object() || value->is_array())) {
+                child.doc_ = nlohmann::json();
+                child.view_ = value;
                 return true;
             }
             return false;
@@ -130,24 +205,27 @@ namespace airlib
 
         size_t size() const
         {
-            return doc_.size();
+            return doc().size();
         }
 
         template <typename Container>
         void getChildNames(Container& c) const
         {
-            for (auto it = doc_.begin(); it != doc_.end(); ++it) {
+            const nlohmann::json& d = doc();
+            for (auto it = d.begin(); it != d.end(); ++it) {
                 c.push_back(it.key());
             }
         }
 
         bool getChild(size_t index, Settings& child) const
         {
-            if (doc_.size() > index &&
-                (doc_[index].type() == nlohmann::detail::value_t::object ||
-                 doc_[index].type() == nlohmann::detail::value_t::array)) {
+            const nlohmann::json& d = doc();
+            if (d.size() > index &&
+                (d[index].type() == nlohmann::detail::value_t::object ||
+                 d[index].type() == nlohmann::detail::value_t::array)) {
 
-                child.doc_ = doc_[index].get<nlohmann::json>();
+                child.doc_ = nlohmann::json();
+                child.view_ = &d[index];
                 return true;
             }
             return false;
@@ -155,87 +233,71 @@ namespace airlib
 
         std::string getString(const std::string& name, std::string defaultValue) const
         {
-            if (doc_.count(name) == 1) {
-                return doc_[name].get<std::string>();
-            }
-            else {
-                return defaultValue;
-            }
+            const nlohmann::json* value = findValue(name);
+            return value != nullptr ? value->get<std::string>() : defaultValue;
         }
 
         double getDouble(const std::string& name, double defaultValue) const
         {
-            if (doc_.count(name) == 1) {
-                return doc_[name].get<double>();
-            }
-            else {
-                return defaultValue;
-            }
+            const nlohmann::json* value = findValue(name);
+            return value != nullptr ? value->get<double>() : defaultValue;
         }
 
         float getFloat(const std::string& name, float defaultValue) const
         {
-            if (doc_.count(name) == 1) {
-                return doc_[name].get<float>();
-            }
-            else {
-                return defaultValue;
-            }
+            const nlohmann::json* value = findValue(name);
+            return value != nullptr ? value->get<float>() : defaultValue;
         }
 
         bool getBool(const std::string& name, bool defaultValue) const
         {
-            if (doc_.count(name) == 1) {
-                return doc_[name].get<bool>();
-            }
-            else {
-                return defaultValue;
-            }
+            const nlohmann::json* value = findValue(name);
+            return value != nullptr ? value->get<bool>() : defaultValue;
         }
 
         bool hasKey(const std::string& key) const
         {
-            return doc_.find(key) != doc_.end();
+            return findValue(key) != nullptr;
         }
 
         int getInt(const std::string& name, int defaultValue) const
         {
-            if (doc_.count(name) == 1) {
-                return doc_[name].get<int>();
-            }
-            else {
-                return defaultValue;
-            }
+            const nlohmann::json* value = findValue(name);
+            return value != nullptr ? value->get<int>() : defaultValue;
         }
 
         bool setString(const std::string& name, std::string value)
         {
-            if (doc_.count(name) != 1 || doc_[name].type() != nlohmann::detail::value_t::string || doc_[name] != value) {
-                doc_[name] = value;
+            nlohmann::json& d = mutableDoc();
+            if (d.count(name) != 1 || d[name].type() != nlohmann::detail::value_t::string || d[name] != value) {
+                d[name] = value;
                 return true;
             }
             return false;
         }
         bool setDouble(const std::string& name, double value)
         {
-            if (doc_.count(name) != 1 || doc_[name].type() != nlohmann::detail::value_t::number_float || static_cast<double>(doc_[name]) != value) {
-                doc_[name] = value;
+            nlohmann::json& d = mutableDoc();
+            if (d.count(name) != 1 || d[name].type() != nlohmann::detail::value_t::number_float || static_cast<double>(d[name]) != value) {
+                d[name] = value;
                 return true;
             }
             return false;
         }
         bool setBool(const std::string& name, bool value)
         {
-            if (doc_.count(name) != 1 || doc_[name].type() != nlohmann::detail::value_t::boolean || static_cast<bool>(doc_[name]) != value) {
-                doc_[name] = value;
+            nlohmann::json& d = mutableDoc();
+            if (d.count(name) != 1 || d[name].type() != nlohmann::detail::value_t::boolean || static_cast<bool>(d[name]) != value) {
+                d[name] = value;
                 return true;
             }
             return false;
         }
         bool setInt(const std::string& name, int value)
         {
-            if (doc_.count(name) != 1 || doc_[name].type() != nlohmann::detail::value_t::number_integer || static_cast<int>(doc_[name]) != value) {
-                doc_[name] = value;
+            nlohmann::json& d = mutableDoc();
+            if (d.count(name) != 1 || d[name].type() != nlohmann::detail::value_t::number_integer || static_cast<int>(d[name]) != value) {
+                d[name] = value;
                 return true;
             }
             return false;
@@ -243,7 +305,7 @@ namespace airlib
 
         void setChild(const std::string& name, Settings& value)
         {
-            doc_[name] = value.doc_;
+            mutableDoc()[name] = value.doc();
         }
     };
 }
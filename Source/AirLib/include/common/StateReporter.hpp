@@ -7,6 +7,8 @@
 #include <sstream>
 #include <string>
 #include <iomanip>
+#include <type_traits>
+#include <vector>
 #include "common/Common.hpp"
 
 namespace msr
@@ -14,12 +16,155 @@ namespace msr
 namespace airlib
 {
 
+    //one write to a StateReporter, what's needed to format it later
+    struct StateReportField
+    {
+        enum class Kind : uint8_t
+        {
+            StartHeading,
+            EndHeading,
+            Name,
+            Vector,
+            Quaternion,
+            Integer,
+            Unsigned,
+            Real,
+            Text,
+            EndLine
+        };
+
+        Kind kind = Kind::Text;
+        string name; //heading or value name
+        bool has_name = false; //values written as "name: value"
+        char end = 0; //written after values and headings, 0 for nothing
+
+        Vector3r vector;
+        Quaternionr quaternion;
+        int64_t integer = 0; //EndHeading: heading size
+        uint64_t unsigned_integer = 0; //EndHeading: columns
+        double real = 0;
+        string text;
+
+        //changes whenever anything above changes
+        uint64_t version = 0;
+    };
+
+    //turns fields into the report text, formatting again only fields whose version changed
+    class StateReportFormatter
+    {
+    public:
+        void initialize(int float_precision, bool is_scientific_notation)
+        {
+            ss_.str(std::string());
+            ss_.clear();
+            if (float_precision >= 0) {
+                ss_ << std::setprecision(float_precision);
+                if (is_scientific_notation)
+                    ss_ << std::scientific;
+                else
+                    ss_ << std::fixed;
+            }
+            texts_.clear();
+            versions_.clear();
+            output_.clear();
+        }
+
+        const string& format(const std::vector<StateReportField>& fields, size_t count)
+        {
+            bool is_changed = count != texts_.size();
+            texts_.resize(count);
+            versions_.resize(count);
+
+            for (size_t i = 0; i < count; ++i) {
+                if (versions_[i] != fields[i].version) {
+                    formatField(fields[i], texts_[i]);
+                    versions_[i] = fields[i].version;
+                    is_changed = true;
+                }
+            }
+
+            if (is_changed) {
+                output_.clear();
+                for (const string& text : texts_)
+                    output_ += text;
+            }
+            return output_;
+        }
+
+    private:
+        void formatField(const StateReportField& field, string& text)
+        {
+            typedef StateReportField::Kind Kind;
+
+            ss_.str(std::string());
+            switch (field.kind) {
+            case Kind::StartHeading:
+                ss_ << "\n"
+                    << field.name;
+                break;
+            case Kind::EndHeading:
+                if (field.end != 0)
+                    ss_ << field.end;
+                for (int64_t lines = field.integer; lines > 0; --lines)
+                    ss_ << std::string(static_cast<size_t>(field.unsigned_integer), '_') << "\n";
+                break;
+            case Kind::Name:
+                ss_ << field.name << ": ";
+                break;
+            case Kind::Vector:
+                ss_ << field.name << ": "
+                    << "(" << field.vector.norm() << ") - "
+                    << "[" << field.vector.x() << ", " << field.vector.y() << ", " << field.vector.z() << "]\n";
+                break;
+            case Kind::Quaternion: {
+                real_T pitch, roll, yaw;
+                VectorMath::toEulerianAngle(field.quaternion, pitch, roll, yaw);
+
+                ss_ << field.name << ":\n"
+                    << "    euler: (" << roll << ", " << pitch << ", " << yaw << ")\n"
+                    << "    quat: [" << field.quaternion.w() << ", " << field.quaternion.x() << ", "
+                    << field.quaternion.y() << ", " << field.quaternion.z() << "]\n";
+                break;
+            }
+            case Kind::EndLine:
+                ss_ << "\n";
+                break;
+            default:
+                if (field.has_name)
+                    ss_ << field.name << ": ";
+                if (field.kind == Kind::Integer)
+                    ss_ << field.integer;
+                else if (field.kind == Kind::Unsigned)
+                    ss_ << field.unsigned_integer;
+                else if (field.kind == Kind::Real)
+                    ss_ << field.real;
+                else
+                    ss_ << field.text;
+                if (field.end != 0)
+                    ss_ << field.end;
+                break;
+            }
+            text = ss_.str();
+        }
+
+    private:
+        std::stringstream ss_;
+        std::vector<string> texts_;
+        std::vector<uint64_t> versions_;
+        string output_;
+    };
+
     /*
     This class is simple key-value reporting provider. It can't inherit from
-    UpdatableObject or we will have circular dependency. This class essentially
-    just provides formatted write APIs over string buffer. The UpdatableObject
+    UpdatableObject or we will have circular dependency. The UpdatableObject
     version is provided by StateReporterWrapper. We expect everyone to use
     StateReporterWrapper instead of StateReporter directly.
+
+    Writes don't format anything. Objects write the same values in the same order
+    every time they report, so each write takes the field at the same position in
+    the previous report and only compares and copies the value, marking the field
+    changed if it differs. The text is made by StateReportFormatter when someone
+    asks for it, reformatting only changed fields.
 */
     class StateReporter
     {
@@ -40,17 +185,28 @@ namespace airlib
                 else
                     ss_ << std::fixed;
             }
+            formatter_.initialize(float_precision_, is_scientific_notation_);
         }
 
+        //starts a new report
         void clear()
         {
-            ss_.str(std::string());
-            ss_.clear();
+            field_count_ = 0;
         }
 
         string getOutput() const
         {
-            return ss_.str();
+            return formatter_.format(fields_, field_count_);
+        }
+
+        //fields written since clear(), valid up to getFieldCount()
+        const std::vector<StateReportField>& getFields() const
+        {
+            return fields_;
+        }
+        size_t getFieldCount() const
+        {
+            return field_count_;
         }
 
         //write APIs - heading
@@ -59,15 +215,14 @@ namespace airlib
         {
             unused(heading_size);
             unused(columns);
-            ss_ << "\n";
-            ss_ << heading;
+            nextField(StateReportField::Kind::StartHeading, heading);
         }
         void endHeading(bool end_line, uint heading_size, uint columns = 20)
         {
-            if (end_line)
-                ss_ << "\n";
-            for (int lines = heading_size; lines > 0; --lines)
-                ss_ << std::string(columns, '_') << "\n";
+            StateReportField& field = nextField(StateReportField::Kind::EndHeading, string());
+            setValue(field, field.end, end_line ? '\n' : '\0');
+            setValue(field, field.integer, static_cast<int64_t>(heading_size));
+            setValue(field, field.unsigned_integer, static_cast<uint64_t>(columns));
         }
         void writeHeading(string heading, uint heading_size = 0, uint columns = 20)
         {
@@ -78,48 +233,113 @@ namespace airlib
         //write APIs - specialized objects
         void writeValue(string name, const Vector3r& vector)
         {
-            ss_ << name << ": "
-                << "(" << vector.norm() << ") - "
-                << "[" << vector.x() << ", " << vector.y() << ", " << vector.z() << "]\n";
+            StateReportField& field = nextField(StateReportField::Kind::Vector, name);
+            setValue(field, field.vector, vector);
         }
         void writeValue(string name, const Quaternionr& quat)
         {
-            real_T pitch, roll, yaw;
-            VectorMath::toEulerianAngle(quat, pitch, roll, yaw);
-
-            ss_ << name << ":\n"
-                << "    euler: (" << roll << ", " << pitch << ", " << yaw << ")\n"
-                << "    quat: [" << quat.w() << ", " << quat.x() << ", " << quat.y() << ", " << quat.z() << "]\n";
+            StateReportField& field = nextField(StateReportField::Kind::Quaternion, name);
+            if (field.quaternion.coeffs() != quat.coeffs()) {
+                field.quaternion = quat;
+                field.version = ++version_;
+            }
         }
 
         //write APIs - generic values
         template <typename T>
         void writeValue(string name, const T& r)
         {
-            writeNameOnly(name);
-            writeValueOnly(r, true);
+            writeValue(name, true, r, '\n');
         }
         void writeNameOnly(string name)
         {
-            ss_ << name << ": ";
+            nextField(StateReportField::Kind::Name, name);
         }
         template <typename T>
         void writeValueOnly(const T& r, bool end_line_or_tab = false)
         {
-            ss_ << r;
-
-            if (end_line_or_tab)
-                ss_ << "\n";
-            else
-                ss_ << "\t";
+            writeValue(string(), false, r, end_line_or_tab ? '\n' : '\t');
         }
         void endl()
         {
-            ss_ << std::endl;
+            nextField(StateReportField::Kind::EndLine, string());
+        }
+
+    private:
+        //the field at the current position, set up anew if the previous report wrote something else there
+        StateReportField& nextField(StateReportField::Kind kind, const string& name)
+        {
+            if (field_count_ == fields_.size())
+                fields_.emplace_back();
+
+            StateReportField& field = fields_[field_count_++];
+            if (field.kind != kind || field.name != name || field.version == 0) {
+                field = StateReportField();
+                field.kind = kind;
+                field.name = name;
+                field.version = ++version_;
+            }
+            return field;
+        }
+
+        template <typename TValue>
+        void setValue(StateReportField& field, TValue& stored, const TValue& value)
+        {
+            if (stored != value) {
+                stored = value;
+                field.version = ++version_;
+            }
+        }
+
+        template <typename T>
+        void writeValue(const string& name, bool has_name, const T& r, char end)
+        {
+            StateReportField& field = nextField(getKind<T>(), name);
+            setValue(field, field.has_name, has_name);
+            setValue(field, field.end, end);
+            setFieldValue(field, r);
+        }
+
+        template <typename T>
+        static constexpr StateReportField::Kind getKind()
+        {
+            return std::is_floating_point<T>::value ? StateReportField::Kind::Real
+                   : std::is_integral<T>::value     ? (std::is_signed<T>::value ? StateReportField::Kind::Integer : StateReportField::Kind::Unsigned)
+                                                    : StateReportField::Kind::Text;
+        }
+
+        template <typename T>
+        typename std::enable_if<std::is_floating_point<T>::value>::type setFieldValue(StateReportField& field, const T& r)
+        {
+            setValue(field, field.real, static_cast<double>(r));
+        }
+        template <typename T>
+        typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type setFieldValue(StateReportField& field, const T& r)
+        {
+            setValue(field, field.integer, static_cast<int64_t>(r));
+        }
+        template <typename T>
+        typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value>::type setFieldValue(StateReportField& field, const T& r)
+        {
+            setValue(field, field.unsigned_integer, static_cast<uint64_t>(r));
+        }
+        template <typename T>
+        typename std::enable_if<!std::is_arithmetic<T>::value>::type setFieldValue(StateReportField& field, const T& r)
+        {
+            //anything else is formatted right away
+            ss_.str(std::string());
+            ss_ << r;
+            const string text = ss_.str();
+            setValue(field, field.text, text);
         }
 
     private:
+        std::vector<StateReportField> fields_;
+        size_t field_count_ = 0;
+        uint64_t version_ = 0;
+
         std::stringstream ss_;
+        mutable StateReportFormatter formatter_;
 
         int float_precision_ = 2;
         bool is_scientific_notation_ = false;
@@ -4,12 +4,15 @@
 #ifndef airsim_core_StateReporterWrapper_hpp
 #define airsim_core_StateReporterWrapper_hpp
 
+#include <atomic>
 #include <sstream>
 #include <string>
 #include <iomanip>
+#include <vector>
 #include "common/Common.hpp"
 #include "common_utils/OnlineStats.hpp"
 #include "common/FrequencyLimiter.hpp"
+#include "common/TripleBuffer.hpp"
 #include "UpdatableObject.hpp"
 #include "StateReporter.hpp"
 
@@ -18,6 +21,15 @@ namespace msr
 namespace airlib
 {
 
+    /*
+    Writes reports at the report frequency and hands them to the thread that shows them. The
+    reporting thread fills getReporter() and calls publishReport(), or, given a source, update()
+    reports the source itself. Only values are copied there; the text is formatted by getOutput()
+    on the reading thread, from the latest published report.
+
+    No new report is made until the previous one was read, so nothing is written or formatted
+    while nobody looks at the output.
+    */
     class StateReporterWrapper : public UpdatableObject
     {
     public:
@@ -30,16 +42,38 @@ namespace airlib
         void initialize(bool enabled = false, int float_precision = 3, bool is_scientific_notation = false)
         {
             enabled_ = enabled;
+            is_freq_enabled_ = enabled;
             report_.initialize(float_precision, is_scientific_notation);
+            formatter_.initialize(float_precision, is_scientific_notation);
             report_freq_.initialize(DefaultReportFreq);
         }
 
+        //object whose reportState update() calls when a report is due, nullptr to report by hand
+        void setSource(UpdatableObject* source)
+        {
+            source_ = source;
+        }
+
         void clearReport()
         {
             report_.clear();
             is_wait_complete = false;
         }
 
+        //makes the report written since clearReport() the one getOutput() returns
+        void publishReport()
+        {
+            Snapshot& snapshot = snapshots_.getWriteBuffer();
+            const std::vector<StateReportField>& fields = report_.getFields();
+            snapshot.count = report_.getFieldCount();
+            if (snapshot.fields.size() < snapshot.count)
+                snapshot.fields.resize(snapshot.count);
+            std::copy(fields.begin(), fields.begin() + snapshot.count, snapshot.fields.begin());
+
+            is_consumed_ = false;
+            snapshots_.publish();
+        }
+
         //*** Start: UpdatableState implementation ***//
         virtual void resetImplementation() override
         {
@@ -62,11 +96,24 @@ namespace airlib
 
             TTimeDelta dt = clock()->updateSince(last_time_);
 
-            if (enabled_) {
+            //enabled_ may be set from another thread, the limiter only changes here
+            const bool enabled = enabled_;
+            if (enabled != is_freq_enabled_) {
+                is_freq_enabled_ = enabled;
+                report_freq_.initialize(enabled ? DefaultReportFreq : 0);
+            }
+
+            if (enabled) {
                 dt_stats_.insert(dt);
                 report_freq_.update();
                 is_wait_complete = is_wait_complete || report_freq_.isWaitComplete();
             }
+
+            if (source_ != nullptr && canReport()) {
+                clearReport();
+                source_->reportState(report_);
+                publishReport();
+            }
         }
         virtual void reportState(StateReporter& reporter) override
         {
@@ -83,7 +130,7 @@ namespace airlib
 
         bool canReport()
         {
-            return enabled_ && is_wait_complete;
+            return enabled_ && is_wait_complete && is_consumed_;
         }
 
         StateReporter* getReporter()
@@ -91,9 +138,14 @@ namespace airlib
             return &report_;
         }
 
+        //text of the latest published report, only from one thread
         string getOutput()
         {
-            return report_.getOutput();
+            snapshots_.read();
+            is_consumed_ = true;
+
+            const Snapshot& snapshot = snapshots_.getReadBuffer();
+            return formatter_.format(snapshot.fields, snapshot.count);
         }
 
         void setReportFreq(real_T freq)
@@ -101,16 +153,10 @@ namespace airlib
             report_freq_.initialize(freq);
         }
 
+        //may be called from any thread
         void setEnable(bool enable)
         {
-            if (enable == enabled_)
-                return;
-
             enabled_ = enable;
-            if (enable)
-                report_freq_.initialize(DefaultReportFreq);
-            else
-                report_freq_.initialize(0);
         }
         bool getEnable()
         {
@@ -120,12 +166,24 @@ namespace airlib
     private:
         typedef common_utils::OnlineStats OnlineStats;
 
+        struct Snapshot
+        {
+            std::vector<StateReportField> fields;
+            size_t count = 0;
+        };
+
         StateReporter report_;
+        UpdatableObject* source_ = nullptr;
+
+        TripleBuffer<Snapshot> snapshots_;
+        StateReportFormatter formatter_;
+        std::atomic<bool> is_consumed_{ true };
 
         OnlineStats dt_stats_;
 
         FrequencyLimiter report_freq_;
-        bool enabled_;
+        std::atomic<bool> enabled_{ false };
+        bool is_freq_enabled_ = false;
         bool is_wait_complete = false;
         TTimePoint last_time_;
     };
@@ -23,7 +23,7 @@ namespace airlib
         //step is how much we would advance the clock by default when calling step()
         //by default we advance by 20ms
         SteppableClock(TTimeDelta step = DefaultStepSize, TTimePoint start = 0)
-            : current_(start), step_(step)
+            : current_(start), step_(step), step_nanos_(toNanos(step))
         {
             start_ = current_ = start ? start : Utils::getTimeSinceEpochNanos();
         }
@@ -40,8 +40,8 @@ namespace airlib
         {
             ClockBase::step();
 
-            current_ = addTo(current_, step_);
-            return current_;
+            //whole nanoseconds so steps add up exactly
+            return current_ += step_nanos_;
         }
 
         TTimeDelta getStepSize() const
@@ -64,6 +64,7 @@ namespace airlib
         std::atomic<TTimePoint> start_;
 
         TTimeDelta step_;
+        TTimePoint step_nanos_;
     };
 }
 } //namespace
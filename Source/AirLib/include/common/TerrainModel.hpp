@@ -0,0 +1,425 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef airsim_core_TerrainModel_hpp
+#define airsim_core_TerrainModel_hpp
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include "common/Common.hpp"
+#include "common/common_utils/MemoryMappedFile.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    /*
+    Ground elevation from digital elevation model tiles, for ground height without the game
+    engine's collision. Tiles are GeoTIFF files or raw heightmaps on a latitude/longitude grid.
+    Their files are memory mapped rather than read, so only the pages around where vehicles are
+    get loaded and the OS file cache keeps them; the last tile sampled is tried first.
+
+    Tiles are added while setting up. After that the model is only read, from any thread.
+    */
+    class TerrainModel
+    {
+    public:
+        enum class SampleType
+        {
+            Int16,
+            UInt16,
+            Float32
+        };
+
+        //rows of samples from north to south, each from west to east, little endian
+        struct RawTileFormat
+        {
+            uint columns = 0;
+            uint rows = 0;
+            SampleType sample_type = SampleType::Int16;
+
+            //first sample, in degrees
+            double north = 0;
+            double west = 0;
+            //between samples, in degrees
+            double latitude_spacing = 0;
+            double longitude_spacing = 0;
+
+            //meters above mean sea level = sample * height_scale + height_offset
+            real_T height_scale = 1;
+            real_T height_offset = 0;
+
+            //samples equal to no_data are holes
+            bool has_no_data = false;
+            double no_data = 0;
+        };
+
+    public:
+        //uncompressed GeoTIFF with one sample per pixel on a geographic grid, as gdal_translate
+        //writes with -co COMPRESS=NONE; throws std::invalid_argument for anything else
+        void addGeoTiff(const std::string& filepath)
+        {
+            std::unique_ptr<Tile> tile(new Tile());
+            tile->file.open(filepath);
+            readGeoTiff(filepath, *tile);
+            addTile(std::move(tile));
+        }
+
+        void addRawTile(const std::string& filepath, const RawTileFormat& format)
+        {
+            std::unique_ptr<Tile> tile(new Tile());
+            tile->file.open(filepath);
+            tile->format = format;
+            tile->sample_size = getSampleSize(format.sample_type);
+
+            const uint64_t row_size = static_cast<uint64_t>(format.columns) * tile->sample_size;
+            for (uint row = 0; row < format.rows; ++row)
+                tile->row_offsets.push_back(row * row_size);
+
+            addTile(std::move(tile));
+        }
+
+        bool empty() const
+        {
+            return tiles_.empty();
+        }
+
+        //meters above mean sea level, NaN where there is no data
+        real_T groundHeightAt(double latitude, double longitude) const
+        {
+            Vector2r slope;
+            return groundHeightAt(latitude, longitude, slope);
+        }
+
+        //also gives the slope, meters of rise per meter north and per meter east
+        real_T groundHeightAt(double latitude, double longitude, Vector2r& slope) const
+        {
+            const size_t hint = last_tile_.load(std::memory_order_relaxed);
+            if (hint < tiles_.size() && contains(*tiles_[hint], latitude, longitude))
+                return sample(*tiles_[hint], latitude, longitude, slope);
+
+            for (size_t tile_index = 0; tile_index < tiles_.size(); ++tile_index) {
+                if (contains(*tiles_[tile_index], latitude, longitude)) {
+                    last_tile_.store(tile_index, std::memory_order_relaxed);
+                    return sample(*tiles_[tile_index], latitude, longitude, slope);
+                }
+            }
+
+            slope = Vector2r::Zero();
+            return Utils::nan<real_T>();
+        }
+
+    private:
+        struct Tile
+        {
+            common_utils::MemoryMappedFile file;
+            RawTileFormat format;
+            uint sample_size = 0;
+
+            //byte offset of each row in the file, for files stored by rows
+            std::vector<uint64_t> row_offsets;
+
+            //byte offset of each block in the file, for tiled GeoTIFFs
+            uint block_columns = 0;
+            uint block_rows = 0;
+            uint blocks_across = 0;
+            std::vector<uint64_t> block_offsets;
+        };
+
+        struct TiffEntry
+        {
+            uint16_t tag = 0;
+            uint16_t type = 0;
+            uint32_t count = 0;
+            uint64_t value_offset = 0; //of the values in the file
+        };
+
+    private:
+        void addTile(std::unique_ptr<Tile> tile)
+        {
+            const RawTileFormat& format = tile->format;
+            if (format.columns < 2 || format.rows < 2 || !(format.latitude_spacing > 0) || !(format.longitude_spacing > 0))
+                throw std::invalid_argument("Terrain tile needs at least 2x2 samples with positive spacing");
+
+            //check every sample is in the file once here so sampling doesn't have to
+            const uint64_t file_size = tile->file.size();
+            const uint64_t row_size = static_cast<uint64_t>(format.columns) * tile->sample_size;
+            if (tile->block_offsets.empty()) {
+                for (uint64_t row_offset : tile->row_offsets) {
+                    if (row_offset + row_size > file_size)
+                        throw std::invalid_argument("Terrain tile file is shorter than its samples");
+                }
+            }
+            else {
+                const uint64_t block_size = static_cast<uint64_t>(tile->block_columns) * tile->block_rows * tile->sample_size;
+                for (uint64_t block_offset : tile->block_offsets) {
+                    if (block_offset + block_size > file_size)
+                        throw std::invalid_argument("Terrain tile file is shorter than its samples");
+                }
+            }
+
+            tiles_.push_back(std::move(tile));
+        }
+
+        static bool contains(const Tile& tile, double latitude, double longitude)
+        {
+            const RawTileFormat& format = tile.format;
+            const double row = (format.north - latitude) / format.latitude_spacing;
+            const double column = (longitude - format.west) / format.longitude_spacing;
+            //a little past the edges so points on a tile's border aren't lost to rounding
+            constexpr double kEdge = 1E-6;
+            return row >= -kEdge && row <= format.rows - 1 + kEdge && column >= -kEdge && column <= format.columns - 1 + kEdge;
+        }
+
+        //bilinear between the four samples around the point
+        static real_T sample(const Tile& tile, double latitude, double longitude, Vector2r& slope)
+        {
+            const RawTileFormat& format = tile.format;
+            const double row_position = (format.north - latitude) / format.latitude_spacing;
+            const double column_position = (longitude - format.west) / format.longitude_spacing;
+            const uint row = std::min(static_cast<uint>(std::max(row_position, 0.0)), format.rows - 2);
+            const uint column = std::min(static_cast<uint>(std::max(column_position, 0.0)), format.columns - 2);
+            const real_T row_fraction = static_cast<real_T>(row_position - row);
+            const real_T column_fraction = static_cast<real_T>(column_position - column);
+
+            const real_T north_west = getSample(tile, row, column);
+            const real_T north_east = getSample(tile, row, column + 1);
+            const real_T south_west = getSample(tile, row + 1, column);
+            const real_T south_east = getSample(tile, row + 1, column + 1);
+            if (std::isnan(north_west) || std::isnan(north_east) || std::isnan(south_west) || std::isnan(south_east)) {
+                slope = Vector2r::Zero();
+                return Utils::nan<real_T>();
+            }
+
+            const real_T north = north_west + (north_east - north_west) * column_fraction;
+            const real_T south = south_west + (south_east - south_west) * column_fraction;
+
+            //rise per sample along the grid, rows go south
+            const real_T rise_east = (north_east - north_west) * (1 - row_fraction) + (south_east - south_west) * row_fraction;
+            const real_T rise_south = south - north;
+            const double meters_per_degree = Utils::degreesToRadians(1.0) * EARTH_RADIUS;
+            slope.x() = static_cast<real_T>(-rise_south / (format.latitude_spacing * meters_per_degree));
+            slope.y() = static_cast<real_T>(rise_east / (format.longitude_spacing * meters_per_degree * std::cos(Utils::degreesToRadians(latitude))));
+
+            return north + (south - north) * row_fraction;
+        }
+
+        static real_T getSample(const Tile& tile, uint row, uint column)
+        {
+            uint64_t offset;
+            if (tile.block_offsets.empty())
+                offset = tile.row_offsets[row] + static_cast<uint64_t>(column) * tile.sample_size;
+            else {
+                const uint block = (row / tile.block_rows) * tile.blocks_across + column / tile.block_columns;
+                const uint64_t in_block = static_cast<uint64_t>(row % tile.block_rows) * tile.block_columns + column % tile.block_columns;
+                offset = tile.block_offsets[block] + in_block * tile.sample_size;
+            }
+
+            //the file is little endian as are all our targets
+            const uint8_t* data = tile.file.data() + offset;
+            double value;
+            switch (tile.format.sample_type) {
+            case SampleType::Int16: {
+                int16_t raw;
+                std::memcpy(&raw, data, sizeof(raw));
+                value = raw;
+                break;
+            }
+            case SampleType::UInt16: {
+                uint16_t raw;
+                std::memcpy(&raw, data, sizeof(raw));
+                value = raw;
+                break;
+            }
+            default: {
+                float raw;
+                std::memcpy(&raw, data, sizeof(raw));
+                value = raw;
+                break;
+            }
+            }
+
+            if (tile.format.has_no_data && value == tile.format.no_data)
+                return Utils::nan<real_T>();
+            return static_cast<real_T>(value) * tile.format.height_scale + tile.format.height_offset;
+        }
+
+        static uint getSampleSize(SampleType sample_type)
+        {
+            return sample_type == SampleType::Float32 ? 4 : 2;
+        }
+
+        static void readGeoTiff(const std::string& filepath, Tile& tile)
+        {
+            const common_utils::MemoryMappedFile& file = tile.file;
+            if (file.size() < 8 || file.data()[0] != 'I' || file.data()[1] != 'I' || readTiff<uint16_t>(file, 2) != 42)
+                throw std::invalid_argument(Utils::stringf("%s is not a little endian GeoTIFF", filepath.c_str()));
+
+            //the first image
+            std::vector<TiffEntry> entries;
+            const uint64_t directory = readTiff<uint32_t>(file, 4);
+            const uint entry_count = readTiff<uint16_t>(file, directory);
+            for (uint entry_index = 0; entry_index < entry_count; ++entry_index) {
+                const uint64_t entry_offset = directory + 2 + entry_index * 12;
+                TiffEntry entry;
+                entry.tag = readTiff<uint16_t>(file, entry_offset);
+                entry.type = readTiff<uint16_t>(file, entry_offset + 2);
+                entry.count = readTiff<uint32_t>(file, entry_offset + 4);
+                //values that fit are in the entry itself
+                entry.value_offset = getTiffTypeSize(entry.type) * entry.count <= 4 ? entry_offset + 8 : readTiff<uint32_t>(file, entry_offset + 8);
+                entries.push_back(entry);
+            }
+
+            auto getValues = [&](uint16_t tag) {
+                std::vector<double> values;
+                for (const TiffEntry& entry : entries) {
+                    if (entry.tag == tag) {
+                        for (uint32_t index = 0; index < entry.count; ++index)
+                            values.push_back(readTiffValue(file, entry, index));
+                    }
+                }
+                return values;
+            };
+            auto getValue = [&](uint16_t tag, double default_value) {
+                const std::vector<double> values = getValues(tag);
+                return values.empty() ? default_value : values[0];
+            };
+            auto fail = [&](const char* reason) {
+                return std::invalid_argument(Utils::stringf("GeoTIFF %s is not supported: %s", filepath.c_str(), reason));
+            };
+
+            RawTileFormat& format = tile.format;
+            format.columns = static_cast<uint>(getValue(256, 0));
+            format.rows = static_cast<uint>(getValue(257, 0));
+            if (getValue(259, 1) != 1)
+                throw fail("it is compressed");
+            if (getValue(277, 1) != 1)
+                throw fail("it has more than one sample per pixel");
+
+            const uint bits = static_cast<uint>(getValue(258, 1));
+            const uint sample_format = static_cast<uint>(getValue(339, 1));
+            if (bits == 16 && sample_format == 2)
+                format.sample_type = SampleType::Int16;
+            else if (bits == 16 && sample_format == 1)
+                format.sample_type = SampleType::UInt16;
+            else if (bits == 32 && sample_format == 3)
+                format.sample_type = SampleType::Float32;
+            else
+                throw fail("samples are not 16 bit integers or 32 bit floats");
+            tile.sample_size = getSampleSize(format.sample_type);
+
+            const std::vector<double> tile_offsets = getValues(324);
+            if (!tile_offsets.empty()) {
+                tile.block_columns = static_cast<uint>(getValue(322, 0));
+                tile.block_rows = static_cast<uint>(getValue(323, 0));
+                if (tile.block_columns == 0 || tile.block_rows == 0)
+                    throw fail("its tiles have no size");
+                tile.blocks_across = (format.columns + tile.block_columns - 1) / tile.block_columns;
+                const uint blocks_down = (format.rows + tile.block_rows - 1) / tile.block_rows;
+                if (tile_offsets.size() < static_cast<size_t>(tile.blocks_across) * blocks_down)
+                    throw fail("tiles are missing");
+                tile.block_offsets.assign(tile_offsets.begin(), tile_offsets.end());
+            }
+            else {
+                const std::vector<double> strip_offsets = getValues(273);
+                const uint rows_per_strip = std::max(1u, static_cast<uint>(std::min<double>(getValue(278, format.rows), format.rows)));
+                if (strip_offsets.size() < (format.rows + rows_per_strip - 1) / rows_per_strip)
+                    throw fail("strips are missing");
+
+                const uint64_t row_size = static_cast<uint64_t>(format.columns) * tile.sample_size;
+                for (uint row = 0; row < format.rows; ++row)
+                    tile.row_offsets.push_back(static_cast<uint64_t>(strip_offsets[row / rows_per_strip]) + (row % rows_per_strip) * row_size);
+            }
+
+            //geo keys are a header of 4 values followed by key, location, count, value
+            const std::vector<double> geo_keys = getValues(34735);
+            bool is_pixel_point = false;
+            for (size_t key = 4; key + 3 < geo_keys.size(); key += 4) {
+                //only keys with their value in place
+                if (geo_keys[key + 1] != 0)
+                    continue;
+                if (geo_keys[key] == 1024 && geo_keys[key + 3] != 2)
+                    throw fail("it is not on a latitude/longitude grid");
+                if (geo_keys[key] == 1025)
+                    is_pixel_point = geo_keys[key + 3] == 2;
+            }
+
+            const std::vector<double> scale = getValues(33550);
+            const std::vector<double> tie_point = getValues(33922);
+            if (scale.size() < 2 || tie_point.size() < 6)
+                throw fail("it has no pixel scale or tie point");
+            format.longitude_spacing = scale[0];
+            format.latitude_spacing = scale[1];
+            //the tie point is a pixel's corner unless pixels are points, samples are in their middle
+            const double center = is_pixel_point ? 0 : 0.5;
+            format.west = tie_point[3] + (center - tie_point[0]) * format.longitude_spacing;
+            format.north = tie_point[4] - (center - tie_point[1]) * format.latitude_spacing;
+
+            //GDAL writes the no data value as text
+            for (const TiffEntry& entry : entries) {
+                if (entry.tag == 42113 && entry.count > 1 && entry.value_offset + entry.count <= file.size()) {
+                    const std::string text(reinterpret_cast<const char*>(file.data() + entry.value_offset), entry.count - 1);
+                    char* end = nullptr;
+                    format.no_data = std::strtod(text.c_str(), &end);
+                    format.has_no_data = end != text.c_str();
+                }
+            }
+        }
+
+        template <typename T>
+        static T readTiff(const common_utils::MemoryMappedFile& file, uint64_t offset)
+        {
+            if (offset + sizeof(T) > file.size())
+                throw std::invalid_argument("GeoTIFF ends within its header");
+
+            T value;
+            std::memcpy(&value, file.data() + offset, sizeof(T));
+            return value;
+        }
+
+        static double readTiffValue(const common_utils::MemoryMappedFile& file, const TiffEntry& entry, uint32_t index)
+        {
+            const uint64_t offset = entry.value_offset + static_cast<uint64_t>(index) * getTiffTypeSize(entry.type);
+            switch (entry.type) {
+            case 1: //byte
+            case 2: //ascii
+                return readTiff<uint8_t>(file, offset);
+            case 3: //short
+                return readTiff<uint16_t>(file, offset);
+            case 4: //long
+                return readTiff<uint32_t>(file, offset);
+            case 11: //float
+                return readTiff<float>(file, offset);
+            case 12: //double
+                return readTiff<double>(file, offset);
+            default:
+                throw std::invalid_argument(Utils::stringf("GeoTIFF value type %u is not supported", entry.type));
+            }
+        }
+
+        static uint getTiffTypeSize(uint16_t type)
+        {
+            switch (type) {
+            case 3:
+                return 2;
+            case 4:
+            case 11:
+                return 4;
+            case 12:
+                return 8;
+            default:
+                return 1;
+            }
+        }
+
+    private:
+        std::vector<std::unique_ptr<Tile>> tiles_;
+        mutable std::atomic<size_t> last_tile_{ 0 };
+    };
+}
+} //namespace
+#endif
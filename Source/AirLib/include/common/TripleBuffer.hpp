@@ -0,0 +1,81 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef air_TripleBuffer_hpp
+#define air_TripleBuffer_hpp
+
+#include <atomic>
+#include <cstdint>
+#include "common/Common.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    /*
+    Hands the newest value from one writer thread to one reader thread without locks. Each side
+    owns one of three buffers and they trade through the third, so the writer never waits for the
+    reader and the reader always gets the most recently published value; values published while
+    the reader wasn't looking are skipped.
+
+    Buffers are reused, so the writer must set every field it cares about before publishing.
+    */
+    template <typename T>
+    class TripleBuffer
+    {
+    public:
+        //writer: fill this, then publish()
+        T& getWriteBuffer()
+        {
+            return buffers_[write_index_];
+        }
+
+        //writer: makes the write buffer the newest value, returns true if the value it
+        //replaces was never read
+        bool publish()
+        {
+            const uint8_t previous = middle_.exchange(write_index_ | kFreshFlag, std::memory_order_acq_rel);
+            write_index_ = previous & kIndexMask;
+            return (previous & kFreshFlag) != 0;
+        }
+
+        //reader: takes the newest published value, returns false if nothing was published
+        //since the last read, in which case the read buffer keeps the value it had
+        bool read()
+        {
+            if ((middle_.load(std::memory_order_relaxed) & kFreshFlag) == 0)
+                return false;
+
+            read_index_ = middle_.exchange(read_index_, std::memory_order_acq_rel) & kIndexMask;
+            return true;
+        }
+
+        const T& getReadBuffer() const
+        {
+            return buffers_[read_index_];
+        }
+
+        //drops published values; only while neither side is using the buffer
+        void reset()
+        {
+            for (T& buffer : buffers_)
+                buffer = T();
+            write_index_ = 0;
+            read_index_ = 1;
+            middle_ = 2;
+        }
+
+    private:
+        static constexpr uint8_t kIndexMask = 0x3;
+        static constexpr uint8_t kFreshFlag = 0x4;
+
+        T buffers_[3];
+        uint8_t write_index_ = 0;
+        uint8_t read_index_ = 1;
+        //index of the buffer being traded plus kFreshFlag if it has a value not read yet
+        std::atomic<uint8_t> middle_{ 2 };
+    };
+}
+} //namespace
+#endif
@@ -58,8 +58,10 @@ namespace airlib
         {
             UpdatableObject::update();
 
-            for (TUpdatableObjectPtr& member : members_)
+            for (TUpdatableObjectPtr& member : members_) {
+                UpdateProfiler::Scope profile_scope(member->getProfileSection());
                 member->update();
+            }
         }
 
         virtual void reportState(StateReporter& reporter) override
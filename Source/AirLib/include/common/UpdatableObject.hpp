@@ -7,6 +7,7 @@
 #include "common/Common.hpp"
 #include "StateReporter.hpp"
 #include "ClockFactory.hpp"
+#include "UpdateProfiler.hpp"
 
 namespace msr
 {
@@ -94,6 +95,13 @@ init->reset calls for base-derived class that would be incorrect.
         void setName(const std::string& name)
         {
             this->name_ = name;
+            profile_section_ = UpdateProfiler::getSection(name);
+        }
+
+        //section that times this object's update() when profiling, 0 if it has no name
+        UpdateProfiler::Section getProfileSection() const
+        {
+            return profile_section_;
         }
 
     protected:
@@ -109,6 +117,7 @@ init->reset calls for base-derived class that would be incorrect.
         bool reset_in_progress = false;
         UpdatableObject* parent_ = nullptr;
         std::string name_;
+        UpdateProfiler::Section profile_section_ = 0;
     };
 }
 } //namespace
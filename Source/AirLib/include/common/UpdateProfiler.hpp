@@ -0,0 +1,377 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef airsim_core_UpdateProfiler_hpp
+#define airsim_core_UpdateProfiler_hpp
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "common/Common.hpp"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace msr
+{
+namespace airlib
+{
+
+    /*
+    Times update() of named UpdatableObjects and the other hot spots of a physics step. Code to be
+    timed holds a Scope for a section, usually the object's getProfileSection(). Each thread
+    counts its scopes in its own buffers without locks or allocation; the thread that runs the
+    physics step folds the time each section took in the step into that section's histogram in
+    endStep(). The last kTraceSize scopes of each thread are kept for a Chrome trace.
+
+    Nothing is timed until enable(true). Defining AIRLIB_NO_PROFILER compiles the timers out,
+    sections are then all 0 and Scope is empty.
+    */
+    class UpdateProfiler
+    {
+    public:
+        //0 is no section, its scopes aren't timed
+        typedef uint Section;
+
+        static constexpr uint kMaxSections = 256;
+        //bucket 0 counts steps under 256 ns, bucket b those in [2^(b+7), 2^(b+8)) ns, the last
+        //one also anything longer
+        static constexpr uint kBucketCount = 24;
+        static constexpr uint kTraceSize = 1 << 14;
+
+        struct SectionStats
+        {
+            std::string name;
+            uint64_t steps = 0; //steps the section ran in
+            uint64_t calls = 0;
+            uint64_t total_nanos = 0;
+            uint64_t max_nanos = 0; //in one step
+            std::vector<uint64_t> histogram; //of the time per step, see kBucketCount
+        };
+
+        class Scope
+        {
+        public:
+            explicit Scope(Section section)
+            {
+#ifndef AIRLIB_NO_PROFILER
+                if (section != 0 && isEnabled()) {
+                    section_ = section;
+                    start_ = ticks();
+                }
+#else
+                unused(section);
+#endif
+            }
+            ~Scope()
+            {
+#ifndef AIRLIB_NO_PROFILER
+                if (section_ != 0)
+                    record(section_, start_, ticks());
+#endif
+            }
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+#ifndef AIRLIB_NO_PROFILER
+            Section section_ = 0;
+            uint64_t start_ = 0;
+#endif
+        };
+
+    public:
+        //same name, same section; 0 for an empty name or once kMaxSections are taken
+        static Section getSection(const std::string& name)
+        {
+#ifndef AIRLIB_NO_PROFILER
+            if (name.empty())
+                return 0;
+
+            UpdateProfiler& profiler = instance();
+            std::lock_guard<std::mutex> lock(profiler.mutex_);
+            auto found = profiler.sections_.find(name);
+            if (found != profiler.sections_.end())
+                return found->second;
+            if (profiler.section_names_.size() >= kMaxSections)
+                return 0;
+
+            const Section section = static_cast<Section>(profiler.section_names_.size());
+            profiler.section_names_.push_back(name);
+            profiler.sections_[name] = section;
+            return section;
+#else
+            unused(name);
+            return 0;
+#endif
+        }
+
+        static void enable(bool is_enabled)
+        {
+            instance().enabled_.store(is_enabled, std::memory_order_relaxed);
+        }
+        static bool isEnabled()
+        {
+            return instance().enabled_.load(std::memory_order_relaxed);
+        }
+
+        //drops everything recorded so far, each thread forgets its counters at its next endStep()
+        static void clear()
+        {
+            ++instance().generation_;
+        }
+
+        //called by the thread running the physics step once the step is done
+        static void endStep()
+        {
+#ifndef AIRLIB_NO_PROFILER
+            ThreadProfile* thread = getThreadProfile(false);
+            if (thread == nullptr)
+                return;
+
+            UpdateProfiler& profiler = instance();
+            const uint generation = profiler.generation_;
+            if (thread->generation != generation) {
+                thread->generation = generation;
+                for (Counters& counters : thread->counters) {
+                    counters.steps.store(0, std::memory_order_relaxed);
+                    counters.calls.store(0, std::memory_order_relaxed);
+                    counters.total_nanos.store(0, std::memory_order_relaxed);
+                    counters.max_nanos.store(0, std::memory_order_relaxed);
+                    for (auto& count : counters.histogram)
+                        count.store(0, std::memory_order_relaxed);
+                }
+                thread->trace_head.store(0, std::memory_order_release);
+            }
+
+            const double nanos_per_tick = profiler.getNanosPerTick();
+            for (Section section : thread->step_sections) {
+                const uint64_t nanos = static_cast<uint64_t>(thread->step_ticks[section] * nanos_per_tick);
+
+                Counters& counters = thread->counters[section];
+                add(counters.steps, 1);
+                add(counters.calls, thread->step_calls[section]);
+                add(counters.total_nanos, nanos);
+                if (nanos > counters.max_nanos.load(std::memory_order_relaxed))
+                    counters.max_nanos.store(nanos, std::memory_order_relaxed);
+                add(counters.histogram[getBucket(nanos)], 1);
+
+                thread->step_ticks[section] = 0;
+                thread->step_calls[section] = 0;
+            }
+            thread->step_sections.clear();
+#endif
+        }
+
+        //totals over all threads, for sections that ran in any step
+        static std::vector<SectionStats> getStats()
+        {
+            UpdateProfiler& profiler = instance();
+            std::lock_guard<std::mutex> lock(profiler.mutex_);
+
+            std::vector<SectionStats> stats;
+            for (Section section = 1; section < profiler.section_names_.size(); ++section) {
+                SectionStats section_stats;
+                section_stats.name = profiler.section_names_[section];
+                section_stats.histogram.assign(kBucketCount, 0);
+
+                for (const auto& thread : profiler.threads_) {
+                    const Counters& counters = thread->counters[section];
+                    section_stats.steps += counters.steps.load(std::memory_order_relaxed);
+                    section_stats.calls += counters.calls.load(std::memory_order_relaxed);
+                    section_stats.total_nanos += counters.total_nanos.load(std::memory_order_relaxed);
+                    section_stats.max_nanos = std::max(section_stats.max_nanos, counters.max_nanos.load(std::memory_order_relaxed));
+                    for (uint bucket = 0; bucket < kBucketCount; ++bucket)
+                        section_stats.histogram[bucket] += counters.histogram[bucket].load(std::memory_order_relaxed);
+                }
+
+                if (section_stats.steps != 0)
+                    stats.push_back(std::move(section_stats));
+            }
+            return stats;
+        }
+
+        //the scopes still in the trace buffers as Chrome trace event JSON, for chrome://tracing or Perfetto
+        static std::string getChromeTrace()
+        {
+            UpdateProfiler& profiler = instance();
+            std::lock_guard<std::mutex> lock(profiler.mutex_);
+
+            const double nanos_per_tick = profiler.getNanosPerTick();
+            std::ostringstream trace;
+            trace << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+
+            bool is_first = true;
+            std::vector<TraceEvent> events;
+            for (const auto& thread : profiler.threads_) {
+                const uint64_t head = thread->trace_head.load(std::memory_order_acquire);
+                const uint64_t first = head > kTraceSize ? head - kTraceSize : 0;
+                events.clear();
+                for (uint64_t index = first; index < head; ++index)
+                    events.push_back(thread->trace[index % kTraceSize]);
+
+                //the thread kept recording while we copied, drop what it may have overwritten
+                const uint64_t new_head = thread->trace_head.load(std::memory_order_acquire);
+                if (new_head < head)
+                    continue;
+                const uint64_t valid_first = new_head >= kTraceSize ? new_head - kTraceSize + 1 : 0;
+
+                for (uint64_t index = std::max(first, valid_first); index < head; ++index) {
+                    const TraceEvent& event = events[index - first];
+                    const double start_micros = static_cast<double>(event.start - profiler.base_ticks_) * nanos_per_tick / 1E3;
+                    const double duration_micros = static_cast<double>(event.end - event.start) * nanos_per_tick / 1E3;
+
+                    trace << (is_first ? "" : ",")
+                          << "{\"name\":\"" << profiler.section_names_[event.section] << "\",\"ph\":\"X\""
+                          << ",\"ts\":" << start_micros << ",\"dur\":" << duration_micros
+                          << ",\"pid\":0,\"tid\":" << thread->id << "}";
+                    is_first = false;
+                }
+            }
+
+            trace << "],\"displayTimeUnit\":\"ns\"}";
+            return trace.str();
+        }
+
+    private:
+        struct Counters
+        {
+            std::atomic<uint64_t> steps{ 0 };
+            std::atomic<uint64_t> calls{ 0 };
+            std::atomic<uint64_t> total_nanos{ 0 };
+            std::atomic<uint64_t> max_nanos{ 0 };
+            std::array<std::atomic<uint64_t>, kBucketCount> histogram{};
+        };
+
+        struct TraceEvent
+        {
+            Section section;
+            uint64_t start;
+            uint64_t end;
+        };
+
+        //written only by its thread, counters and the trace are read by others
+        struct ThreadProfile
+        {
+            uint id = 0;
+            uint generation = 0;
+
+            //the step in progress
+            std::array<uint64_t, kMaxSections> step_ticks{};
+            std::array<uint, kMaxSections> step_calls{};
+            std::vector<Section> step_sections;
+
+            std::array<Counters, kMaxSections> counters;
+
+            std::array<TraceEvent, kTraceSize> trace{};
+            std::atomic<uint64_t> trace_head{ 0 };
+        };
+
+    private:
+        UpdateProfiler()
+            : section_names_(1), base_ticks_(ticks()), base_time_(std::chrono::steady_clock::now())
+        {
+        }
+
+        static UpdateProfiler& instance()
+        {
+            static UpdateProfiler profiler;
+            return profiler;
+        }
+
+        static ThreadProfile* getThreadProfile(bool create)
+        {
+            static thread_local ThreadProfile* thread = nullptr;
+            if (thread == nullptr && create) {
+                UpdateProfiler& profiler = instance();
+                std::lock_guard<std::mutex> lock(profiler.mutex_);
+
+                std::unique_ptr<ThreadProfile> profile(new ThreadProfile());
+                profile->id = static_cast<uint>(profiler.threads_.size());
+                profile->generation = profiler.generation_;
+                profile->step_sections.reserve(kMaxSections);
+                thread = profile.get();
+                profiler.threads_.push_back(std::move(profile));
+            }
+            return thread;
+        }
+
+        static void record(Section section, uint64_t start, uint64_t end)
+        {
+            ThreadProfile& thread = *getThreadProfile(true);
+
+            if (thread.step_calls[section]++ == 0)
+                thread.step_sections.push_back(section);
+            thread.step_ticks[section] += end - start;
+
+            const uint64_t head = thread.trace_head.load(std::memory_order_relaxed);
+            thread.trace[head % kTraceSize] = TraceEvent{ section, start, end };
+            thread.trace_head.store(head + 1, std::memory_order_release);
+        }
+
+        //time stamp counter where there is one, it's constant rate on any CPU of the last decade
+        static uint64_t ticks()
+        {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+            return __rdtsc();
+#elif defined(__x86_64__) || defined(__i386__)
+            return __rdtsc();
+#else
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                             std::chrono::steady_clock::now().time_since_epoch())
+                                             .count());
+#endif
+        }
+
+        //measured against the steady clock since the profiler was created
+        double getNanosPerTick() const
+        {
+            const uint64_t elapsed_ticks = ticks() - base_ticks_;
+            const auto elapsed_nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                           std::chrono::steady_clock::now() - base_time_)
+                                           .count();
+            if (elapsed_ticks == 0 || elapsed_nanos <= 0)
+                return 1;
+            return static_cast<double>(elapsed_nanos) / static_cast<double>(elapsed_ticks);
+        }
+
+        static uint getBucket(uint64_t nanos)
+        {
+            uint bucket = 0;
+            for (nanos >>= 8; nanos != 0 && bucket < kBucketCount - 1; nanos >>= 1)
+                ++bucket;
+            return bucket;
+        }
+
+        //single writer, so no read-modify-write needed
+        static void add(std::atomic<uint64_t>& counter, uint64_t value)
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+
+    private:
+        std::mutex mutex_; //sections and threads
+        std::vector<std::string> section_names_; //by section, 0 is none
+        std::unordered_map<std::string, Section> sections_;
+        std::vector<std::unique_ptr<ThreadProfile>> threads_;
+
+        std::atomic<bool> enabled_{ false };
+        std::atomic<uint> generation_{ 0 };
+
+        const uint64_t base_ticks_;
+        const std::chrono::steady_clock::time_point base_time_;
+    };
+}
+} //namespace
+#endif
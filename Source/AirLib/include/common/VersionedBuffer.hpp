@@ -0,0 +1,188 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef airsim_core_VersionedBuffer_hpp
+#define airsim_core_VersionedBuffer_hpp
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include "common/Common.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    /*
+    Single writer, many reader publication of a value that may be large (point clouds etc).
+    The writer fills a slot nobody is reading and then atomically makes it the published
+    one, so readers always see a complete value and never wait for the writer to finish
+    copying. A reader's snapshot pins its slot; the writer only reuses unpinned slots, so
+    a slow reader never sees its data change underneath it.
+
+    Normally three slots are enough (published, being written, one just released). Every
+    reader holding an older snapshot costs one more slot, allocated on demand up to
+    MaxSlotCount. Slots are reused rather than reallocated so vector capacity inside T
+    is kept too.
+
+    Every publish gets a sequence number one greater than the previous, starting at 1.
+    Sequence 0 is the default constructed value present before the first publish.
+    */
+    template <typename T>
+    class VersionedBuffer
+    {
+    private:
+        struct Slot
+        {
+            EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+            T value = T();
+            uint64_t sequence = 0;
+            mutable std::atomic<uint> readers{ 0 };
+        };
+
+    public:
+        static constexpr uint MaxSlotCount = 32;
+
+        class Snapshot
+        {
+        public:
+            Snapshot(Snapshot&& other) noexcept
+                : slot_(other.slot_)
+            {
+                other.slot_ = nullptr;
+            }
+            Snapshot(const Snapshot&) = delete;
+            Snapshot& operator=(const Snapshot&) = delete;
+
+            ~Snapshot()
+            {
+                if (slot_ != nullptr)
+                    slot_->readers.fetch_sub(1, std::memory_order_release);
+            }
+
+            const T& operator*() const
+            {
+                return slot_->value;
+            }
+            const T* operator->() const
+            {
+                return &slot_->value;
+            }
+            uint64_t getSequence() const
+            {
+                return slot_->sequence;
+            }
+
+        private:
+            friend class VersionedBuffer;
+            explicit Snapshot(const Slot* slot)
+                : slot_(slot)
+            {
+            }
+
+            const Slot* slot_;
+        };
+
+        VersionedBuffer()
+        {
+            slots_[0].reset(new Slot());
+            slot_count_ = 1;
+            published_.store(slots_[0].get());
+        }
+
+        //must only be called from one thread at a time
+        void publish(const T& value)
+        {
+            Slot* slot = acquireFreeSlot();
+            slot->value = value;
+            slot->sequence = ++last_sequence_;
+
+            published_.store(slot);
+            published_sequence_.store(slot->sequence);
+        }
+
+        //like publish() but swaps value in instead of copying it. On return value holds the
+        //stale contents of the reused slot, whose capacity the caller can fill next time.
+        void publishSwap(T& value)
+        {
+            Slot* slot = acquireFreeSlot();
+            using std::swap;
+            swap(slot->value, value);
+            slot->sequence = ++last_sequence_;
+
+            published_.store(slot);
+            published_sequence_.store(slot->sequence);
+        }
+
+        //last published value, only for the writer thread: it stays valid until the next publish
+        const T& getPublished() const
+        {
+            return published_.load(std::memory_order_relaxed)->value;
+        }
+
+        //safe from any thread, the snapshot stays valid and unchanged for as long as it is held
+        Snapshot read() const
+        {
+            while (true) {
+                Slot* slot = published_.load();
+                slot->readers.fetch_add(1);
+
+                //if the slot is still published after pinning it, the writer either hasn't
+                //picked it for reuse yet or will see our pin when it looks for a free slot
+                if (published_.load() == slot)
+                    return Snapshot(slot);
+
+                slot->readers.fetch_sub(1, std::memory_order_release);
+            }
+        }
+
+        //safe from any thread; a read() after this returns at least this sequence
+        uint64_t getSequence() const
+        {
+            return published_sequence_.load();
+        }
+
+        //number of slots allocated so far, for diagnostics
+        uint getSlotCount() const
+        {
+            return slot_count_;
+        }
+
+    private:
+        Slot* acquireFreeSlot()
+        {
+            const Slot* published = published_.load(std::memory_order_relaxed);
+            while (true) {
+                for (uint i = 0; i < slot_count_; ++i) {
+                    Slot* slot = slots_[i].get();
+                    if (slot != published && slot->readers.load() == 0)
+                        return slot;
+                }
+
+                if (slot_count_ < MaxSlotCount) {
+                    slots_[slot_count_].reset(new Slot());
+                    return slots_[slot_count_++].get();
+                }
+
+                //only when MaxSlotCount - 1 readers all hold old snapshots at once
+                std::this_thread::yield();
+            }
+        }
+
+    private:
+        //writer only
+        std::array<std::unique_ptr<Slot>, MaxSlotCount> slots_;
+        uint slot_count_ = 0;
+        uint64_t last_sequence_ = 0;
+
+        //shared with readers
+        std::atomic<Slot*> published_;
+        //the published slot may be reused and rewritten as soon as a new one is published,
+        //so its sequence is kept here for readers that haven't pinned it
+        std::atomic<uint64_t> published_sequence_{ 0 };
+    };
+}
+} //namespace
+#endif
@@ -0,0 +1,49 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef common_utils_MemoryMappedFile_hpp
+#define common_utils_MemoryMappedFile_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace common_utils
+{
+// Read-only view of a whole file. Nothing is read up front, the OS pages the file in as it is
+// touched and keeps the pages it needs in its file cache, so files larger than memory are fine.
+class MemoryMappedFile
+{
+public:
+    MemoryMappedFile() = default;
+    ~MemoryMappedFile()
+    {
+        close();
+    }
+
+    MemoryMappedFile(const MemoryMappedFile&) = delete;
+    MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+
+    // throws std::ios_base::failure if the file can't be opened or is empty
+    void open(const std::string& filepath);
+    void close();
+
+    bool isOpen() const
+    {
+        return data_ != nullptr;
+    }
+    const uint8_t* data() const
+    {
+        return data_;
+    }
+    size_t size() const
+    {
+        return size_;
+    }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
+}
+#endif
@@ -10,6 +10,7 @@
 #include <atomic>
 #include <system_error>
 #include <mutex>
+#include <condition_variable>
 #include <cstdint>
 
 namespace common_utils
@@ -56,6 +57,7 @@ public:
     {
         paused_ = is_paused;
         pause_period_start_ = 0; // cancel any pause period.
+        notifyPauseChanged();
     }
 
     bool isPaused() const
@@ -68,6 +70,7 @@ public:
         pause_period_start_ = nanos();
         pause_period_ = static_cast<TTimeDelta>(1E9 * seconds);
         paused_ = true;
+        notifyPauseChanged();
     }
 
     void continueForTime(double seconds)
@@ -90,11 +93,20 @@ public:
         currentFrameNumber_ = frameNumber;
     }
 
+    //blocks until the executor pauses, e.g. at the end of continueForFrames, or stops;
+    //the callback isn't running by then
+    void waitForPause()
+    {
+        std::unique_lock<std::mutex> locker(pause_mutex_);
+        pause_cv_.wait(locker, [this]() { return (paused_ && !in_callback_) || !started_; });
+    }
+
     void stop()
     {
         if (started_) {
             started_ = false;
             initializePauseState();
+            notifyPauseChanged();
 
             try {
                 if (th_.joinable()) {
@@ -136,6 +148,13 @@ private:
         pause_period_ = 0;
     }
 
+    void notifyPauseChanged()
+    {
+        //waiters check under this lock, so taking it orders the change before their check
+        { std::lock_guard<std::mutex> locker(pause_mutex_); }
+        pause_cv_.notify_all();
+    }
+
 private:
     typedef std::chrono::high_resolution_clock clock;
     typedef uint64_t TTimePoint;
@@ -200,10 +219,16 @@ private:
                     //when we are doing work, don't let other thread to cause contention
                     std::lock_guard<std::mutex> locker(mutex_);
 
+                    in_callback_ = true;
                     bool result = callback_(since_last_call);
+                    in_callback_ = false;
                     if (!result) {
                         started_ = result;
                     }
+
+                    //the callback may have paused us, let waiters know the step is done
+                    if (paused_ || !started_)
+                        notifyPauseChanged();
                 }
             }
             else
@@ -230,13 +255,17 @@ private:
     std::atomic_bool paused_;
     std::atomic<TTimeDelta> pause_period_;
     std::atomic<TTimePoint> pause_period_start_;
-    uint32_t currentFrameNumber_;
-    uint32_t targetFrameNumber_;
+    std::atomic<uint32_t> currentFrameNumber_{ 0 };
+    std::atomic<uint32_t> targetFrameNumber_{ 0 };
     std::atomic_bool frame_countdown_enabled_;
+    std::atomic_bool in_callback_{ false };
 
     double sleep_time_avg_;
 
     std::mutex mutex_;
+    //for waitForPause, separate from mutex_ so waiting never holds up the callback
+    std::mutex pause_mutex_;
+    std::condition_variable pause_cv_;
 };
 }
 #endif
@@ -0,0 +1,257 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef airsim_core_ContactSolver_hpp
+#define airsim_core_ContactSolver_hpp
+
+#include <vector>
+#include "common/Common.hpp"
+#include "common/CommonStructs.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    struct ContactMaterial
+    {
+        real_T restitution = 0;
+        real_T static_friction = 1;
+        real_T dynamic_friction = 1;
+
+        ContactMaterial()
+        {
+        }
+
+        ContactMaterial(real_T restitution_val, real_T static_friction_val, real_T dynamic_friction_val)
+            : restitution(restitution_val), static_friction(static_friction_val), dynamic_friction(dynamic_friction_val)
+        {
+        }
+    };
+
+    //contact properties by material id of the surface touched, e.g. Unreal's physical surface type
+    class ContactMaterialTable
+    {
+    public:
+        void setMaterial(int material_id, const ContactMaterial& material)
+        {
+            if (material_id < 0)
+                throw std::invalid_argument("Contact material id must not be negative");
+
+            if (static_cast<size_t>(material_id) >= materials_.size())
+                materials_.resize(material_id + 1);
+            materials_[material_id].material = material;
+            materials_[material_id].is_set = true;
+        }
+
+        //nullptr if the material has no entry
+        const ContactMaterial* findMaterial(int material_id) const
+        {
+            if (material_id < 0 || static_cast<size_t>(material_id) >= materials_.size() || !materials_[material_id].is_set)
+                return nullptr;
+            return &materials_[material_id].material;
+        }
+
+        bool empty() const
+        {
+            return materials_.empty();
+        }
+
+    private:
+        struct Entry
+        {
+            ContactMaterial material;
+            bool is_set = false;
+        };
+
+        std::vector<Entry> materials_;
+    };
+
+    /*
+    Resolves the contacts of one rigid body against static geometry with sequential impulses:
+    each iteration corrects the velocity at one contact at a time, clamping the total impulse
+    of each contact so it only pushes and friction stays inside its cone. Impulses found in the
+    previous step are applied first for contacts that persist, which is what lets a body resting
+    on several points settle in a few iterations instead of jittering.
+
+    All vectors are in the body frame.
+    */
+    class ContactSolver
+    {
+    public:
+        struct Contact
+        {
+            Vector3r position; //relative to the center of mass
+            Vector3r normal; //pointing out of the surface
+            ContactMaterial material;
+            int material_id = -1;
+        };
+
+    public:
+        //changes velocity and angular_velocity so no contact approaches its surface,
+        //time is used to decide whether last step's impulses still apply
+        void solve(std::vector<Contact>& contacts, real_T mass, const Matrix3x3r& inertia_inv, TTimePoint time,
+                   Vector3r& velocity, Vector3r& angular_velocity)
+        {
+            const real_T mass_inv = 1 / mass;
+            const bool can_warm_start = last_time_ != 0 && time >= last_time_ &&
+                                        static_cast<real_T>(time - last_time_) * 1E-9f <= kWarmStartMaxAge;
+            last_time_ = time;
+
+            //assign keeps the capacity, so steady contact doesn't allocate
+            states_.assign(contacts.size(), ContactState());
+            for (size_t i = 0; i < contacts.size(); ++i) {
+                const Contact& contact = contacts[i];
+                ContactState& state = states_[i];
+
+                //tangent basis, any pair perpendicular to the normal
+                const Vector3r& n = contact.normal;
+                state.tangent1 = std::abs(n.x()) < 0.9f ? Vector3r::UnitX().cross(n).normalized() : Vector3r::UnitY().cross(n).normalized();
+                state.tangent2 = n.cross(state.tangent1);
+
+                state.normal_mass = 1 / getEffectiveMassInv(contact.position, n, mass_inv, inertia_inv);
+                state.tangent1_mass = 1 / getEffectiveMassInv(contact.position, state.tangent1, mass_inv, inertia_inv);
+                state.tangent2_mass = 1 / getEffectiveMassInv(contact.position, state.tangent2, mass_inv, inertia_inv);
+                state.spin_mass = 1 / n.dot(inertia_inv * n);
+
+                //bounce from the approach speed before any impulse, resting contacts don't bounce
+                const real_T normal_velocity = getContactVelocity(contact.position, velocity, angular_velocity).dot(n);
+                state.target_normal_velocity = normal_velocity < -kBounceVelocityMin ? -contact.material.restitution * normal_velocity : 0;
+
+                if (can_warm_start && findPrevious(contact, state)) {
+                    const Vector3r impulse = n * state.normal_impulse + state.tangent1 * state.tangent1_impulse +
+                                             state.tangent2 * state.tangent2_impulse;
+                    applyImpulse(contact.position, impulse, mass_inv, inertia_inv, velocity, angular_velocity);
+                    angular_velocity += inertia_inv * (n * state.spin_impulse);
+                }
+            }
+
+            for (uint iteration = 0; iteration < kIterations; ++iteration) {
+                for (size_t i = 0; i < contacts.size(); ++i) {
+                    const Contact& contact = contacts[i];
+                    ContactState& state = states_[i];
+                    const Vector3r& n = contact.normal;
+
+                    //normal: push until the contact stops approaching, never pull
+                    const real_T normal_velocity = getContactVelocity(contact.position, velocity, angular_velocity).dot(n);
+                    real_T delta = clampAccumulated(state.normal_impulse, (state.target_normal_velocity - normal_velocity) * state.normal_mass,
+                                                    0, Utils::max<real_T>());
+                    applyImpulse(contact.position, n * delta, mass_inv, inertia_inv, velocity, angular_velocity);
+
+                    //friction: static coefficient holds a contact that isn't sliding, dynamic one slows a sliding contact
+                    const Vector3r contact_velocity = getContactVelocity(contact.position, velocity, angular_velocity);
+                    const Vector3r sliding_velocity = contact_velocity - n * contact_velocity.dot(n);
+                    const real_T friction = sliding_velocity.squaredNorm() < kStaticSlidingVelocityMax * kStaticSlidingVelocityMax
+                                                ? contact.material.static_friction
+                                                : contact.material.dynamic_friction;
+                    const real_T max_friction = friction * state.normal_impulse;
+
+                    delta = clampAccumulated(state.tangent1_impulse, -sliding_velocity.dot(state.tangent1) * state.tangent1_mass,
+                                             -max_friction, max_friction);
+                    applyImpulse(contact.position, state.tangent1 * delta, mass_inv, inertia_inv, velocity, angular_velocity);
+                    delta = clampAccumulated(state.tangent2_impulse, -sliding_velocity.dot(state.tangent2) * state.tangent2_mass,
+                                             -max_friction, max_friction);
+                    applyImpulse(contact.position, state.tangent2 * delta, mass_inv, inertia_inv, velocity, angular_velocity);
+
+                    //torsion: friction over the contact patch resists spinning about the normal
+                    const real_T max_spin = contact.material.dynamic_friction * state.normal_impulse * kContactPatchRadius;
+                    delta = clampAccumulated(state.spin_impulse, -angular_velocity.dot(n) * state.spin_mass, -max_spin, max_spin);
+                    angular_velocity += inertia_inv * (n * delta);
+                }
+            }
+
+            //remember impulses to start from next step
+            previous_.resize(contacts.size());
+            for (size_t i = 0; i < contacts.size(); ++i) {
+                previous_[i].position = contacts[i].position;
+                previous_[i].normal = contacts[i].normal;
+                previous_[i].material_id = contacts[i].material_id;
+                previous_[i].state = states_[i];
+            }
+        }
+
+        void reset()
+        {
+            previous_.clear();
+            last_time_ = 0;
+        }
+
+    private:
+        struct ContactState
+        {
+            Vector3r tangent1, tangent2;
+            real_T normal_mass, tangent1_mass, tangent2_mass, spin_mass;
+            real_T target_normal_velocity;
+            real_T normal_impulse = 0, tangent1_impulse = 0, tangent2_impulse = 0, spin_impulse = 0;
+        };
+
+        struct PreviousContact
+        {
+            Vector3r position;
+            Vector3r normal;
+            int material_id;
+            ContactState state;
+        };
+
+        //takes over impulses of the previous step's contact at the same place, if any; impacts
+        //are not carried over, their impulse was spent on the bounce
+        bool findPrevious(const Contact& contact, ContactState& state) const
+        {
+            for (const PreviousContact& previous : previous_) {
+                if (previous.state.target_normal_velocity == 0 && previous.material_id == contact.material_id &&
+                    (previous.position - contact.position).squaredNorm() < kWarmStartDistanceMax * kWarmStartDistanceMax &&
+                    previous.normal.dot(contact.normal) > kWarmStartNormalDotMin) {
+                    //the tangent basis may differ, carry the friction impulse over as a vector
+                    const Vector3r friction_impulse = previous.state.tangent1 * previous.state.tangent1_impulse +
+                                                      previous.state.tangent2 * previous.state.tangent2_impulse;
+                    state.normal_impulse = previous.state.normal_impulse;
+                    state.tangent1_impulse = friction_impulse.dot(state.tangent1);
+                    state.tangent2_impulse = friction_impulse.dot(state.tangent2);
+                    state.spin_impulse = previous.state.spin_impulse;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        static real_T getEffectiveMassInv(const Vector3r& position, const Vector3r& direction, real_T mass_inv, const Matrix3x3r& inertia_inv)
+        {
+            return mass_inv + (inertia_inv * position.cross(direction)).cross(position).dot(direction);
+        }
+
+        static Vector3r getContactVelocity(const Vector3r& position, const Vector3r& velocity, const Vector3r& angular_velocity)
+        {
+            return velocity + angular_velocity.cross(position);
+        }
+
+        static void applyImpulse(const Vector3r& position, const Vector3r& impulse, real_T mass_inv, const Matrix3x3r& inertia_inv,
+                                 Vector3r& velocity, Vector3r& angular_velocity)
+        {
+            velocity += impulse * mass_inv;
+            angular_velocity += inertia_inv * position.cross(impulse);
+        }
+
+        //adds delta to accumulated keeping it in [min_value, max_value], returns the change actually made
+        static real_T clampAccumulated(real_T& accumulated, real_T delta, real_T min_value, real_T max_value)
+        {
+            const real_T old_value = accumulated;
+            accumulated = Utils::clip(accumulated + delta, min_value, max_value);
+            return accumulated - old_value;
+        }
+
+    private:
+        static constexpr uint kIterations = 8;
+        static constexpr real_T kBounceVelocityMin = 0.5f; //m/s
+        static constexpr real_T kStaticSlidingVelocityMax = 0.05f; //m/s
+        static constexpr real_T kContactPatchRadius = 0.05f; //m
+        static constexpr real_T kWarmStartMaxAge = 0.1f; //s
+        static constexpr real_T kWarmStartDistanceMax = 0.05f; //m
+        static constexpr real_T kWarmStartNormalDotMin = 0.95f;
+
+        std::vector<PreviousContact> previous_;
+        std::vector<ContactState> states_; //scratch for solve
+        TTimePoint last_time_ = 0;
+    };
+}
+} //namespace
+#endif
@@ -4,19 +4,39 @@
 #ifndef airsim_core_Environment_hpp
 #define airsim_core_Environment_hpp
 
+#include <atomic>
+#include <mutex>
 #include "common/Common.hpp"
 #include "common/UpdatableObject.hpp"
 #include "common/CommonStructs.hpp"
 #include "common/EarthUtils.hpp"
+#include "common/TerrainModel.hpp"
 
 namespace msr
 {
 namespace airlib
 {
 
+    /*
+    State of the air around a body. update() only notes that the position moved, the state is
+    worked out when someone next asks for it. The geodetic position always follows the body
+    exactly, but the atmosphere and gravity are kept until the altitude has changed by more than
+    the tolerance. Ground queries go to the terrain for the exact position they ask about.
+    */
     class Environment : public UpdatableObject
     {
     public:
+        //updates whose state had to be recomputed against those that got by with what was there
+        struct EvaluationStats
+        {
+            uint64_t recomputed = 0;
+            uint64_t avoided = 0;
+
+            //over the last second of simulation
+            real_T recomputed_per_second = 0;
+            real_T avoided_per_second = 0;
+        };
+
         struct State
         {
             //these fields must be set at initialization time
@@ -68,15 +88,74 @@ namespace airlib
             return home_geo_point_.home_geo_point;
         }
 
+        //terrain shared by all vehicles, nullptr to leave the ground to the game engine
+        void setTerrain(std::shared_ptr<const TerrainModel> terrain)
+        {
+            std::lock_guard<std::mutex> lock(evaluation_mutex_);
+            terrain_ = terrain;
+        }
+        const std::shared_ptr<const TerrainModel>& getTerrain() const
+        {
+            return terrain_;
+        }
+
+        //terrain height below a local NED position as NED z and the normal of the ground there,
+        //pointing up; false where there is no terrain data
+        bool getGroundBelow(const Vector3r& position, real_T& ground_z, Vector3r& normal) const
+        {
+            if (!terrain_)
+                return false;
+
+            const GeoPoint geo_point = EarthUtils::nedToGeodetic(position, home_geo_point_);
+            Vector2r slope;
+            const real_T ground_altitude = terrain_->groundHeightAt(geo_point.latitude, geo_point.longitude, slope);
+            if (std::isnan(ground_altitude))
+                return false;
+
+            ground_z = static_cast<real_T>(home_geo_point_.home_geo_point.altitude) - ground_altitude;
+            normal = Vector3r(-slope.x(), -slope.y(), -1).normalized();
+            return true;
+        }
+
+        //distance along a ray from a local NED position to the terrain, max_distance if it isn't hit
+        real_T getGroundDistance(const Vector3r& start, const Vector3r& direction, real_T max_distance) const
+        {
+            if (!terrain_)
+                return max_distance;
+
+            //march in steps small enough not to skip over terrain features, then bisect the step that went below
+            const real_T step = std::max(1.0f, max_distance / 100);
+            real_T above = 0;
+            for (real_T distance = 0; distance <= max_distance; distance += step) {
+                if (isBelowGround(start + direction * distance)) {
+                    if (distance == 0)
+                        return 0;
+                    real_T below = distance;
+                    for (int i = 0; i < 16; ++i) {
+                        const real_T middle = (above + below) / 2;
+                        if (isBelowGround(start + direction * middle))
+                            below = middle;
+                        else
+                            above = middle;
+                    }
+                    return below;
+                }
+                above = distance;
+            }
+            return max_distance;
+        }
+
         //in local NED coordinates
         void setPosition(const Vector3r& position)
         {
+            std::lock_guard<std::mutex> lock(evaluation_mutex_);
             current_.position = position;
         }
 
         //called in FastPhysicsEngine::getDragWrench()
         void setAirspeedMagnitude(const real_T& airspeed)
         {
+            std::lock_guard<std::mutex> lock(evaluation_mutex_);
             current_.airspeed = airspeed;
         }
 
@@ -84,24 +163,78 @@ namespace airlib
         {
             return initial_;
         }
+        //the reference is only safe to read on the thread that updates the environment
         const State& getState() const
         {
+            evaluate();
             return current_;
         }
         State& getState()
         {
+            evaluate();
+            return current_;
+        }
+        //for any other thread
+        State getStateCopy() const
+        {
+            std::lock_guard<std::mutex> lock(evaluation_mutex_);
+            evaluateLocked();
             return current_;
         }
 
+        //meters the body may climb or descend before the atmosphere is recomputed, 0 for every move
+        void setTolerance(real_T tolerance)
+        {
+            tolerance_ = tolerance;
+        }
+        real_T getTolerance() const
+        {
+            return tolerance_;
+        }
+
+        EvaluationStats getEvaluationStats() const
+        {
+            std::lock_guard<std::mutex> lock(evaluation_mutex_);
+            return stats_;
+        }
+
         virtual void update() override
         {
-            updateState(current_, home_geo_point_);
+            std::lock_guard<std::mutex> lock(evaluation_mutex_);
+
+            //nobody needed the state since the last update
+            if (is_stale_.load(std::memory_order_relaxed))
+                ++stats_.avoided;
+            is_stale_.store(true, std::memory_order_release);
+
+            const TTimePoint now = clock()->nowNanos();
+            const TTimeDelta elapsed = clock()->elapsedBetween(now, stats_window_start_);
+            if (elapsed >= 1) {
+                stats_.recomputed_per_second = static_cast<real_T>((stats_.recomputed - window_recomputed_) / elapsed);
+                stats_.avoided_per_second = static_cast<real_T>((stats_.avoided - window_avoided_) / elapsed);
+                window_recomputed_ = stats_.recomputed;
+                window_avoided_ = stats_.avoided;
+                stats_window_start_ = now;
+            }
+        }
+
+        virtual void reportState(StateReporter& reporter) override
+        {
+            //call base
+            UpdatableObject::reportState(reporter);
+
+            const EvaluationStats stats = getEvaluationStats();
+            reporter.writeValue("Env-Recomputed/s", stats.recomputed_per_second);
+            reporter.writeValue("Env-Avoided/s", stats.avoided_per_second);
         }
 
     protected:
         virtual void resetImplementation() override
         {
+            std::lock_guard<std::mutex> lock(evaluation_mutex_);
             current_ = initial_;
+            setEvaluated(current_);
+            stats_window_start_ = clock()->nowNanos();
         }
 
         virtual void failResetUpdateOrdering(std::string err) override
@@ -114,10 +247,64 @@ namespace airlib
         }
 
     private:
+        bool isBelowGround(const Vector3r& position) const
+        {
+            real_T ground_z;
+            Vector3r normal;
+            return getGroundBelow(position, ground_z, normal) && position.z() >= ground_z;
+        }
+
+        //works out the state for the position the last update() left, if it hasn't been yet
+        void evaluate() const
+        {
+            if (!is_stale_.load(std::memory_order_acquire))
+                return;
+
+            std::lock_guard<std::mutex> lock(evaluation_mutex_);
+            evaluateLocked();
+        }
+
+        void evaluateLocked() const
+        {
+            if (!is_stale_.load(std::memory_order_relaxed))
+                return;
+
+            bool is_recomputed = false;
+            if (current_.position != evaluated_position_) {
+                current_.geo_point = EarthUtils::nedToGeodetic(current_.position, home_geo_point_);
+                evaluated_position_ = current_.position;
+
+                //written so a NaN from reset always recomputes
+                if (!(std::abs(current_.geo_point.altitude - atmosphere_altitude_) <= tolerance_)) {
+                    updateAtmosphere(current_);
+                    atmosphere_altitude_ = current_.geo_point.altitude;
+                    is_recomputed = true;
+                }
+            }
+
+            if (is_recomputed)
+                ++stats_.recomputed;
+            else
+                ++stats_.avoided;
+            is_stale_.store(false, std::memory_order_release);
+        }
+
+        //the state was just computed in full for its position
+        void setEvaluated(const State& state)
+        {
+            evaluated_position_ = state.position;
+            atmosphere_altitude_ = state.geo_point.altitude;
+            is_stale_.store(false, std::memory_order_release);
+        }
+
         static void updateState(State& state, const HomeGeoPoint& home_geo_point)
         {
             state.geo_point = EarthUtils::nedToGeodetic(state.position, home_geo_point);
+            updateAtmosphere(state);
+        }
 
+        static void updateAtmosphere(State& state)
+        {
             real_T geo_pot = EarthUtils::getGeopotential(state.geo_point.altitude / 1000.0f);
             state.temperature = EarthUtils::getStandardTemperature(geo_pot);
             state.air_pressure = EarthUtils::getStandardPressure(geo_pot, state.temperature);
@@ -128,8 +315,23 @@ namespace airlib
         }
 
     private:
-        State initial_, current_;
+        State initial_;
+        //filled in by evaluate() when read
+        mutable State current_;
         HomeGeoPoint home_geo_point_;
+        std::shared_ptr<const TerrainModel> terrain_;
+
+        real_T tolerance_ = 0.1f;
+        mutable std::atomic<bool> is_stale_{ false };
+        mutable std::mutex evaluation_mutex_;
+        //what current_ was last computed for
+        mutable Vector3r evaluated_position_ = Vector3r::Zero();
+        mutable real_T atmosphere_altitude_ = Utils::nan<real_T>();
+
+        mutable EvaluationStats stats_;
+        TTimePoint stats_window_start_ = 0;
+        uint64_t window_recomputed_ = 0;
+        uint64_t window_avoided_ = 0;
     };
 }
 } //namespace
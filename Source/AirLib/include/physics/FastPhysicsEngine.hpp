@@ -6,10 +6,12 @@
 
 #include "common/Common.hpp"
 #include "physics/PhysicsEngineBase.hpp"
+#include "physics/ContactSolver.hpp"
 #include <iostream>
 #include <sstream>
 #include <fstream>
 #include <memory>
+#include <unordered_map>
 #include "common/CommonStructs.hpp"
 #include "common/SteppableClock.hpp"
 #include <cinttypes>
@@ -34,6 +36,7 @@ namespace airlib
             for (PhysicsBody* body_ptr : *this) {
                 initPhysicsBody(body_ptr);
             }
+            contact_solvers_.clear();
         }
 
         virtual void insert(PhysicsBody* body_ptr) override
@@ -70,6 +73,12 @@ namespace airlib
             wind_ = wind;
         }
 
+        //restitution and friction for surfaces by the material id collisions report
+        void setContactMaterials(const ContactMaterialTable& contact_materials)
+        {
+            contact_materials_ = contact_materials;
+        }
+
     private:
         void initPhysicsBody(PhysicsBody* body_ptr)
         {
@@ -85,21 +94,42 @@ namespace airlib
             const Kinematics::State& current = body.getKinematics();
             Kinematics::State next;
             Wrench next_wrench;
-
-            //first compute the response as if there was no collision
-            //this is necessary to take in to account forces and torques generated by body
-            getNextKinematicsNoCollision(dt, body, current, next, next_wrench, wind_);
-
-            //if there is collision, see if we need collision response
-            const CollisionInfo collision_info = body.getCollisionInfo();
             CollisionResponse& collision_response = body.getCollisionResponseInfo();
-            //if collision was already responded then do not respond to it until we get updated information
-            if (body.isGrounded() || (collision_info.has_collided && collision_response.collision_time_stamp != collision_info.time_stamp)) {
-                bool is_collision_response = getNextKinematicsOnCollision(dt, collision_info, body, current, next, next_wrench, enable_ground_lock_);
-                updateCollisionResponseInfo(collision_info, next, is_collision_response, collision_response);
-                //throttledLogOutput("*** has collision", 0.1);
+            //the body's collision info is only copied when the terrain replaces it, the body is locked meanwhile
+            const CollisionInfo& body_collision_info = body.getCollisionInfo();
+            CollisionInfo terrain_collision_info;
+            const bool is_terrain_collision = (!body_collision_info.has_collided || body_collision_info.time_stamp == collision_response.collision_time_stamp) &&
+                                              getTerrainCollision(body, current, terrain_collision_info);
+            const CollisionInfo& collision_info = is_terrain_collision ? terrain_collision_info : body_collision_info;
+
+            if (body.isGrounded() && !canLiftOff(body, current)) {
+                //resting contact: the body stays put until its own forces can lift it,
+                //so there is no drag, integration or collision response to compute
+                next = current;
+                next.twist = Twist::zero();
+                next.accelerations = Accelerations::zero();
+                next_wrench = Wrench::zero();
+                updateCollisionResponseInfo(collision_info, next, false, collision_response);
+            }
+            else {
+                //first compute the response as if there was no collision
+                //this is necessary to take in to account forces and torques generated by body
+                {
+                    UpdateProfiler::Scope profile_scope(integrator_section_);
+                    getNextKinematicsNoCollision(dt, body, current, next, next_wrench, wind_);
+                }
+
+                //if there is collision, see if we need collision response
+                //if collision was already responded then do not respond to it until we get updated information
+                if (body.isGrounded() || (collision_info.has_collided && collision_response.collision_time_stamp != collision_info.time_stamp)) {
+                    UpdateProfiler::Scope profile_scope(collision_section_);
+                    bool is_collision_response = getNextKinematicsOnCollision(dt, collision_info, body, current, next, next_wrench, enable_ground_lock_,
+                                                                              contact_materials_, contact_solvers_[&body]);
+                    updateCollisionResponseInfo(collision_info, next, is_collision_response, collision_response);
+                    //throttledLogOutput("*** has collision", 0.1);
+                }
+                //else throttledLogOutput("*** no collision", 0.1);
             }
-            //else throttledLogOutput("*** no collision", 0.1);
 
             //Utils::log(Utils::stringf("T-VEL %s %" PRIu64 ": ",
             //    VectorMath::toString(next.twist.linear).c_str(), clock()->getStepCount()));
@@ -114,6 +144,24 @@ namespace airlib
             //body.getEnvironment().update();
         }
 
+        //the game engine only knows about ground it has meshes for, so without a new collision from it
+        //check the body's position against the terrain model, taking the position as the lowest point;
+        //false if the body is above the terrain
+        bool getTerrainCollision(const PhysicsBody& body, const Kinematics::State& current, CollisionInfo& collision_info) const
+        {
+            if (!body.hasEnvironment() || !body.getEnvironment().getTerrain())
+                return false;
+
+            real_T ground_z;
+            Vector3r normal;
+            if (!body.getEnvironment().getGroundBelow(current.pose.position, ground_z, normal) || current.pose.position.z() < ground_z)
+                return false;
+
+            const Vector3r ground_point(current.pose.position.x(), current.pose.position.y(), ground_z);
+            collision_info = CollisionInfo(true, normal, ground_point, ground_point, 0, clock()->nowNanos(), "Terrain", -1);
+            return true;
+        }
+
         static void updateCollisionResponseInfo(const CollisionInfo& collision_info, const Kinematics::State& next,
                                                 bool is_collision_response, CollisionResponse& collision_response)
         {
@@ -125,15 +173,36 @@ namespace airlib
                 ++collision_response.collision_count_non_resting;
         }
 
+        //true if the net force the body generates is at least its weight
+        static bool canLiftOff(const PhysicsBody& body, const Kinematics::State& current)
+        {
+            const Wrench body_wrench = getBodyWrench(body, current.pose.orientation);
+            const Vector3r weight = body.getMass() * body.getEnvironment().getState().gravity;
+            return body_wrench.force.squaredNorm() >= weight.squaredNorm();
+        }
+
+        static bool isApproaching(const CollisionInfo& collision_info, const Vector3r& velocity)
+        {
+            if (collision_info.contacts.empty())
+                return collision_info.normal.dot(velocity) < 0.0f;
+
+            for (const ContactPoint& contact : collision_info.contacts) {
+                if (contact.normal.dot(velocity) < 0.0f)
+                    return true;
+            }
+            return false;
+        }
+
         //return value indicates if collision response was generated
         static bool getNextKinematicsOnCollision(TTimeDelta dt, const CollisionInfo& collision_info, PhysicsBody& body,
-                                                 const Kinematics::State& current, Kinematics::State& next, Wrench& next_wrench, bool enable_ground_lock)
+                                                 const Kinematics::State& current, Kinematics::State& next, Wrench& next_wrench, bool enable_ground_lock,
+                                                 const ContactMaterialTable& contact_materials, ContactSolver& contact_solver)
         {
             /************************* Collision response ************************/
             const real_T dt_real = static_cast<real_T>(dt);
 
             //are we going away from collision? if so then keep using computed next state
-            if (collision_info.normal.dot(next.twist.linear) >= 0.0f)
+            if (!isApproaching(collision_info, next.twist.linear))
                 return false;
 
             /********** Core collision response ***********/
@@ -143,76 +212,55 @@ namespace airlib
             //get average angular velocity
             const Vector3r angular_avg = current.twist.angular + current.accelerations.angular * dt_real;
 
-            //contact point vector
-            Vector3r r = collision_info.impact_point - collision_info.position;
-
             //see if impact is straight at body's surface (assuming its box)
             const Vector3r normal_body = VectorMath::transformToBodyFrame(collision_info.normal, current.pose.orientation);
             const bool is_ground_normal = Utils::isApproximatelyEqual(std::abs(normal_body.z()), 1.0f, kAxisTolerance);
-            bool ground_collision = false;
             const float z_vel = vcur_avg.z();
             const bool is_landing = z_vel > std::abs(vcur_avg.x()) && z_vel > std::abs(vcur_avg.y());
 
-            real_T restitution = body.getRestitution();
-            real_T friction = body.getFriction();
-
-            if (is_ground_normal && is_landing
-                // So normal_body is the collision normal translated into body coords, why does an x==1 or y==1
-                // mean we are coliding with the ground???
-                // || Utils::isApproximatelyEqual(std::abs(normal_body.x()), 1.0f, kAxisTolerance)
-                // || Utils::isApproximatelyEqual(std::abs(normal_body.y()), 1.0f, kAxisTolerance)
-            ) {
-                // looks like we are coliding with the ground.  We don't want the ground to be so bouncy
-                // so we reduce the coefficient of restitution.  0 means no bounce.
-                // TODO: it would be better if we did this based on the material we are landing on.
-                // e.g. grass should be inelastic, but a hard surface like the road should be more bouncy.
-                restitution = 0;
-                // crank up friction with the ground so it doesn't try and slide across the ground
-                // again, this should depend on the type of surface we are landing on.
-                friction = 1;
-
-                //we have collided with ground straight on, we will fix orientation later
-                ground_collision = is_ground_normal;
-            }
+            //we have collided with ground straight on, we will fix orientation later
+            const bool ground_collision = is_ground_normal && is_landing;
+
+            //every contact point in body frame with the restitution and friction of what it touches
+            std::vector<ContactSolver::Contact> contacts;
+            auto addContact = [&](const Vector3r& normal, const Vector3r& impact_point, int material_id) {
+                ContactSolver::Contact contact;
+                contact.position = VectorMath::transformToBodyFrame(impact_point - collision_info.position, current.pose.orientation);
+                contact.normal = VectorMath::transformToBodyFrame(normal, current.pose.orientation);
+                contact.material_id = material_id;
+
+                const ContactMaterial* material = contact_materials.findMaterial(material_id);
+                if (material != nullptr)
+                    contact.material = *material;
+                else if (ground_collision) {
+                    // without a material entry, we don't want the ground to be so bouncy (0 means no bounce)
+                    // and crank up friction with the ground so it doesn't try and slide across the ground
+                    contact.material = ContactMaterial(0, 1, 1);
+                }
+                else
+                    contact.material = ContactMaterial(body.getRestitution(), body.getFriction(), body.getFriction());
 
-            //velocity at contact point
-            const Vector3r vcur_avg_body = VectorMath::transformToBodyFrame(vcur_avg, current.pose.orientation);
-            const Vector3r contact_vel_body = vcur_avg_body + angular_avg.cross(r);
+                contacts.push_back(contact);
+            };
+            if (collision_info.contacts.empty())
+                addContact(collision_info.normal, collision_info.impact_point, collision_info.material_id);
+            else {
+                for (const ContactPoint& contact : collision_info.contacts)
+                    addContact(contact.normal, contact.impact_point, contact.material_id);
+            }
 
             /*
-            GafferOnGames - Collision response with columb friction
-            http://gafferongames.com/virtual-go/collision-response-and-coulomb-friction/
-            Assuming collision is with static fixed body,
-            impulse magnitude = j = -(1 + R)V.N / (1/m + (I'(r X N) X r).N)
+            Sequential impulses over all contacts, for one contact each impulse is the classic
+            j = -(1 + R)V.N / (1/m + (I'(r X N) X r).N) with Coulomb friction along the tangent
             Physics Part 3, Collision Response, Chris Hecker, eq 4(a)
             http://chrishecker.com/images/e/e7/Gdmphys3.pdf
-            V(t+1) = V(t) + j*N / m
-        */
-            const real_T impulse_mag_denom = 1.0f / body.getMass() +
-                                             (body.getInertiaInv() * r.cross(normal_body))
-                                                 .cross(r)
-                                                 .dot(normal_body);
-            const real_T impulse_mag = -contact_vel_body.dot(normal_body) * (1 + restitution) / impulse_mag_denom;
-
-            next.twist.linear = vcur_avg + collision_info.normal * (impulse_mag / body.getMass());
-            next.twist.angular = angular_avg + r.cross(normal_body) * impulse_mag;
-
-            //above would modify component in direction of normal
-            //we will use friction to modify component in direction of tangent
-            const Vector3r contact_tang_body = contact_vel_body - normal_body * normal_body.dot(contact_vel_body);
-            const Vector3r contact_tang_unit_body = contact_tang_body.normalized();
-            const real_T friction_mag_denom = 1.0f / body.getMass() +
-                                              (body.getInertiaInv() * r.cross(contact_tang_unit_body))
-                                                  .cross(r)
-                                                  .dot(contact_tang_unit_body);
-            const real_T friction_mag = -contact_tang_body.norm() * friction / friction_mag_denom;
-
-            const Vector3r contact_tang_unit = VectorMath::transformToWorldFrame(contact_tang_unit_body, current.pose.orientation);
-            next.twist.linear += contact_tang_unit * friction_mag;
-            next.twist.angular += r.cross(contact_tang_unit_body) * (friction_mag / body.getMass());
-
-            //TODO: implement better rolling friction
-            next.twist.angular *= 0.9f;
+            */
+            Vector3r velocity_body = VectorMath::transformToBodyFrame(vcur_avg, current.pose.orientation);
+            Vector3r angular_velocity = angular_avg;
+            contact_solver.solve(contacts, body.getMass(), body.getInertiaInv(), collision_info.time_stamp, velocity_body, angular_velocity);
+
+            next.twist.linear = VectorMath::transformToWorldFrame(velocity_body, current.pose.orientation);
+            next.twist.angular = angular_velocity;
 
             // there is no acceleration during collision response, this is a hack, but without it the acceleration cancels
             // the computed impulse response too much and stops the vehicle from bouncing off the collided object.
@@ -304,20 +352,8 @@ namespace airlib
 
         static Wrench getBodyWrench(const PhysicsBody& body, const Quaternionr& orientation)
         {
-            //set wrench sum to zero
-            Wrench wrench = Wrench::zero();
-
             //calculate total force on rigid body's center of gravity
-            for (uint i = 0; i < body.wrenchVertexCount(); ++i) {
-                //aggregate total
-                const PhysicsBodyVertex& vertex = body.getWrenchVertex(i);
-                const auto& vertex_wrench = vertex.getWrench();
-                wrench += vertex_wrench;
-
-                //add additional torque due to force applies farther than COG
-                // tau = r X F
-                wrench.torque += vertex.getPosition().cross(vertex_wrench.force);
-            }
+            Wrench wrench = body.getWrenchSum();
 
             //convert force to world frame, leave torque to local frame
             wrench.force = VectorMath::transformToWorldFrame(wrench.force, orientation);
@@ -462,6 +498,12 @@ namespace airlib
         bool enable_ground_lock_;
         TTimePoint last_message_time;
         Vector3r wind_;
+        ContactMaterialTable contact_materials_;
+        //impulses of the last response per body, to warm start the next one
+        std::unordered_map<const PhysicsBody*, ContactSolver> contact_solvers_;
+
+        const UpdateProfiler::Section integrator_section_ = UpdateProfiler::getSection("Integrator");
+        const UpdateProfiler::Section collision_section_ = UpdateProfiler::getSection("Collision");
     };
 }
 } //namespace
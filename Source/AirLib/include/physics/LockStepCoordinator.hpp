@@ -0,0 +1,320 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef airsim_core_LockStepCoordinator_hpp
+#define airsim_core_LockStepCoordinator_hpp
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "common/Common.hpp"
+#include "common/StateReporter.hpp"
+#include "common/common_utils/ScheduledExecutor.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    /*
+    LockStepCoordinator gates the shared physics step on replies from every lock-stepped
+    autopilot attached to a World. A participant calls beginWait() right after it sends its
+    sensor frame and endWait() when the matching actuator reply arrives. The world stays
+    paused until all participants (or the configured quorum) have replied. Each participant
+    has its own deadline; the world is only ever paused until the earliest outstanding one
+    so a single stalled SITL instance cannot hold the rest of the farm indefinitely.
+
+    All times here are wall clock because the executor pause it drives is wall clock too.
+
+    The World shares the coordinator with its participants so they can still leave it after
+    the world is gone; the world detaches its executor first so nothing is paused any more.
+    */
+    class LockStepCoordinator
+    {
+    public:
+        typedef int ParticipantId;
+        static constexpr ParticipantId InvalidParticipant = -1;
+
+        //reply latency histogram with power-of-two microsecond buckets: [0, 1us), [1us, 2us), ... [2^(n-2)us, inf)
+        struct LatencyHistogram
+        {
+            static constexpr uint BucketCount = 24;
+
+            std::array<uint64_t, BucketCount> buckets{};
+            uint64_t count = 0;
+            uint64_t timeouts = 0;
+            TTimePoint total_nanos = 0;
+            TTimePoint max_nanos = 0;
+
+            void insert(TTimePoint latency_nanos)
+            {
+                uint64_t micros = latency_nanos / 1000;
+                uint bucket = 0;
+                while (micros > 0 && bucket < BucketCount - 1) {
+                    micros >>= 1;
+                    ++bucket;
+                }
+                ++buckets[bucket];
+                ++count;
+                total_nanos += latency_nanos;
+                max_nanos = std::max(max_nanos, latency_nanos);
+            }
+
+            //upper bound in microseconds of the bucket that holds the given fraction of samples
+            uint64_t percentileMicros(double fraction) const
+            {
+                if (count == 0)
+                    return 0;
+
+                uint64_t target = static_cast<uint64_t>(std::ceil(fraction * count));
+                uint64_t seen = 0;
+                for (uint bucket = 0; bucket < BucketCount; ++bucket) {
+                    seen += buckets[bucket];
+                    if (seen >= target)
+                        return 1ull << bucket;
+                }
+                return 1ull << (BucketCount - 1);
+            }
+
+            double meanMicros() const
+            {
+                return count == 0 ? 0 : total_nanos / (1000.0 * count);
+            }
+
+            void clear()
+            {
+                *this = LatencyHistogram();
+            }
+        };
+
+        struct ParticipantStats
+        {
+            std::string name;
+            bool is_waiting = false;
+            LatencyHistogram latency;
+        };
+
+    public:
+        explicit LockStepCoordinator(common_utils::ScheduledExecutor* executor)
+            : executor_(executor)
+        {
+        }
+
+        //fraction of participants that must reply before the world advances, in (0, 1];
+        //anything at or below 0 still waits for one participant
+        void setQuorum(float quorum)
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            quorum_ = Utils::clip(quorum, std::numeric_limits<float>::min(), 1.0f);
+        }
+        float getQuorum() const
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            return quorum_;
+        }
+
+        //called by the world as it goes away, the gate no longer pauses anything after this
+        void detachExecutor()
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            executor_ = nullptr;
+            is_gating_ = false;
+        }
+
+        ParticipantId addParticipant(const std::string& name, TTimeDelta deadline = 1)
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+
+            Participant participant;
+            participant.stats.name = name;
+            participant.deadline_nanos = static_cast<TTimePoint>(deadline * 1E9);
+
+            //reuse slots of removed participants so ids stay small
+            for (uint i = 0; i < participants_.size(); ++i) {
+                if (!participants_[i].is_registered) {
+                    participants_[i] = participant;
+                    return static_cast<ParticipantId>(i);
+                }
+            }
+            participants_.push_back(participant);
+            return static_cast<ParticipantId>(participants_.size() - 1);
+        }
+
+        void removeParticipant(ParticipantId id)
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            if (!isValid(id))
+                return;
+
+            participants_[id].is_registered = false;
+            participants_[id].stats.is_waiting = false;
+            updateGate(Utils::getTimeSinceEpochNanos());
+        }
+
+        //participant has sent its frame and the world must not advance until it replies
+        void beginWait(ParticipantId id)
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            if (!isValid(id))
+                return;
+
+            TTimePoint now = Utils::getTimeSinceEpochNanos();
+            Participant& participant = participants_[id];
+            participant.stats.is_waiting = true;
+            participant.wait_start = now;
+            updateGate(now);
+        }
+
+        //reply received, returns latency in seconds or -1 if participant was not waiting
+        TTimeDelta endWait(ParticipantId id)
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            if (!isValid(id) || !participants_[id].stats.is_waiting)
+                return -1;
+
+            TTimePoint now = Utils::getTimeSinceEpochNanos();
+            Participant& participant = participants_[id];
+            TTimePoint latency = now - participant.wait_start;
+            participant.stats.is_waiting = false;
+            participant.stats.latency.insert(latency);
+            updateGate(now);
+
+            return latency / 1.0E9;
+        }
+
+        //participant gave up waiting (for example its lock step mode was reset)
+        void cancelWait(ParticipantId id, bool is_timeout)
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            if (!isValid(id) || !participants_[id].stats.is_waiting)
+                return;
+
+            participants_[id].stats.is_waiting = false;
+            if (is_timeout)
+                ++participants_[id].stats.latency.timeouts;
+            updateGate(Utils::getTimeSinceEpochNanos());
+        }
+
+        bool hasExpired(ParticipantId id) const
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            if (!isValid(id) || !participants_[id].stats.is_waiting)
+                return false;
+
+            const Participant& participant = participants_[id];
+            return Utils::getTimeSinceEpochNanos() - participant.wait_start >= participant.deadline_nanos;
+        }
+
+        uint getWaitingCount() const
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            uint waiting = 0;
+            for (const auto& participant : participants_)
+                if (participant.is_registered && participant.stats.is_waiting)
+                    ++waiting;
+            return waiting;
+        }
+
+        std::vector<ParticipantStats> getStats() const
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            std::vector<ParticipantStats> stats;
+            for (const auto& participant : participants_)
+                if (participant.is_registered)
+                    stats.push_back(participant.stats);
+            return stats;
+        }
+
+        void clearStats()
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            for (auto& participant : participants_)
+                participant.stats.latency.clear();
+        }
+
+        void reportState(StateReporter& reporter) const
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            bool has_participants = false;
+            for (const auto& participant : participants_) {
+                if (!participant.is_registered)
+                    continue;
+                if (!has_participants) {
+                    reporter.writeHeading("LockStep");
+                    has_participants = true;
+                }
+
+                const LatencyHistogram& latency = participant.stats.latency;
+                reporter.writeValue(participant.stats.name,
+                                    Utils::stringf("mean=%.0fus p50<%lluus p99<%lluus max=%lluus timeouts=%llu",
+                                                   latency.meanMicros(),
+                                                   static_cast<unsigned long long>(latency.percentileMicros(0.5)),
+                                                   static_cast<unsigned long long>(latency.percentileMicros(0.99)),
+                                                   static_cast<unsigned long long>(latency.max_nanos / 1000),
+                                                   static_cast<unsigned long long>(latency.timeouts)));
+            }
+        }
+
+    private:
+        struct Participant
+        {
+            bool is_registered = true;
+            TTimePoint wait_start = 0;
+            TTimePoint deadline_nanos = 0;
+            ParticipantStats stats;
+        };
+
+        bool isValid(ParticipantId id) const
+        {
+            return id >= 0 && static_cast<uint>(id) < participants_.size() && participants_[id].is_registered;
+        }
+
+        //pause the world while more participants are outstanding than the quorum allows,
+        //otherwise let it run. must be called with mutex_ held.
+        void updateGate(TTimePoint now)
+        {
+            if (executor_ == nullptr)
+                return;
+
+            uint registered = 0, waiting = 0;
+            TTimePoint earliest_deadline = 0;
+            for (const auto& participant : participants_) {
+                if (!participant.is_registered)
+                    continue;
+                ++registered;
+                if (participant.stats.is_waiting) {
+                    ++waiting;
+                    TTimePoint deadline = participant.wait_start + participant.deadline_nanos;
+                    if (waiting == 1 || deadline < earliest_deadline)
+                        earliest_deadline = deadline;
+                }
+            }
+
+            uint required = static_cast<uint>(std::ceil(quorum_ * registered));
+            uint allowed_outstanding = registered - std::min(required, registered);
+
+            if (waiting > allowed_outstanding) {
+                TTimePoint remaining = earliest_deadline > now ? earliest_deadline - now : 0;
+                executor_->pauseForTime(remaining / 1.0E9);
+                is_gating_ = true;
+            }
+            else if (is_gating_) {
+                executor_->pause(false);
+                is_gating_ = false;
+            }
+        }
+
+    private:
+        common_utils::ScheduledExecutor* executor_;
+        std::vector<Participant> participants_;
+        float quorum_ = 1.0f;
+        bool is_gating_ = false;
+        mutable std::mutex mutex_;
+    };
+}
+} //namespace
+#endif
@@ -0,0 +1,159 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef airsim_core_LoopbackAutopilot_hpp
+#define airsim_core_LoopbackAutopilot_hpp
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "common/Common.hpp"
+#include "common/UpdatableObject.hpp"
+#include "common/common_utils/RandomGenerator.hpp"
+#include "World.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    /*
+    Stand-in for a lock-stepped SITL autopilot so LockStepCoordinator can be exercised
+    without PX4. Insert it into a World like any vehicle: every update() it "sends" a
+    sensor frame (begins a wait) and a reply thread answers after a simulated latency.
+    Latency is drawn from a gaussian and replies can be dropped with some probability
+    to mimic stalled instances that should hit their deadline.
+    */
+    class LoopbackAutopilot : public UpdatableObject
+    {
+    public:
+        LoopbackAutopilot(const std::string& name, TTimeDelta latency_mean = 1E-4f, TTimeDelta latency_stddev = 0,
+                          float drop_probability = 0, TTimeDelta deadline = 1)
+            : latency_mean_(latency_mean), latency_stddev_(latency_stddev), drop_probability_(drop_probability), deadline_(deadline), latency_rand_(0.0, 1.0), drop_rand_(0.0f, 1.0f)
+        {
+            setName(name);
+            is_running_ = true;
+            reply_thread_ = std::thread(&LoopbackAutopilot::replyLoop, this);
+        }
+
+        virtual ~LoopbackAutopilot()
+        {
+            {
+                std::lock_guard<std::mutex> guard(mutex_);
+                is_running_ = false;
+            }
+            cv_.notify_all();
+            if (reply_thread_.joinable())
+                reply_thread_.join();
+
+            if (coordinator_ != nullptr)
+                coordinator_->removeParticipant(id_);
+        }
+
+        uint64_t getFramesSent() const
+        {
+            return frames_sent_;
+        }
+        uint64_t getRepliesSent() const
+        {
+            return replies_sent_;
+        }
+
+        //*** Start: UpdatableState implementation ***//
+        virtual void resetImplementation() override
+        {
+            World* world = nullptr;
+            for (UpdatableObject* container = this->getParent(); container != nullptr; container = container->getParent()) {
+                if (container->getName() == "World")
+                    world = static_cast<World*>(container);
+            }
+
+            std::lock_guard<std::mutex> guard(mutex_);
+            std::shared_ptr<LockStepCoordinator> coordinator = world != nullptr ? world->getLockStepCoordinator() : nullptr;
+            if (coordinator != coordinator_) {
+                if (coordinator_ != nullptr)
+                    coordinator_->removeParticipant(id_);
+                coordinator_ = coordinator;
+                id_ = coordinator_ != nullptr ? coordinator_->addParticipant(getName(), deadline_) : LockStepCoordinator::InvalidParticipant;
+            }
+            pending_.clear();
+            awaiting_reply_ = false;
+        }
+
+        virtual void update() override
+        {
+            UpdatableObject::update();
+
+            std::lock_guard<std::mutex> guard(mutex_);
+            if (coordinator_ == nullptr)
+                return;
+
+            //like PX4 we only send the next frame once the previous one was answered
+            if (awaiting_reply_) {
+                if (!coordinator_->hasExpired(id_))
+                    return;
+                coordinator_->cancelWait(id_, true);
+                pending_.clear();
+            }
+
+            coordinator_->beginWait(id_);
+            awaiting_reply_ = true;
+            ++frames_sent_;
+
+            if (drop_rand_.next() < drop_probability_)
+                return;
+
+            TTimeDelta latency = std::max<TTimeDelta>(0, latency_mean_ + latency_stddev_ * latency_rand_.next());
+            pending_.push_back(Utils::getTimeSinceEpochNanos() + static_cast<TTimePoint>(latency * 1E9));
+            cv_.notify_one();
+        }
+        //*** End: UpdatableState implementation ***//
+
+    private:
+        void replyLoop()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (is_running_) {
+                if (pending_.empty()) {
+                    cv_.wait(lock);
+                    continue;
+                }
+
+                TTimePoint due = pending_.front();
+                TTimePoint now = Utils::getTimeSinceEpochNanos();
+                if (now < due) {
+                    cv_.wait_for(lock, std::chrono::nanoseconds(due - now));
+                    continue;
+                }
+
+                pending_.pop_front();
+                awaiting_reply_ = false;
+                ++replies_sent_;
+                coordinator_->endWait(id_);
+            }
+        }
+
+    private:
+        TTimeDelta latency_mean_, latency_stddev_;
+        float drop_probability_;
+        TTimeDelta deadline_;
+        common_utils::RandomGeneratorGaussianD latency_rand_;
+        common_utils::RandomGeneratorF drop_rand_;
+
+        std::shared_ptr<LockStepCoordinator> coordinator_;
+        LockStepCoordinator::ParticipantId id_ = LockStepCoordinator::InvalidParticipant;
+
+        std::deque<TTimePoint> pending_;
+        bool awaiting_reply_ = false;
+        std::atomic<uint64_t> frames_sent_{ 0 };
+        std::atomic<uint64_t> replies_sent_{ 0 };
+        std::atomic_bool is_running_{ false };
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        std::thread reply_thread_;
+    };
+}
+} //namespace
+#endif
@@ -77,12 +77,40 @@ namespace airlib
             kinematics_->update();
         }
 
+        //called by the world once the physics engine updated all bodies for the step, e.g. to
+        //publish the state the step ended with
+        virtual void endStep()
+        {
+        }
+
         virtual void setAirspeedBody(const Vector3r airspeed_body_vector)
         {
             unused(airspeed_body_vector);
         }
 
+        //total force and torque about the center of gravity from the wrench vertices, in the body frame;
+        //bodies whose vertices are known at compile time may sum them without going through getWrenchVertex
+        virtual Wrench getWrenchSum() const
+        {
+            Wrench wrench = Wrench::zero();
+            for (uint i = 0; i < wrenchVertexCount(); ++i)
+                addVertexWrench(getWrenchVertex(i), wrench);
+            return wrench;
+        }
+
     public: //methods
+        //overrides of getWrenchSum should add vertices with this, in vertex order, to get the same result
+        static void addVertexWrench(const PhysicsBodyVertex& vertex, Wrench& wrench)
+        {
+            //aggregate total
+            const auto& vertex_wrench = vertex.getWrench();
+            wrench += vertex_wrench;
+
+            //add additional torque due to force applies farther than COG
+            // tau = r X F
+            wrench.torque += vertex.getPosition().cross(vertex_wrench.force);
+        }
+
         //constructors
         PhysicsBody()
         {
@@ -136,7 +164,9 @@ namespace airlib
             //update individual vertices - each vertex takes control signal as input and
             //produces force and thrust as output
             for (uint vertex_index = 0; vertex_index < wrenchVertexCount(); ++vertex_index) {
-                getWrenchVertex(vertex_index).update();
+                PhysicsBodyVertex& vertex = getWrenchVertex(vertex_index);
+                UpdateProfiler::Scope profile_scope(vertex.getProfileSection());
+                vertex.update();
             }
             for (uint vertex_index = 0; vertex_index < dragVertexCount(); ++vertex_index) {
                 getDragVertex(vertex_index).update();
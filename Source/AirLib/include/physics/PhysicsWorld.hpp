@@ -73,12 +73,9 @@ namespace airlib
             reporter_.setEnable(is_enabled);
         }
 
-        void updateStateReport()
+        bool isStateReportEnabled()
         {
-            if (reporter_.canReport()) {
-                reporter_.clearReport();
-                world_.reportState(*reporter_.getReporter());
-            }
+            return reporter_.getEnable();
         }
 
         std::string getDebugReport()
@@ -111,12 +108,24 @@ namespace airlib
             world_.setFrameNumber(frameNumber);
         }
 
+        void waitForPause()
+        {
+            world_.waitForPause();
+        }
+
+        const std::shared_ptr<LockStepCoordinator>& getLockStepCoordinator()
+        {
+            return world_.getLockStepCoordinator();
+        }
+
         void resetImplementation() override {}
 
     private:
         void initializeWorld(const std::vector<UpdatableObject*>& bodies, bool start_async_updator)
         {
+            //the reporter is updated first, so it reports the state at the end of the previous step
             reporter_.initialize(false);
+            reporter_.setSource(&world_);
             world_.insert(&reporter_);
 
             for (size_t bi = 0; bi < bodies.size(); bi++)
@@ -0,0 +1,108 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef airsim_core_RenderStateBuffer_hpp
+#define airsim_core_RenderStateBuffer_hpp
+
+#include <atomic>
+#include "common/Common.hpp"
+#include "common/CommonStructs.hpp"
+#include "common/TripleBuffer.hpp"
+#include "common/VectorMath.hpp"
+#include "Kinematics.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    /*
+    Body state for the renderer, handed from the physics thread without taking the world lock.
+    The body publishes its state at the end of each physics step; the render thread takes the
+    latest one whenever it draws, along with the one published before it, and interpolates the
+    pose between them. Steps published in between are skipped.
+
+    TOutputs is whatever else of the body the renderer shows, e.g. rotor outputs.
+    */
+    template <typename TOutputs>
+    class RenderStateBuffer
+    {
+    public:
+        struct State
+        {
+            TTimePoint time = 0; //0 if nothing was published
+            Kinematics::State kinematics;
+            CollisionResponse collision_response;
+            TOutputs outputs;
+        };
+
+    public:
+        //physics thread
+        void publish(const State& state)
+        {
+            if (is_break_requested_.exchange(false))
+                last_published_.time = 0;
+
+            Frame& frame = buffer_.getWriteBuffer();
+            frame.previous = last_published_;
+            frame.latest = state;
+            last_published_ = state;
+            buffer_.publish();
+        }
+
+        //the next state isn't interpolated from earlier ones, for bodies moved rather than
+        //simulated there; any thread, the next publish() takes it up
+        void breakInterpolation()
+        {
+            is_break_requested_.store(true);
+        }
+
+        /*
+        Render thread: the body's state at time, which should be the clock's time now. The pose
+        trails the physics by one step so it can be interpolated between the last two published
+        states, otherwise it's the latest state. Returns false if nothing was published yet.
+        */
+        bool getState(TTimePoint time, bool interpolate, State& state)
+        {
+            buffer_.read();
+            const Frame& frame = buffer_.getReadBuffer();
+            if (frame.latest.time == 0)
+                return false;
+
+            state = frame.latest;
+
+            const State& previous = frame.previous;
+            if (interpolate && previous.time != 0 && previous.time < frame.latest.time) {
+                const double step = static_cast<double>(frame.latest.time - previous.time);
+                const double since_latest = time > frame.latest.time ? static_cast<double>(time - frame.latest.time) : 0;
+                const real_T alpha = static_cast<real_T>(std::min(since_latest / step, 1.0));
+
+                Pose& pose = state.kinematics.pose;
+                pose.position = previous.kinematics.pose.position + (pose.position - previous.kinematics.pose.position) * alpha;
+                pose.orientation = previous.kinematics.pose.orientation.slerp(alpha, pose.orientation);
+            }
+            return true;
+        }
+
+        //only while the physics thread isn't publishing, e.g. with the world locked on reset
+        void reset()
+        {
+            buffer_.reset();
+            last_published_ = State();
+            is_break_requested_.store(false);
+        }
+
+    private:
+        struct Frame
+        {
+            State previous;
+            State latest;
+        };
+
+        TripleBuffer<Frame> buffer_;
+        State last_published_; //physics thread only
+        std::atomic<bool> is_break_requested_{ false };
+    };
+}
+} //namespace
+#endif
@@ -4,11 +4,14 @@
 #ifndef airsim_core_World_hpp
 #define airsim_core_World_hpp
 
+#include <algorithm>
+#include <cmath>
 #include <functional>
 #include "common/Common.hpp"
 #include "common/UpdatableContainer.hpp"
 #include "PhysicsEngineBase.hpp"
 #include "PhysicsBody.hpp"
+#include "LockStepCoordinator.hpp"
 #include "common/common_utils/ScheduledExecutor.hpp"
 #include "common/ClockFactory.hpp"
 
@@ -21,7 +24,7 @@ namespace airlib
     {
     public:
         World(std::unique_ptr<PhysicsEngineBase> physics_engine)
-            : physics_engine_(std::move(physics_engine))
+            : physics_engine_(std::move(physics_engine)), lock_step_coordinator_(std::make_shared<LockStepCoordinator>(&executor_))
         {
             World::clear();
             setName("World");
@@ -42,14 +45,25 @@ namespace airlib
 
         virtual void update() override
         {
-            ClockFactory::get()->step();
+            //one clock read for the whole step
+            ClockBase::StepScope step_scope(ClockFactory::get());
 
-            //first update our objects
-            UpdatableContainer::update();
+            {
+                UpdateProfiler::Scope profile_scope(getProfileSection());
 
-            //now update kinematics state
-            if (physics_engine_)
-                physics_engine_->update();
+                //first update our objects
+                UpdatableContainer::update();
+
+                //now update kinematics state
+                if (physics_engine_) {
+                    UpdateProfiler::Scope engine_profile_scope(physics_engine_->getProfileSection());
+                    physics_engine_->update();
+
+                    for (PhysicsBody* body : *physics_engine_)
+                        body->endStep();
+                }
+            }
+            UpdateProfiler::endStep();
         }
 
         virtual void reportState(StateReporter& reporter) override
@@ -57,6 +71,7 @@ namespace airlib
             reporter.writeValue("Sleep", 1.0f / executor_.getSleepTimeAvg());
             if (physics_engine_)
                 physics_engine_->reportState(reporter);
+            lock_step_coordinator_->reportState(reporter);
 
             //call base
             UpdatableContainer::reportState(reporter);
@@ -110,11 +125,13 @@ namespace airlib
 
         virtual ~World()
         {
+            lock_step_coordinator_->detachExecutor();
             executor_.stop();
         }
 
         void pause(bool is_paused)
         {
+            continue_until_ = 0;
             executor_.pause(is_paused);
         }
 
@@ -125,24 +142,42 @@ namespace airlib
 
         void pauseForTime(double seconds)
         {
+            continue_until_ = 0;
             executor_.pauseForTime(seconds);
         }
 
+        //runs until the sim clock has advanced by seconds, pausing after the step that gets there;
+        //a microsecond of slack keeps a multiple of a float step size from costing an extra step
         void continueForTime(double seconds)
         {
-            executor_.continueForTime(seconds);
+            const TTimePoint duration = static_cast<TTimePoint>(std::max<int64_t>(0, std::llround(seconds * 1.0E9) - 1000));
+            continue_until_ = ClockFactory::get()->nowNanos() + duration;
+            executor_.pause(false);
         }
 
         void continueForFrames(uint32_t frames)
         {
+            continue_until_ = 0;
             executor_.continueForFrames(frames);
         }
 
+        //blocks until the world is paused between steps, e.g. when continueForTime is done
+        void waitForPause()
+        {
+            executor_.waitForPause();
+        }
+
         void setFrameNumber(uint32_t frameNumber)
         {
             executor_.setFrameNumber(frameNumber);
         }
 
+        //lock-stepped autopilots register here so they gate the shared step together
+        const std::shared_ptr<LockStepCoordinator>& getLockStepCoordinator()
+        {
+            return lock_step_coordinator_;
+        }
+
     private:
         bool worldUpdatorAsync(uint64_t dt_nanos)
         {
@@ -150,6 +185,14 @@ namespace airlib
 
             try {
                 update();
+
+                //paused here rather than by the executor's wall clock so the steps taken don't
+                //depend on when the executor wakes up
+                const TTimePoint continue_until = continue_until_;
+                if (continue_until != 0 && ClockFactory::get()->nowNanos() >= continue_until) {
+                    continue_until_ = 0;
+                    executor_.pause(true);
+                }
             }
             catch (const std::exception& ex) {
                 //Utils::DebugBreak();
@@ -166,6 +209,8 @@ namespace airlib
     private:
         std::unique_ptr<PhysicsEngineBase> physics_engine_ = nullptr;
         common_utils::ScheduledExecutor executor_;
+        std::shared_ptr<LockStepCoordinator> lock_step_coordinator_;
+        std::atomic<TTimePoint> continue_until_{ 0 }; //0 if not continuing for time
     };
 }
 } //namespace
@@ -23,7 +23,7 @@ namespace airlib
         {
             calculateCenter();
 
-            Utils::logMessage("CubeGeoFence: %s", toString().c_str());
+            Utils::log(Utils::stringf("CubeGeoFence: %s", toString().c_str()));
         }
 
         void setBoundry(const Vector3r& origin, float xy_length, float max_z, float min_z) override
@@ -36,7 +36,7 @@ namespace airlib
 
             calculateCenter();
 
-            Utils::logMessage("CubeGeoFence: %s", toString().c_str());
+            Utils::log(Utils::stringf("CubeGeoFence: %s", toString().c_str()));
         }
 
         void checkFence(const Vector3r& cur_loc, const Vector3r& dest_loc,
@@ -0,0 +1,152 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef air_OccupancyMap_hpp
+#define air_OccupancyMap_hpp
+
+#include <array>
+#include <memory>
+#include <shared_mutex>
+#include <unordered_map>
+#include "common/Common.hpp"
+#include "common/CommonStructs.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    /*
+    OccupancyMap is a 3D probabilistic voxel map built from range sensor returns, as a
+    counterpart to the 2D ObstacleMap for obstacles above or below the vehicle.
+
+    Voxels are stored sparsely in hashed blocks of 8x8x8 so only space the sensors have seen
+    takes memory. Each voxel keeps the log-odds of being occupied: every return adds
+    log_odds_hit to the voxel it ends in and log_odds_miss to the voxels the ray passed
+    through, clamped so the map can change its mind when things move. Within one scan each
+    voxel is updated at most once and a hit wins over a miss, like OctoMap, so the many rays
+    leaving the sensor through the same voxels don't outweigh the returns.
+
+    Coordinates are whatever frame the points are inserted in; the insert helpers for sensor
+    data use the vehicle inertial (NED) frame the sensors report poses in.
+
+    One thread is expected to insert scans while others query: inserts take an exclusive
+    lock for a whole scan and queries a shared one, so queries never see half a scan.
+    */
+    class OccupancyMap
+    {
+    public:
+        struct Params
+        {
+            real_T resolution = 0.2f; //voxel edge in meters
+            real_T max_range = 50; //returns further than this only clear space up to it
+
+            float log_odds_hit = 0.85f; //probability 0.7
+            float log_odds_miss = -0.4f; //probability 0.4
+            float log_odds_min = -2.0f; //probability 0.12
+            float log_odds_max = 3.5f; //probability 0.97
+            float log_odds_occupied = 0; //voxels above this are obstacles
+
+            //stop clearing a ray at the first voxel another ray of the same scan cleared,
+            //approximate near the sensor but saves walking the same voxels for every ray
+            bool stop_at_cleared = true;
+        };
+
+        struct ObstacleInfo
+        {
+            bool found = false;
+            real_T distance = 0; //from query point to the center of the obstacle voxel
+            Vector3r position = Vector3r::Zero(); //center of the obstacle voxel
+            float probability = 0; //of the voxel being occupied
+        };
+
+    public:
+        OccupancyMap();
+        explicit OccupancyMap(const Params& params);
+
+        //one ray; end is a return if hit is true, otherwise the ray only clears space up to end
+        void insertRay(const Vector3r& origin, const Vector3r& end, bool hit);
+
+        //a scan of returns from origin; points are xyz triples, transformed by points_frame first
+        void insertPointCloud(const Vector3r& origin, const vector<real_T>& points, const Pose& points_frame = Pose::zero());
+
+        //point_cloud is in the vehicle inertial frame unless sensor_local_frame is set,
+        //in which case it is relative to data.pose like LidarSimple's SensorLocalFrame output
+        void insertLidar(const LidarData& data, bool sensor_local_frame);
+
+        //a range along the sensor's x axis; readings at max_distance mean nothing was seen
+        void insertDistance(const DistanceSensorData& data, const Pose& vehicle_pose);
+
+        void clear();
+
+        //0.5 for voxels never observed
+        float getProbability(const Vector3r& point) const;
+        bool isOccupied(const Vector3r& point) const;
+
+        //nearest occupied voxel within max_distance of point
+        ObstacleInfo getClosestObstacle(const Vector3r& point, real_T max_distance) const;
+        //nearest occupied voxel within max_distance of origin whose bearing is within half_angle of direction
+        ObstacleInfo getClosestObstacleInCone(const Vector3r& origin, const Vector3r& direction, real_T half_angle, real_T max_distance) const;
+
+        const Params& getParams() const;
+        size_t getBlockCount() const;
+        size_t getOccupiedCount() const;
+
+    private:
+        static constexpr int BlockBits = 3;
+        static constexpr int BlockSize = 1 << BlockBits;
+        static constexpr int BlockVoxels = BlockSize * BlockSize * BlockSize;
+        //beyond this many voxels from the origin coordinates don't fit the int keys
+        static constexpr real_T MaxKeyedVoxels = 1.0E9f;
+
+        typedef Eigen::Vector3i VoxelKey;
+
+        enum class VoxelUpdate
+        {
+            Updated,
+            AlreadyCleared, //by another ray of this scan
+            AlreadyHit //by another return of this scan
+        };
+
+        struct Voxel
+        {
+            float log_odds = 0;
+            //scan that last updated the voxel and how, so a scan updates it once
+            uint32_t stamp = 0;
+        };
+
+        struct Block
+        {
+            VoxelKey key; //voxel key divided by BlockSize
+            std::array<Voxel, BlockVoxels> voxels;
+            uint occupied_count = 0;
+        };
+
+        VoxelKey toKey(const Vector3r& point) const;
+        Vector3r toCenter(const VoxelKey& key) const;
+        static uint64_t blockHash(const VoxelKey& block_key);
+        static int voxelIndex(const VoxelKey& key);
+
+        Block* getOrCreateBlock(const VoxelKey& key);
+        const Block* findBlock(const VoxelKey& key) const;
+
+        //caller holds the exclusive lock
+        void beginScan();
+        VoxelUpdate updateVoxel(const VoxelKey& key, bool hit, Block*& cached_block, VoxelKey& cached_block_key);
+        void carveRay(const Vector3r& origin, const Vector3r& end, Block*& cached_block, VoxelKey& cached_block_key);
+
+        template <typename TAccept>
+        ObstacleInfo findClosest(const Vector3r& point, real_T max_distance, const TAccept& accept) const;
+
+    private:
+        Params params_;
+        real_T inv_resolution_;
+        std::unordered_map<uint64_t, std::unique_ptr<Block>> blocks_;
+        size_t occupied_count_ = 0;
+        uint32_t scan_ = 0;
+
+        mutable std::shared_timed_mutex mutex_;
+    };
+}
+} //namespace
+#endif
@@ -8,11 +8,14 @@
 #include <array>
 #include <memory>
 #include "ObstacleMap.hpp"
+#include "OccupancyMap.hpp"
 #include "common/common_utils/Utils.hpp"
 #include "IGeoFence.hpp"
 #include "common/Common.hpp"
 #include "vehicles/multirotor/api/MultirotorCommon.hpp"
 #include "common/common_utils/EnumFlags.hpp"
+#include "common/EarthUtils.hpp"
+#include "common/TerrainModel.hpp"
 
 namespace msr
 {
@@ -29,6 +32,7 @@ namespace airlib
             GeoFence = 1 << 0,
             Obstacle = 1 << 1,
             VelocityLimit = 1 << 2,
+            Terrain = 1 << 3,
             All = Utils::max<uint>()
         };
         //add bitwise operators for enum
@@ -88,19 +92,32 @@ namespace airlib
         };
 
     private:
+        //clearance added for an obstacle seen with no confidence, 3.2 comes from inverse CDF
+        //for epsilon = 0.05 (i.e. 95% confidence), author: akapoor
+        static constexpr float PrStlClearanceMargin = 3.2f;
+
         MultirotorApiParams vehicle_params_;
         shared_ptr<IGeoFence> fence_ptr_;
         shared_ptr<ObstacleMap> obs_xy_ptr_;
+        //3D map from range sensors, replaces obs_xy_ptr_ for obstacle checks when set
+        shared_ptr<OccupancyMap> occupancy_map_ptr_;
+        float occupancy_cone_half_angle_ = M_PIf / 8;
+        shared_ptr<const TerrainModel> terrain_ptr_;
+        HomeGeoPoint terrain_home_;
+        float terrain_clearance_ = 0;
         SafetyViolationType enable_reasons_ = SafetyEval::SafetyViolationType_::GeoFence;
         ObsAvoidanceStrategy obs_strategy_ = SafetyEval::ObsAvoidanceStrategy::RaiseException;
 
         void checkFence(const Vector3r& cur_pos, const Vector3r& dest_pos, EvalResult& appendToResult);
+        void checkTerrain(const Vector3r& dest_pos, EvalResult& appendToResult);
         void isSafeDestination(const Vector3r& dest, const Vector3r& cur_pos, const Quaternionr& quaternion, SafetyEval::EvalResult& result);
         Vector3r getDestination(const Vector3r& cur_pos, const Vector3r& velocity) const;
         bool isThisRiskDistLess(float this_risk_dist, float other_risk_dist) const;
         void isCurrentSafer(SafetyEval::EvalResult& result);
         void setSuggestedVelocity(SafetyEval::EvalResult& result, const Quaternionr& quaternion);
         float adjustClearanceForPrStl(float base_clearance, float obs_confidence);
+        ObstacleMap::ObstacleInfo toObstacleInfo(const OccupancyMap::ObstacleInfo& info) const;
+        void setSuggestedVelocityFromMap(SafetyEval::EvalResult& result);
 
     public:
         SafetyEval(MultirotorApiParams vehicle_params, shared_ptr<IGeoFence> fence_ptr, shared_ptr<ObstacleMap> obs_xy);
@@ -113,6 +130,15 @@ namespace airlib
                        const Vector3r& origin, float xy_length, float max_z, float min_z);
         void setObsAvoidanceStrategy(SafetyEval::ObsAvoidanceStrategy obs_strategy);
         SafetyEval::ObsAvoidanceStrategy getObsAvoidanceStrategy();
+
+        //obstacles towards destination are looked for in a cone of cone_half_angle around it,
+        //pass nullptr to go back to the 2D obstacle map
+        void setOccupancyMap(shared_ptr<OccupancyMap> occupancy_map, float cone_half_angle = M_PIf / 8);
+        shared_ptr<OccupancyMap> getOccupancyMap() const;
+
+        //destinations closer than clearance above the terrain are unsafe when Terrain is enabled,
+        //positions are local NED from home
+        void setTerrain(shared_ptr<const TerrainModel> terrain, const GeoPoint& home, float clearance);
     };
 }
 } //namespace
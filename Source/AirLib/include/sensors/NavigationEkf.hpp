@@ -0,0 +1,482 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_airlib_NavigationEkf_hpp
+#define msr_airlib_NavigationEkf_hpp
+
+#include <array>
+#include <chrono>
+#include "common/Common.hpp"
+#include "common/ClockBase.hpp"
+#include "common/EarthUtils.hpp"
+#include "common/ExtendedKalmanFilter.hpp"
+#include "common/StateReporter.hpp"
+#include "physics/Kinematics.hpp"
+#include "sensors/SensorCollection.hpp"
+#include "sensors/imu/ImuBase.hpp"
+#include "sensors/gps/GpsBase.hpp"
+#include "sensors/barometer/BarometerBase.hpp"
+#include "sensors/magnetometer/MagnetometerBase.hpp"
+#include "sensors/airspeed/AirspeedBase.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    /*
+    Onboard navigation filter: an error state EKF that integrates the IMU and corrects with the GPS,
+    barometer, magnetometer and airspeed sensors of a vehicle, the first sensor of each type found.
+    Sensors that are missing are skipped, except the IMU without which the filter doesn't run.
+
+    The nominal state is position and velocity in local NED, orientation and the sensor biases. The
+    filter tracks the covariance of small errors around it: position, velocity, attitude as a rotation
+    vector in the body frame, gyro bias, accelerometer bias and barometer offset.
+
+    Sensors report with latency, so GPS, barometer and airspeed are compared with the position and
+    velocity the filter had at the time stamp of the measurement, kept for the last kHistorySize
+    IMU samples, and the correction is applied to the current state. The filter starts from the
+    true state at the first IMU sample, like a vehicle that was aligned before it moved.
+
+    Past the start, ground truth is only used to measure how consistent the filter is.
+    */
+    class NavigationEkf
+    {
+    public:
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+        struct Params
+        {
+            //process noise, defaults are the noise of ImuSimpleParams
+            real_T gyro_noise = 8.7E-5f; //rad/sqrt(s), 0.3 deg/sqrt(hour)
+            real_T accel_noise = 2.4E-3f; //m/s/sqrt(s), 0.24 mg
+            real_T gyro_bias_walk = 1.0E-6f; //rad/s/sqrt(s), 4.6 deg/hour over 500s
+            real_T accel_bias_walk = 1.25E-5f; //m/s^2/sqrt(s), 36 ug over 800s
+            real_T baro_offset_walk = 0.01f; //m/sqrt(s)
+
+            //measurement noise, defaults are the noise of the simple sensors. GpsSimple has none, its
+            //velocity sigma covers comparing it with the state at the IMU sample before its time stamp
+            real_T gps_position_sigma_min = 0.1f; //m, GPS eph/epv are used if larger
+            real_T gps_velocity_sigma = 0.004f; //m/s
+            real_T baro_sigma = 0.22f; //m, 2.7 Pa
+            real_T mag_sigma = 0.005f; //Gauss
+            real_T airspeed_sigma = 1.0f; //m/s
+            real_T airspeed_min = 3.0f; //m/s, below this airspeed is not used
+
+            //measurements with larger normalized innovation per dimension are rejected
+            real_T innovation_gate_sigma = 5.0f;
+
+            //initial uncertainty
+            real_T position_sigma = 1.0f; //m
+            real_T velocity_sigma = 0.5f; //m/s
+            real_T attitude_sigma = 0.05f; //rad
+            real_T gyro_bias_sigma = 0.01f; //rad/s
+            real_T accel_bias_sigma = 0.1f; //m/s^2
+            real_T baro_offset_sigma = 1.0f; //m
+        };
+
+        struct Metrics
+        {
+            uint64_t update_count = 0;
+            uint64_t rejected_count = 0; //measurements rejected by the innovation gate
+
+            //wall time spent in update, without the consistency check
+            uint64_t last_latency_nanos = 0;
+            uint64_t max_latency_nanos = 0;
+            double mean_latency_nanos = 0;
+
+            //normalized estimation error squared of position, velocity and attitude
+            //against ground truth; averages kNeesDof if the filter is consistent
+            real_T last_nees = 0;
+            double mean_nees = 0;
+            uint64_t nees_count = 0;
+        };
+
+        static constexpr int kNeesDof = 9;
+
+    public:
+        NavigationEkf(const SensorCollection* sensors)
+            : NavigationEkf(sensors, Params())
+        {
+        }
+        NavigationEkf(const SensorCollection* sensors, const Params& params)
+            : sensors_(sensors), params_(params)
+        {
+        }
+
+        //filter restarts at the next IMU sample
+        void reset()
+        {
+            is_initialized_ = false;
+            is_baro_initialized_ = false;
+            metrics_ = Metrics();
+        }
+
+        /*
+        Call once per physics step after the sensors were updated, with the true state the filter
+        starts from and is checked against. Does nothing until the IMU has a sample.
+        */
+        void update(const Kinematics::State& ground_truth, const GeoPoint& home_geo_point)
+        {
+            const ImuBase* imu = getSensor<ImuBase>(SensorBase::SensorType::Imu);
+            if (imu == nullptr || imu->getOutputSequence() == 0)
+                return;
+
+            if (!is_initialized_)
+                initialize(ground_truth, home_geo_point, imu->getOutput());
+
+            const auto start_time = std::chrono::steady_clock::now();
+
+            if (imu->getOutputSequence() != sequences_.imu) {
+                sequences_.imu = imu->getOutputSequence();
+                predict(imu->getOutput());
+            }
+
+            const GpsBase* gps = getSensor<GpsBase>(SensorBase::SensorType::Gps);
+            if (gps != nullptr && gps->getOutputSequence() != sequences_.gps) {
+                sequences_.gps = gps->getOutputSequence();
+                updateGps(gps->getOutput());
+            }
+            const BarometerBase* baro = getSensor<BarometerBase>(SensorBase::SensorType::Barometer);
+            if (baro != nullptr && baro->getOutputSequence() != sequences_.baro) {
+                sequences_.baro = baro->getOutputSequence();
+                updateBarometer(baro->getOutput());
+            }
+            const MagnetometerBase* mag = getSensor<MagnetometerBase>(SensorBase::SensorType::Magnetometer);
+            if (mag != nullptr && mag->getOutputSequence() != sequences_.mag) {
+                sequences_.mag = mag->getOutputSequence();
+                updateMagnetometer(mag->getOutput());
+            }
+            const AirspeedBase* airspeed = getSensor<AirspeedBase>(SensorBase::SensorType::Airspeed);
+            if (airspeed != nullptr && airspeed->getOutputSequence() != sequences_.airspeed) {
+                sequences_.airspeed = airspeed->getOutputSequence();
+                updateAirspeed(airspeed->getOutput());
+            }
+
+            const uint64_t latency = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time).count());
+            ++metrics_.update_count;
+            metrics_.last_latency_nanos = latency;
+            metrics_.max_latency_nanos = std::max(metrics_.max_latency_nanos, latency);
+            metrics_.mean_latency_nanos += (latency - metrics_.mean_latency_nanos) / metrics_.update_count;
+
+            updateNees(ground_truth);
+        }
+
+        bool isInitialized() const
+        {
+            return is_initialized_;
+        }
+
+        //estimated state in the same frames as Kinematics, valid once initialized
+        const Kinematics::State& getKinematics() const
+        {
+            return kinematics_;
+        }
+
+        GeoPoint getGeoPoint() const
+        {
+            return EarthUtils::nedToGeodeticFast(kinematics_.pose.position, home_geo_point_);
+        }
+
+        const Metrics& getMetrics() const
+        {
+            return metrics_;
+        }
+
+        void reportState(StateReporter& reporter) const
+        {
+            reporter.writeValue("EKF-Updates", metrics_.update_count);
+            reporter.writeValue("EKF-Rejected", metrics_.rejected_count);
+            reporter.writeValue("EKF-Latency-us", metrics_.last_latency_nanos / 1.0E3);
+            reporter.writeValue("EKF-Latency-Mean-us", metrics_.mean_latency_nanos / 1.0E3);
+            reporter.writeValue("EKF-Latency-Max-us", metrics_.max_latency_nanos / 1.0E3);
+            reporter.writeValue("EKF-NEES", metrics_.last_nees);
+            reporter.writeValue("EKF-NEES-Mean", metrics_.mean_nees);
+            reporter.writeValue("EKF-Pos-Err", kinematics_.pose.position - last_true_position_);
+        }
+
+    private:
+        //error state layout
+        static constexpr int kPosition = 0;
+        static constexpr int kVelocity = 3;
+        static constexpr int kAttitude = 6;
+        static constexpr int kGyroBias = 9;
+        static constexpr int kAccelBias = 12;
+        static constexpr int kBaroOffset = 15;
+        static constexpr int kStateSize = 16;
+
+        //IMU samples of past states kept to compare delayed measurements with
+        static constexpr uint kHistorySize = 256;
+
+        struct PastState
+        {
+            TTimePoint time;
+            Vector3r position;
+            Vector3r velocity;
+        };
+
+        typedef ExtendedKalmanFilter<kStateSize> Filter;
+
+        template <typename TSensor>
+        const TSensor* getSensor(SensorBase::SensorType type) const
+        {
+            return sensors_->size(type) > 0 ? static_cast<const TSensor*>(sensors_->getByType(type)) : nullptr;
+        }
+
+        void initialize(const Kinematics::State& ground_truth, const GeoPoint& home_geo_point, const ImuBase::Output& imu)
+        {
+            home_geo_point_ = home_geo_point;
+            kinematics_ = ground_truth;
+            gyro_bias_ = accel_bias_ = Vector3r::Zero();
+            baro_offset_ = 0;
+            last_imu_time_ = imu.time_stamp;
+            sequences_ = Sequences();
+            history_count_ = 0;
+            remember();
+
+            Filter::StateVector variance;
+            variance.segment<3>(kPosition).setConstant(params_.position_sigma * params_.position_sigma);
+            variance.segment<3>(kVelocity).setConstant(params_.velocity_sigma * params_.velocity_sigma);
+            variance.segment<3>(kAttitude).setConstant(params_.attitude_sigma * params_.attitude_sigma);
+            variance.segment<3>(kGyroBias).setConstant(params_.gyro_bias_sigma * params_.gyro_bias_sigma);
+            variance.segment<3>(kAccelBias).setConstant(params_.accel_bias_sigma * params_.accel_bias_sigma);
+            variance(kBaroOffset) = params_.baro_offset_sigma * params_.baro_offset_sigma;
+            filter_.reset(variance);
+
+            is_initialized_ = true;
+        }
+
+        void predict(const ImuBase::Output& imu)
+        {
+            const real_T dt = static_cast<real_T>(ClockBase::toSeconds(ClockBase::elapsedNanosBetween(imu.time_stamp, last_imu_time_)));
+            last_imu_time_ = imu.time_stamp;
+            if (dt <= 0)
+                return;
+
+            const Vector3r angular_velocity = imu.angular_velocity - gyro_bias_;
+            const Vector3r specific_force = imu.linear_acceleration - accel_bias_;
+            const Matrix3x3r rotation = kinematics_.pose.orientation.toRotationMatrix();
+            const Vector3r gravity(0, 0, EarthUtils::getGravity(home_geo_point_.altitude - kinematics_.pose.position.z()));
+            const Vector3r acceleration = rotation * specific_force + gravity;
+
+            //nominal state
+            kinematics_.pose.position += kinematics_.twist.linear * dt + acceleration * (dt * dt / 2);
+            kinematics_.twist.linear += acceleration * dt;
+            kinematics_.pose.orientation = (kinematics_.pose.orientation * toQuaternion(angular_velocity * dt)).normalized();
+            kinematics_.accelerations.linear = acceleration;
+            kinematics_.accelerations.angular = (angular_velocity - kinematics_.twist.angular) / dt;
+            kinematics_.twist.angular = angular_velocity;
+            remember();
+
+            //error state, first order
+            Filter::StateMatrix transition = Filter::StateMatrix::Identity();
+            transition.block<3, 3>(kPosition, kVelocity) = Matrix3x3r::Identity() * dt;
+            transition.block<3, 3>(kVelocity, kAttitude) = -rotation * skew(specific_force) * dt;
+            transition.block<3, 3>(kVelocity, kAccelBias) = -rotation * dt;
+            transition.block<3, 3>(kAttitude, kAttitude) = Matrix3x3r::Identity() - skew(angular_velocity) * dt;
+            transition.block<3, 3>(kAttitude, kGyroBias) = -Matrix3x3r::Identity() * dt;
+
+            Filter::StateVector noise = Filter::StateVector::Zero();
+            noise.segment<3>(kVelocity).setConstant(params_.accel_noise * params_.accel_noise * dt);
+            noise.segment<3>(kAttitude).setConstant(params_.gyro_noise * params_.gyro_noise * dt);
+            noise.segment<3>(kGyroBias).setConstant(params_.gyro_bias_walk * params_.gyro_bias_walk * dt);
+            noise.segment<3>(kAccelBias).setConstant(params_.accel_bias_walk * params_.accel_bias_walk * dt);
+            noise(kBaroOffset) = params_.baro_offset_walk * params_.baro_offset_walk * dt;
+
+            filter_.predict(transition, noise.asDiagonal().toDenseMatrix());
+        }
+
+        void updateGps(const GpsBase::Output& gps)
+        {
+            const PastState* past = recall(gps.time_stamp);
+            if (!gps.is_valid || gps.gnss.fix_type < GpsBase::GnssFixType::GNSS_FIX_3D_FIX || past == nullptr)
+                return;
+
+            Eigen::Matrix<real_T, 6, 1> residual;
+            residual.head<3>() = EarthUtils::GeodeticToNedFast(gps.gnss.geo_point, home_geo_point_) - past->position;
+            residual.tail<3>() = gps.gnss.velocity - past->velocity;
+
+            Filter::ObservationMatrix<6> observation = Filter::ObservationMatrix<6>::Zero();
+            observation.block<3, 3>(0, kPosition).setIdentity();
+            observation.block<3, 3>(3, kVelocity).setIdentity();
+
+            const real_T horizontal_sigma = std::max(gps.gnss.eph, params_.gps_position_sigma_min);
+            const real_T vertical_sigma = std::max(gps.gnss.epv, params_.gps_position_sigma_min);
+            Eigen::Matrix<real_T, 6, 1> noise;
+            noise << horizontal_sigma * horizontal_sigma, horizontal_sigma * horizontal_sigma, vertical_sigma * vertical_sigma,
+                Vector3r::Constant(params_.gps_velocity_sigma * params_.gps_velocity_sigma);
+
+            correct<6>(residual, observation, noise.asDiagonal().toDenseMatrix());
+        }
+
+        void updateBarometer(const BarometerBase::Output& baro)
+        {
+            //barometric altitude = altitude + offset, the offset takes up qnh and pressure drift
+            const PastState* past = recall(baro.time_stamp);
+            if (past == nullptr)
+                return;
+            const real_T altitude = static_cast<real_T>(home_geo_point_.altitude) - past->position.z();
+            if (!is_baro_initialized_) {
+                baro_offset_ = baro.altitude - altitude;
+                is_baro_initialized_ = true;
+                return;
+            }
+
+            Eigen::Matrix<real_T, 1, 1> residual;
+            residual(0) = baro.altitude - (altitude + baro_offset_);
+
+            Filter::ObservationMatrix<1> observation = Filter::ObservationMatrix<1>::Zero();
+            observation(0, kPosition + 2) = -1;
+            observation(0, kBaroOffset) = 1;
+
+            correct<1>(residual, observation, Eigen::Matrix<real_T, 1, 1>::Constant(params_.baro_sigma * params_.baro_sigma));
+        }
+
+        void updateMagnetometer(const MagnetometerBase::Output& mag)
+        {
+            //same dipole model as MagnetometerSimple, in Gauss
+            const Vector3r field_world = EarthUtils::getMagField(getGeoPoint()) * 1E4f;
+            const Vector3r field_body = VectorMath::transformToBodyFrame(field_world, kinematics_.pose.orientation);
+
+            const Vector3r residual = mag.magnetic_field_body - field_body;
+
+            Filter::ObservationMatrix<3> observation = Filter::ObservationMatrix<3>::Zero();
+            observation.block<3, 3>(0, kAttitude) = skew(field_body);
+
+            correct<3>(residual, observation, Matrix3x3r::Identity() * (params_.mag_sigma * params_.mag_sigma));
+        }
+
+        void updateAirspeed(const AirspeedBase::Output& airspeed)
+        {
+            //no wind, airspeed is the magnitude of the velocity
+            const PastState* past = recall(airspeed.time_stamp);
+            if (past == nullptr || airspeed.diff_pressure <= 0)
+                return;
+            const real_T speed = past->velocity.norm();
+            const real_T air_density = EarthUtils::getAirDensity(static_cast<real_T>(home_geo_point_.altitude) - past->position.z());
+            if (speed < params_.airspeed_min)
+                return;
+            const real_T measured = std::sqrt(2 * airspeed.diff_pressure / air_density);
+            if (measured < params_.airspeed_min)
+                return;
+
+            Eigen::Matrix<real_T, 1, 1> residual;
+            residual(0) = measured - speed;
+
+            Filter::ObservationMatrix<1> observation = Filter::ObservationMatrix<1>::Zero();
+            observation.block<1, 3>(0, kVelocity) = past->velocity.transpose() / speed;
+
+            correct<1>(residual, observation, Eigen::Matrix<real_T, 1, 1>::Constant(params_.airspeed_sigma * params_.airspeed_sigma));
+        }
+
+        template <int TMeasurementSize>
+        void correct(const Filter::MeasurementVector<TMeasurementSize>& residual, const Filter::ObservationMatrix<TMeasurementSize>& observation,
+                     const Filter::MeasurementMatrix<TMeasurementSize>& noise)
+        {
+            const real_T gate = params_.innovation_gate_sigma * params_.innovation_gate_sigma * TMeasurementSize;
+            Filter::StateVector correction;
+            if (!filter_.update<TMeasurementSize>(residual, observation, noise, gate, correction)) {
+                ++metrics_.rejected_count;
+                return;
+            }
+
+            //move the error into the nominal state, the error is zero again
+            kinematics_.pose.position += correction.segment<3>(kPosition);
+            kinematics_.twist.linear += correction.segment<3>(kVelocity);
+            for (uint i = 0; i < history_count_; ++i) {
+                history_[i].position += correction.segment<3>(kPosition);
+                history_[i].velocity += correction.segment<3>(kVelocity);
+            }
+            kinematics_.pose.orientation = (kinematics_.pose.orientation * toQuaternion(correction.segment<3>(kAttitude))).normalized();
+            gyro_bias_ += correction.segment<3>(kGyroBias);
+            accel_bias_ += correction.segment<3>(kAccelBias);
+            baro_offset_ += correction(kBaroOffset);
+        }
+
+        void updateNees(const Kinematics::State& ground_truth)
+        {
+            last_true_position_ = ground_truth.pose.position;
+
+            Eigen::Matrix<real_T, kNeesDof, 1> error;
+            error.segment<3>(0) = ground_truth.pose.position - kinematics_.pose.position;
+            error.segment<3>(3) = ground_truth.twist.linear - kinematics_.twist.linear;
+            //true = estimated * exp(attitude error)
+            const Quaternionr attitude_error = kinematics_.pose.orientation.conjugate() * ground_truth.pose.orientation;
+            error.segment<3>(6) = attitude_error.vec() * (attitude_error.w() < 0 ? -2.0f : 2.0f);
+
+            metrics_.last_nees = filter_.getNormalizedErrorSquared<kNeesDof>(kPosition, error);
+            ++metrics_.nees_count;
+            metrics_.mean_nees += (metrics_.last_nees - metrics_.mean_nees) / metrics_.nees_count;
+        }
+
+        void remember()
+        {
+            PastState& state = history_[history_next_];
+            state.time = last_imu_time_;
+            state.position = kinematics_.pose.position;
+            state.velocity = kinematics_.twist.linear;
+
+            history_next_ = (history_next_ + 1) % kHistorySize;
+            history_count_ = std::min(history_count_ + 1, kHistorySize);
+        }
+
+        //latest state not after time, nullptr if the history doesn't go back that far
+        const PastState* recall(TTimePoint time) const
+        {
+            for (uint i = 1; i <= history_count_; ++i) {
+                const PastState& state = history_[(history_next_ + kHistorySize - i) % kHistorySize];
+                if (state.time <= time)
+                    return &state;
+            }
+            return nullptr;
+        }
+
+        static Matrix3x3r skew(const Vector3r& v)
+        {
+            Matrix3x3r m;
+            m << 0, -v.z(), v.y(),
+                v.z(), 0, -v.x(),
+                -v.y(), v.x(), 0;
+            return m;
+        }
+
+        //rotation by the rotation vector
+        static Quaternionr toQuaternion(const Vector3r& rotation)
+        {
+            const real_T angle = rotation.norm();
+            if (angle < 1E-6f)
+                return Quaternionr(1, rotation.x() / 2, rotation.y() / 2, rotation.z() / 2).normalized();
+            return Quaternionr(AngleAxisr(angle, rotation / angle));
+        }
+
+    private:
+        struct Sequences
+        {
+            uint64_t imu = 0, gps = 0, baro = 0, mag = 0, airspeed = 0;
+        };
+
+        const SensorCollection* sensors_;
+        Params params_;
+
+        Filter filter_;
+        bool is_initialized_ = false;
+        bool is_baro_initialized_ = false;
+
+        Kinematics::State kinematics_;
+        Vector3r gyro_bias_ = Vector3r::Zero();
+        Vector3r accel_bias_ = Vector3r::Zero();
+        real_T baro_offset_ = 0;
+        GeoPoint home_geo_point_;
+        TTimePoint last_imu_time_ = 0;
+        Sequences sequences_;
+        std::array<PastState, kHistorySize> history_;
+        uint history_next_ = 0;
+        uint history_count_ = 0;
+
+        Metrics metrics_;
+        Vector3r last_true_position_ = Vector3r::Zero();
+    };
+}
+} //namespace
+#endif
@@ -37,6 +37,8 @@ namespace airlib
         SensorBase(const std::string& sensor_name = "")
             : name_(sensor_name)
         {
+            //also times the sensor's update() under its name
+            setName(sensor_name);
         }
 
     protected:
@@ -63,6 +65,14 @@ namespace airlib
             return name_;
         }
 
+        //Clock time at which this sensor next has work to do in update(). SensorCollection
+        //skips update() calls before this time, so sensors that need every physics tick
+        //keep the default of 0 which means always due.
+        virtual TTimePoint getNextUpdateTime() const
+        {
+            return 0;
+        }
+
         virtual ~SensorBase() = default;
 
     private:
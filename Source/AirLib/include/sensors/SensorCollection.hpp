@@ -5,6 +5,8 @@
 #define msr_airlib_SensorCollection_hpp
 
 #include <unordered_map>
+#include <algorithm>
+#include <functional>
 #include "sensors/SensorBase.hpp"
 #include "common/UpdatableContainer.hpp"
 #include "common/Common.hpp"
@@ -14,6 +16,13 @@ namespace msr
 namespace airlib
 {
 
+    /*
+    Holds sensors indexed by type and schedules their updates. Most sensors only produce
+    output at their own rate (see SensorBase::getNextUpdateTime), so instead of ticking
+    every sensor on every physics step we keep a min-heap ordered by next due time and
+    only update sensors that are due. Between samples a vehicle full of low rate sensors
+    then costs one heap peek per step.
+    */
     class SensorCollection : public UpdatableObject
     {
     public: //types
@@ -31,6 +40,9 @@ namespace airlib
             else {
                 it->second->insert(sensor);
             }
+
+            schedule_.push_back(ScheduledSensor{ 0, sensor });
+            std::push_heap(schedule_.begin(), schedule_.end(), std::greater<ScheduledSensor>());
         }
 
         const SensorBase* getByType(SensorBase::SensorType type, uint index = 0) const
@@ -69,23 +81,58 @@ namespace airlib
         void clear()
         {
             sensors_.clear();
+            schedule_.clear();
+            due_.clear();
+        }
+
+        //number of sensor update() calls made by the last update()
+        uint getLastUpdateCount() const
+        {
+            return last_update_count_;
         }
 
         //*** Start: UpdatableState implementation ***//
         virtual void resetImplementation() override
         {
+            //reset sensors directly rather than through their type containers because
+            //containers are never updated, only the sensors in them
             for (auto& pair : sensors_) {
-                pair.second->reset();
+                for (auto& sensor : *pair.second)
+                    sensor->reset();
             }
+
+            //everything is due on the first step after reset so each sensor sees
+            //reset() followed by update() as UpdatableObject requires
+            for (auto& entry : schedule_)
+                entry.next_update_time = 0;
+            last_update_count_ = 0;
         }
 
         virtual void update() override
         {
             UpdatableObject::update();
 
-            for (auto& pair : sensors_) {
-                pair.second->update();
+            //pop everything that is due first so a sensor that is still due after its
+            //update is not picked again in the same step
+            const TTimePoint now = clock()->stepNanos();
+            due_.clear();
+            while (!schedule_.empty() && schedule_.front().next_update_time <= now) {
+                std::pop_heap(schedule_.begin(), schedule_.end(), std::greater<ScheduledSensor>());
+                due_.push_back(schedule_.back());
+                schedule_.pop_back();
             }
+
+            for (auto& entry : due_) {
+                {
+                    UpdateProfiler::Scope profile_scope(entry.sensor->getProfileSection());
+                    entry.sensor->update();
+                }
+                entry.next_update_time = entry.sensor->getNextUpdateTime();
+                schedule_.push_back(entry);
+                std::push_heap(schedule_.begin(), schedule_.end(), std::greater<ScheduledSensor>());
+            }
+
+            last_update_count_ = static_cast<uint>(due_.size());
         }
 
         virtual void reportState(StateReporter& reporter) override
@@ -97,8 +144,23 @@ namespace airlib
         //*** End: UpdatableState implementation ***//
 
     private:
+        struct ScheduledSensor
+        {
+            TTimePoint next_update_time;
+            SensorBasePtr sensor;
+
+            bool operator>(const ScheduledSensor& other) const
+            {
+                return next_update_time > other.next_update_time;
+            }
+        };
+
         typedef UpdatableContainer<SensorBasePtr> SensorBaseContainer;
         unordered_map<uint, unique_ptr<SensorBaseContainer>> sensors_;
+
+        vector<ScheduledSensor> schedule_; //min-heap on next_update_time
+        vector<ScheduledSensor> due_; //scratch, kept to avoid allocating every step
+        uint last_update_count_ = 0;
     };
 }
 } //namespace
@@ -66,6 +66,11 @@ namespace airlib
             if (freq_limiter_.isWaitComplete())
                 setOutput(delay_line_.getOutput());
         }
+
+        virtual TTimePoint getNextUpdateTime() const override
+        {
+            return std::min(freq_limiter_.getNextUpdateTime(), delay_line_.getNextOutputTime());
+        }
         //*** End: UpdatableState implementation ***//
 
         virtual ~BarometerSimple() = default;
@@ -5,6 +5,7 @@
 #define msr_airlib_DistanceBase_hpp
 
 #include "sensors/SensorBase.hpp"
+#include "common/VersionedBuffer.hpp"
 
 namespace msr
 {
@@ -33,14 +34,29 @@ namespace airlib
             return output_;
         }
 
+        //consistent copy of the latest output that can be read from any thread,
+        //unlike getOutput() which is only safe on the thread that updates the sensor
+        VersionedBuffer<DistanceSensorData>::Snapshot getOutputSnapshot() const
+        {
+            return published_output_.read();
+        }
+
+        //increases by one every time a new output is set
+        uint64_t getOutputSequence() const
+        {
+            return published_output_.getSequence();
+        }
+
     protected:
         void setOutput(const DistanceSensorData& output)
         {
             output_ = output;
+            published_output_.publish(output);
         }
 
     private:
         DistanceSensorData output_;
+        VersionedBuffer<DistanceSensorData> published_output_;
     };
 }
 } //namespace
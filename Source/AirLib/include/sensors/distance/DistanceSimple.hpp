@@ -61,6 +61,11 @@ namespace airlib
             if (freq_limiter_.isWaitComplete())
                 setOutput(delay_line_.getOutput());
         }
+
+        virtual TTimePoint getNextUpdateTime() const override
+        {
+            return std::min(freq_limiter_.getNextUpdateTime(), delay_line_.getNextOutputTime());
+        }
         //*** End: UpdatableState implementation ***//
 
         virtual ~DistanceSimple() = default;
@@ -80,7 +85,14 @@ namespace airlib
             const GroundTruth& ground_truth = getGroundTruth();
 
             //order of Pose addition is important here because it also adds quaternions which is not commutative!
-            auto distance = getRayLength(params_.relative_pose + ground_truth.kinematics->pose);
+            const Pose pose = params_.relative_pose + ground_truth.kinematics->pose;
+            auto distance = getRayLength(pose);
+
+            //terrain the game engine has no meshes for can be closer
+            if (ground_truth.environment && ground_truth.environment->getTerrain()) {
+                const Vector3r direction = VectorMath::rotateVector(VectorMath::front(), pose.orientation, true);
+                distance = std::min(distance, ground_truth.environment->getGroundDistance(pose.position, direction, params_.max_distance));
+            }
 
             //add noise in distance (about 0.2m sigma)
             distance += uncorrelated_noise_.next();
@@ -65,6 +65,11 @@ namespace airlib
                 setOutput(delay_line_.getOutput());
         }
 
+        virtual TTimePoint getNextUpdateTime() const override
+        {
+            return std::min(freq_limiter_.getNextUpdateTime(), delay_line_.getNextOutputTime());
+        }
+
         //*** End: UpdatableState implementation ***//
 
         virtual ~GpsSimple() = default;
@@ -5,6 +5,7 @@
 #define msr_airlib_LidarBase_hpp
 
 #include "sensors/SensorBase.hpp"
+#include "common/VersionedBuffer.hpp"
 
 namespace msr
 {
@@ -25,23 +26,46 @@ namespace airlib
             //call base
             UpdatableObject::reportState(reporter);
 
-            reporter.writeValue("Lidar-Timestamp", output_.time_stamp);
-            reporter.writeValue("Lidar-NumPoints", static_cast<int>(output_.point_cloud.size() / 3));
+            const LidarData& output = getOutput();
+            reporter.writeValue("Lidar-Timestamp", output.time_stamp);
+            reporter.writeValue("Lidar-NumPoints", static_cast<int>(output.point_cloud.size() / 3));
         }
 
+        //point clouds are large so unlike other sensors we don't keep a private copy of
+        //the output, the updating thread reads the published value directly
         const LidarData& getOutput() const
         {
-            return output_;
+            return published_output_.getPublished();
+        }
+
+        //consistent copy of the latest output that can be read from any thread,
+        //unlike getOutput() which is only safe on the thread that updates the sensor
+        VersionedBuffer<LidarData>::Snapshot getOutputSnapshot() const
+        {
+            return published_output_.read();
+        }
+
+        //increases by one every time a new output is set
+        uint64_t getOutputSequence() const
+        {
+            return published_output_.getSequence();
         }
 
     protected:
         void setOutput(const LidarData& output)
         {
-            output_ = output;
+            published_output_.publish(output);
+        }
+
+        //publishes output without copying it. On return output holds a recycled buffer
+        //whose vectors keep their capacity for filling in the next scan.
+        void swapOutput(LidarData& output)
+        {
+            published_output_.publishSwap(output);
         }
 
     private:
-        LidarData output_;
+        VersionedBuffer<LidarData> published_output_;
     };
 }
 } //namespace
@@ -0,0 +1,110 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_airlib_LidarCompactEncoding_hpp
+#define msr_airlib_LidarCompactEncoding_hpp
+
+#include <cmath>
+#include "common/Common.hpp"
+#include "common/CommonStructs.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    /*
+    Lossy wire format for LidarData when bandwidth matters more than precision.
+    Each coordinate is quantized to int16 around the center of the scan's bounding box, so
+    the error per axis is at most half of scale (extent / 65534): 1.5mm for a 200m extent.
+    Points are sent as one byte blob instead of an array of floats, and segmentation as
+    (value, run length) pairs since consecutive returns usually hit the same object.
+    A point costs 6 bytes instead of about 15 for msgpack floats, plus the segmentation.
+    */
+    struct LidarCompactData
+    {
+        TTimePoint time_stamp = 0;
+        Pose pose;
+        Vector3r center = Vector3r::Zero();
+        Vector3r scale = Vector3r::Zero();
+        vector<uint8_t> points; //little endian int16 x, y, z per point
+        vector<int> segmentation_runs; //value, count, value, count...
+    };
+
+    class LidarCompactEncoding
+    {
+    public:
+        static void encode(const LidarData& data, LidarCompactData& compact)
+        {
+            compact.time_stamp = data.time_stamp;
+            compact.pose = data.pose;
+
+            const vector<real_T>& cloud = data.point_cloud;
+            const size_t point_count = cloud.size() / 3;
+
+            Vector3r min_point = Vector3r::Zero(), max_point = Vector3r::Zero();
+            for (size_t i = 0; i < point_count; ++i) {
+                Vector3r point(cloud[3 * i], cloud[3 * i + 1], cloud[3 * i + 2]);
+                if (i == 0) {
+                    min_point = max_point = point;
+                }
+                else {
+                    min_point = min_point.cwiseMin(point);
+                    max_point = max_point.cwiseMax(point);
+                }
+            }
+            compact.center = (min_point + max_point) / 2;
+            compact.scale = (max_point - min_point) / (2 * kQuantizedMax);
+
+            compact.points.resize(point_count * 3 * sizeof(int16_t));
+            uint8_t* out = compact.points.data();
+            for (size_t i = 0; i < 3 * point_count; ++i) {
+                uint axis = i % 3;
+                real_T scale = compact.scale[axis];
+                long quantized = scale > 0 ? std::lround((cloud[i] - compact.center[axis]) / scale) : 0;
+                quantized = std::max<long>(-kQuantizedMax, std::min<long>(kQuantizedMax, quantized));
+
+                uint16_t bits = static_cast<uint16_t>(static_cast<int16_t>(quantized));
+                *out++ = static_cast<uint8_t>(bits & 0xFF);
+                *out++ = static_cast<uint8_t>(bits >> 8);
+            }
+
+            compact.segmentation_runs.clear();
+            for (size_t i = 0; i < data.segmentation.size(); ++i) {
+                int value = data.segmentation[i];
+                if (i > 0 && compact.segmentation_runs[compact.segmentation_runs.size() - 2] == value)
+                    ++compact.segmentation_runs.back();
+                else {
+                    compact.segmentation_runs.push_back(value);
+                    compact.segmentation_runs.push_back(1);
+                }
+            }
+        }
+
+        static void decode(const LidarCompactData& compact, LidarData& data)
+        {
+            data.time_stamp = compact.time_stamp;
+            data.pose = compact.pose;
+
+            const size_t value_count = compact.points.size() / sizeof(int16_t);
+            data.point_cloud.resize(value_count);
+            const uint8_t* in = compact.points.data();
+            for (size_t i = 0; i < value_count; ++i) {
+                uint16_t bits = static_cast<uint16_t>(in[0] | (in[1] << 8));
+                in += 2;
+
+                uint axis = i % 3;
+                data.point_cloud[i] = compact.center[axis] + static_cast<int16_t>(bits) * compact.scale[axis];
+            }
+
+            data.segmentation.clear();
+            for (size_t i = 0; i + 1 < compact.segmentation_runs.size(); i += 2)
+                data.segmentation.insert(data.segmentation.end(), static_cast<size_t>(std::max(0, compact.segmentation_runs[i + 1])), compact.segmentation_runs[i]);
+        }
+
+    private:
+        static constexpr long kQuantizedMax = 32767;
+    };
+}
+} //namespace
+#endif
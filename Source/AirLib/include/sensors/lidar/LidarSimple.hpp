@@ -49,6 +49,11 @@ namespace airlib
             }
         }
 
+        virtual TTimePoint getNextUpdateTime() const override
+        {
+            return freq_limiter_.getNextUpdateTime();
+        }
+
         virtual void reportState(StateReporter& reporter) override
         {
             //call base
@@ -77,7 +82,10 @@ namespace airlib
         {
             TTimeDelta delta_time = clock()->updateSince(last_time_);
 
-            point_cloud_.clear();
+            //output_buffer_ comes back from swapOutput() holding an old scan, reuse its capacity
+            LidarData& output = output_buffer_;
+            output.point_cloud.clear();
+            output.segmentation.clear();
 
             const GroundTruth& ground_truth = getGroundTruth();
 
@@ -93,24 +101,20 @@ namespace airlib
             getPointCloud(params_.relative_pose, // relative lidar pose
                           ground_truth.kinematics->pose, // relative vehicle pose
                           delta_time,
-                          point_cloud_,
-                          segmentation_cloud_);
+                          output.point_cloud,
+                          output.segmentation);
 
-            LidarData output;
-            output.point_cloud = point_cloud_;
             output.time_stamp = clock()->nowNanos();
             output.pose = lidar_pose;
-            output.segmentation = segmentation_cloud_;
 
             last_time_ = output.time_stamp;
 
-            setOutput(output);
+            swapOutput(output);
         }
 
     private:
         LidarSimpleParams params_;
-        vector<real_T> point_cloud_;
-        vector<int> segmentation_cloud_;
+        LidarData output_buffer_;
 
         FrequencyLimiter freq_limiter_;
         TTimePoint last_time_;
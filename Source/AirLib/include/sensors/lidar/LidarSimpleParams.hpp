@@ -36,6 +36,7 @@ namespace airlib
         };
 
         bool draw_debug_points = false;
+        uint draw_debug_history = 1; // scans kept on screen
         std::string data_frame = AirSimSettings::kVehicleInertialFrame;
 
         bool external_controller = true;
@@ -53,6 +54,7 @@ namespace airlib
             points_per_second = settings_json.getInt("PointsPerSecond", points_per_second);
             horizontal_rotation_frequency = settings_json.getInt("RotationsPerSecond", horizontal_rotation_frequency);
             draw_debug_points = settings_json.getBool("DrawDebugPoints", draw_debug_points);
+            draw_debug_history = settings_json.getInt("DrawDebugHistory", draw_debug_history);
             data_frame = settings_json.getString("DataFrame", data_frame);
             external_controller = settings_json.getBool("ExternalController", external_controller);
 
@@ -12,6 +12,7 @@
 #include "MultiRotorParams.hpp"
 #include <vector>
 #include "physics/PhysicsBody.hpp"
+#include "physics/RenderStateBuffer.hpp"
 
 namespace msr
 {
@@ -20,6 +21,9 @@ namespace airlib
 
     class MultiRotorPhysicsBody : public PhysicsBody
     {
+    public:
+        typedef RenderStateBuffer<vector<RotorActuator::Output>> RenderStates;
+
     public:
         MultiRotorPhysicsBody(MultiRotorParams* params, VehicleApiBase* vehicle_api,
                               Kinematics* kinematics, Environment* environment)
@@ -38,6 +42,8 @@ namespace airlib
 
             //reset sensors last after their ground truth has been reset
             resetSensors();
+
+            render_states_.reset();
         }
 
         virtual void update() override
@@ -55,6 +61,7 @@ namespace airlib
             PhysicsBody::reportState(reporter);
 
             reportSensors(*params_, reporter);
+            vehicle_api_->reportState(reporter);
 
             //report rotors
             for (uint rotor_index = 0; rotor_index < rotors_.size(); ++rotor_index) {
@@ -87,7 +94,10 @@ namespace airlib
             updateSensors(*params_, getKinematics(), getEnvironment());
 
             //update controller which will update actuator control signal
-            vehicle_api_->update();
+            {
+                UpdateProfiler::Scope profile_scope(firmware_section_);
+                vehicle_api_->update();
+            }
 
             //transfer new input values from controller to rotors
             for (uint rotor_index = 0; rotor_index < rotors_.size(); ++rotor_index) {
@@ -95,6 +105,12 @@ namespace airlib
             }
         }
 
+        //the renderer gets the state once the step is done, stamped with the step's time
+        virtual void endStep() override
+        {
+            publishRenderState();
+        }
+
         //sensor getter
         const SensorCollection& getSensors() const
         {
@@ -142,6 +158,12 @@ namespace airlib
             return rotors_.at(rotor_index).getOutput();
         }
 
+        //state at the end of each physics step, for the render thread
+        RenderStates& getRenderStates()
+        {
+            return render_states_;
+        }
+
         virtual ~MultiRotorPhysicsBody() = default;
 
     private: //methods
@@ -187,6 +209,18 @@ namespace airlib
             params_->getSensors().reset();
         }
 
+        void publishRenderState()
+        {
+            render_state_.time = clock()->stepNanos();
+            render_state_.kinematics = getKinematics();
+            render_state_.collision_response = getCollisionResponseInfo();
+            render_state_.outputs.resize(rotors_.size());
+            for (uint rotor_index = 0; rotor_index < rotors_.size(); ++rotor_index)
+                render_state_.outputs[rotor_index] = rotors_.at(rotor_index).getOutput();
+
+            render_states_.publish(render_state_);
+        }
+
         void createDragVertices()
         {
             const auto& params = params_->getParams();
@@ -225,6 +259,10 @@ namespace airlib
 
         std::unique_ptr<Environment> environment_;
         VehicleApiBase* vehicle_api_;
+        const UpdateProfiler::Section firmware_section_ = UpdateProfiler::getSection("Firmware");
+
+        RenderStates render_states_;
+        RenderStates::State render_state_; //reused so publishing doesn't allocate
     };
 }
 } //namespace
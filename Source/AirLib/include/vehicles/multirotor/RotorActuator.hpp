@@ -49,6 +49,7 @@ namespace airlib
             params_ = params;
             turning_direction_ = turning_direction;
             environment_ = environment;
+            setName("RotorActuator");
             air_density_sea_level_ = EarthUtils::getAirDensity(0.0f);
 
             control_signal_filter_.initialize(params_.control_signal_filter_tc, 0, 0);
@@ -25,6 +25,14 @@ namespace airlib
         {
             return static_cast<MultirotorApiBase*>(RpcLibServerBase::getVehicleApi(vehicle_name));
         }
+
+    private:
+        //binds command under its name, answered when the command ends, and under name + "Start",
+        //answered with a command id as soon as the command's steps are handed to the vehicle
+        template <typename Command>
+        void bindCommand(const std::string& name, Command command);
+        template <typename Command, typename... Args>
+        void bindCommandStart(const std::string& name, Command command, bool (Command::*)(Args...) const);
     };
 }
 } //namespace
@@ -10,6 +10,7 @@
 #include "MavLinkVehicle.hpp"
 #include "MavLinkVideoStream.hpp"
 
+#include <atomic>
 #include <exception>
 #include <memory>
 #include <mutex>
@@ -99,6 +100,8 @@ namespace airlib
                     world_ = static_cast<World*>(container);
                 }
             }
+            if (world_ == nullptr)
+                unregisterLockStep();
             MultirotorApiBase::resetImplementation();
             was_reset_ = true;
         }
@@ -129,18 +132,26 @@ namespace airlib
                 auto now = clock()->nowNanos() / 1000;
                 MultirotorApiBase::update();
 
+                if (lock_step_waiting_ && !lock_step_active_) {
+                    // session was reset while the world was still waiting on our reply
+                    cancelLockStepWait(false);
+                }
+
                 if (sensors_ == nullptr || !connected_ || connection_ == nullptr || !connection_->isOpen() || !got_first_heartbeat_)
                     return;
 
+                registerLockStep();
+
                 {
                     std::lock_guard<std::mutex> guard(telemetry_mutex_);
                     update_count_++;
                 }
 
                 if (lock_step_active_) {
-                    if (last_update_time_ + 1000000 < now) {
-                        // if 1 second passes then something is terribly wrong, reset lockstep mode
+                    if (isLockStepExpired(now)) {
+                        // if the deadline passes then something is terribly wrong, reset lockstep mode
                         lock_step_active_ = false;
+                        cancelLockStepWait(true);
                         {
                             std::lock_guard<std::mutex> guard(telemetry_mutex_);
                             lock_step_resets_++;
@@ -905,6 +916,7 @@ namespace airlib
             addStatusMessage("Disconnecting mavlink vehicle");
             connected_ = false;
             connecting_ = false;
+            unregisterLockStep();
 
             if (is_armed_) {
                 // close the telemetry log.
@@ -1624,9 +1636,78 @@ namespace airlib
                 std::lock_guard<std::mutex> guard(telemetry_mutex_);
                 actuator_delay_ += delay;
             }
-            if (world_ != nullptr) {
+            endLockStepWait();
+        }
+
+        void registerLockStep()
+        {
+            // only a connected autopilot that lock steps may hold up the world, once per world
+            if (world_ == nullptr || !connection_info_.lock_step)
+                return;
+
+            std::lock_guard<std::mutex> guard(lock_step_mutex_);
+            const std::shared_ptr<LockStepCoordinator>& coordinator = world_->getLockStepCoordinator();
+            if (coordinator == lock_step_coordinator_)
+                return;
+
+            removeLockStepParticipant();
+            int port = connection_info_.use_tcp ? connection_info_.tcp_port : connection_info_.udp_port;
+            lock_step_coordinator_ = coordinator;
+            lock_step_id_ = coordinator->addParticipant(
+                Utils::stringf("%s:%d", connection_info_.model.c_str(), port), connection_info_.lock_step_timeout);
+        }
+
+        void unregisterLockStep()
+        {
+            std::lock_guard<std::mutex> guard(lock_step_mutex_);
+            removeLockStepParticipant();
+        }
+
+        // must be called with lock_step_mutex_ held
+        void removeLockStepParticipant()
+        {
+            if (lock_step_coordinator_ != nullptr)
+                lock_step_coordinator_->removeParticipant(lock_step_id_);
+            lock_step_coordinator_ = nullptr;
+            lock_step_id_ = LockStepCoordinator::InvalidParticipant;
+        }
+
+        void beginLockStepWait()
+        {
+            lock_step_waiting_ = true;
+            std::lock_guard<std::mutex> guard(lock_step_mutex_);
+            if (lock_step_coordinator_ != nullptr)
+                lock_step_coordinator_->beginWait(lock_step_id_);
+            else if (world_ != nullptr)
+                world_->pauseForTime(connection_info_.lock_step_timeout); // max delay waiting for actuator controls.
+        }
+
+        void endLockStepWait()
+        {
+            lock_step_waiting_ = false;
+            std::lock_guard<std::mutex> guard(lock_step_mutex_);
+            if (lock_step_coordinator_ != nullptr)
+                lock_step_coordinator_->endWait(lock_step_id_);
+            else if (world_ != nullptr)
                 world_->pause(false);
+        }
+
+        void cancelLockStepWait(bool is_timeout)
+        {
+            lock_step_waiting_ = false;
+            std::lock_guard<std::mutex> guard(lock_step_mutex_);
+            if (lock_step_coordinator_ != nullptr)
+                lock_step_coordinator_->cancelWait(lock_step_id_, is_timeout);
+        }
+
+        bool isLockStepExpired(uint64_t now) const
+        {
+            {
+                std::lock_guard<std::mutex> guard(lock_step_mutex_);
+                if (lock_step_coordinator_ != nullptr)
+                    return lock_step_coordinator_->hasExpired(lock_step_id_);
             }
+            return last_update_time_ + static_cast<uint64_t>(connection_info_.lock_step_timeout * 1E6) < now;
         }
 
         void processMavMessages(const mavlinkcom::MavLinkMessage& msg)
@@ -1790,8 +1871,8 @@ namespace airlib
             if (hil_node_ != nullptr) {
                 hil_node_->sendMessage(hil_sensor);
                 received_actuator_controls_ = false;
-                if (lock_step_active_ && world_ != nullptr) {
-                    world_->pauseForTime(1); // 1 second delay max waiting for actuator controls.
+                if (lock_step_active_) {
+                    beginLockStepWait();
                 }
             }
 
@@ -2026,7 +2107,12 @@ namespace airlib
         common_utils::Timer gcs_message_timer_;
         std::shared_ptr<mavlinkcom::MavLinkFileLog> log_;
         std::string log_file_name_;
-        World* world_;
+        World* world_ = nullptr;
+        // shared with the world so we can still leave it when the world goes first
+        std::shared_ptr<LockStepCoordinator> lock_step_coordinator_;
+        LockStepCoordinator::ParticipantId lock_step_id_ = LockStepCoordinator::InvalidParticipant;
+        mutable std::mutex lock_step_mutex_;
+        std::atomic<bool> lock_step_waiting_{ false };
 
         //every time we return status update, we need to check if we have new data
         //this is why below two variables are marked as mutable
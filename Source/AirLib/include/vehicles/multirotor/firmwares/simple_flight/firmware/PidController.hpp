@@ -2,6 +2,7 @@
 
 #include <cstdlib>
 #include <algorithm>
+#include <stdexcept>
 #include "interfaces/CommonStructs.hpp"
 #include "interfaces/IPidIntegrator.hpp"
 #include "StdPidIntegrator.hpp"
@@ -15,18 +16,9 @@ class PidController : public IUpdatable
 {
 public:
     PidController(const IBoardClock* clock = nullptr, const PidConfig<T>& config = PidConfig<T>())
-        : clock_(clock), config_(config)
+        : clock_(clock), config_(config), std_integrator_(config_), rk_integrator_(config_)
     {
-        switch (config.integrator_type) {
-        case PidConfig<T>::IntegratorType::Standard:
-            integrator = std::unique_ptr<StdPidIntegrator<T>>(new StdPidIntegrator<T>(config_));
-            break;
-        case PidConfig<T>::IntegratorType::RungKutta:
-            integrator = std::unique_ptr<RungKuttaPidIntegrator<T>>(new RungKuttaPidIntegrator<T>(config_));
-            break;
-        default:
-            throw std::invalid_argument("PID integrator type is not recognized");
-        }
+        validateConfig(config);
     }
 
     void setGoal(const T& goal)
@@ -55,12 +47,14 @@ public:
     //allow changing config at runtime
     void setConfig(const PidConfig<T>& config)
     {
+        validateConfig(config);
+
         bool renabled = !config_.enabled && config.enabled;
         config_ = config;
 
         if (renabled) {
             last_error_ = goal_ - measured_;
-            integrator->set(output_);
+            integratorSet(output_);
         }
     }
 
@@ -76,7 +70,7 @@ public:
         goal_ = T();
         measured_ = T();
         last_time_ = clock_ == nullptr ? 0 : clock_->millis();
-        integrator->reset();
+        integratorReset();
         last_error_ = goal_ - measured_;
         min_dt_ = config_.time_scale * config_.time_scale;
     }
@@ -95,14 +89,14 @@ public:
         float pterm = error * config_.kp;
         float dterm = 0;
         if (dt > min_dt_) {
-            integrator->update(dt, error, last_time_);
+            integratorUpdate(dt, error, last_time_);
 
             float error_der = dt > 0 ? (error - last_error_) / dt : 0;
             dterm = error_der * config_.kd;
             last_error_ = error;
         }
 
-        output_ = config_.output_bias + pterm + integrator->getOutput() + dterm;
+        output_ = config_.output_bias + pterm + integratorOutput() + dterm;
 
         //limit final output
         output_ = clip(output_, config_.min_output, config_.max_output);
@@ -111,6 +105,53 @@ public:
     }
 
 private:
+    static void validateConfig(const PidConfig<T>& config)
+    {
+        switch (config.integrator_type) {
+        case PidConfig<T>::IntegratorType::Standard:
+            break;
+        case PidConfig<T>::IntegratorType::RungKutta:
+            //anything else used to quietly integrate as order 2
+            if (config.integrator_order != 2 && config.integrator_order != 4)
+                throw std::invalid_argument("PID integrator order must be 2 or 4");
+            break;
+        default:
+            throw std::invalid_argument("PID integrator type is not recognized");
+        }
+    }
+
+    //integrators are held by value and dispatched on type so the per-tick path
+    //has no heap indirection and no virtual calls
+    bool isRungKutta() const
+    {
+        return config_.integrator_type == PidConfig<T>::IntegratorType::RungKutta;
+    }
+    void integratorReset()
+    {
+        if (isRungKutta())
+            rk_integrator_.reset();
+        else
+            std_integrator_.reset();
+    }
+    void integratorSet(T val)
+    {
+        if (isRungKutta())
+            rk_integrator_.set(val);
+        else
+            std_integrator_.set(val);
+    }
+    void integratorUpdate(float dt, T error, uint64_t last_time)
+    {
+        if (isRungKutta())
+            rk_integrator_.update(dt, error, last_time);
+        else
+            std_integrator_.update(dt, error, last_time);
+    }
+    T integratorOutput()
+    {
+        return isRungKutta() ? rk_integrator_.getOutput() : std_integrator_.getOutput();
+    }
+
     //TODO: replace with std::clamp after moving to C++17
     static T clip(T val, T min_value, T max_value)
     {
@@ -127,7 +168,8 @@ private:
     float min_dt_;
     const PidConfig<T> config_;
 
-    std::unique_ptr<IPidIntegrator<T>> integrator;
+    StdPidIntegrator<T> std_integrator_;
+    RungKuttaPidIntegrator<T> rk_integrator_;
 };
 
 } //namespace
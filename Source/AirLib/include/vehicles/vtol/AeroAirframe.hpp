@@ -0,0 +1,125 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef msr_airlib_AeroAirframe_hpp
+#define msr_airlib_AeroAirframe_hpp
+
+#include <array>
+#include <utility>
+#include <type_traits>
+#include "common/Common.hpp"
+#include "RotorTiltable.hpp"
+#include "AeroBodyParams.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    //where AeroBody reads its inputs in the controller's actuation vector,
+    //{flap1, flap2, flap3, rotor1thr, rotor1ang, rotor2thr, rotor2ang, ...}
+    struct AeroActuators
+    {
+        static constexpr uint kFlapCount = 3;
+
+        static constexpr uint throttle(uint rotor_index)
+        {
+            return kFlapCount + 2 * rotor_index;
+        }
+        static constexpr uint angle(uint rotor_index)
+        {
+            return kFlapCount + 2 * rotor_index + 1;
+        }
+    };
+
+    /*
+    Airframes tell AeroBody how its rotors are stored and visited. With a fixed airframe the rotor
+    count and which rotors tilt are known at compile time, so the per-step loops over rotors are
+    unrolled with the rotor index a constant and the inputs of fixed rotors are never set. Both kinds
+    do the same arithmetic in the same order, so a body gives identical results with either.
+
+    forEachRotor calls func(index) for each rotor in order, index is a std::integral_constant for
+    fixed airframes.
+    */
+
+    //any layout, as set up in AeroBodyParams
+    struct DynamicAirframe
+    {
+        typedef vector<RotorTiltable> Rotors;
+
+        //RotorTiltable ignores angle inputs of fixed rotors
+        static constexpr bool isTilting(uint)
+        {
+            return true;
+        }
+
+        static void resize(Rotors& rotors, uint rotor_count)
+        {
+            rotors.clear();
+            rotors.resize(rotor_count);
+        }
+
+        static bool matches(const AeroBodyParams::Params& params)
+        {
+            unused(params);
+            return true;
+        }
+
+        template <typename TFunc>
+        static void forEachRotor(const Rotors& rotors, TFunc&& func)
+        {
+            for (uint rotor_index = 0; rotor_index < rotors.size(); ++rotor_index)
+                func(rotor_index);
+        }
+    };
+
+    //TTiltMask has bit i set if rotor i tilts
+    template <uint TRotorCount, uint TTiltMask>
+    struct FixedAirframe
+    {
+        typedef std::array<RotorTiltable, TRotorCount> Rotors;
+
+        static constexpr bool isTilting(uint rotor_index)
+        {
+            return ((TTiltMask >> rotor_index) & 1) != 0;
+        }
+
+        static bool matches(const AeroBodyParams::Params& params)
+        {
+            if (params.rotor_count != TRotorCount || params.rotor_configs.size() != TRotorCount)
+                return false;
+            for (uint rotor_index = 0; rotor_index < TRotorCount; ++rotor_index) {
+                if (params.rotor_configs[rotor_index].is_fixed == isTilting(rotor_index))
+                    return false;
+            }
+            return true;
+        }
+
+        static void resize(Rotors& rotors, uint rotor_count)
+        {
+            unused(rotors);
+            if (rotor_count != TRotorCount)
+                throw std::invalid_argument(Utils::stringf("Airframe has %u rotors, not %u", TRotorCount, rotor_count));
+        }
+
+        template <typename TFunc>
+        static void forEachRotor(const Rotors& rotors, TFunc&& func)
+        {
+            unused(rotors);
+            forEachRotor(func, std::make_integer_sequence<uint, TRotorCount>());
+        }
+
+    private:
+        template <typename TFunc, uint... TIndexes>
+        static void forEachRotor(TFunc& func, std::integer_sequence<uint, TIndexes...>)
+        {
+            (func(std::integral_constant<uint, TIndexes>()), ...);
+        }
+    };
+
+    //airframes set up by AeroBodyParams
+    typedef FixedAirframe<1, 0x0> GenericFixedWingAirframe;
+    typedef FixedAirframe<3, 0x3> TriTiltrotorAirframe; //front two rotors tilt, rear is fixed
+}
+} //namespace
+#endif
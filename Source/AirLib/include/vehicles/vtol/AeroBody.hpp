@@ -8,26 +8,39 @@
 #include "common/CommonStructs.hpp"
 #include "RotorTiltable.hpp"
 #include "AeroVertex.hpp"
+#include "AeroAirframe.hpp"
 #include "api/VehicleApiBase.hpp"
 #include "api/VehicleSimApiBase.hpp"
 #include "AeroBodyParams.hpp"
 #include "physics/PhysicsBody.hpp"
+#include "physics/RenderStateBuffer.hpp"
 
 namespace msr
 {
 namespace airlib
 {
 
+    /*
+    Fixed wing or VTOL body: flaps on one aero vertex at the center of gravity plus tiltable rotors.
+    The rotors live in AirframeAeroBody so that known airframes get their rotor loops unrolled;
+    create bodies with AeroBodyParamsFactory::createBody.
+    */
     class AeroBody : public PhysicsBody
     {
     public:
-        AeroBody(AeroBodyParams* params, VehicleApiBase* vehicle_api,
-                 Kinematics* kinematics, Environment* environment)
+        struct RenderOutputs
+        {
+            vector<RotorTiltable::TiltOutput> rotors;
+            AeroVertex::Output aero; //flaps
+        };
+        typedef RenderStateBuffer<RenderOutputs> RenderStates;
+
+    public:
+        AeroBody(AeroBodyParams* params, VehicleApiBase* vehicle_api)
             : params_(params), vehicle_api_(vehicle_api)
         {
             setName("AeroBody");
             vehicle_api_->setParent(this);
-            initialize(kinematics, environment);
         }
 
         //*** Start: UpdatableState implementation ***//
@@ -38,30 +51,24 @@ namespace airlib
 
             //reset sensors last after their ground truth has been reset
             resetSensors();
-        }
-
-        virtual void update() override
-        {
-            //update forces on vertices that we will use next
-            PhysicsBody::update();
 
-            //Note that controller gets updated after kinematics gets updated in updateKinematics
-            //otherwise sensors will have values from previous cycle causing lags which will appear
-            //as crazy jerks whenever commands like velocity is issued
+            render_states_.reset();
         }
+
         virtual void reportState(StateReporter& reporter) override
         {
             //call base
             PhysicsBody::reportState(reporter);
 
             reportSensors(*params_, reporter);
+            vehicle_api_->reportState(reporter);
 
             //report rotors
-            for (uint rotor_index = 0; rotor_index < rotors_.size(); ++rotor_index) {
+            for (uint rotor_index = 0; rotor_index < rotorCount(); ++rotor_index) {
                 reporter.startHeading("", 1);
                 reporter.writeValue("RotorTiltable", rotor_index);
                 reporter.endHeading(false, 1);
-                rotors_.at(rotor_index).reportState(reporter);
+                getRotor(rotor_index).reportState(reporter);
             }
 
             //report AeroVertex
@@ -93,7 +100,10 @@ namespace airlib
             updateSensors(*params_, getKinematics(), getEnvironment());
 
             //update controller which will update actuator control signal
-            vehicle_api_->update();
+            {
+                UpdateProfiler::Scope profile_scope(firmware_section_);
+                vehicle_api_->update();
+            }
 
             //update all control inputs
             //for now assuming actuation order is {flap1, flap2, flap3, rotor1thr, rotor1ang, rotor2thr, rotor2ang, ...}
@@ -101,28 +111,19 @@ namespace airlib
             aero_vertex_.setFlapInputs(aero_inputs);
 
             //transfer new input values from controller to rotors
-            for (uint rotor_index = 0; rotor_index < rotors_.size(); ++rotor_index) {
-                rotors_.at(rotor_index).setControlSignal(vehicle_api_->getActuation(3 + 2 * rotor_index));
-                rotors_.at(rotor_index).setAngleSignal(vehicle_api_->getActuation(3 + 2 * rotor_index + 1));
-            }
+            setRotorInputs();
         }
 
-        //this gets called in getDragWrench function in physics engine
-        virtual void setAirspeedBody(const Vector3r airspeed_body_vector) override
+        //the renderer gets the state once the step is done, stamped with the step's time
+        virtual void endStep() override
         {
-            PhysicsBody::setAirspeedBody(airspeed_body_vector);
-
-            aero_vertex_.setAirspeedVertex(airspeed_body_vector);
-
-            for (uint rotor_index = 0; rotor_index < rotors_.size(); ++rotor_index) {
-                rotors_[rotor_index].setAirspeedRotor(airspeed_body_vector);
-            }
+            publishRenderState();
         }
 
         void overwriteRotorTilts(const vector<float>& angles, bool spin_props)
         {
-            for (uint i = 0; i < rotors_.size(); ++i) {
-                auto& rotor = rotors_.at(i);
+            for (uint i = 0; i < rotorCount(); ++i) {
+                auto& rotor = getRotor(i);
                 rotor.overwriteTilt(angles[i], spin_props);
             }
         }
@@ -144,7 +145,7 @@ namespace airlib
                 return aero_vertex_; //aero vertex is index 0
             }
             else {
-                return rotors_.at(index - 1);
+                return getRotor(index - 1);
             }
         }
         virtual const PhysicsBodyVertex& getWrenchVertex(uint index) const override
@@ -153,7 +154,7 @@ namespace airlib
                 return aero_vertex_; //aero vertex is index 0
             }
             else {
-                return rotors_.at(index - 1);
+                return getRotor(index - 1);
             }
         }
 
@@ -168,7 +169,7 @@ namespace airlib
 
         RotorTiltable::TiltOutput getRotorOutput(uint index) const
         {
-            return rotors_.at(index).getOutput();
+            return getRotor(index).getOutput();
         }
 
         AeroVertex::Output getAeroOutput() const
@@ -181,29 +182,32 @@ namespace airlib
             return params_->getParams().rotor_count;
         }
 
+        //state at the end of each physics step, for the render thread
+        RenderStates& getRenderStates()
+        {
+            return render_states_;
+        }
+
         virtual ~AeroBody() = default;
 
-    private: //methods
+    protected: //airframe specific
+        virtual RotorTiltable& getRotor(uint index) = 0;
+        virtual const RotorTiltable& getRotor(uint index) const = 0;
+        //passes the controller's rotor actuation to the rotors
+        virtual void setRotorInputs() = 0;
+        //fills render_state_.outputs.rotors
+        virtual void getRotorOutputs(vector<RotorTiltable::TiltOutput>& outputs) const = 0;
+
+    protected: //methods
         void initialize(Kinematics* kinematics, Environment* environment)
         {
             PhysicsBody::initialize(params_->getParams().mass, params_->getParams().inertia, kinematics, environment);
 
-            createRotors(*params_, rotors_, environment);
             createAeroVertex(*params_, aero_vertex_, environment, kinematics);
 
             initSensors(*params_, getKinematics(), getEnvironment());
         }
 
-        static void createRotors(const AeroBodyParams& params, vector<RotorTiltable>& rotors, const Environment* environment)
-        {
-            rotors.clear();
-            //for each rotor pose
-            for (uint rotor_index = 0; rotor_index < params.getParams().rotor_configs.size(); ++rotor_index) {
-                const AeroBodyParams::RotorTiltableConfiguration& rotor_config = params.getParams().rotor_configs.at(rotor_index);
-                rotors.emplace_back(rotor_config.position, rotor_config.normal_nominal, rotor_config.direction, rotor_config.is_fixed, rotor_config.rotation_axis, rotor_config.max_angle, rotor_config.params, environment, rotor_index);
-            }
-        }
-
         static void createAeroVertex(const AeroBodyParams& params, AeroVertex& aero_vertex, const Environment* environment, const Kinematics* kinematics)
         {
             AirState air_state;
@@ -233,12 +237,124 @@ namespace airlib
             params_->getSensors().reset();
         }
 
-    private: //fields
+        void publishRenderState()
+        {
+            render_state_.time = clock()->stepNanos();
+            render_state_.kinematics = getKinematics();
+            render_state_.collision_response = getCollisionResponseInfo();
+            getRotorOutputs(render_state_.outputs.rotors);
+            render_state_.outputs.aero = aero_vertex_.getOutput();
+
+            render_states_.publish(render_state_);
+        }
+
+    protected: //fields
         AeroBodyParams* params_;
         AeroVertex aero_vertex_; //one aerovertex at the center of mass for calculating aerodynamic forces and moments
-        vector<RotorTiltable> rotors_;
 
         VehicleApiBase* vehicle_api_;
+        const UpdateProfiler::Section firmware_section_ = UpdateProfiler::getSection("Firmware");
+
+        RenderStates render_states_;
+        RenderStates::State render_state_; //reused so publishing doesn't allocate
+    };
+
+    //AeroBody with rotors stored and visited as TAirframe says, see AeroAirframe.hpp
+    template <typename TAirframe>
+    class AirframeAeroBody : public AeroBody
+    {
+    public:
+        AirframeAeroBody(AeroBodyParams* params, VehicleApiBase* vehicle_api,
+                         Kinematics* kinematics, Environment* environment)
+            : AeroBody(params, vehicle_api)
+        {
+            createRotors(*params_, rotors_, environment);
+            initialize(kinematics, environment);
+        }
+
+        virtual void update() override
+        {
+            //same as PhysicsBody::update, which goes through getWrenchVertex, for our vertices
+            UpdatableObject::update();
+
+            //update forces on vertices that we will use next
+            {
+                UpdateProfiler::Scope profile_scope(aero_vertex_.getProfileSection());
+                aero_vertex_.update();
+            }
+            TAirframe::forEachRotor(rotors_, [this](auto rotor_index) {
+                UpdateProfiler::Scope profile_scope(rotors_[rotor_index].getProfileSection());
+                rotors_[rotor_index].update();
+            });
+
+            //Note that controller gets updated after kinematics gets updated in updateKinematics
+            //otherwise sensors will have values from previous cycle causing lags which will appear
+            //as crazy jerks whenever commands like velocity is issued
+        }
+
+        virtual Wrench getWrenchSum() const override
+        {
+            //vertex order as in getWrenchVertex so the sum comes out the same
+            Wrench wrench = Wrench::zero();
+            addVertexWrench(aero_vertex_, wrench);
+            TAirframe::forEachRotor(rotors_, [this, &wrench](auto rotor_index) {
+                addVertexWrench(rotors_[rotor_index], wrench);
+            });
+            return wrench;
+        }
+
+        //this gets called in getDragWrench function in physics engine
+        virtual void setAirspeedBody(const Vector3r airspeed_body_vector) override
+        {
+            PhysicsBody::setAirspeedBody(airspeed_body_vector);
+
+            aero_vertex_.setAirspeedVertex(airspeed_body_vector);
+
+            TAirframe::forEachRotor(rotors_, [this, &airspeed_body_vector](auto rotor_index) {
+                rotors_[rotor_index].setAirspeedRotor(airspeed_body_vector);
+            });
+        }
+
+    protected:
+        virtual RotorTiltable& getRotor(uint index) override
+        {
+            return rotors_.at(index);
+        }
+        virtual const RotorTiltable& getRotor(uint index) const override
+        {
+            return rotors_.at(index);
+        }
+
+        virtual void setRotorInputs() override
+        {
+            TAirframe::forEachRotor(rotors_, [this](auto rotor_index) {
+                rotors_[rotor_index].setControlSignal(vehicle_api_->getActuation(AeroActuators::throttle(rotor_index)));
+                if (TAirframe::isTilting(rotor_index))
+                    rotors_[rotor_index].setAngleSignal(vehicle_api_->getActuation(AeroActuators::angle(rotor_index)));
+            });
+        }
+
+        virtual void getRotorOutputs(vector<RotorTiltable::TiltOutput>& outputs) const override
+        {
+            outputs.resize(rotors_.size());
+            TAirframe::forEachRotor(rotors_, [this, &outputs](auto rotor_index) {
+                outputs[rotor_index] = rotors_[rotor_index].getOutput();
+            });
+        }
+
+    private:
+        static void createRotors(const AeroBodyParams& params, typename TAirframe::Rotors& rotors, const Environment* environment)
+        {
+            TAirframe::resize(rotors, static_cast<uint>(params.getParams().rotor_configs.size()));
+            //for each rotor pose
+            for (uint rotor_index = 0; rotor_index < params.getParams().rotor_configs.size(); ++rotor_index) {
+                const AeroBodyParams::RotorTiltableConfiguration& rotor_config = params.getParams().rotor_configs.at(rotor_index);
+                rotors[rotor_index].initialize(rotor_config.position, rotor_config.normal_nominal, rotor_config.direction, rotor_config.is_fixed, rotor_config.rotation_axis, rotor_config.max_angle, rotor_config.params, environment, rotor_index);
+            }
+        }
+
+    private:
+        typename TAirframe::Rotors rotors_;
     };
 
 }
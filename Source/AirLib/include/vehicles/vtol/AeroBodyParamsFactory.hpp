@@ -6,6 +6,7 @@
 
 #include "vehicles/vtol/firmwares/vtol_simple/VtolSimpleParams.hpp"
 #include "vehicles/vtol/firmwares/mavlink/Px4VtolParams.hpp"
+#include "vehicles/vtol/AeroBody.hpp"
 
 namespace msr
 {
@@ -37,6 +38,20 @@ namespace airlib
 
             return config;
         }
+
+        //body for the airframe params describes, specialized for the airframes we know
+        static std::unique_ptr<AeroBody> createBody(AeroBodyParams* params, VehicleApiBase* vehicle_api,
+                                                    Kinematics* kinematics, Environment* environment)
+        {
+            const AeroBodyParams::Params& body_params = params->getParams();
+
+            if (TriTiltrotorAirframe::matches(body_params))
+                return std::unique_ptr<AeroBody>(new AirframeAeroBody<TriTiltrotorAirframe>(params, vehicle_api, kinematics, environment));
+            else if (GenericFixedWingAirframe::matches(body_params))
+                return std::unique_ptr<AeroBody>(new AirframeAeroBody<GenericFixedWingAirframe>(params, vehicle_api, kinematics, environment));
+            else
+                return std::unique_ptr<AeroBody>(new AirframeAeroBody<DynamicAirframe>(params, vehicle_api, kinematics, environment));
+        }
     };
 }
 } //namespace
@@ -49,6 +49,7 @@ namespace airlib
             environment_ = environment;
             kinematics_ = kinematics;
             air_state_ = air_state;
+            setName("AeroVertex");
 
             //computed wrench is about center of mass, normal direction not used
             PhysicsBodyVertex::initialize(Vector3r::Zero(), Vector3r::Zero());
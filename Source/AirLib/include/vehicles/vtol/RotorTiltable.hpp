@@ -57,6 +57,7 @@ namespace airlib
             max_angle_ = max_angle;
             tilt_params_ = params;
             environment_ = environment;
+            setName("RotorTiltable");
 
             angle_signal_filter_.initialize(params.angle_signal_filter_tc, 0, 0);
             angle_filter_.initialize(params.angle_filter_tc, 0, 0);
@@ -10,8 +10,10 @@
 #include "physics/Kinematics.hpp"
 #include "physics/Environment.hpp"
 #include "api/VehicleApiBase.hpp"
+#include "common/CommandExecutor.hpp"
 
 #include <atomic>
+#include <map>
 #include <thread>
 #include <memory>
 
@@ -86,6 +88,9 @@ namespace airlib
         }
 
         virtual void resetImplementation() override;
+        //feeds new range sensor outputs to the SafetyEval occupancy map, if it has one,
+        //and steps the running command
+        virtual void update() override;
 
     public: //these APIs uses above low level APIs
         virtual ~VtolApiBase() = default;
@@ -165,6 +170,23 @@ namespace airlib
         virtual void cancelLastTask() override
         {
             token_.cancel();
+            command_executor_.cancel();
+        }
+
+        //calls command, e.g. a move API, and returns once its steps are handed to update() instead of
+        //when they end. The returned id is polled with isCommandDone and getCommandResult.
+        CommandExecutor::CommandId startCommand(const CommandExecutor::CommandFunction& command)
+        {
+            return command_executor_.start(command);
+        }
+        bool isCommandDone(CommandExecutor::CommandId command_id)
+        {
+            return command_executor_.isDone(command_id);
+        }
+        //rethrows the exception the command's steps threw, if any
+        bool getCommandResult(CommandExecutor::CommandId command_id)
+        {
+            return command_executor_.getResult(command_id);
         }
 
         /******************* rotors' states setter ********************/
@@ -195,8 +217,15 @@ namespace airlib
 
         /************* wait helpers ************/
         // helper function can wait for anything (as defined by the given function) up to the max_wait duration (in seconds).
-        // returns true if the wait function succeeded, or false if timeout occurred or the timeout is invalid.
-        Waiter waitForFunction(WaitFunction function, float max_wait);
+        // the function is called from update() at command period, the calling thread only waits for the outcome.
+        CommandExecutor::Result waitForFunction(WaitFunction function, float max_wait);
+        // runs step from update() at command period until it completes or fails, up to timeout_sec.
+        CommandExecutor::Result executeSteps(CommandExecutor::StepFunction step, float timeout_sec);
+        // same as executeSteps for the last wait of a command, returns true if the step completed.
+        // commands called through startCommand() return here right away, the steps must own what they use.
+        bool executeCommand(CommandExecutor::StepFunction step, float timeout_sec);
+        // runs step from update() at command period until duration ends, returns true unless cancelled.
+        bool executeCommandFor(std::function<void()> step, float duration);
 
         //useful for derived class to check after takeoff
         bool waitForZ(float timeout_sec, float z, float margin);
@@ -245,11 +274,15 @@ namespace airlib
                 if (!token.try_lock()) {
                     //TODO: should we worry about spurious failures in try_lock?
                     token.cancel();
+                    api->command_executor_.cancel();
                     token.lock();
                 }
 
-                if (isRootCall())
+                if (isRootCall()) {
                     token.reset();
+                    //a started command's steps may still run without holding the token
+                    api->command_executor_.cancel();
+                }
                 //else this is not the start of the call
             }
 
@@ -291,8 +324,11 @@ namespace airlib
 
             virtual ~SingleTaskCall()
             {
-                if (isRootCall())
-                    getVehicleApi()->afterTask();
+                if (isRootCall()) {
+                    //a started command's task ends after this call
+                    auto* api = getVehicleApi();
+                    api->command_executor_.afterCommand([api]() { api->afterTask(); });
+                }
             }
         };
 
@@ -368,13 +404,17 @@ namespace airlib
         void adjustYaw(float x, float y, DrivetrainType drivetrain, YawMode& yaw_mode);
         void moveToPathPosition(const Vector3r& dest, float velocity, DrivetrainType drivetrain, /* pass by value */ YawMode yaw_mode, float last_z);
         bool isYawWithinMargin(float yaw_target, float margin) const;
+        void updateOccupancyMap();
 
     private: //variables
         CancelToken token_;
+        CommandExecutor command_executor_;
         std::recursive_mutex status_mutex_;
         RCData rc_data_trims_;
         shared_ptr<SafetyEval> safety_eval_ptr_;
         float obs_avoidance_vel_ = 0.5f;
+        //last output of each range sensor inserted in the occupancy map
+        std::map<const SensorBase*, uint64_t> occupancy_sensor_sequences_;
 
         //TODO: make this configurable?
         float landing_vel_ = 0.2f; //velocity to use for landing
@@ -41,6 +41,8 @@ namespace airlib
             board_.reset(new VtolSimpleBoard(&params_));
             comm_link_.reset(new VtolSimpleCommLink());
             estimator_.reset(new VtolSimpleEstimator());
+            if (use_ekf_)
+                estimator_->enableEkf(&vehicle_params_->getSensors());
 
             //create firmware
             firmware_.reset(new vtol_simple::Firmware(&params_, board_.get(), comm_link_.get(), estimator_.get()));
@@ -51,15 +53,25 @@ namespace airlib
         {
             VtolApiBase::resetImplementation();
 
+            estimator_->reset();
             firmware_->reset();
         }
         virtual void update() override
         {
             VtolApiBase::update();
 
+            estimator_->update();
+
             //update controller which will update actuator control signal
             firmware_->update();
         }
+        virtual void reportState(StateReporter& reporter) override
+        {
+            VtolApiBase::reportState(reporter);
+
+            if (estimator_->getEkf() != nullptr)
+                estimator_->getEkf()->reportState(reporter);
+        }
         virtual bool isApiControlEnabled() const override
         {
             return firmware_->offboardApi().hasApiControl();
@@ -471,6 +483,12 @@ namespace airlib
             params_.rc.allow_api_when_disconnected = vehicle_setting.rc.allow_api_when_disconnected;
             params_.rc.allow_api_always = vehicle_setting.allow_api_always;
 
+            if (vehicle_setting.state_estimator == "Ekf")
+                use_ekf_ = true;
+            else if (vehicle_setting.state_estimator != "" && vehicle_setting.state_estimator != "GroundTruth")
+                throw std::invalid_argument(Utils::stringf("StateEstimator '%s' is not recognized, use GroundTruth or Ekf",
+                                                           vehicle_setting.state_estimator.c_str()));
+
             params_.actuator.actuator_count = getActuatorCount();
         }
 
@@ -478,6 +496,7 @@ namespace airlib
         const AeroBodyParams* vehicle_params_;
 
         int remote_control_id_ = 0;
+        bool use_ekf_ = false;
         vtol_simple::Params params_;
 
         unique_ptr<VtolSimpleBoard> board_;
@@ -5,6 +5,7 @@
 #define msr_airlib_VtolSimpleCommLink_hpp
 
 #include <exception>
+#include <mutex>
 #include "firmware/interfaces/ICommLink.hpp"
 #include "common/Common.hpp"
 
@@ -16,8 +17,10 @@ namespace airlib
     class VtolSimpleCommLink : public vtol_simple::ICommLink
     {
     public: // derived class specific methods
+        //called from the render thread while the firmware logs from the physics thread
         void getStatusMessages(std::vector<std::string>& messages)
         {
+            std::lock_guard<std::mutex> lock(messages_mutex_);
             if (messages_.size() > 0) {
                 messages.insert(messages.end(), messages_.begin(), messages_.end());
                 messages_.clear();
@@ -29,6 +32,7 @@ namespace airlib
         {
             vtol_simple::ICommLink::reset();
 
+            std::lock_guard<std::mutex> lock(messages_mutex_);
             messages_.clear();
         }
 
@@ -42,11 +46,13 @@ namespace airlib
             unused(log_level);
             //if (log_level > 0)
             //    Utils::DebugBreak();
+            std::lock_guard<std::mutex> lock(messages_mutex_);
             messages_.push_back(std::string(message));
         }
 
     private:
         std::vector<std::string> messages_;
+        std::mutex messages_mutex_;
     };
 
 }
@@ -8,6 +8,7 @@
 #include "VtolSimpleCommon.hpp"
 #include "physics/Kinematics.hpp"
 #include "physics/Environment.hpp"
+#include "sensors/NavigationEkf.hpp"
 #include "common/Common.hpp"
 
 namespace msr
@@ -20,17 +21,42 @@ namespace airlib
     public:
         virtual ~VtolSimpleEstimator() {}
 
-        //for now we don't do any state estimation and use ground truth (i.e. assume perfect sensors)
+        //unless the EKF is enabled we don't do any state estimation and use ground truth (i.e. assume perfect sensors)
         void setGroundTruthKinematics(const Kinematics::State* kinematics, const Environment* environment)
         {
             kinematics_ = kinematics;
             environment_ = environment;
         }
 
+        //estimate the state from the vehicle's sensors instead of using ground truth
+        void enableEkf(const SensorCollection* sensors)
+        {
+            ekf_.reset(new NavigationEkf(sensors));
+        }
+
+        //nullptr if the EKF isn't enabled
+        const NavigationEkf* getEkf() const
+        {
+            return ekf_.get();
+        }
+
+        void reset()
+        {
+            if (ekf_)
+                ekf_->reset();
+        }
+
+        //call after sensors are updated, before the firmware
+        void update()
+        {
+            if (ekf_)
+                ekf_->update(*kinematics_, environment_->getHomeGeoPoint());
+        }
+
         virtual vtol_simple::Axis3r getAngles() const override
         {
             vtol_simple::Axis3r angles;
-            VectorMath::toEulerianAngle(kinematics_->pose.orientation,
+            VectorMath::toEulerianAngle(kinematics().pose.orientation,
                                         angles.pitch(),
                                         angles.roll(),
                                         angles.yaw());
@@ -42,7 +68,7 @@ namespace airlib
 
         virtual vtol_simple::Axis3r getAngularVelocity() const override
         {
-            const auto& anguler = kinematics_->twist.angular;
+            const auto& anguler = kinematics().twist.angular;
 
             vtol_simple::Axis3r conv;
             conv.x() = anguler.x();
@@ -54,29 +80,29 @@ namespace airlib
 
         virtual vtol_simple::Axis3r getPosition() const override
         {
-            return VtolSimpleCommon::toAxis3r(kinematics_->pose.position);
+            return VtolSimpleCommon::toAxis3r(kinematics().pose.position);
         }
 
         virtual vtol_simple::Axis3r transformToBodyFrame(const vtol_simple::Axis3r& world_frame_val) const override
         {
             const Vector3r& vec = VtolSimpleCommon::toVector3r(world_frame_val);
-            const Vector3r& trans = VectorMath::transformToBodyFrame(vec, kinematics_->pose.orientation);
+            const Vector3r& trans = VectorMath::transformToBodyFrame(vec, kinematics().pose.orientation);
             return VtolSimpleCommon::toAxis3r(trans);
         }
 
         virtual vtol_simple::Axis3r getLinearVelocity() const override
         {
-            return VtolSimpleCommon::toAxis3r(kinematics_->twist.linear);
+            return VtolSimpleCommon::toAxis3r(kinematics().twist.linear);
         }
 
         virtual vtol_simple::Axis4r getOrientation() const override
         {
-            return VtolSimpleCommon::toAxis4r(kinematics_->pose.orientation);
+            return VtolSimpleCommon::toAxis4r(kinematics().pose.orientation);
         }
 
         virtual vtol_simple::GeoPoint getGeoPoint() const override
         {
-            return VtolSimpleCommon::toSimpleFlightGeoPoint(environment_->getState().geo_point);
+            return VtolSimpleCommon::toSimpleFlightGeoPoint(isEstimating() ? ekf_->getGeoPoint() : environment_->getState().geo_point);
         }
 
         virtual vtol_simple::GeoPoint getHomeGeoPoint() const override
@@ -91,15 +117,28 @@ namespace airlib
             state.orientation = getOrientation();
             state.linear_velocity = getLinearVelocity();
             state.angular_velocity = getAngularVelocity();
-            state.linear_acceleration = VtolSimpleCommon::toAxis3r(kinematics_->accelerations.linear);
-            state.angular_acceleration = VtolSimpleCommon::toAxis3r(kinematics_->accelerations.angular);
+            state.linear_acceleration = VtolSimpleCommon::toAxis3r(kinematics().accelerations.linear);
+            state.angular_acceleration = VtolSimpleCommon::toAxis3r(kinematics().accelerations.angular);
 
             return state;
         }
 
+    private:
+        bool isEstimating() const
+        {
+            return ekf_ && ekf_->isInitialized();
+        }
+
+        //estimated or true state
+        const Kinematics::State& kinematics() const
+        {
+            return isEstimating() ? ekf_->getKinematics() : *kinematics_;
+        }
+
     private:
         const Kinematics::State* kinematics_;
         const Environment* environment_;
+        unique_ptr<NavigationEkf> ekf_;
     };
 
 }
@@ -62,40 +62,13 @@ public:
         }
 
         for (unsigned int axis = 0; axis < Axis4r::AxisCount(); ++axis) {
-            //re-create axis controllers if goal mode was changed since last time, or if gains have been updated
+            //switch axis controllers if goal mode was changed since last time, or re-create them if gains have been updated
             if (goal_mode[axis] != last_goal_mode_[axis] || params_->gains_changed == true) {
-                switch (goal_mode[axis]) {
-                case GoalModeType::AngleRate:
-                    axis_controllers_[axis].reset(new AngleRateController(params_, clock_));
-                    break;
-                case GoalModeType::AngleLevel:
-                    axis_controllers_[axis].reset(new AngleLevelController(params_, clock_));
-                    break;
-                case GoalModeType::VelocityWorld:
-                    axis_controllers_[axis].reset(new VelocityController(params_, clock_));
-                    break;
-                case GoalModeType::PositionWorld:
-                    axis_controllers_[axis].reset(new PositionController(params_, clock_));
-                    break;
-                case GoalModeType::Passthrough:
-                    axis_controllers_[axis].reset(new PassthroughController());
-                    break;
-                case GoalModeType::Unknown:
-                    axis_controllers_[axis].reset(nullptr);
-                    break;
-                case GoalModeType::ConstantOutput:
-                    axis_controllers_[axis].reset(new ConstantOutputController());
-                    break;
-                default:
-                    throw std::invalid_argument("Axis controller type is not yet implemented for axis " + std::to_string(axis));
-                }
+                axis_controllers_[axis] = getAxisController(axis, goal_mode[axis], params_->gains_changed);
                 last_goal_mode_[axis] = goal_mode[axis];
 
-                //initialize axis controller
-                if (axis_controllers_[axis] != nullptr) {
-                    axis_controllers_[axis]->initialize(axis, goal_, state_estimator_);
+                if (axis_controllers_[axis] != nullptr)
                     axis_controllers_[axis]->reset();
-                }
             }
 
             //update axis controller
@@ -128,6 +101,55 @@ public:
     }
 
 private:
+    //axis controllers are kept per goal mode so switching modes back and forth only
+    //resets them instead of allocating a new controller tree; gain changes rebuild them
+    IAxisController* getAxisController(unsigned int axis, GoalModeType mode, bool recreate)
+    {
+        unsigned int mode_index = static_cast<unsigned int>(mode);
+        if (mode_index >= kGoalModeTypeCount)
+            throw std::invalid_argument("Axis controller type is not yet implemented for axis " + std::to_string(axis));
+
+        if (recreate) {
+            for (auto& controller : axis_controller_cache_[axis])
+                controller.reset();
+        }
+
+        auto& controller = axis_controller_cache_[axis][mode_index];
+        if (controller == nullptr) {
+            switch (mode) {
+            case GoalModeType::AngleRate:
+                controller.reset(new AngleRateController(params_, clock_));
+                break;
+            case GoalModeType::AngleLevel:
+                controller.reset(new AngleLevelController(params_, clock_));
+                break;
+            case GoalModeType::VelocityWorld:
+                controller.reset(new VelocityController(params_, clock_));
+                break;
+            case GoalModeType::PositionWorld:
+                controller.reset(new PositionController(params_, clock_));
+                break;
+            case GoalModeType::Passthrough:
+                controller.reset(new PassthroughController());
+                break;
+            case GoalModeType::Unknown:
+                return nullptr;
+            case GoalModeType::ConstantOutput:
+                controller.reset(new ConstantOutputController());
+                break;
+            default:
+                throw std::invalid_argument("Axis controller type is not yet implemented for axis " + std::to_string(axis));
+            }
+
+            controller->initialize(axis, goal_, state_estimator_);
+        }
+
+        return controller.get();
+    }
+
+private:
+    static constexpr unsigned int kGoalModeTypeCount = static_cast<unsigned int>(GoalModeType::ConstantOutput) + 1;
+
     Params* params_;
     const IBoardClock* clock_;
 
@@ -141,7 +163,8 @@ private:
     Axis4r last_goal_val_;
     bool is_last_goal_mode_all_passthrough_;
 
-    std::unique_ptr<IAxisController> axis_controllers_[Axis4r::AxisCount()];
+    std::unique_ptr<IAxisController> axis_controller_cache_[Axis4r::AxisCount()][kGoalModeTypeCount];
+    IAxisController* axis_controllers_[Axis4r::AxisCount()] = {};
 };
 
 }
\ No newline at end of file
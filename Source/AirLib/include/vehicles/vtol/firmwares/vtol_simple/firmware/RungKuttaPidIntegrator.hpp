@@ -1,10 +1,18 @@
 #pragma once
 
+#include <cmath>
 #include "interfaces/CommonStructs.hpp"
 
 namespace vtol_simple
 {
 
+/*
+    Integrates error over the actual dt of each update with a Runge-Kutta scheme.
+    The integrand is the error signal itself, which we only know at update times,
+    so intermediate RK stages are evaluated on an interpolation of the most recent
+    error samples: linear for order 2 (Heun) and quadratic for order 4 (classic RK4).
+    Until enough samples are available after reset we fall back to lower order.
+*/
 template <typename T>
 class RungKuttaPidIntegrator : public IPidIntegrator<T>
 {
@@ -19,6 +27,7 @@ public:
     virtual void reset() override
     {
         iterm_int_ = T();
+        sample_count_ = 0;
     }
 
     virtual void set(T val) override
@@ -29,77 +38,92 @@ public:
 
     virtual void update(float dt, T error, uint64_t last_time) override
     {
-        unused(dt);
+        unused(last_time);
 
-        error_int = error;
-        y[0] = error_int;
+        T increment;
+        if (sample_count_ == 0 || dt <= 0) {
+            //nothing to interpolate from yet, rectangle rule
+            increment = dt * error;
+        }
+        else {
+            //stages at start, middle and end of [t - dt, t]
+            T k1 = last_error_;
+            T k4 = error;
+            if (config_.integrator_order >= 4 && sample_count_ >= 2 && last_dt_ > 0) {
+                T k2 = interpolateMid(prev_error_, last_error_, error, last_dt_, dt);
+                T k3 = k2;
+                increment = dt / 6 * (k1 + 2 * k2 + 2 * k3 + k4);
+            }
+            else
+                increment = dt / 2 * (k1 + k4);
+        }
 
-        rungeKutta(y, yp, static_cast<float>(last_time), 0.003f, length);
+        //to supoort changes in ki at runtime, we accumulate iterm
+        //instead of error
+        iterm_int_ = iterm_int_ * discount(dt) + increment * config_.ki;
 
         //don't let iterm grow beyond limits (integral windup)
         clipIterm();
+
+        prev_error_ = last_error_;
+        last_error_ = error;
+        last_dt_ = dt;
+        if (sample_count_ < 2)
+            ++sample_count_;
     }
 
     virtual T getOutput() override
     {
-        return config_.ki * yp[0];
+        return iterm_int_;
     }
 
 private:
-    void clipIterm()
+    //value at the middle of the last interval of the quadratic through
+    //(-h1, e0), (0, e1), (h2, e2)
+    static T interpolateMid(T e0, T e1, T e2, float h1, float h2)
     {
-        yp[0] = clip(yp[0], config_.min_output, config_.max_output);
+        float t = h2 / 2;
+        float l0 = t * (t - h2) / (h1 * (h1 + h2));
+        float l1 = -(t + h1) * (t - h2) / (h1 * h2);
+        float l2 = (t + h1) * t / ((h1 + h2) * h2);
+        return l0 * e0 + l1 * e1 + l2 * e2;
     }
 
-    //TODO: replace with std::clamp after moving to C++17
-    static T clip(T val, T min_value, T max_value)
+    void clipIterm()
     {
-        return std::max(min_value, std::min(val, max_value));
+        iterm_int_ = clip(iterm_int_, config_.min_output, config_.max_output);
     }
 
-    void model(float* y_val, float last_time_, float* y_out)
+    float discount(float dt)
     {
-        unused(last_time_);
-        y_out[0] = y_val[0];
+        if (config_.iterm_discount == 1 || config_.iterm_discount_period <= 0)
+            return config_.iterm_discount;
+        //dt hardly ever changes between updates, so only redo the pow when it does
+        if (dt != discount_dt_) {
+            discount_dt_ = dt;
+            discount_ = std::pow(config_.iterm_discount, dt / config_.iterm_discount_period);
+        }
+        return discount_;
     }
 
-    void rungeKutta(float* y_val, float* yp_val, float time, float dt, int size)
+    //TODO: replace with std::clamp after moving to C++17
+    static T clip(T val, T min_value, T max_value)
     {
-        float k1, k2, k3, k4;
-        float zero_vec[length] = { 0 };
-        float* y_temp;
-        float* y_out = zero_vec;
-        for (int n = 0; n < size; n++) {
-            y_temp = y_val;
-            model(y_temp, time, y_out);
-            k1 = dt * y_out[n];
-
-            y_temp[n] = y_val[n] + k1 / 2;
-            model(y_temp, time + dt / 2, y_out);
-            k2 = dt * y_out[n];
-
-            y_temp[n] = y_val[n] + k2 / 2;
-            model(y_temp, time + dt / 2, y_out);
-            k3 = dt * y_out[n];
-
-            y_temp[n] = y_val[n] + k3;
-            model(y_temp, time + dt, y_out);
-            k4 = dt * y_out[n];
-
-            yp_val[n] = y_val[n] + k1 / 6 + k2 / 3 + k3 / 4 + k4 / 6;
-        }
+        return std::max(min_value, std::min(val, max_value));
     }
 
 private:
-    float iterm_int_;
+    T iterm_int_ = T();
     const PidConfig<T> config_;
 
-    static constexpr int length = 1;
-    float y_vec[length] = {};
-    float* y = y_vec;
-    float yp_vec[length] = {};
-    float* yp = yp_vec;
-    float error_int = 0;
+    //discount for the dt of the last update
+    float discount_dt_ = -1;
+    float discount_ = 1;
+
+    T last_error_ = T();
+    T prev_error_ = T();
+    float last_dt_ = 0;
+    unsigned int sample_count_ = 0;
 };
 
 } //namespace
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cmath>
 #include "interfaces/CommonStructs.hpp"
 
 namespace vtol_simple
@@ -33,7 +34,7 @@ public:
 
         //to supoort changes in ki at runtime, we accumulate iterm
         //instead of error
-        iterm_int_ = iterm_int_ * config_.iterm_discount + dt * error * config_.ki;
+        iterm_int_ = iterm_int_ * discount(dt) + dt * error * config_.ki;
 
         //don't let iterm grow beyond limits (integral windup)
         clipIterm();
@@ -50,6 +51,18 @@ private:
         iterm_int_ = clip(iterm_int_, config_.min_output, config_.max_output);
     }
 
+    float discount(float dt)
+    {
+        if (config_.iterm_discount == 1 || config_.iterm_discount_period <= 0)
+            return config_.iterm_discount;
+        //dt hardly ever changes between updates, so only redo the pow when it does
+        if (dt != discount_dt_) {
+            discount_dt_ = dt;
+            discount_ = std::pow(config_.iterm_discount, dt / config_.iterm_discount_period);
+        }
+        return discount_;
+    }
+
     //TODO: replace with std::clamp after moving to C++17
     static T clip(T val, T min_value, T max_value)
     {
@@ -59,6 +72,10 @@ private:
 private:
     float iterm_int_;
     const PidConfig<T> config_;
+
+    //discount for the dt of the last update
+    float discount_dt_ = -1;
+    float discount_ = 1;
 };
 
 } //namespace
\ No newline at end of file
@@ -359,13 +359,18 @@ struct PidConfig
     bool enabled;
     T output_bias;
     float iterm_discount;
+    //iterm_discount is applied once per this many seconds of dt rather than once per update,
+    //so the decay doesn't depend on the update rate. Default is the 3ms period it was tuned at.
+    float iterm_discount_period = 0.003f;
 
     enum class IntegratorType
     {
-        Standard,
-        RungKutta
+        Standard, //rectangle rule, first order
+        RungKutta //order selected by integrator_order
     };
     IntegratorType integrator_type = IntegratorType::Standard;
+    //2 = Heun (trapezoid), 4 = classic RK4 over quadratic interpolation of recent error samples
+    unsigned int integrator_order = 4;
 };
 
 } //namespace
\ No newline at end of file
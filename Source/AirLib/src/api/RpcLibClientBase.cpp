@@ -179,6 +179,13 @@ __pragma(warning(disable : 4239))
             return pimpl_->client.call("getLidarData", lidar_name, vehicle_name).as<RpcLibAdaptorsBase::LidarData>().to();
         }
 
+        msr::airlib::LidarData RpcLibClientBase::getLidarDataCompact(const std::string& lidar_name, const std::string& vehicle_name) const
+        {
+            msr::airlib::LidarData data;
+            msr::airlib::LidarCompactEncoding::decode(pimpl_->client.call("getLidarDataCompact", lidar_name, vehicle_name).as<RpcLibAdaptorsBase::LidarDataCompact>().to(), data);
+            return data;
+        }
+
         msr::airlib::ImuBase::Output RpcLibClientBase::getImuData(const std::string& imu_name, const std::string& vehicle_name) const
         {
             return pimpl_->client.call("getImuData", imu_name, vehicle_name).as<RpcLibAdaptorsBase::ImuData>().to();
@@ -534,6 +541,22 @@ __pragma(warning(disable : 4239))
             return pimpl_->client.call("listVehicles").as<vector<string>>();
         }
 
+        void RpcLibClientBase::simEnableProfiler(bool is_enabled, bool clear)
+        {
+            pimpl_->client.call("simEnableProfiler", is_enabled, clear);
+        }
+
+        std::vector<UpdateProfiler::SectionStats> RpcLibClientBase::simGetProfilerStats() const
+        {
+            return RpcLibAdaptorsBase::ProfileSectionStats::to(
+                pimpl_->client.call("simGetProfilerStats").as<vector<RpcLibAdaptorsBase::ProfileSectionStats>>());
+        }
+
+        std::string RpcLibClientBase::simGetProfilerTrace() const
+        {
+            return pimpl_->client.call("simGetProfilerTrace").as<std::string>();
+        }
+
         std::string RpcLibClientBase::getSettingsString() const
         {
             return pimpl_->client.call("getSettingsString").as<std::string>();
@@ -239,8 +239,13 @@ namespace airlib
         });
 
         pimpl_->server.bind("getLidarData", [&](const std::string& lidar_name, const std::string& vehicle_name) -> RpcLibAdaptorsBase::LidarData {
-            const auto& lidar_data = getVehicleApi(vehicle_name)->getLidarData(lidar_name);
-            return RpcLibAdaptorsBase::LidarData(lidar_data);
+            return RpcLibAdaptorsBase::LidarData(getVehicleApi(vehicle_name)->getLidarData(lidar_name));
+        });
+
+        pimpl_->server.bind("getLidarDataCompact", [&](const std::string& lidar_name, const std::string& vehicle_name) -> RpcLibAdaptorsBase::LidarDataCompact {
+            msr::airlib::LidarCompactData compact;
+            msr::airlib::LidarCompactEncoding::encode(getVehicleApi(vehicle_name)->getLidarData(lidar_name), compact);
+            return RpcLibAdaptorsBase::LidarDataCompact(std::move(compact));
         });
 
         pimpl_->server.bind("getImuData", [&](const std::string& imu_name, const std::string& vehicle_name) -> RpcLibAdaptorsBase::ImuData {
@@ -387,7 +392,7 @@ namespace airlib
         });
 
         pimpl_->server.bind("simGetGroundTruthEnvironment", [&](const std::string& vehicle_name) -> RpcLibAdaptorsBase::EnvironmentState {
-            const Environment::State& result = (*getVehicleSimApi(vehicle_name)->getGroundTruthEnvironment()).getState();
+            const Environment::State result = getVehicleSimApi(vehicle_name)->getGroundTruthEnvironment()->getStateCopy();
             return RpcLibAdaptorsBase::EnvironmentState(result);
         });
         pimpl_->server.bind("simCreateVoxelGrid", [&](const RpcLibAdaptorsBase::Vector3r& position, const int& x, const int& y, const int& z, const float& res, const std::string& output_file) -> bool {
@@ -426,6 +431,20 @@ namespace airlib
             return getWorldSimApi()->getSettingsString();
         });
 
+        pimpl_->server.bind("simEnableProfiler", [&](bool is_enabled, bool clear) -> void {
+            if (clear)
+                UpdateProfiler::clear();
+            UpdateProfiler::enable(is_enabled);
+        });
+
+        pimpl_->server.bind("simGetProfilerStats", [&]() -> vector<RpcLibAdaptorsBase::ProfileSectionStats> {
+            return RpcLibAdaptorsBase::ProfileSectionStats::from(UpdateProfiler::getStats());
+        });
+
+        pimpl_->server.bind("simGetProfilerTrace", [&]() -> std::string {
+            return UpdateProfiler::getChromeTrace();
+        });
+
         pimpl_->server.bind("simSetPoseCustom", [&](const RpcLibAdaptorsBase::Pose& pose, vector<float>& custom_vals, bool ignore_collision, bool spin_props, const std::string& vehicle_name) -> void {
             getVehicleSimApi(vehicle_name)->setPoseCustom(pose.to(), custom_vals, ignore_collision, spin_props);
         });
@@ -0,0 +1,104 @@
+// in header only mode, control library is not available
+#ifndef AIRLIB_HEADER_ONLY
+
+#include "common/common_utils/MemoryMappedFile.hpp"
+
+#include "common/common_utils/Utils.hpp"
+#include <codecvt>
+#include <cstring>
+#include <ios>
+#include <string>
+
+#if defined _WIN32 || defined _WIN64
+
+#include "common/common_utils/WindowsApisCommonPre.hpp"
+
+#include "common/common_utils/MinWinDefines.hpp"
+
+#undef NOKERNEL // All KERNEL #undefs and routines
+
+#include <Windows.h>
+
+#include "common/common_utils/WindowsApisCommonPost.hpp"
+
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+namespace common_utils
+{
+
+void MemoryMappedFile::open(const std::string& filepath)
+{
+    close();
+
+#ifdef _WIN32
+    // WIN32 will create the wrong file names if we don't first convert them to UTF-16.
+    std::wstring_convert<std::codecvt_utf8<wchar_t>, wchar_t> converter;
+    std::wstring wide_path = converter.from_bytes(filepath);
+
+    HANDLE file = CreateFileW(wide_path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        throw std::ios_base::failure(Utils::stringf("Cannot open %s, error %u", filepath.c_str(), GetLastError()));
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        CloseHandle(file);
+        throw std::ios_base::failure(Utils::stringf("Cannot map %s, it is empty or its size is unknown", filepath.c_str()));
+    }
+
+    // the view keeps the file and the mapping open, their handles aren't needed after this
+    HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    void* view = mapping != NULL ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    const DWORD error = GetLastError();
+    if (mapping != NULL)
+        CloseHandle(mapping);
+    CloseHandle(file);
+    if (view == NULL)
+        throw std::ios_base::failure(Utils::stringf("Cannot map %s, error %u", filepath.c_str(), error));
+
+    data_ = static_cast<const uint8_t*>(view);
+    size_ = static_cast<size_t>(file_size.QuadPart);
+#else
+    int file = ::open(filepath.c_str(), O_RDONLY);
+    if (file < 0)
+        throw std::ios_base::failure(Utils::stringf("Cannot open %s: %s", filepath.c_str(), strerror(errno)));
+
+    struct stat file_stat;
+    if (fstat(file, &file_stat) != 0 || file_stat.st_size == 0) {
+        ::close(file);
+        throw std::ios_base::failure(Utils::stringf("Cannot map %s, it is empty or its size is unknown", filepath.c_str()));
+    }
+
+    // the mapping keeps the file open, the descriptor isn't needed after this
+    void* view = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_SHARED, file, 0);
+    const int error = errno;
+    ::close(file);
+    if (view == MAP_FAILED)
+        throw std::ios_base::failure(Utils::stringf("Cannot map %s: %s", filepath.c_str(), strerror(error)));
+
+    data_ = static_cast<const uint8_t*>(view);
+    size_ = static_cast<size_t>(file_stat.st_size);
+#endif
+}
+
+void MemoryMappedFile::close()
+{
+    if (data_ == nullptr)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(data_);
+#else
+    munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+    data_ = nullptr;
+    size_ = 0;
+}
+}
+
+#endif
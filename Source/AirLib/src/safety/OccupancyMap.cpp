@@ -0,0 +1,377 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+//in header only mode, control library is not available
+#ifndef AIRLIB_HEADER_ONLY
+
+#include "safety/OccupancyMap.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include "common/VectorMath.hpp"
+
+namespace msr
+{
+namespace airlib
+{
+
+    OccupancyMap::OccupancyMap()
+        : OccupancyMap(Params())
+    {
+    }
+
+    OccupancyMap::OccupancyMap(const Params& params)
+        : params_(params), inv_resolution_(1 / params.resolution)
+    {
+    }
+
+    void OccupancyMap::insertRay(const Vector3r& origin, const Vector3r& end, bool hit)
+    {
+        std::unique_lock<std::shared_timed_mutex> lock(mutex_);
+        beginScan();
+
+        Vector3r ray_end = end;
+        const real_T length = (end - origin).norm();
+        if (length > params_.max_range) {
+            ray_end = origin + (end - origin) * (params_.max_range / length);
+            hit = false;
+        }
+
+        Block* block = nullptr;
+        VoxelKey block_key;
+        if (hit)
+            updateVoxel(toKey(ray_end), true, block, block_key);
+        carveRay(origin, ray_end, block, block_key);
+    }
+
+    void OccupancyMap::insertPointCloud(const Vector3r& origin, const vector<real_T>& points, const Pose& points_frame)
+    {
+        const bool transform = !(points_frame.position.isZero() && points_frame.orientation.isApprox(Quaternionr::Identity()));
+        const size_t point_count = points.size() / 3;
+
+        //ends of the rays, the ones beyond max_range pulled in and not counted as returns
+        vector<Vector3r> ends(point_count);
+        vector<bool> hits(point_count);
+        for (size_t i = 0; i < point_count; ++i) {
+            Vector3r point(points[3 * i], points[3 * i + 1], points[3 * i + 2]);
+            if (transform)
+                point = VectorMath::transformToWorldFrame(point, points_frame, true);
+
+            const real_T length = (point - origin).norm();
+            hits[i] = length <= params_.max_range;
+            ends[i] = hits[i] ? point : origin + (point - origin) * (params_.max_range / length);
+        }
+
+        std::unique_lock<std::shared_timed_mutex> lock(mutex_);
+        beginScan();
+
+        //hits first so a voxel with a return isn't cleared by another ray of the same scan
+        Block* block = nullptr;
+        VoxelKey block_key;
+        for (size_t i = 0; i < point_count; ++i) {
+            if (hits[i])
+                updateVoxel(toKey(ends[i]), true, block, block_key);
+        }
+        for (size_t i = 0; i < point_count; ++i)
+            carveRay(origin, ends[i], block, block_key);
+    }
+
+    void OccupancyMap::insertLidar(const LidarData& data, bool sensor_local_frame)
+    {
+        insertPointCloud(data.pose.position, data.point_cloud, sensor_local_frame ? data.pose : Pose::zero());
+    }
+
+    void OccupancyMap::insertDistance(const DistanceSensorData& data, const Pose& vehicle_pose)
+    {
+        if (!(data.distance > 0))
+            return;
+
+        const Pose sensor_pose = data.relative_pose + vehicle_pose;
+        const Vector3r direction = VectorMath::transformToWorldFrame(Vector3r(1, 0, 0), sensor_pose.orientation, true);
+        const bool hit = data.distance < data.max_distance;
+        insertRay(sensor_pose.position, sensor_pose.position + direction * data.distance, hit);
+    }
+
+    void OccupancyMap::clear()
+    {
+        std::unique_lock<std::shared_timed_mutex> lock(mutex_);
+        blocks_.clear();
+        occupied_count_ = 0;
+    }
+
+    float OccupancyMap::getProbability(const Vector3r& point) const
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex_);
+
+        const VoxelKey key = toKey(point);
+        const Block* block = findBlock(VoxelKey(key.x() >> BlockBits, key.y() >> BlockBits, key.z() >> BlockBits));
+        const float log_odds = block == nullptr ? 0 : block->voxels[voxelIndex(key)].log_odds;
+        return 1 - 1 / (1 + std::exp(log_odds));
+    }
+
+    bool OccupancyMap::isOccupied(const Vector3r& point) const
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex_);
+
+        const VoxelKey key = toKey(point);
+        const Block* block = findBlock(VoxelKey(key.x() >> BlockBits, key.y() >> BlockBits, key.z() >> BlockBits));
+        return block != nullptr && block->voxels[voxelIndex(key)].log_odds > params_.log_odds_occupied;
+    }
+
+    OccupancyMap::ObstacleInfo OccupancyMap::getClosestObstacle(const Vector3r& point, real_T max_distance) const
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex_);
+        return findClosest(point, max_distance, [](const Vector3r&) { return true; });
+    }
+
+    OccupancyMap::ObstacleInfo OccupancyMap::getClosestObstacleInCone(const Vector3r& origin, const Vector3r& direction, real_T half_angle, real_T max_distance) const
+    {
+        const Vector3r axis = direction.normalized();
+        const real_T cos_half_angle = std::cos(half_angle);
+
+        std::shared_lock<std::shared_timed_mutex> lock(mutex_);
+        return findClosest(origin, max_distance, [&axis, cos_half_angle](const Vector3r& offset) {
+            return offset.dot(axis) >= cos_half_angle * offset.norm();
+        });
+    }
+
+    const OccupancyMap::Params& OccupancyMap::getParams() const
+    {
+        return params_;
+    }
+
+    size_t OccupancyMap::getBlockCount() const
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex_);
+        return blocks_.size();
+    }
+
+    size_t OccupancyMap::getOccupiedCount() const
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex_);
+        return occupied_count_;
+    }
+
+    OccupancyMap::VoxelKey OccupancyMap::toKey(const Vector3r& point) const
+    {
+        return VoxelKey(static_cast<int>(std::floor(point.x() * inv_resolution_)),
+                        static_cast<int>(std::floor(point.y() * inv_resolution_)),
+                        static_cast<int>(std::floor(point.z() * inv_resolution_)));
+    }
+
+    Vector3r OccupancyMap::toCenter(const VoxelKey& key) const
+    {
+        return (key.cast<real_T>() + Vector3r::Constant(0.5f)) * params_.resolution;
+    }
+
+    //21 bits per axis covers +-1M blocks, far more than any map we build
+    uint64_t OccupancyMap::blockHash(const VoxelKey& block_key)
+    {
+        const uint64_t mask = (1 << 21) - 1;
+        return ((static_cast<uint64_t>(block_key.x()) & mask) << 42) |
+               ((static_cast<uint64_t>(block_key.y()) & mask) << 21) |
+               (static_cast<uint64_t>(block_key.z()) & mask);
+    }
+
+    int OccupancyMap::voxelIndex(const VoxelKey& key)
+    {
+        const int mask = BlockSize - 1;
+        return ((key.x() & mask) << (2 * BlockBits)) | ((key.y() & mask) << BlockBits) | (key.z() & mask);
+    }
+
+    OccupancyMap::Block* OccupancyMap::getOrCreateBlock(const VoxelKey& block_key)
+    {
+        std::unique_ptr<Block>& block = blocks_[blockHash(block_key)];
+        if (block == nullptr) {
+            block.reset(new Block());
+            block->key = block_key;
+        }
+        return block.get();
+    }
+
+    const OccupancyMap::Block* OccupancyMap::findBlock(const VoxelKey& block_key) const
+    {
+        auto found = blocks_.find(blockHash(block_key));
+        return found == blocks_.end() ? nullptr : found->second.get();
+    }
+
+    void OccupancyMap::beginScan()
+    {
+        //stamps are 2 * scan for misses and 2 * scan + 1 for hits
+        if (++scan_ >= Utils::max<uint32_t>() / 2) {
+            //wrapped around, forget which scan touched what so stale stamps don't match
+            for (auto& block : blocks_) {
+                for (auto& voxel : block.second->voxels)
+                    voxel.stamp = 0;
+            }
+            scan_ = 1;
+        }
+    }
+
+    OccupancyMap::VoxelUpdate OccupancyMap::updateVoxel(const VoxelKey& key, bool hit, Block*& cached_block, VoxelKey& cached_block_key)
+    {
+        //consecutive voxels of a ray are mostly in the same block, skip the hash lookup for those
+        const VoxelKey block_key(key.x() >> BlockBits, key.y() >> BlockBits, key.z() >> BlockBits);
+        if (cached_block == nullptr || block_key != cached_block_key) {
+            cached_block = getOrCreateBlock(block_key);
+            cached_block_key = block_key;
+        }
+
+        Voxel& voxel = cached_block->voxels[voxelIndex(key)];
+        if (voxel.stamp == 2 * scan_)
+            return VoxelUpdate::AlreadyCleared;
+        if (voxel.stamp == 2 * scan_ + 1)
+            return VoxelUpdate::AlreadyHit;
+        voxel.stamp = 2 * scan_ + (hit ? 1 : 0);
+
+        float& log_odds = voxel.log_odds;
+        const bool was_occupied = log_odds > params_.log_odds_occupied;
+        log_odds = Utils::clip(log_odds + (hit ? params_.log_odds_hit : params_.log_odds_miss), params_.log_odds_min, params_.log_odds_max);
+        const bool is_occupied = log_odds > params_.log_odds_occupied;
+
+        if (is_occupied != was_occupied) {
+            if (is_occupied) {
+                ++cached_block->occupied_count;
+                ++occupied_count_;
+            }
+            else {
+                --cached_block->occupied_count;
+                --occupied_count_;
+            }
+        }
+        return VoxelUpdate::Updated;
+    }
+
+    //marks voxels from origin up to but not including the one end is in as free, walking
+    //the grid as in Amanatides & Woo, "A Fast Voxel Traversal Algorithm". The walk goes from
+    //end back to origin so with stop_at_cleared it can stop where an earlier ray of the scan
+    //already cleared the way: rays converge on the sensor, so from there on they would
+    //mostly clear the same voxels again.
+    void OccupancyMap::carveRay(const Vector3r& origin, const Vector3r& end, Block*& cached_block, VoxelKey& cached_block_key)
+    {
+        VoxelKey key = toKey(end);
+        const VoxelKey origin_key = toKey(origin);
+        const Vector3r ray = origin - end;
+        const real_T length = ray.norm();
+        if (key == origin_key || !(length > 0))
+            return;
+        const Vector3r direction = ray / length;
+
+        int step[3];
+        real_T t_max[3], t_delta[3];
+        for (int axis = 0; axis < 3; ++axis) {
+            if (direction[axis] > 0) {
+                step[axis] = 1;
+                t_max[axis] = ((key[axis] + 1) * params_.resolution - end[axis]) / direction[axis];
+                t_delta[axis] = params_.resolution / direction[axis];
+            }
+            else if (direction[axis] < 0) {
+                step[axis] = -1;
+                t_max[axis] = (key[axis] * params_.resolution - end[axis]) / direction[axis];
+                t_delta[axis] = -params_.resolution / direction[axis];
+            }
+            else {
+                step[axis] = 0;
+                t_max[axis] = t_delta[axis] = Utils::max<real_T>();
+            }
+        }
+
+        //a ray crosses at most this many voxel boundaries, guards against rounding at the end
+        int remaining = static_cast<int>((origin_key - key).cwiseAbs().sum());
+        while (remaining-- > 0) {
+            const int axis = t_max[0] < t_max[1] ? (t_max[0] < t_max[2] ? 0 : 2) : (t_max[1] < t_max[2] ? 1 : 2);
+            if (t_max[axis] > length)
+                break;
+            key[axis] += step[axis];
+            t_max[axis] += t_delta[axis];
+
+            if (updateVoxel(key, false, cached_block, cached_block_key) == VoxelUpdate::AlreadyCleared && params_.stop_at_cleared)
+                break;
+            if (key == origin_key)
+                break;
+        }
+    }
+
+    //visits blocks with obstacles nearest first and stops once the next block can't be closer
+    //than what was found; caller holds at least the shared lock
+    template <typename TAccept>
+    OccupancyMap::ObstacleInfo OccupancyMap::findClosest(const Vector3r& point, real_T max_distance, const TAccept& accept) const
+    {
+        ObstacleInfo result;
+        real_T best_squared = max_distance * max_distance;
+        const real_T block_edge = BlockSize * params_.resolution;
+
+        auto squaredDistanceToBlock = [&](const VoxelKey& block_key) {
+            const Vector3r low = block_key.cast<real_T>() * block_edge;
+            const Vector3r outside = (low - point).cwiseMax(point - low - Vector3r::Constant(block_edge)).cwiseMax(0);
+            return outside.squaredNorm();
+        };
+
+        vector<std::pair<real_T, const Block*>> candidates;
+        //the box's keys are only computed for radii whose voxel coordinates fit an int
+        const bool is_box_keyed = (point.cwiseAbs().maxCoeff() + max_distance) * inv_resolution_ < MaxKeyedVoxels;
+        VoxelKey block_low = VoxelKey::Zero(), block_high = VoxelKey::Zero();
+        double box_blocks = std::numeric_limits<double>::infinity();
+        if (is_box_keyed) {
+            const VoxelKey low = toKey(point - Vector3r::Constant(max_distance));
+            const VoxelKey high = toKey(point + Vector3r::Constant(max_distance));
+            block_low = VoxelKey(low.x() >> BlockBits, low.y() >> BlockBits, low.z() >> BlockBits);
+            block_high = VoxelKey(high.x() >> BlockBits, high.y() >> BlockBits, high.z() >> BlockBits);
+            box_blocks = static_cast<double>(block_high.x() - block_low.x() + 1) *
+                         (block_high.y() - block_low.y() + 1) * (block_high.z() - block_low.z() + 1);
+        }
+
+        auto consider = [&](const Block* block) {
+            if (block != nullptr && block->occupied_count > 0) {
+                const real_T squared = squaredDistanceToBlock(block->key);
+                if (squared <= best_squared)
+                    candidates.emplace_back(squared, block);
+            }
+        };
+        //for large radii walking the map is cheaper than looking up every block in the box
+        if (box_blocks <= blocks_.size()) {
+            for (int x = block_low.x(); x <= block_high.x(); ++x)
+                for (int y = block_low.y(); y <= block_high.y(); ++y)
+                    for (int z = block_low.z(); z <= block_high.z(); ++z)
+                        consider(findBlock(VoxelKey(x, y, z)));
+        }
+        else {
+            for (const auto& block : blocks_)
+                consider(block.second.get());
+        }
+
+        std::sort(candidates.begin(), candidates.end(), [](const std::pair<real_T, const Block*>& a, const std::pair<real_T, const Block*>& b) {
+            return a.first < b.first;
+        });
+
+        for (const auto& candidate : candidates) {
+            if (candidate.first > best_squared)
+                break;
+
+            const Block& block = *candidate.second;
+            const VoxelKey first_key = block.key * BlockSize;
+            for (int index = 0; index < BlockVoxels; ++index) {
+                if (!(block.voxels[index].log_odds > params_.log_odds_occupied))
+                    continue;
+
+                const VoxelKey key = first_key + VoxelKey(index >> (2 * BlockBits), (index >> BlockBits) & (BlockSize - 1), index & (BlockSize - 1));
+                const Vector3r offset = toCenter(key) - point;
+                const real_T squared = offset.squaredNorm();
+                if (squared < best_squared && accept(offset)) {
+                    best_squared = squared;
+                    result.found = true;
+                    result.position = offset + point;
+                    result.probability = 1 - 1 / (1 + std::exp(block.voxels[index].log_odds));
+                }
+            }
+        }
+
+        if (result.found)
+            result.distance = std::sqrt(best_squared);
+        return result;
+    }
+}
+} //namespace
+
+#endif
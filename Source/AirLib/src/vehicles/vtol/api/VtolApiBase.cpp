@@ -5,6 +5,7 @@
 #ifndef AIRLIB_HEADER_ONLY
 
 #include "vehicles/vtol/api/VtolApiBase.hpp"
+#include "sensors/lidar/LidarSimple.hpp"
 #include <functional>
 #include <exception>
 #include <vector>
@@ -22,6 +23,51 @@ namespace airlib
         SingleTaskCall lock(this); //cancel previous tasks
     }
 
+    void VtolApiBase::update()
+    {
+        VehicleApiBase::update();
+
+        updateOccupancyMap();
+        command_executor_.update();
+    }
+
+    void VtolApiBase::updateOccupancyMap()
+    {
+        const auto safety_eval_ptr = std::atomic_load(&safety_eval_ptr_);
+        if (safety_eval_ptr == nullptr)
+            return;
+        const auto occupancy_map = safety_eval_ptr->getOccupancyMap();
+        if (occupancy_map == nullptr)
+            return;
+
+        //sensors publish at their own rates, only outputs not seen before are inserted
+        const SensorCollection& sensors = getSensors();
+        for (uint i = 0; i < sensors.size(SensorBase::SensorType::Lidar); ++i) {
+            auto* lidar = static_cast<const LidarBase*>(sensors.getByType(SensorBase::SensorType::Lidar, i));
+            uint64_t& last_sequence = occupancy_sensor_sequences_[lidar];
+            const uint64_t sequence = lidar->getOutputSequence();
+            if (sequence == last_sequence)
+                continue;
+            last_sequence = sequence;
+
+            auto* lidar_simple = dynamic_cast<const LidarSimple*>(lidar);
+            const bool sensor_local_frame = lidar_simple != nullptr && lidar_simple->getParams().data_frame == AirSimSettings::kSensorLocalFrame;
+            occupancy_map->insertLidar(*lidar->getOutputSnapshot(), sensor_local_frame);
+        }
+
+        const Pose vehicle_pose(getPosition(), getOrientation());
+        for (uint i = 0; i < sensors.size(SensorBase::SensorType::Distance); ++i) {
+            auto* distance = static_cast<const DistanceBase*>(sensors.getByType(SensorBase::SensorType::Distance, i));
+            uint64_t& last_sequence = occupancy_sensor_sequences_[distance];
+            const uint64_t sequence = distance->getOutputSequence();
+            if (sequence == last_sequence)
+                continue;
+            last_sequence = sequence;
+
+            occupancy_map->insertDistance(*distance->getOutputSnapshot(), vehicle_pose);
+        }
+    }
+
     bool VtolApiBase::takeoff(float timeout_sec)
     {
         SingleTaskCall lock(this);
@@ -56,24 +102,23 @@ namespace airlib
         //after landing we detect if drone has stopped moving
         int near_zero_vel_count = 0;
 
-        return waitForFunction([&]() {
-                   moveByVelocityInternal(0, 0, landing_vel_, YawMode::Zero());
-
-                   float z_vel = getVelocity().z();
-                   if (z_vel <= approx_zero_vel_)
-                       ++near_zero_vel_count;
-                   else
-                       near_zero_vel_count = 0;
-
-                   if (near_zero_vel_count > 10)
-                       return true;
-                   else {
-                       moveByVelocityInternal(0, 0, landing_vel_, YawMode::Zero());
-                       return false;
-                   }
-               },
-                               timeout_sec)
-            .isComplete();
+        return executeCommand([=]() mutable {
+            moveByVelocityInternal(0, 0, landing_vel_, YawMode::Zero());
+
+            float z_vel = getVelocity().z();
+            if (z_vel <= approx_zero_vel_)
+                ++near_zero_vel_count;
+            else
+                near_zero_vel_count = 0;
+
+            if (near_zero_vel_count > 10)
+                return CommandExecutor::StepResult::Complete;
+            else {
+                moveByVelocityInternal(0, 0, landing_vel_, YawMode::Zero());
+                return CommandExecutor::StepResult::Running;
+            }
+        },
+                              timeout_sec);
     }
 
     bool VtolApiBase::goHome(float timeout_sec)
@@ -98,12 +143,10 @@ namespace airlib
         YawMode adj_yaw_mode(yaw_mode.is_rate, yaw_mode.yaw_or_rate);
         adjustYaw(vx_new, vy_new, drivetrain, adj_yaw_mode);
 
-        return waitForFunction([&]() {
-                   moveByVelocityInternal(vx_new, vy_new, vz, adj_yaw_mode);
-                   return false; //keep moving until timeout
-               },
-                               duration)
-            .isTimeout();
+        return executeCommandFor([=]() {
+            moveByVelocityInternal(vx_new, vy_new, vz, adj_yaw_mode);
+        },
+                                 duration);
     }
 
     bool VtolApiBase::moveByVelocityZBodyFrame(float vx, float vy, float z, float duration, DrivetrainType drivetrain, const YawMode& yaw_mode)
@@ -121,12 +164,10 @@ namespace airlib
         YawMode adj_yaw_mode(yaw_mode.is_rate, yaw_mode.yaw_or_rate);
         adjustYaw(vx_new, vy_new, drivetrain, adj_yaw_mode);
 
-        return waitForFunction([&]() {
-                   moveByVelocityZInternal(vx_new, vy_new, z, adj_yaw_mode);
-                   return false; //keep moving until timeout
-               },
-                               duration)
-            .isTimeout();
+        return executeCommandFor([=]() {
+            moveByVelocityZInternal(vx_new, vy_new, z, adj_yaw_mode);
+        },
+                                 duration);
     }
 
     bool VtolApiBase::moveByMotorPWMs(const vector<float>& pwm_values, float duration)
@@ -136,16 +177,16 @@ namespace airlib
         if (duration <= 0)
             return true;
 
-        bool res = waitForFunction([&]() {
-                       commandMotorPWMs(pwm_values);
-                       return false; //keep moving until timeout
-                   },
-                                   duration)
-                       .isTimeout();
+        bool res = executeCommandFor([=]() {
+            commandMotorPWMs(pwm_values);
+        },
+                                     duration);
 
         // Send a final command of zeros so it doesn't get stuck running last command
         vector<float> pwm_zeros(pwm_values.size(), 0.f);
-        commandMotorPWMs(pwm_zeros);
+        command_executor_.afterCommand([=]() {
+            commandMotorPWMs(pwm_zeros);
+        });
         return res;
     }
 
@@ -156,12 +197,10 @@ namespace airlib
         if (duration <= 0)
             return true;
 
-        return waitForFunction([&]() {
-                   moveByRollPitchYawZInternal(roll, pitch, yaw, z);
-                   return false; //keep moving until timeout
-               },
-                               duration)
-            .isTimeout();
+        return executeCommandFor([=]() {
+            moveByRollPitchYawZInternal(roll, pitch, yaw, z);
+        },
+                                 duration);
     }
 
     bool VtolApiBase::moveByRollPitchYawThrottle(float roll, float pitch, float yaw, float throttle, float duration)
@@ -171,12 +210,10 @@ namespace airlib
         if (duration <= 0)
             return true;
 
-        return waitForFunction([&]() {
-                   moveByRollPitchYawThrottleInternal(roll, pitch, yaw, throttle);
-                   return false; //keep moving until timeout
-               },
-                               duration)
-            .isTimeout();
+        return executeCommandFor([=]() {
+            moveByRollPitchYawThrottleInternal(roll, pitch, yaw, throttle);
+        },
+                                 duration);
     }
 
     bool VtolApiBase::moveByRollPitchYawrateThrottle(float roll, float pitch, float yaw_rate, float throttle, float duration)
@@ -186,12 +223,10 @@ namespace airlib
         if (duration <= 0)
             return true;
 
-        return waitForFunction([&]() {
-                   moveByRollPitchYawrateThrottleInternal(roll, pitch, yaw_rate, throttle);
-                   return false; //keep moving until timeout
-               },
-                               duration)
-            .isTimeout();
+        return executeCommandFor([=]() {
+            moveByRollPitchYawrateThrottleInternal(roll, pitch, yaw_rate, throttle);
+        },
+                                 duration);
     }
 
     bool VtolApiBase::moveByRollPitchYawrateZ(float roll, float pitch, float yaw_rate, float z, float duration)
@@ -201,12 +236,10 @@ namespace airlib
         if (duration <= 0)
             return true;
 
-        return waitForFunction([&]() {
-                   moveByRollPitchYawrateZInternal(roll, pitch, yaw_rate, z);
-                   return false; //keep moving until timeout
-               },
-                               duration)
-            .isTimeout();
+        return executeCommandFor([=]() {
+            moveByRollPitchYawrateZInternal(roll, pitch, yaw_rate, z);
+        },
+                                 duration);
     }
 
     bool VtolApiBase::moveByAngleRatesZ(float roll_rate, float pitch_rate, float yaw_rate, float z, float duration)
@@ -216,12 +249,10 @@ namespace airlib
         if (duration <= 0)
             return true;
 
-        return waitForFunction([&]() {
-                   moveByAngleRatesZInternal(roll_rate, pitch_rate, yaw_rate, z);
-                   return false; //keep moving until timeout
-               },
-                               duration)
-            .isTimeout();
+        return executeCommandFor([=]() {
+            moveByAngleRatesZInternal(roll_rate, pitch_rate, yaw_rate, z);
+        },
+                                 duration);
     }
 
     bool VtolApiBase::moveByAngleRatesThrottle(float roll_rate, float pitch_rate, float yaw_rate, float throttle, float duration)
@@ -231,12 +262,10 @@ namespace airlib
         if (duration <= 0)
             return true;
 
-        return waitForFunction([&]() {
-                   moveByAngleRatesThrottleInternal(roll_rate, pitch_rate, yaw_rate, throttle);
-                   return false; //keep moving until timeout
-               },
-                               duration)
-            .isTimeout();
+        return executeCommandFor([=]() {
+            moveByAngleRatesThrottleInternal(roll_rate, pitch_rate, yaw_rate, throttle);
+        },
+                                 duration);
     }
 
     bool VtolApiBase::moveByVelocity(float vx, float vy, float vz, float duration, DrivetrainType drivetrain, const YawMode& yaw_mode)
@@ -249,12 +278,10 @@ namespace airlib
         YawMode adj_yaw_mode(yaw_mode.is_rate, yaw_mode.yaw_or_rate);
         adjustYaw(vx, vy, drivetrain, adj_yaw_mode);
 
-        return waitForFunction([&]() {
-                   moveByVelocityInternal(vx, vy, vz, adj_yaw_mode);
-                   return false; //keep moving until timeout
-               },
-                               duration)
-            .isTimeout();
+        return executeCommandFor([=]() {
+            moveByVelocityInternal(vx, vy, vz, adj_yaw_mode);
+        },
+                                 duration);
     }
 
     bool VtolApiBase::moveByVelocityZ(float vx, float vy, float z, float duration, DrivetrainType drivetrain, const YawMode& yaw_mode)
@@ -267,12 +294,10 @@ namespace airlib
         YawMode adj_yaw_mode(yaw_mode.is_rate, yaw_mode.yaw_or_rate);
         adjustYaw(vx, vy, drivetrain, adj_yaw_mode);
 
-        return waitForFunction([&]() {
-                   moveByVelocityZInternal(vx, vy, z, adj_yaw_mode);
-                   return false; //keep moving until timeout
-               },
-                               duration)
-            .isTimeout();
+        return executeCommandFor([=]() {
+            moveByVelocityZInternal(vx, vy, z, adj_yaw_mode);
+        },
+                                 duration);
     }
 
     bool VtolApiBase::moveOnPath(const vector<Vector3r>& path, float velocity, float timeout_sec, DrivetrainType drivetrain, const YawMode& yaw_mode,
@@ -342,15 +367,108 @@ namespace airlib
 
         float lookahead_error_increasing = 0;
         float lookahead_error = 0;
-        Waiter waiter(getCommandPeriod(), timeout_sec, getCancelToken());
 
         //initialize next path position
         setNextPathPosition(path3d, path_segs, cur_path_loc, lookahead + lookahead_error, next_path_loc);
         float overshoot = 0;
         float goal_dist = 0;
+        bool is_first_step = true, is_path_complete = false;
+
+        //each step sees where the previous command got us, then sends the next one.
+        //the path state is owned by the step, it outlives this call for started commands
+        auto follow_path = [=]() mutable {
+            if (!is_first_step) {
+                /*  Below, P is previous position on path, N is next goal and C is our current position.
+
+            N
+            ^
+            |
+            |
+            |
+            C'|---C
+            |  /
+            | /
+            |/
+            P
+
+            Note that PC could be at any angle relative to PN, including 0 or -ve. We increase lookahead distance
+            by the amount of |PC|. For this, we project PC on to PN to get vector PC' and length of
+            CC'is our adaptive lookahead error by which we will increase lookahead distance. 
+
+            For next iteration, we first update our current position by goal_dist and then
+            set next goal by the amount lookahead + lookahead_error.
+
+            We need to take care of following cases:
+
+            1. |PN| == 0 => lookahead_error = |PC|, goal_dist = 0
+            2. |PC| == 0 => lookahead_error = 0, goal_dist = 0
+            3. PC in opposite direction => lookahead_error = |PC|, goal_dist = 0
+
+            One good test case is if C just keeps moving perpendicular to the path (instead of along the path).
+            In that case, we expect next goal to come up and down by the amount of lookahead_error. However
+            under no circumstances we should go back on the path (i.e. current pos on path can only move forward).
+            */
+
+                //how much have we moved towards last goal?
+                const Vector3r& goal_vect = next_path_loc.position - cur_path_loc.position;
+
+                if (!goal_vect.isZero()) { //goal can only be zero if we are at the end of path
+                    const Vector3r& actual_vect = getPosition() - cur_path_loc.position;
+
+                    //project actual vector on goal vector
+                    const Vector3r& goal_normalized = goal_vect.normalized();
+                    goal_dist = actual_vect.dot(goal_normalized); //dist could be -ve if drone moves away from goal
+
+                    //if adaptive lookahead is enabled the calculate lookahead error (see above fig)
+                    if (adaptive_lookahead) {
+                        const Vector3r& actual_on_goal = goal_normalized * goal_dist;
+                        float error = (actual_vect - actual_on_goal).norm() * adaptive_lookahead;
+                        if (error > lookahead_error) {
+                            lookahead_error_increasing++;
+                            //TODO: below should be lower than 1E3 and configurable
+                            //but lower values like 100 doesn't work for simple_flight + ScalableClock
+                            if (lookahead_error_increasing > 1E5) {
+                                throw std::runtime_error("lookahead error is continually increasing so we do not have safe control, aborting moveOnPath operation");
+                            }
+                        }
+                        else {
+                            lookahead_error_increasing = 0;
+                        }
+                        lookahead_error = error;
+                    }
+                }
+                else {
+                    lookahead_error_increasing = 0;
+                    goal_dist = 0;
+                    lookahead_error = 0; //this is not really required because we will exit
+                    is_path_complete = true;
+                }
 
-        //until we are at the end of the path (last seg is always zero size)
-        while (!waiter.isTimeout() && (next_path_loc.seg_index < path_segs.size() - 1 || goal_dist > 0)) { //current position is approximately at the last end point
+                // Utils::logMessage("PF: cur=%s, goal_dist=%f, cur_path_loc=%s, next_path_loc=%s, lookahead_error=%f",
+                //     VectorMath::toString(getPosition()).c_str(), goal_dist, VectorMath::toString(cur_path_loc.position).c_str(),
+                //     VectorMath::toString(next_path_loc.position).c_str(), lookahead_error);
+
+                //if drone moved backward, we don't want goal to move backward as well
+                //so only climb forward on the path, never back. Also note >= which means
+                //we climb path even if distance was 0 to take care of duplicated points on path
+                if (goal_dist >= 0) {
+                    overshoot = setNextPathPosition(path3d, path_segs, cur_path_loc, goal_dist, cur_path_loc);
+                    if (overshoot)
+                        Utils::log(Utils::stringf("overshoot=%f", overshoot));
+                }
+                //else
+                //    Utils::logMessage("goal_dist was negative: %f", goal_dist);
+
+                //compute next target on path
+                overshoot = setNextPathPosition(path3d, path_segs, cur_path_loc, lookahead + lookahead_error, next_path_loc);
+            }
+            is_first_step = false;
+
+            if (is_path_complete)
+                return CommandExecutor::StepResult::Complete;
+            //until we are at the end of the path (last seg is always zero size)
+            if (next_path_loc.seg_index >= path_segs.size() - 1 && goal_dist <= 0) //current position is approximately at the last end point
+                return CommandExecutor::StepResult::Failed;
 
             float seg_velocity = path_segs.at(next_path_loc.seg_index).seg_velocity;
             float path_length_remaining = path_length - path_segs.at(cur_path_loc.seg_index).seg_path_length - cur_path_loc.offset;
@@ -362,96 +480,10 @@ namespace airlib
             //send drone command to get to next lookahead
             moveToPathPosition(next_path_loc.position, seg_velocity, drivetrain, yaw_mode, path_segs.at(cur_path_loc.seg_index).start_z);
 
-            //sleep for rest of the cycle
-            if (!waiter.sleep())
-                return false;
-
-            /*  Below, P is previous position on path, N is next goal and C is our current position.
-
-        N
-        ^
-        |
-        |
-        |
-        C'|---C
-        |  /
-        | /
-        |/
-        P
-
-        Note that PC could be at any angle relative to PN, including 0 or -ve. We increase lookahead distance
-        by the amount of |PC|. For this, we project PC on to PN to get vector PC' and length of
-        CC'is our adaptive lookahead error by which we will increase lookahead distance. 
-
-        For next iteration, we first update our current position by goal_dist and then
-        set next goal by the amount lookahead + lookahead_error.
-
-        We need to take care of following cases:
-
-        1. |PN| == 0 => lookahead_error = |PC|, goal_dist = 0
-        2. |PC| == 0 => lookahead_error = 0, goal_dist = 0
-        3. PC in opposite direction => lookahead_error = |PC|, goal_dist = 0
-
-        One good test case is if C just keeps moving perpendicular to the path (instead of along the path).
-        In that case, we expect next goal to come up and down by the amount of lookahead_error. However
-        under no circumstances we should go back on the path (i.e. current pos on path can only move forward).
-        */
-
-            //how much have we moved towards last goal?
-            const Vector3r& goal_vect = next_path_loc.position - cur_path_loc.position;
-
-            if (!goal_vect.isZero()) { //goal can only be zero if we are at the end of path
-                const Vector3r& actual_vect = getPosition() - cur_path_loc.position;
-
-                //project actual vector on goal vector
-                const Vector3r& goal_normalized = goal_vect.normalized();
-                goal_dist = actual_vect.dot(goal_normalized); //dist could be -ve if drone moves away from goal
-
-                //if adaptive lookahead is enabled the calculate lookahead error (see above fig)
-                if (adaptive_lookahead) {
-                    const Vector3r& actual_on_goal = goal_normalized * goal_dist;
-                    float error = (actual_vect - actual_on_goal).norm() * adaptive_lookahead;
-                    if (error > lookahead_error) {
-                        lookahead_error_increasing++;
-                        //TODO: below should be lower than 1E3 and configurable
-                        //but lower values like 100 doesn't work for simple_flight + ScalableClock
-                        if (lookahead_error_increasing > 1E5) {
-                            throw std::runtime_error("lookahead error is continually increasing so we do not have safe control, aborting moveOnPath operation");
-                        }
-                    }
-                    else {
-                        lookahead_error_increasing = 0;
-                    }
-                    lookahead_error = error;
-                }
-            }
-            else {
-                lookahead_error_increasing = 0;
-                goal_dist = 0;
-                lookahead_error = 0; //this is not really required because we will exit
-                waiter.complete();
-            }
-
-            // Utils::logMessage("PF: cur=%s, goal_dist=%f, cur_path_loc=%s, next_path_loc=%s, lookahead_error=%f",
-            //     VectorMath::toString(getPosition()).c_str(), goal_dist, VectorMath::toString(cur_path_loc.position).c_str(),
-            //     VectorMath::toString(next_path_loc.position).c_str(), lookahead_error);
-
-            //if drone moved backward, we don't want goal to move backward as well
-            //so only climb forward on the path, never back. Also note >= which means
-            //we climb path even if distance was 0 to take care of duplicated points on path
-            if (goal_dist >= 0) {
-                overshoot = setNextPathPosition(path3d, path_segs, cur_path_loc, goal_dist, cur_path_loc);
-                if (overshoot)
-                    Utils::log(Utils::stringf("overshoot=%f", overshoot));
-            }
-            //else
-            //    Utils::logMessage("goal_dist was negative: %f", goal_dist);
+            return CommandExecutor::StepResult::Running;
+        };
 
-            //compute next target on path
-            overshoot = setNextPathPosition(path3d, path_segs, cur_path_loc, lookahead + lookahead_error, next_path_loc);
-        }
-
-        return waiter.isComplete();
+        return executeCommand(follow_path, timeout_sec);
     }
 
     bool VtolApiBase::moveToPosition(float x, float y, float z, float velocity, float timeout_sec, DrivetrainType drivetrain,
@@ -485,9 +517,7 @@ namespace airlib
         //freeze the quaternion
         Quaternionr starting_quaternion = getKinematicsEstimated().pose.orientation;
 
-        Waiter waiter(getCommandPeriod(), duration, getCancelToken());
-        do {
-
+        auto fly_manual = [=]() {
             RCData rc_data = getRCData();
             TTimeDelta age = clock()->elapsedSince(rc_data.timestamp);
             if (rc_data.is_valid && (rc_data.timestamp == 0 || age <= kMaxMessageAge)) { //if rc message timestamp is not set OR is not too old
@@ -514,11 +544,10 @@ namespace airlib
             }
             else
                 Utils::log(Utils::stringf("RCData had too old timestamp: %f", age));
+        };
 
-        } while (waiter.sleep());
-
-        //if timeout occurred then command completed successfully otherwise it was interrupted
-        return waiter.isTimeout();
+        //if duration ended then command completed successfully otherwise it was interrupted
+        return executeCommandFor(fly_manual, duration);
     }
 
     bool VtolApiBase::rotateToYaw(float yaw, float timeout_sec, float margin)
@@ -533,23 +562,22 @@ namespace airlib
         YawMode move_yaw_mode(false, yaw_target);
         YawMode stop_yaw_mode(true, 0);
 
-        return waitForFunction([&]() {
-                   if (isYawWithinMargin(yaw_target, margin)) { // yaw is within margin, then trying to stop rotation
-                       moveToPositionInternal(start_pos, stop_yaw_mode); // let yaw rate be zero
-                       auto yaw_rate = getKinematicsEstimated().twist.angular.z();
-                       if (abs(yaw_rate) <= approx_zero_angular_vel_) { // already sopped
-                           return true; //stop all for stably achieving the goal
-                       }
-                   }
-                   else { // yaw is not within margin, go on rotation
-                       moveToPositionInternal(start_pos, move_yaw_mode);
-                   }
-
-                   // yaw is not within margin
-                   return false; //keep moving until timeout
-               },
-                               timeout_sec)
-            .isComplete();
+        return executeCommand([=]() {
+            if (isYawWithinMargin(yaw_target, margin)) { // yaw is within margin, then trying to stop rotation
+                moveToPositionInternal(start_pos, stop_yaw_mode); // let yaw rate be zero
+                auto yaw_rate = getKinematicsEstimated().twist.angular.z();
+                if (abs(yaw_rate) <= approx_zero_angular_vel_) { // already sopped
+                    return CommandExecutor::StepResult::Complete; //stop all for stably achieving the goal
+                }
+            }
+            else { // yaw is not within margin, go on rotation
+                moveToPositionInternal(start_pos, move_yaw_mode);
+            }
+
+            // yaw is not within margin
+            return CommandExecutor::StepResult::Running; //keep moving until timeout
+        },
+                              timeout_sec);
     }
 
     bool VtolApiBase::rotateByYawRate(float yaw_rate, float duration)
@@ -562,12 +590,10 @@ namespace airlib
         auto start_pos = getPosition();
         YawMode yaw_mode(true, yaw_rate);
 
-        return waitForFunction([&]() {
-                   moveToPositionInternal(start_pos, yaw_mode);
-                   return false; //keep moving until timeout
-               },
-                               duration)
-            .isTimeout();
+        return executeCommandFor([=]() {
+            moveToPositionInternal(start_pos, yaw_mode);
+        },
+                                 duration);
     }
 
     void VtolApiBase::setAngleLevelControllerGains(const vector<float>& kp, const vector<float>& ki, const vector<float>& kd)
@@ -664,19 +690,36 @@ namespace airlib
 
     //executes a given function until it returns true. Each execution is spaced apart at command period.
     //return value is true if exit was due to given function returning true, otherwise false (due to timeout)
-    Waiter VtolApiBase::waitForFunction(WaitFunction function, float timeout_sec)
+    CommandExecutor::Result VtolApiBase::waitForFunction(WaitFunction function, float timeout_sec)
     {
-        Waiter waiter(getCommandPeriod(), timeout_sec, getCancelToken());
-        if (timeout_sec <= 0)
-            return waiter;
+        return executeSteps([&function]() {
+            return function() ? CommandExecutor::StepResult::Complete : CommandExecutor::StepResult::Running;
+        },
+                            timeout_sec);
+    }
 
-        do {
-            if (function()) {
-                waiter.complete();
-                break;
-            }
-        } while (waiter.sleep());
-        return waiter;
+    CommandExecutor::Result VtolApiBase::executeSteps(CommandExecutor::StepFunction step, float timeout_sec)
+    {
+        //the calling thread waits here asleep on the future, the steps run on the physics thread through update()
+        return command_executor_.run(std::move(step), getCommandPeriod(), timeout_sec, getCancelToken());
+    }
+
+    bool VtolApiBase::executeCommand(CommandExecutor::StepFunction step, float timeout_sec)
+    {
+        //within startCommand() this returns right away and the caller polls the command id instead
+        return command_executor_.runCommand(std::move(step), getCommandPeriod(), timeout_sec, getCancelToken());
+    }
+
+    bool VtolApiBase::executeCommandFor(std::function<void()> step, float duration)
+    {
+        return command_executor_.runCommand([step]() {
+            step();
+            return CommandExecutor::StepResult::Running; //keep moving until duration ends
+        },
+                                            getCommandPeriod(),
+                                            duration,
+                                            getCancelToken(),
+                                            true);
     }
 
     bool VtolApiBase::waitForZ(float timeout_sec, float z, float margin)
@@ -693,7 +736,8 @@ namespace airlib
     void VtolApiBase::setSafetyEval(const shared_ptr<SafetyEval> safety_eval_ptr)
     {
         SingleCall lock(this);
-        safety_eval_ptr_ = safety_eval_ptr;
+        //update() reads it from the physics thread
+        std::atomic_store(&safety_eval_ptr_, safety_eval_ptr);
     }
 
     RCData VtolApiBase::estimateRCTrims(float trimduration, float minCountForTrim, float maxTrim)
@@ -701,17 +745,16 @@ namespace airlib
         rc_data_trims_ = RCData();
 
         //get trims
-        Waiter waiter_trim(getCommandPeriod(), trimduration, getCancelToken());
         uint count = 0;
-        do {
-
+        waitForFunction([&]() {
             const RCData rc_data = getRCData();
             if (rc_data.is_valid) {
                 rc_data_trims_.add(rc_data);
                 count++;
             }
-
-        } while (waiter_trim.sleep());
+            return false;
+        },
+                        trimduration);
 
         rc_data_trims_.is_valid = true;
 
@@ -51,6 +51,7 @@ __pragma(warning(disable : 4239))
         {
         public:
             std::future<RPCLIB_MSGPACK::object_handle> last_future;
+            std::string last_vehicle_name;
         };
 
         VtolRpcLibClient::VtolRpcLibClient(const string& ip_address, uint16_t port, float timeout_sec)
@@ -65,87 +66,101 @@ __pragma(warning(disable : 4239))
 
         VtolRpcLibClient* VtolRpcLibClient::takeoffAsync(float timeout_sec, const std::string& vehicle_name)
         {
-            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("takeoff", timeout_sec, vehicle_name);
+            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("takeoffStart", timeout_sec, vehicle_name);
+            pimpl_->last_vehicle_name = vehicle_name;
             return this;
         }
         VtolRpcLibClient* VtolRpcLibClient::landAsync(float timeout_sec, const std::string& vehicle_name)
         {
-            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("land", timeout_sec, vehicle_name);
+            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("landStart", timeout_sec, vehicle_name);
+            pimpl_->last_vehicle_name = vehicle_name;
             return this;
         }
         VtolRpcLibClient* VtolRpcLibClient::goHomeAsync(float timeout_sec, const std::string& vehicle_name)
         {
-            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("goHome", timeout_sec, vehicle_name);
+            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("goHomeStart", timeout_sec, vehicle_name);
+            pimpl_->last_vehicle_name = vehicle_name;
             return this;
         }
 
         VtolRpcLibClient* VtolRpcLibClient::moveByVelocityBodyFrameAsync(float vx, float vy, float vz, float duration,
                                                                                    DrivetrainType drivetrain, const YawMode& yaw_mode, const std::string& vehicle_name)
         {
-            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("moveByVelocityBodyFrame", vx, vy, vz, duration, drivetrain, MultirotorRpcLibAdaptors::YawMode(yaw_mode), vehicle_name);
+            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("moveByVelocityBodyFrameStart", vx, vy, vz, duration, drivetrain, MultirotorRpcLibAdaptors::YawMode(yaw_mode), vehicle_name);
+            pimpl_->last_vehicle_name = vehicle_name;
             return this;
         }
 
         VtolRpcLibClient* VtolRpcLibClient::moveByVelocityZBodyFrameAsync(float vx, float vy, float z, float duration,
                                                                                     DrivetrainType drivetrain, const YawMode& yaw_mode, const std::string& vehicle_name)
         {
-            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("moveByVelocityZBodyFrame", vx, vy, z, duration, drivetrain, MultirotorRpcLibAdaptors::YawMode(yaw_mode), vehicle_name);
+            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("moveByVelocityZBodyFrameStart", vx, vy, z, duration, drivetrain, MultirotorRpcLibAdaptors::YawMode(yaw_mode), vehicle_name);
+            pimpl_->last_vehicle_name = vehicle_name;
             return this;
         }
 
         VtolRpcLibClient* VtolRpcLibClient::moveByMotorPWMsAsync(const vector<float>& pwm_values, float duration, const std::string& vehicle_name)
         {
-            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("moveByMotorPWMs", pwm_values, duration, vehicle_name);
+            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("moveByMotorPWMsStart", pwm_values, duration, vehicle_name);
+            pimpl_->last_vehicle_name = vehicle_name;
             return this;
         }
 
         VtolRpcLibClient* VtolRpcLibClient::moveByRollPitchYawZAsync(float roll, float pitch, float yaw, float z, float duration, const std::string& vehicle_name)
         {
-            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("moveByRollPitchYawZ", roll, pitch, yaw, z, duration, vehicle_name);
+            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("moveByRollPitchYawZStart", roll, pitch, yaw, z, duration, vehicle_name);
+            pimpl_->last_vehicle_name = vehicle_name;
             return this;
         }
 
         VtolRpcLibClient* VtolRpcLibClient::moveByRollPitchYawThrottleAsync(float roll, float pitch, float yaw, float throttle, float duration, const std::string& vehicle_name)
         {
-            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("moveByRollPitchYawThrottle", roll, pitch, yaw, throttle, duration, vehicle_name);
+            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("moveByRollPitchYawThrottleStart", roll, pitch, yaw, throttle, duration, vehicle_name);
+            pimpl_->last_vehicle_name = vehicle_name;
             return this;
         }
 
         VtolRpcLibClient* VtolRpcLibClient::moveByRollPitchYawrateThrottleAsync(float roll, float pitch, float yaw_rate, float throttle, float duration, const std::string& vehicle_name)
         {
-            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("moveByRollPitchYawrateThrottle", roll, pitch, yaw_rate, throttle, duration, vehicle_name);
+            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("moveByRollPitchYawrateThrottleStart", roll, pitch, yaw_rate, throttle, duration, vehicle_name);
+            pimpl_->last_vehicle_name = vehicle_name;
             return this;
         }
 
         VtolRpcLibClient* VtolRpcLibClient::moveByRollPitchYawrateZAsync(float roll, float pitch, float yaw_rate, float z, float duration, const std::string& vehicle_name)
         {
-            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("moveByRollPitchYawrateZ", roll, pitch, yaw_rate, z, duration, vehicle_name);
+            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("moveByRollPitchYawrateZStart", roll, pitch, yaw_rate, z, duration, vehicle_name);
+            pimpl_->last_vehicle_name = vehicle_name;
             return this;
         }
 
         VtolRpcLibClient* VtolRpcLibClient::moveByAngleRatesZAsync(float roll_rate, float pitch_rate, float yaw_rate, float z, float duration, const std::string& vehicle_name)
         {
-            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("moveByAngleRatesZ", roll_rate, pitch_rate, yaw_rate, z, duration, vehicle_name);
+            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("moveByAngleRatesZStart", roll_rate, pitch_rate, yaw_rate, z, duration, vehicle_name);
+            pimpl_->last_vehicle_name = vehicle_name;
             return this;
         }
 
         VtolRpcLibClient* VtolRpcLibClient::moveByAngleRatesThrottleAsync(float roll_rate, float pitch_rate, float yaw_rate, float throttle, float duration, const std::string& vehicle_name)
         {
-            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("moveByAngleRatesThrottle", roll_rate, pitch_rate, yaw_rate, throttle, duration, vehicle_name);
+            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("moveByAngleRatesThrottleStart", roll_rate, pitch_rate, yaw_rate, throttle, duration, vehicle_name);
+            pimpl_->last_vehicle_name = vehicle_name;
             return this;
         }
 
         VtolRpcLibClient* VtolRpcLibClient::moveByVelocityAsync(float vx, float vy, float vz, float duration,
                                                                           DrivetrainType drivetrain, const YawMode& yaw_mode, const std::string& vehicle_name)
         {
-            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("moveByVelocity", vx, vy, vz, duration, drivetrain, MultirotorRpcLibAdaptors::YawMode(yaw_mode), vehicle_name);
+            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("moveByVelocityStart", vx, vy, vz, duration, drivetrain, MultirotorRpcLibAdaptors::YawMode(yaw_mode), vehicle_name);
+            pimpl_->last_vehicle_name = vehicle_name;
             return this;
         }
 
         VtolRpcLibClient* VtolRpcLibClient::moveByVelocityZAsync(float vx, float vy, float z, float duration,
                                                                            DrivetrainType drivetrain, const YawMode& yaw_mode, const std::string& vehicle_name)
         {
-            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("moveByVelocityZ", vx, vy, z, duration, drivetrain, MultirotorRpcLibAdaptors::YawMode(yaw_mode), vehicle_name);
+            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("moveByVelocityZStart", vx, vy, z, duration, drivetrain, MultirotorRpcLibAdaptors::YawMode(yaw_mode), vehicle_name);
+            pimpl_->last_vehicle_name = vehicle_name;
             return this;
         }
 
@@ -154,45 +169,52 @@ __pragma(warning(disable : 4239))
         {
             vector<VtolRpcLibAdaptors::Vector3r> conv_path;
             VtolRpcLibAdaptors::from(path, conv_path);
-            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("moveOnPath", conv_path, velocity, duration, drivetrain, MultirotorRpcLibAdaptors::YawMode(yaw_mode), lookahead, adaptive_lookahead, vehicle_name);
+            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("moveOnPathStart", conv_path, velocity, duration, drivetrain, MultirotorRpcLibAdaptors::YawMode(yaw_mode), lookahead, adaptive_lookahead, vehicle_name);
+            pimpl_->last_vehicle_name = vehicle_name;
             return this;
         }
 
         VtolRpcLibClient* VtolRpcLibClient::moveToPositionAsync(float x, float y, float z, float velocity, float timeout_sec,
                                                                           DrivetrainType drivetrain, const YawMode& yaw_mode, float lookahead, float adaptive_lookahead, const std::string& vehicle_name)
         {
-            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("moveToPosition", x, y, z, velocity, timeout_sec, drivetrain, MultirotorRpcLibAdaptors::YawMode(yaw_mode), lookahead, adaptive_lookahead, vehicle_name);
+            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("moveToPositionStart", x, y, z, velocity, timeout_sec, drivetrain, MultirotorRpcLibAdaptors::YawMode(yaw_mode), lookahead, adaptive_lookahead, vehicle_name);
+            pimpl_->last_vehicle_name = vehicle_name;
             return this;
         }
 
         VtolRpcLibClient* VtolRpcLibClient::moveToZAsync(float z, float velocity, float timeout_sec, const YawMode& yaw_mode, float lookahead, float adaptive_lookahead, const std::string& vehicle_name)
         {
-            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("moveToZ", z, velocity, timeout_sec, MultirotorRpcLibAdaptors::YawMode(yaw_mode), lookahead, adaptive_lookahead, vehicle_name);
+            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("moveToZStart", z, velocity, timeout_sec, MultirotorRpcLibAdaptors::YawMode(yaw_mode), lookahead, adaptive_lookahead, vehicle_name);
+            pimpl_->last_vehicle_name = vehicle_name;
             return this;
         }
 
         VtolRpcLibClient* VtolRpcLibClient::moveByManualAsync(float vx_max, float vy_max, float z_min, float duration,
                                                                         DrivetrainType drivetrain, const YawMode& yaw_mode, const std::string& vehicle_name)
         {
-            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("moveByManual", vx_max, vy_max, z_min, duration, drivetrain, MultirotorRpcLibAdaptors::YawMode(yaw_mode), vehicle_name);
+            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("moveByManualStart", vx_max, vy_max, z_min, duration, drivetrain, MultirotorRpcLibAdaptors::YawMode(yaw_mode), vehicle_name);
+            pimpl_->last_vehicle_name = vehicle_name;
             return this;
         }
 
         VtolRpcLibClient* VtolRpcLibClient::rotateToYawAsync(float yaw, float timeout_sec, float margin, const std::string& vehicle_name)
         {
-            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("rotateToYaw", yaw, timeout_sec, margin, vehicle_name);
+            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("rotateToYawStart", yaw, timeout_sec, margin, vehicle_name);
+            pimpl_->last_vehicle_name = vehicle_name;
             return this;
         }
 
         VtolRpcLibClient* VtolRpcLibClient::rotateByYawRateAsync(float yaw_rate, float duration, const std::string& vehicle_name)
         {
-            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("rotateByYawRate", yaw_rate, duration, vehicle_name);
+            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("rotateByYawRateStart", yaw_rate, duration, vehicle_name);
+            pimpl_->last_vehicle_name = vehicle_name;
             return this;
         }
 
         VtolRpcLibClient* VtolRpcLibClient::hoverAsync(const std::string& vehicle_name)
         {
-            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("hover", vehicle_name);
+            pimpl_->last_future = static_cast<rpc::client*>(getClient())->async_call("hoverStart", vehicle_name);
+            pimpl_->last_vehicle_name = vehicle_name;
             return this;
         }
 
@@ -243,15 +265,25 @@ __pragma(warning(disable : 4239))
         //cancellation or timeout
         VtolRpcLibClient* VtolRpcLibClient::waitOnLastTask(bool* task_result, float timeout_sec)
         {
-            bool result;
-            if (std::isnan(timeout_sec) || timeout_sec == Utils::max<float>())
-                result = pimpl_->last_future.get().as<bool>();
-            else {
-                auto future_status = pimpl_->last_future.wait_for(std::chrono::duration<double>(timeout_sec));
-                if (future_status == std::future_status::ready)
-                    result = pimpl_->last_future.get().as<bool>();
-                else
-                    result = false;
+            //the task was started with a command id, the server doesn't hold a thread for it so its outcome is polled
+            static constexpr std::chrono::milliseconds kPollPeriod{ 10 };
+
+            const bool has_timeout = !std::isnan(timeout_sec) && timeout_sec != Utils::max<float>();
+            const auto deadline = std::chrono::steady_clock::now() +
+                                  std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(has_timeout ? timeout_sec : 0));
+
+            bool result = false;
+            if (!has_timeout || pimpl_->last_future.wait_until(deadline) == std::future_status::ready) {
+                auto* client = static_cast<rpc::client*>(getClient());
+                const auto command_id = pimpl_->last_future.get().as<CommandExecutor::CommandId>();
+
+                bool is_done = client->call("isCommandDone", command_id, pimpl_->last_vehicle_name).as<bool>();
+                while (!is_done && !(has_timeout && std::chrono::steady_clock::now() >= deadline)) {
+                    std::this_thread::sleep_for(kPollPeriod);
+                    is_done = client->call("isCommandDone", command_id, pimpl_->last_vehicle_name).as<bool>();
+                }
+                if (is_done)
+                    result = client->call("getCommandResult", command_id, pimpl_->last_vehicle_name).as<bool>();
             }
 
             if (task_result)
@@ -10,6 +10,7 @@
 #include "vehicles/vtol/api/VtolRpcLibServer.hpp"
 
 #include "common/Common.hpp"
+#include <tuple>
 STRICT_MODE_OFF
 
 #ifndef RPCLIB_MSGPACK
@@ -41,75 +42,100 @@ namespace airlib
     typedef msr::airlib_rpclib::VtolRpcLibAdaptors VtolRpcLibAdaptors;
     typedef msr::airlib_rpclib::MultirotorRpcLibAdaptors MultirotorRpcLibAdaptors;
 
+    template <typename Command>
+    void VtolRpcLibServer::bindCommand(const std::string& name, Command command)
+    {
+        (static_cast<rpc::server*>(getServer()))->bind(name, command);
+        bindCommandStart(name + "Start", command, &Command::operator());
+    }
+
+    template <typename Command, typename... Args>
+    void VtolRpcLibServer::bindCommandStart(const std::string& name, Command command, bool (Command::*)(Args...) const)
+    {
+        (static_cast<rpc::server*>(getServer()))->bind(name, [this, command](Args... args) -> CommandExecutor::CommandId {
+            //vehicle name is the last argument of every command
+            const std::string& vehicle_name = std::get<sizeof...(Args) - 1>(std::forward_as_tuple(args...));
+            return getVehicleApi(vehicle_name)->startCommand([&]() {
+                return command(args...);
+            });
+        });
+    }
+
     VtolRpcLibServer::VtolRpcLibServer(ApiProvider* api_provider, string server_address, uint16_t port)
         : RpcLibServerBase(api_provider, server_address, port)
     {
-        (static_cast<rpc::server*>(getServer()))->bind("takeoff", [&](float timeout_sec, const std::string& vehicle_name) -> bool {
+        bindCommand("takeoff", [&](float timeout_sec, const std::string& vehicle_name) -> bool {
             return getVehicleApi(vehicle_name)->takeoff(timeout_sec);
         });
-        (static_cast<rpc::server*>(getServer()))->bind("land", [&](float timeout_sec, const std::string& vehicle_name) -> bool {
+        bindCommand("land", [&](float timeout_sec, const std::string& vehicle_name) -> bool {
             return getVehicleApi(vehicle_name)->land(timeout_sec);
         });
-        (static_cast<rpc::server*>(getServer()))->bind("goHome", [&](float timeout_sec, const std::string& vehicle_name) -> bool {
+        bindCommand("goHome", [&](float timeout_sec, const std::string& vehicle_name) -> bool {
             return getVehicleApi(vehicle_name)->goHome(timeout_sec);
         });
-        (static_cast<rpc::server*>(getServer()))->bind("moveByVelocityBodyFrame", [&](float vx, float vy, float vz, float duration, DrivetrainType drivetrain, const MultirotorRpcLibAdaptors::YawMode& yaw_mode, const std::string& vehicle_name) -> bool {
+        bindCommand("moveByVelocityBodyFrame", [&](float vx, float vy, float vz, float duration, DrivetrainType drivetrain, const MultirotorRpcLibAdaptors::YawMode& yaw_mode, const std::string& vehicle_name) -> bool {
             return getVehicleApi(vehicle_name)->moveByVelocityBodyFrame(vx, vy, vz, duration, drivetrain, yaw_mode.to());
         });
-        (static_cast<rpc::server*>(getServer()))->bind("moveByVelocityZBodyFrame", [&](float vx, float vy, float z, float duration, DrivetrainType drivetrain, const MultirotorRpcLibAdaptors::YawMode& yaw_mode, const std::string& vehicle_name) -> bool {
+        bindCommand("moveByVelocityZBodyFrame", [&](float vx, float vy, float z, float duration, DrivetrainType drivetrain, const MultirotorRpcLibAdaptors::YawMode& yaw_mode, const std::string& vehicle_name) -> bool {
             return getVehicleApi(vehicle_name)->moveByVelocityZBodyFrame(vx, vy, z, duration, drivetrain, yaw_mode.to());
         });
-        (static_cast<rpc::server*>(getServer()))->bind("moveByMotorPWMs", [&](const vector<float>& pwm_values, float duration, const std::string& vehicle_name) -> bool {
+        bindCommand("moveByMotorPWMs", [&](const vector<float>& pwm_values, float duration, const std::string& vehicle_name) -> bool {
             return getVehicleApi(vehicle_name)->moveByMotorPWMs(pwm_values, duration);
         });
-        (static_cast<rpc::server*>(getServer()))->bind("moveByRollPitchYawZ", [&](float roll, float pitch, float yaw, float z, float duration, const std::string& vehicle_name) -> bool {
+        bindCommand("moveByRollPitchYawZ", [&](float roll, float pitch, float yaw, float z, float duration, const std::string& vehicle_name) -> bool {
             return getVehicleApi(vehicle_name)->moveByRollPitchYawZ(roll, pitch, yaw, z, duration);
         });
-        (static_cast<rpc::server*>(getServer()))->bind("moveByRollPitchYawThrottle", [&](float roll, float pitch, float yaw, float throttle, float duration, const std::string& vehicle_name) -> bool {
+        bindCommand("moveByRollPitchYawThrottle", [&](float roll, float pitch, float yaw, float throttle, float duration, const std::string& vehicle_name) -> bool {
             return getVehicleApi(vehicle_name)->moveByRollPitchYawThrottle(roll, pitch, yaw, throttle, duration);
         });
-        (static_cast<rpc::server*>(getServer()))->bind("moveByRollPitchYawrateThrottle", [&](float roll, float pitch, float yaw_rate, float throttle, float duration, const std::string& vehicle_name) -> bool {
+        bindCommand("moveByRollPitchYawrateThrottle", [&](float roll, float pitch, float yaw_rate, float throttle, float duration, const std::string& vehicle_name) -> bool {
             return getVehicleApi(vehicle_name)->moveByRollPitchYawrateThrottle(roll, pitch, yaw_rate, throttle, duration);
         });
-        (static_cast<rpc::server*>(getServer()))->bind("moveByRollPitchYawrateZ", [&](float roll, float pitch, float yaw_rate, float z, float duration, const std::string& vehicle_name) -> bool {
+        bindCommand("moveByRollPitchYawrateZ", [&](float roll, float pitch, float yaw_rate, float z, float duration, const std::string& vehicle_name) -> bool {
             return getVehicleApi(vehicle_name)->moveByRollPitchYawrateZ(roll, pitch, yaw_rate, z, duration);
         });
-        (static_cast<rpc::server*>(getServer()))->bind("moveByAngleRatesZ", [&](float roll_rate, float pitch_rate, float yaw_rate, float z, float duration, const std::string& vehicle_name) -> bool {
+        bindCommand("moveByAngleRatesZ", [&](float roll_rate, float pitch_rate, float yaw_rate, float z, float duration, const std::string& vehicle_name) -> bool {
             return getVehicleApi(vehicle_name)->moveByAngleRatesZ(roll_rate, pitch_rate, yaw_rate, z, duration);
         });
-        (static_cast<rpc::server*>(getServer()))->bind("moveByAngleRatesThrottle", [&](float roll_rate, float pitch_rate, float yaw_rate, float throttle, float duration, const std::string& vehicle_name) -> bool {
+        bindCommand("moveByAngleRatesThrottle", [&](float roll_rate, float pitch_rate, float yaw_rate, float throttle, float duration, const std::string& vehicle_name) -> bool {
             return getVehicleApi(vehicle_name)->moveByAngleRatesThrottle(roll_rate, pitch_rate, yaw_rate, throttle, duration);
         });
-        (static_cast<rpc::server*>(getServer()))->bind("moveByVelocity", [&](float vx, float vy, float vz, float duration, DrivetrainType drivetrain, const MultirotorRpcLibAdaptors::YawMode& yaw_mode, const std::string& vehicle_name) -> bool {
+        bindCommand("moveByVelocity", [&](float vx, float vy, float vz, float duration, DrivetrainType drivetrain, const MultirotorRpcLibAdaptors::YawMode& yaw_mode, const std::string& vehicle_name) -> bool {
             return getVehicleApi(vehicle_name)->moveByVelocity(vx, vy, vz, duration, drivetrain, yaw_mode.to());
         });
-        (static_cast<rpc::server*>(getServer()))->bind("moveByVelocityZ", [&](float vx, float vy, float z, float duration, DrivetrainType drivetrain, const MultirotorRpcLibAdaptors::YawMode& yaw_mode, const std::string& vehicle_name) -> bool {
+        bindCommand("moveByVelocityZ", [&](float vx, float vy, float z, float duration, DrivetrainType drivetrain, const MultirotorRpcLibAdaptors::YawMode& yaw_mode, const std::string& vehicle_name) -> bool {
             return getVehicleApi(vehicle_name)->moveByVelocityZ(vx, vy, z, duration, drivetrain, yaw_mode.to());
         });
-        (static_cast<rpc::server*>(getServer()))->bind("moveOnPath", [&](const vector<VtolRpcLibAdaptors::Vector3r>& path, float velocity, float timeout_sec, DrivetrainType drivetrain, const MultirotorRpcLibAdaptors::YawMode& yaw_mode, float lookahead, float adaptive_lookahead, const std::string& vehicle_name) -> bool {
+        bindCommand("moveOnPath", [&](const vector<VtolRpcLibAdaptors::Vector3r>& path, float velocity, float timeout_sec, DrivetrainType drivetrain, const MultirotorRpcLibAdaptors::YawMode& yaw_mode, float lookahead, float adaptive_lookahead, const std::string& vehicle_name) -> bool {
             vector<Vector3r> conv_path;
             VtolRpcLibAdaptors::to(path, conv_path);
             return getVehicleApi(vehicle_name)->moveOnPath(conv_path, velocity, timeout_sec, drivetrain, yaw_mode.to(), lookahead, adaptive_lookahead);
         });
-        (static_cast<rpc::server*>(getServer()))->bind("moveToPosition", [&](float x, float y, float z, float velocity, float timeout_sec, DrivetrainType drivetrain, const MultirotorRpcLibAdaptors::YawMode& yaw_mode, float lookahead, float adaptive_lookahead, const std::string& vehicle_name) -> bool {
+        bindCommand("moveToPosition", [&](float x, float y, float z, float velocity, float timeout_sec, DrivetrainType drivetrain, const MultirotorRpcLibAdaptors::YawMode& yaw_mode, float lookahead, float adaptive_lookahead, const std::string& vehicle_name) -> bool {
             return getVehicleApi(vehicle_name)->moveToPosition(x, y, z, velocity, timeout_sec, drivetrain, yaw_mode.to(), lookahead, adaptive_lookahead);
         });
-        (static_cast<rpc::server*>(getServer()))->bind("moveToZ", [&](float z, float velocity, float timeout_sec, const MultirotorRpcLibAdaptors::YawMode& yaw_mode, float lookahead, float adaptive_lookahead, const std::string& vehicle_name) -> bool {
+        bindCommand("moveToZ", [&](float z, float velocity, float timeout_sec, const MultirotorRpcLibAdaptors::YawMode& yaw_mode, float lookahead, float adaptive_lookahead, const std::string& vehicle_name) -> bool {
             return getVehicleApi(vehicle_name)->moveToZ(z, velocity, timeout_sec, yaw_mode.to(), lookahead, adaptive_lookahead);
         });
-        (static_cast<rpc::server*>(getServer()))->bind("moveByManual", [&](float vx_max, float vy_max, float z_min, float duration, DrivetrainType drivetrain, const MultirotorRpcLibAdaptors::YawMode& yaw_mode, const std::string& vehicle_name) -> bool {
+        bindCommand("moveByManual", [&](float vx_max, float vy_max, float z_min, float duration, DrivetrainType drivetrain, const MultirotorRpcLibAdaptors::YawMode& yaw_mode, const std::string& vehicle_name) -> bool {
             return getVehicleApi(vehicle_name)->moveByManual(vx_max, vy_max, z_min, duration, drivetrain, yaw_mode.to());
         });
 
-        (static_cast<rpc::server*>(getServer()))->bind("rotateToYaw", [&](float yaw, float timeout_sec, float margin, const std::string& vehicle_name) -> bool {
+        bindCommand("rotateToYaw", [&](float yaw, float timeout_sec, float margin, const std::string& vehicle_name) -> bool {
             return getVehicleApi(vehicle_name)->rotateToYaw(yaw, timeout_sec, margin);
         });
-        (static_cast<rpc::server*>(getServer()))->bind("rotateByYawRate", [&](float yaw_rate, float duration, const std::string& vehicle_name) -> bool {
+        bindCommand("rotateByYawRate", [&](float yaw_rate, float duration, const std::string& vehicle_name) -> bool {
             return getVehicleApi(vehicle_name)->rotateByYawRate(yaw_rate, duration);
         });
-        (static_cast<rpc::server*>(getServer()))->bind("hover", [&](const std::string& vehicle_name) -> bool {
+        bindCommand("hover", [&](const std::string& vehicle_name) -> bool {
             return getVehicleApi(vehicle_name)->hover();
         });
+        (static_cast<rpc::server*>(getServer()))->bind("isCommandDone", [&](CommandExecutor::CommandId command_id, const std::string& vehicle_name) -> bool {
+            return getVehicleApi(vehicle_name)->isCommandDone(command_id);
+        });
+        (static_cast<rpc::server*>(getServer()))->bind("getCommandResult", [&](CommandExecutor::CommandId command_id, const std::string& vehicle_name) -> bool {
+            return getVehicleApi(vehicle_name)->getCommandResult(command_id);
+        });
         (static_cast<rpc::server*>(getServer()))->bind("setAngleLevelControllerGains", [&](const vector<float>& kp, const vector<float>& ki, const vector<float>& kd, const std::string& vehicle_name) -> void {
             getVehicleApi(vehicle_name)->setAngleLevelControllerGains(kp, ki, kd);
         });
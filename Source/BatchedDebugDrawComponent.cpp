@@ -0,0 +1,106 @@
+#include "BatchedDebugDrawComponent.h"
+
+UBatchedDebugDrawComponent::UBatchedDebugDrawComponent()
+{
+    PrimaryComponentTick.bCanEverTick = true;
+    PrimaryComponentTick.bStartWithTickEnabled = true;
+}
+
+void UBatchedDebugDrawComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+    //ULineBatchComponent's tick walks every element to age lifetimes, ours never expire so skip it
+    UActorComponent::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+    time_since_draw_ += DeltaTime;
+    if (dirty_ && time_since_draw_ >= draw_interval_) {
+        flush();
+        time_since_draw_ = 0;
+    }
+}
+
+void UBatchedDebugDrawComponent::setDrawRate(float draw_rate)
+{
+    draw_interval_ = draw_rate > 0 ? 1 / draw_rate : 0;
+}
+
+void UBatchedDebugDrawComponent::setPointHistory(int32 history)
+{
+    point_history_ = FMath::Max(history, 1);
+    if (point_sets_.Num() > point_history_) {
+        point_sets_.SetNum(point_history_);
+        dirty_ = true;
+    }
+    next_point_set_ = 0;
+}
+
+void UBatchedDebugDrawComponent::setLineCapacity(int32 capacity)
+{
+    line_capacity_ = FMath::Max(capacity, 1);
+    if (BatchedLines.Num() > line_capacity_) {
+        BatchedLines.SetNum(line_capacity_);
+        dirty_ = true;
+    }
+    next_line_ = 0;
+}
+
+bool UBatchedDebugDrawComponent::isDrawDue() const
+{
+    return time_since_draw_ >= draw_interval_;
+}
+
+TArray<FBatchedPoint>& UBatchedDebugDrawComponent::addPointSet()
+{
+    dirty_ = true;
+
+    if (point_sets_.Num() < point_history_)
+        return point_sets_.AddDefaulted_GetRef();
+
+    //reuse the oldest set's allocation, scans are usually the same size
+    TArray<FBatchedPoint>& point_set = point_sets_[next_point_set_];
+    next_point_set_ = (next_point_set_ + 1) % point_history_;
+    point_set.Reset();
+    return point_set;
+}
+
+void UBatchedDebugDrawComponent::addLine(const FVector& start, const FVector& end, const FColor& color, float thickness)
+{
+    dirty_ = true;
+
+    //BatchedLines is the ring itself, draw order doesn't matter
+    const FBatchedLine line(start, end, color, 0, thickness, SDPG_World);
+    if (BatchedLines.Num() < line_capacity_)
+        BatchedLines.Add(line);
+    else {
+        BatchedLines[next_line_] = line;
+        next_line_ = (next_line_ + 1) % line_capacity_;
+    }
+}
+
+void UBatchedDebugDrawComponent::clearPoints()
+{
+    point_sets_.Reset();
+    next_point_set_ = 0;
+    dirty_ = true;
+}
+
+void UBatchedDebugDrawComponent::clearLines()
+{
+    BatchedLines.Reset();
+    next_line_ = 0;
+    dirty_ = true;
+}
+
+void UBatchedDebugDrawComponent::flush()
+{
+    int32 point_count = 0;
+    for (const auto& point_set : point_sets_)
+        point_count += point_set.Num();
+
+    BatchedPoints.Reset(point_count);
+    for (const auto& point_set : point_sets_)
+        BatchedPoints.Append(point_set);
+
+    //one scene proxy rebuild for everything added since the last draw
+    MarkRenderStateDirty();
+    dirty_ = false;
+}
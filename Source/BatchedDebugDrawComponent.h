@@ -0,0 +1,58 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/LineBatchComponent.h"
+#include "BatchedDebugDrawComponent.generated.h"
+
+/*
+    Debug points and lines for one source, e.g. one lidar or one vehicle trace, drawn by a single
+    component instead of a DrawDebugPoint/DrawDebugLine call per element. Callers fill whole point
+    sets in bulk and the component hands everything to the renderer at most draw_rate times per
+    second, so the per-element cost is one array write instead of a world lookup and a render
+    state update.
+
+    Point sets are kept in a ring of history size (e.g. the last few lidar scans) and lines in a
+    ring of line capacity, adding beyond either drops the oldest. Everything stays until dropped
+    or cleared, there are no per-element lifetimes to tick.
+*/
+UCLASS()
+class AIRSIM_API UBatchedDebugDrawComponent : public ULineBatchComponent
+{
+    GENERATED_BODY()
+
+public:
+    UBatchedDebugDrawComponent();
+
+    virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+    //times per second changes are sent to the renderer, 0 for every frame
+    void setDrawRate(float draw_rate);
+    void setPointHistory(int32 history);
+    void setLineCapacity(int32 capacity);
+
+    //true if changes made now would be drawn this frame, lets callers skip building point sets that
+    //a newer one would replace before they are drawn
+    bool isDrawDue() const;
+
+    //empty point set replacing the oldest one if history is full, for the caller to fill
+    TArray<FBatchedPoint>& addPointSet();
+    void addLine(const FVector& start, const FVector& end, const FColor& color, float thickness);
+
+    void clearPoints();
+    void clearLines();
+
+private:
+    void flush();
+
+private:
+    float draw_interval_ = 0;
+    float time_since_draw_ = 0;
+    bool dirty_ = false;
+
+    TArray<TArray<FBatchedPoint>> point_sets_;
+    int32 point_history_ = 1;
+    int32 next_point_set_ = 0;
+
+    int32 line_capacity_ = 10000;
+    int32 next_line_ = 0;
+};
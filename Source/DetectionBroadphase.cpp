@@ -0,0 +1,216 @@
+#include "DetectionBroadphase.h"
+
+#include "CoreGlobals.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "ObjectNameIndex.h"
+
+std::map<const UWorld*, std::unique_ptr<DetectionBroadphase>> DetectionBroadphase::broadphases_;
+
+DetectionBroadphase& DetectionBroadphase::get(UWorld* world)
+{
+    static bool cleanup_registered = false;
+    if (!cleanup_registered) {
+        FWorldDelegates::OnWorldCleanup.AddStatic(&DetectionBroadphase::onWorldCleanup);
+        cleanup_registered = true;
+    }
+
+    std::unique_ptr<DetectionBroadphase>& broadphase = broadphases_[world];
+    if (broadphase == nullptr)
+        broadphase.reset(new DetectionBroadphase(world));
+    return *broadphase;
+}
+
+DetectionBroadphase::DetectionBroadphase(UWorld* world)
+    : world_(world)
+{
+    actor_spawned_handle_ = world->AddOnActorSpawnedHandler(
+        FOnActorSpawned::FDelegate::CreateRaw(this, &DetectionBroadphase::onActorSpawned));
+    level_added_handle_ = FWorldDelegates::LevelAddedToWorld.AddRaw(this, &DetectionBroadphase::onLevelAdded);
+}
+
+DetectionBroadphase::~DetectionBroadphase()
+{
+    if (world_.IsValid())
+        world_->RemoveOnActorSpawnedHandler(actor_spawned_handle_);
+    FWorldDelegates::LevelAddedToWorld.Remove(level_added_handle_);
+}
+
+void DetectionBroadphase::query(const FObjectFilter& filter, const FConvexVolume& frustum, const FVector& view_location,
+                                float max_distance, TArray<Candidate>& candidates)
+{
+    FilterSet& filter_set = getFilterSet(filter);
+    update(filter_set);
+
+    const float max_distance_squared = max_distance * max_distance;
+    auto isBoxInView = [&frustum, &view_location, max_distance_squared](const FBox& box) {
+        return box.ComputeSquaredDistanceToPoint(view_location) <= max_distance_squared &&
+               frustum.IntersectBox(box.GetCenter(), box.GetExtent());
+    };
+    auto addCandidate = [&filter_set, &candidates](int32 index) {
+        const Member& member = filter_set.members[index];
+        if (AActor* actor = member.actor.Get())
+            candidates.Add(Candidate{ actor, member.bounds });
+    };
+
+    filter_set.tree.query(isBoxInView, addCandidate);
+}
+
+void DetectionBroadphase::refreshActor(AActor* actor)
+{
+    for (auto& filter_set : filter_sets_)
+        testActor(*filter_set, actor);
+}
+
+DetectionBroadphase::FilterSet& DetectionBroadphase::getFilterSet(const FObjectFilter& filter)
+{
+    FilterSet* found = nullptr;
+    for (auto it = filter_sets_.begin(); it != filter_sets_.end();) {
+        FilterSet& filter_set = **it;
+        if (filter_set.filter == filter) {
+            found = &filter_set;
+            ++it;
+        }
+        else if (filter_set.used_frame + kUnusedFrames < GFrameCounter)
+            it = filter_sets_.erase(it);
+        else
+            ++it;
+    }
+
+    if (found == nullptr) {
+        filter_sets_.emplace_back(new FilterSet());
+        found = filter_sets_.back().get();
+        found->filter = filter;
+        populate(*found);
+    }
+
+    found->used_frame = GFrameCounter;
+    return *found;
+}
+
+void DetectionBroadphase::populate(FilterSet& filter_set)
+{
+    if (!world_.IsValid())
+        return;
+
+    const FObjectFilter& filter = filter_set.filter;
+    if (filter.actor_instance_) {
+        testActor(filter_set, filter.actor_instance_);
+    }
+    else if (filter.isNameOnly()) {
+        //only actors whose name or mesh names match can pass the filter
+        TSet<AActor*> matches;
+        ObjectNameIndex& name_index = ObjectNameIndex::get(world_.Get());
+        for (const FString& wildcard_mesh_name : filter.wildcard_mesh_names_) {
+            const auto pattern = msr::airlib::NamePattern::compile(TCHAR_TO_UTF8(*wildcard_mesh_name),
+                                                                   msr::airlib::NamePattern::Syntax::Wildcard,
+                                                                   true);
+            name_index.findActors(*pattern, true, matches);
+        }
+        for (AActor* actor : matches)
+            testActor(filter_set, actor);
+    }
+    else {
+        for (TActorIterator<AActor> actor_itr(world_.Get()); actor_itr; ++actor_itr)
+            testActor(filter_set, *actor_itr);
+    }
+
+    filter_set.updated_frame = GFrameCounter;
+}
+
+void DetectionBroadphase::update(FilterSet& filter_set)
+{
+    if (filter_set.updated_frame == GFrameCounter)
+        return;
+    filter_set.updated_frame = GFrameCounter;
+
+    for (int32 index = filter_set.members.Num() - 1; index >= 0; --index) {
+        Member& member = filter_set.members[index];
+        const AActor* actor = member.actor.Get();
+        if (actor == nullptr)
+            removeMember(filter_set, index);
+        else if (member.is_movable) {
+            member.bounds = getBounds(actor);
+            filter_set.tree.moveLeaf(member.leaf, member.bounds + actor->GetActorLocation());
+        }
+    }
+}
+
+void DetectionBroadphase::testActor(FilterSet& filter_set, AActor* actor)
+{
+    if (actor == nullptr || actor->IsPendingKill())
+        return;
+
+    int32 index = INDEX_NONE;
+    if (const int32* found = filter_set.member_indexes.Find(actor)) {
+        index = *found;
+        //an actor destroyed since may have left its address to this one
+        if (filter_set.members[index].actor.Get() != actor) {
+            removeMember(filter_set, index);
+            index = INDEX_NONE;
+        }
+    }
+
+    const bool is_match = filter_set.filter.matchesActor(actor);
+    if (is_match && index == INDEX_NONE)
+        addMember(filter_set, actor);
+    else if (!is_match && index != INDEX_NONE)
+        removeMember(filter_set, index);
+}
+
+void DetectionBroadphase::addMember(FilterSet& filter_set, AActor* actor)
+{
+    const USceneComponent* root = actor->GetRootComponent();
+
+    Member member;
+    member.actor = actor;
+    member.key = actor;
+    member.bounds = getBounds(actor);
+    member.is_movable = root == nullptr || root->Mobility != EComponentMobility::Static;
+
+    const int32 index = filter_set.members.Num();
+    //tree boxes include the actor location, which the distance cutoff is measured from
+    member.leaf = filter_set.tree.createLeaf(member.bounds + actor->GetActorLocation(), index);
+    filter_set.members.Add(member);
+    filter_set.member_indexes.Add(actor, index);
+}
+
+void DetectionBroadphase::removeMember(FilterSet& filter_set, int32 index)
+{
+    TArray<Member>& members = filter_set.members;
+    filter_set.tree.destroyLeaf(members[index].leaf);
+
+    filter_set.member_indexes.Remove(members[index].key);
+
+    const int32 last = members.Num() - 1;
+    if (index != last) {
+        members[index] = members[last];
+        filter_set.tree.setUserData(members[index].leaf, index);
+        filter_set.member_indexes.Add(members[index].key, index);
+    }
+    members.RemoveAt(last, 1, false);
+}
+
+FBox DetectionBroadphase::getBounds(const AActor* actor)
+{
+    //same box detections report, from the components' cached bounds
+    return actor->GetComponentsBoundingBox(true);
+}
+
+void DetectionBroadphase::onActorSpawned(AActor* actor)
+{
+    refreshActor(actor);
+}
+
+void DetectionBroadphase::onLevelAdded(ULevel* level, UWorld* world)
+{
+    if (level == nullptr || world != world_.Get())
+        return;
+    for (AActor* actor : level->Actors)
+        refreshActor(actor);
+}
+
+void DetectionBroadphase::onWorldCleanup(UWorld* world, bool session_ended, bool cleanup_resources)
+{
+    broadphases_.erase(world);
+}
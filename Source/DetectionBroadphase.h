@@ -0,0 +1,92 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "ConvexVolume.h"
+
+#include <map>
+#include <memory>
+#include <vector>
+#include "AabbTree.h"
+#include "ObjectFilter.h"
+
+/*
+    Actors matching detection filters, kept with their bounds in an AabbTree per distinct filter
+    so detection queries look only at actors that can be in view instead of every actor in the
+    world. All detection components using the same filter share its tree, and the tree is brought
+    up to date at most once per frame however many cameras query it.
+
+    Filter membership is computed when a filter is first used and kept current as actors spawn
+    and levels stream in. Only movable actors have their bounds refreshed each frame. Trees for
+    filters no camera asked for in a while are dropped.
+
+    Game thread only.
+*/
+class DetectionBroadphase
+{
+public:
+    struct Candidate
+    {
+        AActor* actor;
+        FBox bounds;
+    };
+
+    static DetectionBroadphase& get(UWorld* world);
+
+    ~DetectionBroadphase();
+
+    //actors matching filter whose bounds may intersect frustum and come within max_distance of
+    //view_location, the caller does the exact tests
+    void query(const FObjectFilter& filter, const FConvexVolume& frustum, const FVector& view_location,
+               float max_distance, TArray<Candidate>& candidates);
+
+    //for actors whose components or meshes changed after they were spawned
+    void refreshActor(AActor* actor);
+
+private:
+    struct Member
+    {
+        TWeakObjectPtr<AActor> actor;
+        const AActor* key; //in member_indexes, kept to remove the entry once the actor is gone
+        FBox bounds;
+        int32 leaf;
+        bool is_movable;
+    };
+
+    struct FilterSet
+    {
+        FObjectFilter filter;
+        AabbTree tree;
+        TArray<Member> members;
+        TMap<const AActor*, int32> member_indexes;
+        uint64 updated_frame = 0;
+        uint64 used_frame = 0;
+    };
+
+    explicit DetectionBroadphase(UWorld* world);
+
+    FilterSet& getFilterSet(const FObjectFilter& filter);
+    void populate(FilterSet& filter_set);
+    void update(FilterSet& filter_set);
+    void testActor(FilterSet& filter_set, AActor* actor);
+    void addMember(FilterSet& filter_set, AActor* actor);
+    void removeMember(FilterSet& filter_set, int32 index);
+
+    void onActorSpawned(AActor* actor);
+    void onLevelAdded(ULevel* level, UWorld* world);
+
+    static FBox getBounds(const AActor* actor);
+    static void onWorldCleanup(UWorld* world, bool session_ended, bool cleanup_resources);
+
+private:
+    //frames a filter can go unused before its tree is dropped
+    static constexpr uint64 kUnusedFrames = 600;
+
+    TWeakObjectPtr<UWorld> world_;
+    FDelegateHandle actor_spawned_handle_;
+    FDelegateHandle level_added_handle_;
+
+    std::vector<std::unique_ptr<FilterSet>> filter_sets_;
+
+    static std::map<const UWorld*, std::unique_ptr<DetectionBroadphase>> broadphases_;
+};
@@ -1,21 +1,31 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "DetectionComponent.h"
+#include "DetectionBroadphase.h"
 
+#include <Async/ParallelFor.h>
 #include <Components/SceneCaptureComponent2D.h>
 #include <Components/StaticMeshComponent.h>
 #include <DrawDebugHelpers.h>
 #include <Engine/Engine.h>
 #include <Engine/StaticMesh.h>
 #include <Engine/TextureRenderTarget2D.h>
+#include <SceneManagement.h>
 #include <EngineUtils.h>
 #include <Math/UnrealMathUtility.h>
 #include <Kismet/KismetSystemLibrary.h>
 #include <Kismet/KismetMathLibrary.h>
 #include <Engine/EngineTypes.h>
 
+const FVector UDetectionComponent::kBoxCorners[8] = {
+    FVector(1, 1, 1), FVector(-1, 1, 1), FVector(1, -1, 1), FVector(-1, -1, 1),
+    FVector(1, 1, -1), FVector(-1, 1, -1), FVector(1, -1, -1), FVector(-1, -1, -1)
+};
+
 UDetectionComponent::UDetectionComponent()
     : max_distance_to_camera_(20000.f)
+    , cached_frame_(0)
+    , cached_max_distance_(0)
 {
     // Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
     // off to improve performance if you don't need them.
@@ -37,45 +47,82 @@ void UDetectionComponent::TickComponent(float DeltaTime, ELevelTick TickType, FA
 
 const TArray<FDetectionInfo>& UDetectionComponent::getDetections()
 {
+    if (!texture_target_) {
+        cached_detections_.Empty();
+        return cached_detections_;
+    }
+
+    const FMatrix view_projection = getViewProjectionMatrix();
+    const FTransform component_transform = GetComponentTransform();
+
+    // Repeated requests within a frame for an unchanged view get the same detections
+    if (cached_frame_ == GFrameCounter && cached_filter_ == object_filter_ &&
+        cached_max_distance_ == max_distance_to_camera_ && cached_view_projection_.Equals(view_projection, 0) &&
+        cached_transform_.Equals(component_transform, 0)) {
+        return cached_detections_;
+    }
+    cached_frame_ = GFrameCounter;
+    cached_filter_ = object_filter_;
+    cached_max_distance_ = max_distance_to_camera_;
+    cached_view_projection_ = view_projection;
+    cached_transform_ = component_transform;
+
     cached_detections_.Empty();
 
-    for (TActorIterator<AActor> actor_itr(GetWorld()); actor_itr; ++actor_itr) {
-        AActor* actor = *actor_itr;
-        if (object_filter_.matchesActor(actor)) {
-            if (FVector::Distance(actor->GetActorLocation(), GetComponentLocation()) <= max_distance_to_camera_) {
-                FBox2D box_2D_out;
-                if (texture_target_ && calcBoundingFromViewInfo(actor, box_2D_out)) {
-                    FDetectionInfo detection;
-                    detection.Actor = actor;
-                    detection.Box2D = box_2D_out;
-
-                    FBox box_3D = actor->GetComponentsBoundingBox(true);
-                    detection.Box3D = FBox(getRelativeLocation(box_3D.Min), getRelativeLocation(box_3D.Max));
-
-                    detection.RelativeTransform = FTransform(getRelativeRotation(actor->GetActorLocation(), actor->GetActorRotation()),
-                                                             getRelativeLocation(actor->GetActorLocation()));
-                    cached_detections_.Add(detection);
-                }
+    // Only filtered actors whose bounds can be in the view frustum and within range
+    FConvexVolume frustum;
+    GetViewFrustumBounds(frustum, view_projection, false);
+    const FVector view_location = GetComponentLocation();
+    TArray<DetectionBroadphase::Candidate> candidates;
+    DetectionBroadphase::get(GetWorld()).query(object_filter_, frustum, view_location, max_distance_to_camera_, candidates);
+
+    TArray<int32> in_view;
+    TArray<FBox2D> boxes_2D;
+    TArray<int32> seeds;
+    for (int32 i = 0; i < candidates.Num(); i++) {
+        const DetectionBroadphase::Candidate& candidate = candidates[i];
+        if (FVector::Distance(candidate.actor->GetActorLocation(), view_location) <= max_distance_to_camera_) {
+            FBox2D box_2D_out;
+            if (calcBoundingFromViewInfo(candidate.bounds, view_projection, box_2D_out)) {
+                in_view.Add(i);
+                boxes_2D.Add(box_2D_out);
+                seeds.Add(FMath::Rand());
             }
         }
     }
 
-    return cached_detections_;
-}
+    // Visibility traces for all actors in view at once, spread over worker threads
+    TArray<bool> is_visible;
+    is_visible.SetNumZeroed(in_view.Num());
+    ParallelFor(
+        in_view.Num(), [&](int32 i) {
+            const DetectionBroadphase::Candidate& candidate = candidates[in_view[i]];
+            is_visible[i] = isVisible(candidate.actor, candidate.bounds, view_location, seeds[i]);
+        },
+        in_view.Num() < kMinParallelVisibilityTests);
+
+    for (int32 i = 0; i < in_view.Num(); i++) {
+        if (!is_visible[i]) {
+            continue;
+        }
 
-bool UDetectionComponent::calcBoundingFromViewInfo(AActor* actor, FBox2D& box_out)
-{
-    FVector origin;
-    FVector extend;
-    actor->GetActorBounds(false, origin, extend);
+        const DetectionBroadphase::Candidate& candidate = candidates[in_view[i]];
+        AActor* actor = candidate.actor;
 
-    TArray<FVector> points;
-    TArray<FVector2D> points_2D;
-    bool is_in_camera_view = false;
+        FDetectionInfo detection;
+        detection.Actor = actor;
+        detection.Box2D = boxes_2D[i];
+        detection.Box3D = FBox(getRelativeLocation(candidate.bounds.Min), getRelativeLocation(candidate.bounds.Max));
+        detection.RelativeTransform = FTransform(getRelativeRotation(actor->GetActorLocation(), actor->GetActorRotation()),
+                                                 getRelativeLocation(actor->GetActorLocation()));
+        cached_detections_.Add(detection);
+    }
 
-    // get render target for texture size
-    FRenderTarget* render_target = texture_target_->GameThread_GetRenderTargetResource();
+    return cached_detections_;
+}
 
+FMatrix UDetectionComponent::getViewProjectionMatrix() const
+{
     // initialize viewinfo for projection matrix
     FMinimalViewInfo info;
     info.Location = scene_capture_component_2D_->GetComponentTransform().GetLocation();
@@ -87,19 +134,6 @@ bool UDetectionComponent::calcBoundingFromViewInfo(AActor* actor, FBox2D& box_ou
     info.OrthoFarClipPlane = 100000;
     info.bConstrainAspectRatio = true;
 
-    // calculate 3D corner Points of bounding box
-    points.Add(origin + FVector(extend.X, extend.Y, extend.Z));
-    points.Add(origin + FVector(-extend.X, extend.Y, extend.Z));
-    points.Add(origin + FVector(extend.X, -extend.Y, extend.Z));
-    points.Add(origin + FVector(-extend.X, -extend.Y, extend.Z));
-    points.Add(origin + FVector(extend.X, extend.Y, -extend.Z));
-    points.Add(origin + FVector(-extend.X, extend.Y, -extend.Z));
-    points.Add(origin + FVector(extend.X, -extend.Y, -extend.Z));
-    points.Add(origin + FVector(-extend.X, -extend.Y, -extend.Z));
-
-    // initialize pixel values
-    FVector2D min_pixel(texture_target_->SizeX, texture_target_->SizeY);
-    FVector2D max_pixel(0, 0);
     FIntRect screen_rect(0, 0, texture_target_->SizeX, texture_target_->SizeY);
 
     // initialize projection data for sceneview
@@ -121,50 +155,33 @@ bool UDetectionComponent::calcBoundingFromViewInfo(AActor* actor, FBox2D& box_ou
     }
     projection_data.SetConstrainedViewRectangle(screen_rect);
 
-    // Project Points to pixels and get the corner pixels
-    for (FVector& point : points) {
+    return projection_data.ComputeViewProjectionMatrix();
+}
+
+bool UDetectionComponent::calcBoundingFromViewInfo(const FBox& bounds, const FMatrix& view_projection, FBox2D& box_out) const
+{
+    FVector origin;
+    FVector extend;
+    bounds.GetCenterAndExtents(origin, extend);
+
+    bool is_in_camera_view = false;
+
+    // initialize pixel values
+    FVector2D min_pixel(texture_target_->SizeX, texture_target_->SizeY);
+    FVector2D max_pixel(0, 0);
+    FIntRect screen_rect(0, 0, texture_target_->SizeX, texture_target_->SizeY);
+
+    // Project corner points of bounding box to pixels and get the corner pixels
+    for (const FVector& corner : kBoxCorners) {
         FVector2D Pixel(0, 0);
-        FSceneView::ProjectWorldToScreen((point), screen_rect, projection_data.ComputeViewProjectionMatrix(), Pixel);
+        FSceneView::ProjectWorldToScreen(origin + corner * extend, screen_rect, view_projection, Pixel);
         is_in_camera_view |= (Pixel != screen_rect.Min) && (Pixel != screen_rect.Max) && screen_rect.Contains(FIntPoint(Pixel.X, Pixel.Y));
-        points_2D.Add(Pixel);
         max_pixel.X = FMath::Max(Pixel.X, max_pixel.X);
         max_pixel.Y = FMath::Max(Pixel.Y, max_pixel.Y);
         min_pixel.X = FMath::Min(Pixel.X, min_pixel.X);
         min_pixel.Y = FMath::Min(Pixel.Y, min_pixel.Y);
     }
 
-    // If actor in camera view - check if it's actually visible or hidden
-    // Check against 8 extend points
-    bool is_visible = false;
-    if (is_in_camera_view) {
-        FHitResult result;
-        bool is_world_hit;
-        for (FVector& point : points) {
-            is_world_hit = GetWorld()->LineTraceSingleByChannel(result, GetComponentLocation(), point, ECC_WorldStatic);
-            if (is_world_hit) {
-                if (result.Actor == actor) {
-                    is_visible = true;
-                    break;
-                }
-            }
-        }
-
-        // If actor in camera view but didn't hit any point out of 8 extend points,
-        // check against 10 random points
-        if (!is_visible) {
-            for (int i = 0; i < 10; i++) {
-                FVector point = UKismetMathLibrary::RandomPointInBoundingBox(origin, extend);
-                is_world_hit = GetWorld()->LineTraceSingleByChannel(result, GetComponentLocation(), point, ECC_WorldStatic);
-                if (is_world_hit) {
-                    if (result.Actor == actor) {
-                        is_visible = true;
-                        break;
-                    }
-                }
-            }
-        }
-    }
-
     FBox2D box_out_temp = FBox2D(min_pixel, max_pixel);
 
     box_out.Min.X = FMath::Clamp<float>(box_out_temp.Min.X, 0, texture_target_->SizeX);
@@ -172,7 +189,41 @@ bool UDetectionComponent::calcBoundingFromViewInfo(AActor* actor, FBox2D& box_ou
     box_out.Max.X = FMath::Clamp<float>(box_out_temp.Max.X, 0, texture_target_->SizeX);
     box_out.Max.Y = FMath::Clamp<float>(box_out_temp.Max.Y, 0, texture_target_->SizeY);
 
-    return is_in_camera_view && is_visible;
+    return is_in_camera_view;
+}
+
+bool UDetectionComponent::isVisible(const AActor* actor, const FBox& bounds, const FVector& view_location, int32 seed) const
+{
+    // Runs on worker threads: scene queries may run concurrently while the game thread waits,
+    // the same way the engine runs async traces
+    UWorld* world = GetWorld();
+    FVector origin;
+    FVector extend;
+    bounds.GetCenterAndExtents(origin, extend);
+
+    FHitResult result;
+    auto isActorHit = [&](const FVector& point) {
+        return world->LineTraceSingleByChannel(result, view_location, point, ECC_WorldStatic) && result.Actor == actor;
+    };
+
+    // Check against 8 extend points
+    for (const FVector& corner : kBoxCorners) {
+        if (isActorHit(origin + corner * extend)) {
+            return true;
+        }
+    }
+
+    // If actor in camera view but didn't hit any point out of 8 extend points,
+    // check against 10 random points
+    FRandomStream random(seed);
+    for (int i = 0; i < 10; i++) {
+        const FVector point = origin + extend * FVector(random.FRandRange(-1, 1), random.FRandRange(-1, 1), random.FRandRange(-1, 1));
+        if (isActorHit(point)) {
+            return true;
+        }
+    }
+
+    return false;
 }
 
 FVector UDetectionComponent::getRelativeLocation(FVector in_location)
@@ -45,7 +45,11 @@ public:
     const TArray<FDetectionInfo>& getDetections();
 
 private:
-    bool calcBoundingFromViewInfo(AActor* actor, FBox2D& box_out);
+    FMatrix getViewProjectionMatrix() const;
+
+    bool calcBoundingFromViewInfo(const FBox& bounds, const FMatrix& view_projection, FBox2D& box_out) const;
+
+    bool isVisible(const AActor* actor, const FBox& bounds, const FVector& view_location, int32 seed) const;
 
     FVector getRelativeLocation(FVector in_location);
 
@@ -67,4 +71,15 @@ private:
 
     UPROPERTY()
     TArray<FDetectionInfo> cached_detections_;
+
+    // What cached_detections_ were computed for
+    uint64 cached_frame_;
+    FObjectFilter cached_filter_;
+    float cached_max_distance_;
+    FMatrix cached_view_projection_;
+    FTransform cached_transform_;
+
+    // Fewer actors than this to test for visibility are traced on the calling thread
+    static constexpr int32 kMinParallelVisibilityTests = 4;
+    static const FVector kBoxCorners[8];
 };
@@ -162,6 +162,12 @@ bool FObjectFilter::isMatchAnyWildcard(FString component_name) const
     return false;
 }
 
+bool FObjectFilter::isNameOnly() const
+{
+    return !static_mesh_ && !skeletal_mesh_ && !actor_class_ && !component_class_ &&
+           actor_tag_.IsNone() && component_tag_.IsNone() && !actor_instance_;
+}
+
 bool operator==(const FObjectFilter& x, const FObjectFilter& y)
 {
     // Check pointer equality first for performance
@@ -54,6 +54,10 @@ struct AIRSIM_API FObjectFilter
 
     bool isMatchAnyWildcard(FString component_name) const;
 
+    /* True if actor and mesh names are all that can make an actor match, so
+     * matches can be looked up by name instead of testing every actor. */
+    bool isNameOnly() const;
+
     friend bool operator==(const FObjectFilter& x, const FObjectFilter& y);
 
     friend uint32 getTypeHash(const FObjectFilter& key);
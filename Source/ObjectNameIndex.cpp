@@ -0,0 +1,166 @@
+#include "ObjectNameIndex.h"
+
+#include "Components/SkeletalMeshComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "AirBlueprintLib.h"
+
+std::map<const UWorld*, std::unique_ptr<ObjectNameIndex>> ObjectNameIndex::indexes_;
+
+namespace
+{
+std::string toStdString(const FString& str)
+{
+    return std::string(TCHAR_TO_UTF8(*str));
+}
+
+//objects destroyed since they were indexed are dropped when a query comes across them
+template <typename T>
+void removeDead(std::vector<TWeakObjectPtr<T>>& objects)
+{
+    objects.erase(std::remove_if(objects.begin(), objects.end(), [](const TWeakObjectPtr<T>& object) { return !object.IsValid(); }),
+                  objects.end());
+}
+}
+
+ObjectNameIndex& ObjectNameIndex::get(UWorld* world)
+{
+    static bool cleanup_registered = false;
+    if (!cleanup_registered) {
+        FWorldDelegates::OnWorldCleanup.AddStatic(&ObjectNameIndex::onWorldCleanup);
+        cleanup_registered = true;
+    }
+
+    std::unique_ptr<ObjectNameIndex>& index = indexes_[world];
+    if (index == nullptr)
+        index.reset(new ObjectNameIndex(world));
+    else if (index->mesh_naming_method_ != UAirBlueprintLib::GetMeshNamingMethod())
+        index->rebuild(); //mesh names depend on the naming method
+    return *index;
+}
+
+ObjectNameIndex::ObjectNameIndex(UWorld* world)
+    : world_(world)
+{
+    actor_spawned_handle_ = world->AddOnActorSpawnedHandler(
+        FOnActorSpawned::FDelegate::CreateRaw(this, &ObjectNameIndex::onActorSpawned));
+    level_added_handle_ = FWorldDelegates::LevelAddedToWorld.AddRaw(this, &ObjectNameIndex::onLevelAdded);
+
+    rebuild();
+}
+
+ObjectNameIndex::~ObjectNameIndex()
+{
+    if (world_.IsValid())
+        world_->RemoveOnActorSpawnedHandler(actor_spawned_handle_);
+    FWorldDelegates::LevelAddedToWorld.Remove(level_added_handle_);
+}
+
+void ObjectNameIndex::forEachMesh(const NamePattern& pattern, const std::function<void(UPrimitiveComponent*)>& component_func,
+                                  const std::function<void(ALandscapeProxy*)>& landscape_func)
+{
+    mesh_components_.forEachMatch(pattern, [&component_func](const std::string&, std::vector<TWeakObjectPtr<UPrimitiveComponent>>& components) {
+        removeDead(components);
+        for (const auto& component : components)
+            component_func(component.Get());
+    });
+    landscapes_.forEachMatch(pattern, [&landscape_func](const std::string&, std::vector<TWeakObjectPtr<ALandscapeProxy>>& landscapes) {
+        removeDead(landscapes);
+        for (const auto& landscape : landscapes)
+            landscape_func(landscape.Get());
+    });
+}
+
+void ObjectNameIndex::findActors(const NamePattern& pattern, bool with_mesh_names, TSet<AActor*>& actors)
+{
+    auto addActors = [&actors](const std::string&, std::vector<TWeakObjectPtr<AActor>>& matches) {
+        removeDead(matches);
+        for (const auto& actor : matches)
+            actors.Add(actor.Get());
+    };
+
+    actors_.forEachMatch(pattern, addActors);
+    if (with_mesh_names)
+        actor_meshes_.forEachMatch(pattern, addActors);
+}
+
+void ObjectNameIndex::refreshActor(AActor* actor)
+{
+    indexActor(actor, true);
+}
+
+void ObjectNameIndex::rebuild()
+{
+    mesh_naming_method_ = UAirBlueprintLib::GetMeshNamingMethod();
+
+    mesh_components_.clear();
+    landscapes_.clear();
+    actors_.clear();
+    actor_meshes_.clear();
+
+    if (!world_.IsValid())
+        return;
+    for (TActorIterator<AActor> actor_itr(world_.Get()); actor_itr; ++actor_itr)
+        indexActor(*actor_itr, false);
+}
+
+void ObjectNameIndex::indexActor(AActor* actor, bool refresh)
+{
+    if (actor == nullptr)
+        return;
+
+    //a refresh adds only what isn't there yet, the initial build can skip the check
+    actors_.add(toStdString(actor->GetName()), actor, refresh);
+
+    if (ALandscapeProxy* landscape = Cast<ALandscapeProxy>(actor)) {
+        const std::string mesh_name = UAirBlueprintLib::GetMeshName(landscape);
+        if (mesh_name != "")
+            landscapes_.add(mesh_name, landscape, refresh);
+    }
+
+    TInlineComponentArray<UActorComponent*> components;
+    actor->GetComponents(components);
+    for (UActorComponent* component : components) {
+        std::string mesh_name;
+        UPrimitiveComponent* mesh_component = nullptr;
+
+        if (UStaticMeshComponent* static_mesh_component = Cast<UStaticMeshComponent>(component)) {
+            mesh_name = UAirBlueprintLib::GetMeshName(static_mesh_component);
+            mesh_component = static_mesh_component;
+            if (static_mesh_component->GetStaticMesh() != nullptr)
+                actor_meshes_.add(toStdString(static_mesh_component->GetStaticMesh()->GetName()), actor, refresh);
+        }
+        else if (USkinnedMeshComponent* skinned_mesh_component = Cast<USkinnedMeshComponent>(component)) {
+            mesh_name = UAirBlueprintLib::GetMeshName(skinned_mesh_component);
+            mesh_component = skinned_mesh_component;
+            USkeletalMeshComponent* skeletal_mesh_component = Cast<USkeletalMeshComponent>(component);
+            if (skeletal_mesh_component != nullptr && skeletal_mesh_component->SkeletalMesh != nullptr)
+                actor_meshes_.add(toStdString(skeletal_mesh_component->SkeletalMesh->GetName()), actor, refresh);
+        }
+
+        if (mesh_component != nullptr && mesh_name != "")
+            mesh_components_.add(mesh_name, mesh_component, refresh);
+    }
+}
+
+void ObjectNameIndex::onActorSpawned(AActor* actor)
+{
+    indexActor(actor, false);
+}
+
+void ObjectNameIndex::onLevelAdded(ULevel* level, UWorld* world)
+{
+    //streamed in levels bring actors that were never spawned in this world
+    if (level == nullptr || world != world_.Get())
+        return;
+    for (AActor* actor : level->Actors)
+        indexActor(actor, true);
+}
+
+void ObjectNameIndex::onWorldCleanup(UWorld* world, bool session_ended, bool cleanup_resources)
+{
+    indexes_.erase(world);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "Components/PrimitiveComponent.h"
+#include "LandscapeProxy.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include "common/NameIndex.hpp"
+#include "common/AirSimSettings.hpp"
+
+/*
+    Names of the scene objects API calls look up by pattern, so segmentation ID and detection
+    filter queries touch only the objects whose names can match instead of every object in the
+    world. One index per world, built on first use and kept current as actors spawn and levels
+    stream in. Objects destroyed since are skipped and dropped as queries come across them.
+
+    Indexed names:
+    - mesh names as UAirBlueprintLib::GetMeshName gives them for static and skinned mesh
+      components and landscapes, for segmentation IDs
+    - actor names
+    - names of the static and skeletal mesh assets actors use, for detection filters
+
+    Game thread only.
+*/
+class ObjectNameIndex
+{
+public:
+    typedef msr::airlib::NamePattern NamePattern;
+
+    static ObjectNameIndex& get(UWorld* world);
+
+    ~ObjectNameIndex();
+
+    //calls func for each live mesh component or landscape whose mesh name matches
+    void forEachMesh(const NamePattern& pattern, const std::function<void(UPrimitiveComponent*)>& component_func,
+                     const std::function<void(ALandscapeProxy*)>& landscape_func);
+    //live actors whose name or, if with_mesh_names, one of whose mesh asset names matches
+    void findActors(const NamePattern& pattern, bool with_mesh_names, TSet<AActor*>& actors);
+
+    //for actors whose components or meshes changed after they were spawned
+    void refreshActor(AActor* actor);
+
+private:
+    explicit ObjectNameIndex(UWorld* world);
+
+    void rebuild();
+    void indexActor(AActor* actor, bool refresh);
+    void onActorSpawned(AActor* actor);
+    void onLevelAdded(ULevel* level, UWorld* world);
+
+    static void onWorldCleanup(UWorld* world, bool session_ended, bool cleanup_resources);
+
+private:
+    TWeakObjectPtr<UWorld> world_;
+    FDelegateHandle actor_spawned_handle_;
+    FDelegateHandle level_added_handle_;
+    msr::airlib::AirSimSettings::SegmentationSetting::MeshNamingMethodType mesh_naming_method_;
+
+    msr::airlib::NameIndex<TWeakObjectPtr<UPrimitiveComponent>> mesh_components_;
+    msr::airlib::NameIndex<TWeakObjectPtr<ALandscapeProxy>> landscapes_;
+    msr::airlib::NameIndex<TWeakObjectPtr<AActor>> actors_;
+    msr::airlib::NameIndex<TWeakObjectPtr<AActor>> actor_meshes_;
+
+    static std::map<const UWorld*, std::unique_ptr<ObjectNameIndex>> indexes_;
+};
@@ -10,6 +10,8 @@
 #include "PIPCamera.h"
 #include "NedTransform.h"
 #include "common/EarthUtils.hpp"
+#include "safety/CubeGeoFence.hpp"
+#include "PhysicalMaterials/PhysicalMaterial.h"
 
 #include "Materials/MaterialParameterCollectionInstance.h"
 #include "DrawDebugHelpers.h"
@@ -29,7 +31,10 @@ void PawnSimApi::initialize()
     Environment::State initial_environment;
     initial_environment.position = initial_kinematic_state.pose.position;
     initial_environment.geo_point = params_.home_geopoint;
-    environment_.reset(new Environment(initial_environment));
+    environment_.reset(new Environment());
+    environment_->setTerrain(params_.terrain);
+    environment_->setTolerance(AirSimSettings::singleton().environment_tolerance);
+    environment_->initialize(initial_environment);
 
     //initialize state
     params_.pawn->GetActorBounds(true, initial_state_.mesh_origin, initial_state_.mesh_bounds);
@@ -51,6 +56,17 @@ void PawnSimApi::initialize()
 
     setupCamerasFromSettings(params_.cameras);
     image_capture_.reset(new UnrealImageCapture(&cameras_));
+    if (params_.cpu_rasterizer) {
+        cpu_image_capture_ = std::make_shared<msr::airlib::CpuImageCapture>(params_.cpu_rasterizer, params_.segmentation_palette,
+                                                                            AirSimSettings::singleton().cpu_image_capture.thread_count);
+        updateCpuImageEffects();
+        image_capture_->setCpuCapture(cpu_image_capture_, params_.global_transform);
+    }
+
+    trace_draw_ = NewObject<UBatchedDebugDrawComponent>(params_.pawn);
+    trace_draw_->setDrawRate(AirSimSettings::singleton().debug_draw_rate);
+    trace_draw_->setLineCapacity(kTraceSegments);
+    trace_draw_->RegisterComponent();
 
     //add listener for pawn's collision event
     params_.pawn_events->getCollisionSignal().connect_member(this, &PawnSimApi::onCollision);
@@ -71,6 +87,47 @@ void PawnSimApi::setStartPosition(const FVector& position, const FRotator& rotat
                                                              AirSimSettings::singleton().origin_geopoint);
 }
 
+std::shared_ptr<msr::airlib::SafetyEval> PawnSimApi::createSafetyEval() const
+{
+    typedef msr::airlib::SafetyEval SafetyEval;
+
+    const AirSimSettings::SafetySetting& setting = getVehicleSetting()->safety;
+    if (!setting.enabled)
+        return nullptr;
+
+    msr::airlib::MultirotorApiParams safety_params;
+    safety_params.obs_clearance = setting.obs_clearance;
+
+    //the fence is unbounded until a setSafety call gives it a boundary
+    auto fence = std::make_shared<msr::airlib::CubeGeoFence>(Vector3r(-1E10f, -1E10f, -1E10f),
+                                                             Vector3r(1E10f, 1E10f, 1E10f),
+                                                             safety_params.distance_accuracy);
+    //nothing in the sim feeds the 2D map, obstacles come from the occupancy map when there is one
+    auto obs_xy = std::make_shared<msr::airlib::ObstacleMap>(4);
+    auto safety_eval = std::make_shared<SafetyEval>(safety_params, fence, obs_xy);
+
+    SafetyEval::SafetyViolationType enable_reasons = SafetyEval::SafetyViolationType_::GeoFence;
+    if (setting.occupancy_map) {
+        msr::airlib::OccupancyMap::Params map_params;
+        map_params.resolution = setting.occupancy_resolution;
+        map_params.max_range = setting.occupancy_max_range;
+        safety_eval->setOccupancyMap(std::make_shared<msr::airlib::OccupancyMap>(map_params),
+                                     Utils::degreesToRadians(setting.occupancy_cone_half_angle));
+        enable_reasons |= SafetyEval::SafetyViolationType_::Obstacle;
+    }
+    if (setting.check_terrain && params_.terrain != nullptr) {
+        //same home as the environment so positions map to the ground the physics collides with
+        safety_eval->setTerrain(params_.terrain, environment_->getHomeGeoPoint(), setting.terrain_clearance);
+        enable_reasons |= SafetyEval::SafetyViolationType_::Terrain;
+    }
+
+    //NaN boundary leaves the fence as it is
+    safety_eval->setSafety(enable_reasons, setting.obs_clearance, SafetyEval::ObsAvoidanceStrategy::RaiseException,
+                           VectorMath::nanVector(), Utils::nan<float>(), Utils::nan<float>(), Utils::nan<float>());
+
+    return safety_eval;
+}
+
 void PawnSimApi::pawnTick(float dt)
 {
     //default behavior is to call update every tick
@@ -117,6 +174,26 @@ void PawnSimApi::setupCamerasFromSettings(const common_utils::UniqueValueMap<std
     }
 }
 
+void PawnSimApi::updateCpuImageEffects()
+{
+    //the same noise and distortion the cameras' post process materials put on Unreal captures,
+    //distortion parameters are shared by all cameras like the material parameter collection
+    const auto& camera_defaults = AirSimSettings::singleton().camera_defaults;
+    for (auto& pair : cameras_.getMap()) {
+        const auto& camera_setting = Utils::findOrDefault(getVehicleSetting()->cameras, pair.first, camera_defaults);
+        msr::airlib::ImageEffects::DistortionParams distortion;
+        UMaterialParameterCollectionInstance* distortion_params = pair.second->distortion_param_instance_;
+        if (distortion_params) {
+            distortion_params->GetScalarParameterValue(FName(TEXT("K1")), distortion.K1);
+            distortion_params->GetScalarParameterValue(FName(TEXT("K2")), distortion.K2);
+            distortion_params->GetScalarParameterValue(FName(TEXT("K3")), distortion.K3);
+            distortion_params->GetScalarParameterValue(FName(TEXT("P1")), distortion.P1);
+            distortion_params->GetScalarParameterValue(FName(TEXT("P2")), distortion.P2);
+        }
+        cpu_image_capture_->setCameraEffects(pair.first, camera_setting.noise_settings, distortion);
+    }
+}
+
 void PawnSimApi::createCamerasFromSettings()
 {
     //UStaticMeshComponent* bodyMesh = UAirBlueprintLib::GetActorComponent<UStaticMeshComponent>(this, TEXT("BodyMesh"));
@@ -155,6 +232,11 @@ void PawnSimApi::onCollision(class UPrimitiveComponent* MyComp, class AActor* Ot
 
     UPrimitiveComponent* comp = Cast<class UPrimitiveComponent>(Other ? (Other->GetRootComponent() ? Other->GetRootComponent() : nullptr) : nullptr);
 
+    //physical surface type of what was hit, sweeps don't always return the physical material
+    const UPhysicalMaterial* phys_material = Hit.PhysMaterial.Get();
+    if (phys_material == nullptr && OtherComp != nullptr && OtherComp->GetBodyInstance() != nullptr)
+        phys_material = OtherComp->GetBodyInstance()->GetSimplePhysicalMaterial();
+
     state_.collision_info.has_collided = true;
     state_.collision_info.normal = Vector3r(Hit.ImpactNormal.X, Hit.ImpactNormal.Y, -Hit.ImpactNormal.Z);
     state_.collision_info.impact_point = ned_transform_.toLocalNed(Hit.ImpactPoint);
@@ -163,6 +245,16 @@ void PawnSimApi::onCollision(class UPrimitiveComponent* MyComp, class AActor* Ot
     state_.collision_info.time_stamp = msr::airlib::ClockFactory::get()->nowNanos();
     state_.collision_info.object_name = std::string(Other ? TCHAR_TO_UTF8(*(Other->GetName())) : "(null)");
     state_.collision_info.object_id = comp ? comp->CustomDepthStencilValue : -1;
+    state_.collision_info.material_id = phys_material ? static_cast<int>(phys_material->SurfaceType) : -1;
+
+    //Unreal reports one blocking hit per move, collect the hits of this frame as the contact set
+    if (collision_frame_ != GFrameCounter) {
+        state_.collision_info.contacts.clear();
+        collision_frame_ = GFrameCounter;
+    }
+    if (state_.collision_info.contacts.size() < kMaxContacts)
+        state_.collision_info.contacts.emplace_back(state_.collision_info.normal, state_.collision_info.impact_point,
+                                                    state_.collision_info.penetration_depth, state_.collision_info.material_id);
 
     ++state_.collision_info.collision_count;
 
@@ -338,6 +430,8 @@ void PawnSimApi::resetImplementation()
     params_.pawn->SetActorLocationAndRotation(state_.start_location, state_.start_rotation, false, nullptr, ETeleportType::TeleportPhysics);
     kinematics_->reset();
     environment_->reset();
+    //the world is locked, so neither thread is using it
+    render_inputs_.reset();
 }
 
 void PawnSimApi::update()
@@ -461,7 +555,7 @@ void PawnSimApi::toggleTrace()
     state_.tracing_enabled = !state_.tracing_enabled;
 
     if (!state_.tracing_enabled)
-        UKismetSystemLibrary::FlushPersistentDebugLines(params_.pawn->GetWorld());
+        trace_draw_->clearLines();
     else {
         state_.debug_position_offset = state_.current_debug_position - state_.current_position;
         state_.last_debug_position = state_.last_position;
@@ -537,6 +631,8 @@ void PawnSimApi::setDistortionParam(const std::string& camera_name, const std::s
     UAirBlueprintLib::RunCommandOnGameThread([this, camera_name, param_name, value]() {
         APIPCamera* camera = getCamera(camera_name);
         camera->distortion_param_instance_->SetScalarParameterValue(FName(param_name.c_str()), value);
+        if (cpu_image_capture_)
+            updateCpuImageEffects();
     },
                                              true);
 }
@@ -601,7 +697,7 @@ void PawnSimApi::setPoseInternal(const Pose& pose, bool ignore_collision)
         params_.pawn->SetActorLocationAndRotation(position, orientation, true);
 
     if (state_.tracing_enabled && (state_.last_position - position).SizeSquared() > 0.25) {
-        DrawDebugLine(params_.pawn->GetWorld(), state_.last_position, position, trace_color_, true, -1.0F, 0, trace_thickness_);
+        trace_draw_->addLine(state_.last_position, position, trace_color_, trace_thickness_);
         state_.last_position = position;
     }
     else if (!state_.tracing_enabled) {
@@ -615,7 +711,7 @@ void PawnSimApi::setDebugPose(const Pose& debug_pose)
     if (state_.tracing_enabled && !VectorMath::hasNan(debug_pose.position)) {
         FVector debug_position = state_.current_debug_position - state_.debug_position_offset;
         if ((state_.last_debug_position - debug_position).SizeSquared() > 0.25) {
-            DrawDebugLine(params_.pawn->GetWorld(), state_.last_debug_position, debug_position, FColor(0xaa, 0x33, 0x11), true, -1.0F, 0, 10.0F);
+            trace_draw_->addLine(state_.last_debug_position, debug_position, FColor(0xaa, 0x33, 0x11), 10.0F);
             UAirBlueprintLib::LogMessage(FString("Debug Pose: "), debug_position.ToCompactString(), LogDebugLevel::Informational);
             state_.last_debug_position = debug_position;
         }
@@ -666,6 +762,38 @@ void PawnSimApi::updateRendering(float dt)
     //no default action in this base class
 }
 
+void PawnSimApi::publishRenderInputs()
+{
+    RenderInputs& inputs = render_inputs_.getWriteBuffer();
+    inputs.collision_info = getCollisionInfo();
+    inputs.has_rc_data = getRemoteControlID() >= 0;
+    if (inputs.has_rc_data)
+        inputs.rc_data = getRCData();
+    render_inputs_.publish();
+}
+
+bool PawnSimApi::applyRenderInputs(msr::airlib::PhysicsBody& body, msr::airlib::VehicleApiBase& api)
+{
+    if (!render_inputs_.read())
+        return false;
+
+    const RenderInputs& inputs = render_inputs_.getReadBuffer();
+    body.setCollisionInfo(inputs.collision_info);
+    if (inputs.has_rc_data)
+        api.setRCData(inputs.rc_data);
+    return true;
+}
+
+void PawnSimApi::setRenderInterpolation(bool is_enabled)
+{
+    is_render_interpolated_ = is_enabled;
+}
+
+bool PawnSimApi::isRenderInterpolated() const
+{
+    return is_render_interpolated_;
+}
+
 const msr::airlib::Kinematics::State* PawnSimApi::getGroundTruthKinematics() const
 {
     return &kinematics_->getState();
@@ -4,6 +4,7 @@
 #include "GameFramework/Pawn.h"
 #include "Particles/ParticleSystemComponent.h"
 #include "UnrealImageCapture.h"
+#include "BatchedDebugDrawComponent.h"
 
 #include <vector>
 #include <memory>
@@ -13,12 +14,15 @@
 #include "common/GeodeticConverter.hpp"
 #include "PIPCamera.h"
 #include "physics/Kinematics.hpp"
+#include "physics/PhysicsBody.hpp"
 #include "NedTransform.h"
 #include "common/AirSimSettings.hpp"
 #include "SimJoyStick/SimJoyStick.h"
 #include "api/VehicleApiBase.hpp"
 #include "api/VehicleSimApiBase.hpp"
+#include "safety/SafetyEval.hpp"
 #include "common/common_utils/UniqueValueMap.hpp"
+#include "common/TripleBuffer.hpp"
 
 #include "PawnEvents.h"
 
@@ -48,6 +52,11 @@ public: //types
         UParticleSystem* collision_display_template;
         msr::airlib::GeoPoint home_geopoint;
         std::string vehicle_name;
+        //shared by all vehicles, nullptr without terrain data
+        std::shared_ptr<const msr::airlib::TerrainModel> terrain;
+        //shared by all vehicles, nullptr unless depth and segmentation images are rendered on the CPU
+        std::shared_ptr<msr::airlib::CpuRasterizer> cpu_rasterizer;
+        std::vector<msr::airlib::CpuImageCapture::PaletteColor> segmentation_palette;
 
         Params()
         {
@@ -115,6 +124,15 @@ protected: //additional interface for derived class
     msr::airlib::Kinematics* getKinematics();
     msr::airlib::Environment* getEnvironment();
 
+    //game thread: hands this frame's collision info and RC input to the physics thread
+    void publishRenderInputs();
+    //physics thread: applies the inputs published since the last call, false if there were none
+    bool applyRenderInputs(msr::airlib::PhysicsBody& body, msr::airlib::VehicleApiBase& api);
+    bool isRenderInterpolated() const;
+
+    //SafetyEval for the vehicle api from the vehicle's Safety setting, nullptr unless it is enabled
+    std::shared_ptr<msr::airlib::SafetyEval> createSafetyEval() const;
+
 public: //Unreal specific methods
     PawnSimApi(const Params& params);
 
@@ -143,12 +161,17 @@ public: //Unreal specific methods
     void possess();
     void setRCForceFeedback(float rumble_strength, float auto_center);
 
+    //whether rendered poses are interpolated between physics steps, off while the physics is
+    //paused so the last step shows as it is
+    void setRenderInterpolation(bool is_enabled);
+
 private: //methods
     bool canTeleportWhileMove() const;
     void allowPassthroughToggleInput();
     void detectUsbRc();
     void setupCamerasFromSettings(const common_utils::UniqueValueMap<std::string, APIPCamera*>& cameras);
     void createCamerasFromSettings();
+    void updateCpuImageEffects();
     //on collision, pawns should update this
     void onCollision(class UPrimitiveComponent* MyComp, class AActor* Other, class UPrimitiveComponent* OtherComp,
                      bool bSelfMoved, FVector HitLocation, FVector HitNormal, FVector NormalImpulse, const FHitResult& Hit);
@@ -174,6 +197,7 @@ private: //vars
     FVector ground_trace_end_;
     FVector ground_margin_;
     std::unique_ptr<UnrealImageCapture> image_capture_;
+    std::shared_ptr<msr::airlib::CpuImageCapture> cpu_image_capture_; //nullptr unless CPU capture is enabled
     std::string log_line_;
 
     mutable msr::airlib::RCData rc_data_;
@@ -208,4 +232,20 @@ private: //vars
 
     FColor trace_color_ = FColor::Purple;
     float trace_thickness_ = 3.0f;
+    //trace and debug pose segments, owned by the pawn
+    UBatchedDebugDrawComponent* trace_draw_ = nullptr;
+    static constexpr int32 kTraceSegments = 100000;
+
+    //frame the collision contacts were collected in
+    uint64 collision_frame_ = 0;
+    static constexpr size_t kMaxContacts = 8;
+
+    struct RenderInputs
+    {
+        CollisionInfo collision_info;
+        bool has_rc_data = false;
+        msr::airlib::RCData rc_data;
+    };
+    msr::airlib::TripleBuffer<RenderInputs> render_inputs_;
+    bool is_render_interpolated_ = true;
 };
@@ -251,6 +251,7 @@ void ASimHUD::initializeSettings()
         AirSimSettings::createDefaultSettingsFile();
 
     AirSimSettings::singleton().load(std::bind(&ASimHUD::getSimModeFromUser, this));
+    UAirBlueprintLib::LogMessageString("Settings load time: ", AirSimSettings::singleton().getLoadTimingReport(), LogDebugLevel::Informational);
     for (const auto& warning : AirSimSettings::singleton().warning_messages) {
         UAirBlueprintLib::LogMessageString(warning, "", LogDebugLevel::Failure);
     }
@@ -136,6 +136,8 @@ void ASimModeBase::BeginPlay()
 
     UAirBlueprintLib::LogMessage(TEXT("Press F1 to see help"), TEXT(""), LogDebugLevel::Informational);
 
+    loadTerrain();
+    loadCpuImageScene();
     setupVehiclesAndCamera();
     FRecordingThread::init();
 
@@ -199,6 +201,11 @@ void ASimModeBase::EndPlay(const EEndPlayReason::Type EndPlayReason)
     sun_ = nullptr;
 
     spawned_actors_.Empty();
+    //the components go with this actor
+    lidar_debug_draws_.clear();
+    debug_draw_components_.Empty();
+    lidar_checks_done_ = false;
+    lidar_draw_debug_points_ = false;
     vehicle_sim_apis_.clear();
 
     Super::EndPlay(EndPlayReason);
@@ -339,6 +346,65 @@ void ASimModeBase::setupPhysicsLoopPeriod()
 {
 }
 
+void ASimModeBase::loadTerrain()
+{
+    const auto& terrain_tiles = getSettings().terrain_tiles;
+    if (terrain_tiles.empty())
+        return;
+
+    try {
+        auto terrain = std::make_shared<msr::airlib::TerrainModel>();
+        for (const auto& tile : terrain_tiles) {
+            if (tile.isGeoTiff())
+                terrain->addGeoTiff(tile.file_path);
+            else
+                terrain->addRawTile(tile.file_path, tile.raw_format);
+        }
+        terrain_ = terrain;
+    }
+    catch (const std::exception& ex) {
+        //vehicles still have the ground the game engine has
+        UAirBlueprintLib::LogMessageString("Cannot load terrain: ", ex.what(), LogDebugLevel::Failure);
+    }
+}
+
+void ASimModeBase::loadCpuImageScene()
+{
+    const auto& setting = getSettings().cpu_image_capture;
+    if (!setting.enabled)
+        return;
+
+    try {
+        segmentation_palette_ = msr::airlib::CpuImageCapture::loadSegmentationPalette(setting.segmentation_palette);
+
+        //the scene is rasterized as it is now, so vehicles that move about are left out
+        std::vector<int> segmentation_ids;
+        const auto meshes = UAirBlueprintLib::GetStaticMeshComponents(true, &segmentation_ids);
+
+        auto rasterizer = std::make_shared<msr::airlib::CpuRasterizer>(setting.thread_count);
+        const NedTransform& ned_transform = getGlobalNedTransform();
+        std::vector<float> vertices;
+        for (size_t mesh_index = 0; mesh_index < meshes.size(); ++mesh_index) {
+            const auto& mesh = meshes[mesh_index];
+            vertices.resize(mesh.vertices.size());
+            for (size_t i = 0; i + 2 < mesh.vertices.size(); i += 3) {
+                const auto ned = ned_transform.toGlobalNed(FVector(mesh.vertices[i], mesh.vertices[i + 1], mesh.vertices[i + 2]));
+                vertices[i] = ned.x();
+                vertices[i + 1] = ned.y();
+                vertices[i + 2] = ned.z();
+            }
+            rasterizer->addMesh(vertices, mesh.indices, static_cast<uint8_t>(Utils::clip(segmentation_ids[mesh_index], 0, 255)));
+        }
+        cpu_rasterizer_ = rasterizer;
+
+        UAirBlueprintLib::LogMessageString("CPU image capture triangles: ", std::to_string(rasterizer->getTriangleCount()), LogDebugLevel::Informational);
+    }
+    catch (const std::exception& ex) {
+        //images are then all captured by Unreal
+        UAirBlueprintLib::LogMessageString("Cannot set up CPU image capture: ", ex.what(), LogDebugLevel::Failure);
+    }
+}
+
 void ASimModeBase::Tick(float DeltaSeconds)
 {
     if (isRecording())
@@ -408,6 +474,7 @@ void ASimModeBase::reset()
         for (auto& api : getApiProvider()->getVehicleSimApis()) {
             api->reset();
         }
+        clearLidarDebugPoints();
     },
                                              true);
 }
@@ -540,7 +607,14 @@ void ASimModeBase::updateDebugReport(msr::airlib::StateReporterWrapper& debug_re
             reporter.writeValue("Lin-Accl", kinematics->accelerations.linear);
             reporter.writeValue("Ang-Vel", kinematics->twist.angular);
             reporter.writeValue("Ang-Accl", kinematics->accelerations.angular);
+
+            const auto cache_stats = vehicle_sim_api->getImageCapture()->getCacheStats();
+            reporter.writeValue("Img-Cache Hits", cache_stats.hits);
+            reporter.writeValue("Img-Cache Joins", cache_stats.joins);
+            reporter.writeValue("Img-Cache Misses", cache_stats.misses);
         }
+
+        debug_reporter.publishReport();
     }
 }
 
@@ -599,6 +673,9 @@ std::unique_ptr<PawnSimApi> ASimModeBase::createVehicleApi(APawn* vehicle_pawn)
     const std::string vehicle_name(TCHAR_TO_UTF8(*(vehicle_pawn->GetName())));
 
     PawnSimApi::Params pawn_sim_api_params(vehicle_pawn, &getGlobalNedTransform(), getVehiclePawnEvents(vehicle_pawn), getVehiclePawnCameras(vehicle_pawn), pip_camera_class, collision_display_template, home_geopoint, vehicle_name);
+    pawn_sim_api_params.terrain = terrain_;
+    pawn_sim_api_params.cpu_rasterizer = cpu_rasterizer_;
+    pawn_sim_api_params.segmentation_palette = segmentation_palette_;
 
     std::unique_ptr<PawnSimApi> vehicle_sim_api = createVehicleSimApi(pawn_sim_api_params);
     auto vehicle_sim_api_p = vehicle_sim_api.get();
@@ -772,6 +849,7 @@ void ASimModeBase::drawLidarDebugPoints()
     if (getApiProvider() == nullptr)
         return;
 
+    ++lidar_draw_pass_;
     for (auto& sim_api : getApiProvider()->getVehicleSimApis()) {
         PawnSimApi* pawn_sim_api = static_cast<PawnSimApi*>(sim_api);
         std::string vehicle_name = pawn_sim_api->getVehicleName();
@@ -785,46 +863,93 @@ void ASimModeBase::drawLidarDebugPoints()
                 const msr::airlib::LidarSimple* lidar =
                     static_cast<const msr::airlib::LidarSimple*>(api->getSensors().getByType(SensorType::Lidar, i));
                 if (lidar != nullptr && lidar->getParams().draw_debug_points) {
-                    lidar_draw_debug_points_ = true;
-
-                    msr::airlib::LidarData lidar_data = lidar->getOutput();
-
-                    if (lidar_data.point_cloud.size() < 3)
-                        return;
-
-                    for (int j = 0; j < lidar_data.point_cloud.size(); j = j + 3) {
-                        Vector3r point(lidar_data.point_cloud[j], lidar_data.point_cloud[j + 1], lidar_data.point_cloud[j + 2]);
-
-                        FVector uu_point;
-
-                        if (lidar->getParams().data_frame == AirSimSettings::kVehicleInertialFrame) {
-                            uu_point = pawn_sim_api->getNedTransform().fromLocalNed(point);
-                        }
-                        else if (lidar->getParams().data_frame == AirSimSettings::kSensorLocalFrame) {
-
-                            Vector3r point_w = VectorMath::transformToWorldFrame(point, lidar_data.pose, true);
-                            uu_point = pawn_sim_api->getNedTransform().fromLocalNed(point_w);
-                        }
-                        else
-                            throw std::runtime_error("Unknown requested data frame");
+                    LidarDebugDraw& debug_draw = lidar_debug_draws_[std::make_pair(vehicle_name, lidar->getName())];
+                    debug_draw.draw_pass = lidar_draw_pass_;
+                    if (debug_draw.component == nullptr) {
+                        debug_draw.component = NewObject<UBatchedDebugDrawComponent>(this);
+                        debug_draw.component->setDrawRate(getSettings().debug_draw_rate);
+                        debug_draw.component->setPointHistory(lidar->getParams().draw_debug_history);
+                        debug_draw.component->RegisterComponent();
+                        debug_draw_components_.Add(debug_draw.component);
+                    }
 
-                        DrawDebugPoint(
-                            this->GetWorld(),
-                            uu_point,
-                            5, // size
-                            FColor::Green,
-                            false, // persistent (never goes away)
-                            0.03 // LifeTime: point leaves a trail on moving object
-                        );
+                    //skip scans already drawn and ones a newer scan would replace before the next draw
+                    const uint64_t sequence = lidar->getOutputSequence();
+                    if (sequence == debug_draw.drawn_sequence || !debug_draw.component->isDrawDue())
+                        continue;
+                    debug_draw.drawn_sequence = sequence;
+
+                    //game thread, read the published snapshot instead of the physics side output
+                    const auto lidar_snapshot = lidar->getOutputSnapshot();
+                    const msr::airlib::LidarData& lidar_data = *lidar_snapshot;
+
+                    //points go to Unreal world by one affine map per scan, found by mapping the frame axes once
+                    Pose points_frame;
+                    if (lidar->getParams().data_frame == AirSimSettings::kVehicleInertialFrame)
+                        points_frame = Pose::zero();
+                    else if (lidar->getParams().data_frame == AirSimSettings::kSensorLocalFrame)
+                        points_frame = lidar_data.pose;
+                    else
+                        throw std::runtime_error("Unknown requested data frame");
+
+                    const NedTransform& ned_transform = pawn_sim_api->getNedTransform();
+                    const FVector origin = ned_transform.fromLocalNed(points_frame.position);
+                    const FVector axis_x = ned_transform.fromRelativeNed(VectorMath::rotateVector(VectorMath::front(), points_frame.orientation, true));
+                    const FVector axis_y = ned_transform.fromRelativeNed(VectorMath::rotateVector(VectorMath::right(), points_frame.orientation, true));
+                    const FVector axis_z = ned_transform.fromRelativeNed(VectorMath::rotateVector(VectorMath::down(), points_frame.orientation, true));
+
+                    const FLinearColor color = FColor::Green;
+                    const int32 point_count = static_cast<int32>(lidar_data.point_cloud.size() / 3);
+                    const float* xyz = lidar_data.point_cloud.data();
+
+                    TArray<FBatchedPoint>& points = debug_draw.component->addPointSet();
+                    points.Reserve(point_count);
+                    for (int32 j = 0; j < point_count; ++j, xyz += 3) {
+                        points.Emplace(origin + axis_x * xyz[0] + axis_y * xyz[1] + axis_z * xyz[2],
+                                       color,
+                                       5, // size
+                                       0, // LifeTime: kept until a newer scan replaces it
+                                       SDPG_World);
                     }
                 }
             }
         }
     }
 
+    //lidars that stopped drawing or whose vehicle is gone take their points with them
+    for (auto it = lidar_debug_draws_.begin(); it != lidar_debug_draws_.end();) {
+        if (it->second.draw_pass != lidar_draw_pass_) {
+            removeLidarDebugDraw(it->second);
+            it = lidar_debug_draws_.erase(it);
+        }
+        else
+            ++it;
+    }
+
+    lidar_draw_debug_points_ = !lidar_debug_draws_.empty();
     lidar_checks_done_ = true;
 }
 
+void ASimModeBase::removeLidarDebugDraw(LidarDebugDraw& debug_draw)
+{
+    if (debug_draw.component == nullptr)
+        return;
+
+    debug_draw.component->clearPoints();
+    debug_draw.component->DestroyComponent();
+    debug_draw_components_.Remove(debug_draw.component);
+    debug_draw.component = nullptr;
+}
+
+void ASimModeBase::clearLidarDebugPoints()
+{
+    //points are kept until replaced, so scans from before a reset would stay up
+    for (auto& entry : lidar_debug_draws_) {
+        if (entry.second.component != nullptr)
+            entry.second.component->clearPoints();
+    }
+}
+
 // Draw debug-point on main viewport for Distance sensor hit
 void ASimModeBase::drawDistanceSensorDebugPoints()
 {
@@ -846,7 +971,7 @@ void ASimModeBase::drawDistanceSensorDebugPoints()
                     static_cast<const msr::airlib::DistanceSimple*>(api->getSensors().getByType(SensorType::Distance, i));
 
                 if (distance_sensor != nullptr && distance_sensor->getParams().draw_debug_points) {
-                    msr::airlib::DistanceSensorData distance_sensor_data = distance_sensor->getOutput();
+                    msr::airlib::DistanceSensorData distance_sensor_data = *distance_sensor->getOutputSnapshot();
 
                     // Find position of point hit
                     // Similar to UnrealDistanceSensor.cpp#L19
@@ -6,7 +6,9 @@
 #include "GameFramework/Actor.h"
 #include "ParticleDefinitions.h"
 
+#include <map>
 #include <string>
+#include "BatchedDebugDrawComponent.h"
 #include "CameraDirector.h"
 #include "common/AirSimSettings.hpp"
 #include "common/ClockFactory.hpp"
@@ -121,6 +123,8 @@ protected: //optional overrides
     void initializeCameraDirector(const FTransform& camera_transform, float follow_distance);
     void checkVehicleReady(); //checks if vehicle is available to use
     virtual void updateDebugReport(msr::airlib::StateReporterWrapper& debug_reporter);
+    //drops the drawn lidar points, e.g. when vehicles are reset
+    void clearLidarDebugPoints();
 
 protected: //Utility methods for derived classes
     virtual const msr::airlib::AirSimSettings& getSettings() const;
@@ -172,6 +176,9 @@ private:
     std::unique_ptr<msr::airlib::ApiProvider> api_provider_;
     std::unique_ptr<msr::airlib::ApiServerBase> api_server_;
     msr::airlib::StateReporterWrapper debug_reporter_;
+    std::shared_ptr<const msr::airlib::TerrainModel> terrain_;
+    std::shared_ptr<msr::airlib::CpuRasterizer> cpu_rasterizer_;
+    std::vector<msr::airlib::CpuImageCapture::PaletteColor> segmentation_palette_;
 
     std::vector<std::unique_ptr<msr::airlib::VehicleSimApiBase>> vehicle_sim_apis_;
 
@@ -180,6 +187,18 @@ private:
 
     bool lidar_checks_done_ = false;
     bool lidar_draw_debug_points_ = false;
+
+    struct LidarDebugDraw
+    {
+        UBatchedDebugDrawComponent* component = nullptr;
+        uint64_t drawn_sequence = 0; //last lidar output added to component
+        uint64_t draw_pass = 0; //last drawLidarDebugPoints call that found the lidar drawing
+    };
+    //by vehicle and lidar name, so nothing points at sensors of vehicles that are gone
+    std::map<std::pair<std::string, std::string>, LidarDebugDraw> lidar_debug_draws_;
+    uint64_t lidar_draw_pass_ = 0;
+    UPROPERTY()
+    TArray<UBatchedDebugDrawComponent*> debug_draw_components_; //keep refs alive from Unreal GC
     static ASimModeBase* SIMMODE;
 
 private:
@@ -188,7 +207,10 @@ private:
     void advanceTimeOfDay();
     void setSunRotation(FRotator rotation);
     void setupPhysicsLoopPeriod();
+    void loadTerrain();
+    void loadCpuImageScene();
     void showClockStats();
     void drawLidarDebugPoints();
+    void removeLidarDebugDraw(LidarDebugDraw& debug_draw);
     void drawDistanceSensorDebugPoints();
 };
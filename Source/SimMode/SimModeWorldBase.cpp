@@ -21,6 +21,7 @@ void ASimModeWorldBase::initializeForPlay()
     physics_world_.reset(new msr::airlib::PhysicsWorld(std::move(physics_engine),
                                                        vehicles,
                                                        getPhysicsLoopPeriod()));
+    physics_world_->getLockStepCoordinator()->setQuorum(getSettings().lock_step_quorum);
 }
 
 void ASimModeWorldBase::registerPhysicsBody(msr::airlib::VehicleSimApiBase* physicsBody)
@@ -30,6 +31,13 @@ void ASimModeWorldBase::registerPhysicsBody(msr::airlib::VehicleSimApiBase* phys
 
 void ASimModeWorldBase::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
+    //no more frames, release any API call waiting for one
+    {
+        std::lock_guard<std::mutex> lock(frame_mutex_);
+        is_rendering_ = false;
+    }
+    frame_cv_.notify_all();
+
     //remove everything that we created in BeginPlay
     physics_world_.reset();
 
@@ -64,7 +72,9 @@ std::unique_ptr<ASimModeWorldBase::PhysicsEngineBase> ASimModeWorldBase::createP
     else if (physics_engine_name == "FastPhysicsEngine") {
         msr::airlib::Settings fast_phys_settings;
         if (msr::airlib::Settings::singleton().getChild("FastPhysicsEngine", fast_phys_settings)) {
-            physics_engine.reset(new msr::airlib::FastPhysicsEngine(fast_phys_settings.getBool("EnableGroundLock", true)));
+            auto* fast_physics_engine = new msr::airlib::FastPhysicsEngine(fast_phys_settings.getBool("EnableGroundLock", true));
+            fast_physics_engine->setContactMaterials(loadContactMaterials(fast_phys_settings));
+            physics_engine.reset(fast_physics_engine);
         }
         else {
             physics_engine.reset(new msr::airlib::FastPhysicsEngine());
@@ -83,6 +93,27 @@ std::unique_ptr<ASimModeWorldBase::PhysicsEngineBase> ASimModeWorldBase::createP
     return physics_engine;
 }
 
+msr::airlib::ContactMaterialTable ASimModeWorldBase::loadContactMaterials(const msr::airlib::Settings& fast_phys_settings)
+{
+    //"ContactMaterials": [{"SurfaceType": 1, "Restitution": 0, "StaticFriction": 1, "DynamicFriction": 0.8}, ...]
+    //where SurfaceType is the physical surface type of the Unreal physical material, DynamicFriction defaults to StaticFriction
+    msr::airlib::ContactMaterialTable contact_materials;
+    msr::airlib::Settings materials_settings;
+    if (fast_phys_settings.getChild("ContactMaterials", materials_settings)) {
+        for (size_t i = 0; i < materials_settings.size(); ++i) {
+            msr::airlib::Settings material_settings;
+            if (materials_settings.getChild(i, material_settings)) {
+                msr::airlib::ContactMaterial material;
+                material.restitution = material_settings.getFloat("Restitution", material.restitution);
+                material.static_friction = material_settings.getFloat("StaticFriction", material.static_friction);
+                material.dynamic_friction = material_settings.getFloat("DynamicFriction", material.static_friction);
+                contact_materials.setMaterial(material_settings.getInt("SurfaceType", 0), material);
+            }
+        }
+    }
+    return contact_materials;
+}
+
 bool ASimModeWorldBase::isPaused() const
 {
     return physics_world_->isPaused();
@@ -96,35 +127,34 @@ void ASimModeWorldBase::pause(bool is_paused)
 
 void ASimModeWorldBase::continueForTime(double seconds)
 {
-    int64 start_frame_number = UKismetSystemLibrary::GetFrameCount();
-    if (physics_world_->isPaused()) {
-        physics_world_->pause(false);
+    if (physics_world_->isPaused())
         UGameplayStatics::SetGamePaused(this->GetWorld(), false);
-    }
 
     physics_world_->continueForTime(seconds);
-    while (!physics_world_->isPaused()) {
-        continue;
-    }
-    // wait if no new frame is renderd
-    while (start_frame_number == UKismetSystemLibrary::GetFrameCount()) {
-        continue;
-    }
-    UGameplayStatics::SetGamePaused(this->GetWorld(), true);
+    finishContinue();
 }
 
 void ASimModeWorldBase::continueForFrames(uint32_t frames)
 {
-    if (physics_world_->isPaused()) {
-        physics_world_->pause(false);
+    if (physics_world_->isPaused())
         UGameplayStatics::SetGamePaused(this->GetWorld(), false);
-    }
 
+    //Tick keeps the frame number current from here on
     physics_world_->setFrameNumber((uint32_t)GFrameNumber);
     physics_world_->continueForFrames(frames);
-    while (!physics_world_->isPaused()) {
-        physics_world_->setFrameNumber((uint32_t)GFrameNumber);
-    }
+    finishContinue();
+}
+
+void ASimModeWorldBase::finishContinue()
+{
+    physics_world_->waitForPause();
+
+    //a frame that started before the pause may show an earlier step, wait for the next one
+    std::unique_lock<std::mutex> lock(frame_mutex_);
+    const uint64 fence = frames_started_ + 1;
+    frame_cv_.wait(lock, [this, fence]() { return frames_rendered_ >= fence || !is_rendering_; });
+    lock.unlock();
+
     UGameplayStatics::SetGamePaused(this->GetWorld(), true);
 }
 
@@ -141,21 +171,30 @@ void ASimModeWorldBase::updateDebugReport(msr::airlib::StateReporterWrapper& deb
 
 void ASimModeWorldBase::Tick(float DeltaSeconds)
 {
-    { //keep this lock as short as possible
-        physics_world_->lock();
-
-        physics_world_->enableStateReport(EnableReport);
-        physics_world_->updateStateReport();
+    uint64 frame;
+    {
+        std::lock_guard<std::mutex> lock(frame_mutex_);
+        frame = ++frames_started_;
+    }
+    physics_world_->setFrameNumber((uint32_t)GFrameNumber);
 
-        for (auto& api : getApiProvider()->getVehicleSimApis())
-            api->updateRenderedState(DeltaSeconds);
+    //the report is written by the physics thread and only formatted when the HUD reads it
+    physics_world_->enableStateReport(EnableReport);
 
-        physics_world_->unlock();
+    //vehicles take their state from the last physics step without the lock;
+    //a paused step is shown as it is rather than interpolated towards
+    const bool is_interpolated = !physics_world_->isPaused();
+    for (auto& api : getApiProvider()->getVehicleSimApis()) {
+        static_cast<PawnSimApi*>(api)->setRenderInterpolation(is_interpolated);
+        api->updateRenderedState(DeltaSeconds);
+        api->updateRendering(DeltaSeconds);
     }
 
-    //perform any expensive rendering update outside of lock region
-    for (auto& api : getApiProvider()->getVehicleSimApis())
-        api->updateRendering(DeltaSeconds);
+    {
+        std::lock_guard<std::mutex> lock(frame_mutex_);
+        frames_rendered_ = frame;
+    }
+    frame_cv_.notify_all();
 
     Super::Tick(DeltaSeconds);
 }
@@ -164,6 +203,7 @@ void ASimModeWorldBase::reset()
 {
     UAirBlueprintLib::RunCommandOnGameThread([this]() {
         physics_world_->reset();
+        clearLidarDebugPoints();
     },
                                              true);
 
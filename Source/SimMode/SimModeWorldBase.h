@@ -3,9 +3,12 @@
 #include "CoreMinimal.h"
 #include <memory>
 #include <vector>
+#include <mutex>
+#include <condition_variable>
 #include "Kismet/KismetSystemLibrary.h"
 #include "api/VehicleSimApiBase.hpp"
 #include "physics/PhysicsEngineBase.hpp"
+#include "physics/ContactSolver.hpp"
 #include "physics/World.hpp"
 #include "physics/PhysicsWorld.hpp"
 #include "common/StateReporterWrapper.hpp"
@@ -56,11 +59,22 @@ private:
 
     //create the physics engine as needed from settings
     std::unique_ptr<PhysicsEngineBase> createPhysicsEngine();
+    static msr::airlib::ContactMaterialTable loadContactMaterials(const msr::airlib::Settings& fast_phys_settings);
+
+    //waits for the physics to pause itself and a frame to render its last step, then pauses the game
+    void finishContinue();
 
 private:
     std::unique_ptr<msr::airlib::PhysicsWorld> physics_world_;
     PhysicsEngineBase* physics_engine_;
 
+    //render frame fence for continueForTime/Frames, frames are counted as they start and finish Tick
+    std::mutex frame_mutex_;
+    std::condition_variable frame_cv_;
+    uint64 frames_started_ = 0;
+    uint64 frames_rendered_ = 0;
+    bool is_rendering_ = true;
+
     /*
     300Hz seems to be minimum for non-aggressive flights
     400Hz is needed for moderately aggressive flights (such as
@@ -3,10 +3,11 @@
 #include "ImageUtils.h"
 
 #include "RenderRequest.h"
+#include "common/AirSimSettings.hpp"
 #include "common/ClockFactory.hpp"
 
 UnrealImageCapture::UnrealImageCapture(const common_utils::UniqueValueMap<std::string, APIPCamera*>* cameras)
-    : cameras_(cameras)
+    : cameras_(cameras), cache_(msr::airlib::AirSimSettings::singleton().image_cache_max_frame_age)
 {
     //TODO: explore screenshot option
     //addScreenCaptureHandler(camera->GetWorld());
@@ -25,8 +26,67 @@ void UnrealImageCapture::getImages(const std::vector<msr::airlib::ImageCaptureBa
             responses[responses.size() - 1].message = "camera is not set";
         }
     }
-    else
-        getSceneCaptureImage(requests, responses, false);
+    else {
+        //images CPU capture renders go to it, the rest through Unreal, answered in request order
+        std::vector<ImageRequest> cpu_requests, unreal_requests;
+        for (const auto& request : requests)
+            (isCpuCaptured(request.image_type) ? cpu_requests : unreal_requests).push_back(request);
+
+        std::vector<ImageResponse> cpu_responses, unreal_responses;
+        if (!cpu_requests.empty())
+            getCpuImages(cpu_requests, cpu_responses);
+
+        //requests for the same images in the same frame share one render and readback
+        if (!unreal_requests.empty()) {
+            cache_.getImages(GFrameCounter, unreal_requests, unreal_responses, [this](const std::vector<ImageRequest>& capture_requests, std::vector<ImageResponse>& capture_responses) {
+                getSceneCaptureImage(capture_requests, capture_responses, false);
+            });
+        }
+
+        auto cpu_response = cpu_responses.begin();
+        auto unreal_response = unreal_responses.begin();
+        for (const auto& request : requests)
+            responses.push_back(std::move(isCpuCaptured(request.image_type) ? *cpu_response++ : *unreal_response++));
+    }
+}
+
+msr::airlib::ImageCaptureCache::Stats UnrealImageCapture::getCacheStats() const
+{
+    return cache_.getStats();
+}
+
+void UnrealImageCapture::setCpuCapture(std::shared_ptr<msr::airlib::CpuImageCapture> cpu_capture, const NedTransform* ned_transform)
+{
+    cpu_capture_ = cpu_capture;
+    ned_transform_ = ned_transform;
+}
+
+bool UnrealImageCapture::isCpuCaptured(ImageType image_type) const
+{
+    return cpu_capture_ != nullptr && msr::airlib::CpuImageCapture::isSupported(image_type);
+}
+
+void UnrealImageCapture::getCpuImages(const std::vector<ImageRequest>& requests, std::vector<ImageResponse>& responses) const
+{
+    //views follow the capture components, so camera poses, gimbals and FoV changes apply as in Unreal captures
+    for (const auto& request : requests) {
+        APIPCamera* camera = cameras_->findOrDefault(request.camera_name, nullptr);
+        if (camera == nullptr)
+            continue;
+        const USceneCaptureComponent2D* capture = camera->getCaptureComponent(request.image_type, false);
+        const UTextureRenderTarget2D* render_target = camera->getRenderTarget(request.image_type, false);
+        if (capture == nullptr || render_target == nullptr)
+            continue;
+
+        msr::airlib::CpuRasterizer::Camera view;
+        view.pose = ned_transform_->toGlobalNed(capture->GetComponentTransform());
+        view.fov_degrees = capture->FOVAngle;
+        view.width = render_target->SizeX;
+        view.height = render_target->SizeY;
+        cpu_capture_->setCamera(request.camera_name, request.image_type, view);
+    }
+
+    cpu_capture_->getImages(requests, responses);
 }
 
 void UnrealImageCapture::getSceneCaptureImage(const std::vector<msr::airlib::ImageCaptureBase::ImageRequest>& requests,
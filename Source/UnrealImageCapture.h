@@ -2,7 +2,10 @@
 
 #include "CoreMinimal.h"
 #include "PIPCamera.h"
+#include "NedTransform.h"
+#include "common/CpuImageCapture.hpp"
 #include "common/ImageCaptureBase.hpp"
+#include "common/ImageCaptureCache.hpp"
 #include "common/common_utils/UniqueValueMap.hpp"
 
 class UnrealImageCapture : public msr::airlib::ImageCaptureBase
@@ -15,6 +18,12 @@ public:
 
     virtual void getImages(const std::vector<ImageRequest>& requests, std::vector<ImageResponse>& responses) const override;
 
+    msr::airlib::ImageCaptureCache::Stats getCacheStats() const;
+
+    //image types cpu_capture supports are rendered by it from then on, the cameras' views are
+    //taken from their capture components in the global NED frame of ned_transform
+    void setCpuCapture(std::shared_ptr<msr::airlib::CpuImageCapture> cpu_capture, const NedTransform* ned_transform);
+
 private:
     void getSceneCaptureImage(const std::vector<msr::airlib::ImageCaptureBase::ImageRequest>& requests,
                               std::vector<msr::airlib::ImageCaptureBase::ImageResponse>& responses, bool use_safe_method) const;
@@ -24,7 +33,13 @@ private:
 
     bool updateCameraVisibility(APIPCamera* camera, const msr::airlib::ImageCaptureBase::ImageRequest& request);
 
+    bool isCpuCaptured(ImageType image_type) const;
+    void getCpuImages(const std::vector<ImageRequest>& requests, std::vector<ImageResponse>& responses) const;
+
 private:
     const common_utils::UniqueValueMap<std::string, APIPCamera*>* cameras_;
     std::vector<uint8_t> last_compressed_png_;
+    mutable msr::airlib::ImageCaptureCache cache_;
+    std::shared_ptr<msr::airlib::CpuImageCapture> cpu_capture_;
+    const NedTransform* ned_transform_ = nullptr;
 };
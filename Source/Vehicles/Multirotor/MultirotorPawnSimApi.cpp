@@ -25,6 +25,9 @@ void MultirotorPawnSimApi::initialize()
     rotor_actuator_info_.assign(rotor_count_, RotorActuatorInfo());
 
     vehicle_api_->setSimulatedGroundTruth(getGroundTruthKinematics(), getGroundTruthEnvironment());
+    auto safety_eval = createSafetyEval();
+    if (safety_eval != nullptr)
+        vehicle_api_->setSafetyEval(safety_eval);
 
     //initialize private vars
     last_phys_pose_ = Pose::nanPose();
@@ -58,32 +61,36 @@ void MultirotorPawnSimApi::updateRenderedState(float dt)
         return;
     }
 
-    //move collision info from rendering engine to vehicle
-    const CollisionInfo& collision_info = getCollisionInfo();
-    multirotor_physics_body_->setCollisionInfo(collision_info);
-
-    last_phys_pose_ = multirotor_physics_body_->getPose();
-
-    collision_response = multirotor_physics_body_->getCollisionResponseInfo();
+    //move collision info and RC from rendering engine to vehicle, applied on the next physics step
+    publishRenderInputs();
+
+    //vehicle state as of the last physics step, handed over without locking the world
+    const bool has_state = multirotor_physics_body_->getRenderStates().getState(clock()->nowNanos(), isRenderInterpolated(), render_state_);
+    if (has_state) {
+        collision_response = render_state_.collision_response;
+
+        //update rotor poses
+        for (unsigned int i = 0; i < rotor_count_; ++i) {
+            const auto& rotor_output = render_state_.outputs[i];
+            RotorActuatorInfo* info = &rotor_actuator_info_[i];
+            info->rotor_speed = rotor_output.speed;
+            info->rotor_direction = static_cast<int>(rotor_output.turning_direction);
+            info->rotor_thrust = rotor_output.thrust;
+            info->rotor_control_filtered = rotor_output.control_signal_filtered;
+        }
+    }
 
-    //update rotor poses
-    for (unsigned int i = 0; i < rotor_count_; ++i) {
-        const auto& rotor_output = multirotor_physics_body_->getRotorOutput(i);
-        // update private rotor variable
-        rotor_states_.rotors[i].update(rotor_output.thrust, rotor_output.torque_scaler, rotor_output.speed);
-        RotorActuatorInfo* info = &rotor_actuator_info_[i];
-        info->rotor_speed = rotor_output.speed;
-        info->rotor_direction = static_cast<int>(rotor_output.turning_direction);
-        info->rotor_thrust = rotor_output.thrust;
-        info->rotor_control_filtered = rotor_output.control_signal_filtered;
+    if (pending_pose_status_ == PendingPoseStatus::RenderPending) {
+        //pose was set rather than simulated, show it right away as the physics may be paused
+        multirotor_physics_body_->lock();
+        last_phys_pose_ = multirotor_physics_body_->getPose();
+        set_pose_time_ = pending_pose_time_;
+        multirotor_physics_body_->unlock();
     }
+    else if (has_state && render_state_.time > set_pose_time_) //states from before the pose was set are stale
+        last_phys_pose_ = render_state_.kinematics.pose;
 
     vehicle_api_->getStatusMessages(vehicle_api_messages_);
-
-    if (getRemoteControlID() >= 0)
-        vehicle_api_->setRCData(getRCData());
-    rotor_states_.timestamp = clock()->nowNanos();
-    vehicle_api_->setRotorStates(rotor_states_);
 }
 
 void MultirotorPawnSimApi::updateRendering(float dt)
@@ -134,6 +141,8 @@ void MultirotorPawnSimApi::setPose(const Pose& pose, bool ignore_collision)
     multirotor_physics_body_->lock();
     multirotor_physics_body_->setPose(pose);
     multirotor_physics_body_->setGrounded(false);
+    multirotor_physics_body_->getRenderStates().breakInterpolation();
+    pending_pose_time_ = clock()->nowNanos();
     multirotor_physics_body_->unlock();
     pending_pose_collisions_ = ignore_collision;
     pending_pose_status_ = PendingPoseStatus::RenderPending;
@@ -147,17 +156,29 @@ void MultirotorPawnSimApi::resetImplementation()
     vehicle_api_->reset();
     multirotor_physics_body_->reset();
     vehicle_api_messages_.clear();
+    set_pose_time_ = 0;
 }
 
 //this is high frequency physics tick, flier gets ticked at rendering frame rate
 void MultirotorPawnSimApi::update()
 {
+    //collision info and RC the game thread left for this step
+    applyRenderInputs(*multirotor_physics_body_, *vehicle_api_);
+
     //environment update for current position
     PawnSimApi::update();
 
     //update forces on vertices
     multirotor_physics_body_->update();
 
+    //rotor states for the controller, as of this step
+    for (unsigned int i = 0; i < rotor_count_; ++i) {
+        const auto& rotor_output = multirotor_physics_body_->getRotorOutput(i);
+        rotor_states_.rotors[i].update(rotor_output.thrust, rotor_output.torque_scaler, rotor_output.speed);
+    }
+    rotor_states_.timestamp = clock()->nowNanos();
+    vehicle_api_->setRotorStates(rotor_states_);
+
     //update to controller must be done after kinematics have been updated by physics engine
 }
 
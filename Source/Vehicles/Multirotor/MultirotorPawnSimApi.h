@@ -10,6 +10,7 @@
 #include "common/CommonStructs.hpp"
 #include "common/common_utils/UniqueValueMap.hpp"
 #include "MultirotorPawnEvents.h"
+#include <atomic>
 #include <future>
 
 class MultirotorPawnSimApi : public PawnSimApi
@@ -76,6 +77,8 @@ private:
         RenderPending
     } pending_pose_status_;
     Pose pending_phys_pose_; //force new pose through API
+    std::atomic<msr::airlib::TTimePoint> pending_pose_time_{ 0 }; //when the pending pose was set, from the API thread
+    msr::airlib::TTimePoint set_pose_time_ = 0; //when the pose shown was last set rather than simulated
 
     //reset must happen while World is locked so its async task initiated from API thread
     bool reset_pending_;
@@ -83,6 +86,7 @@ private:
     std::packaged_task<void()> reset_task_;
 
     Pose last_phys_pose_; //for trace lines showing vehicle path
+    MultiRotor::RenderStates::State render_state_;
     std::vector<std::string> vehicle_api_messages_;
     RotorStates rotor_states_;
 };
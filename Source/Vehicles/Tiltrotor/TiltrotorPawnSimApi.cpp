@@ -20,10 +20,13 @@ void TiltrotorPawnSimApi::initialize()
     vehicle_params_ = AeroBodyParamsFactory::createConfig(getVehicleSetting(), sensor_factory);
     vehicle_api_ = vehicle_params_->createVtolApi();
     //setup physics vehicle
-    aero_physics_body_ = std::unique_ptr<AeroBody>(new AeroBody(vehicle_params_.get(), vehicle_api_.get(), getKinematics(), getEnvironment()));
+    aero_physics_body_ = AeroBodyParamsFactory::createBody(vehicle_params_.get(), vehicle_api_.get(), getKinematics(), getEnvironment());
 
     vehicle_api_->setSimulatedGroundTruth(getGroundTruthKinematics(), getGroundTruthEnvironment());
     vehicle_api_->setCollisionInfo(CollisionInfo());
+    auto safety_eval = createSafetyEval();
+    if (safety_eval != nullptr)
+        vehicle_api_->setSafetyEval(safety_eval);
 
     //initialize private vars
     last_phys_pose_ = pending_phys_pose_ = Pose::nanPose();
@@ -59,23 +62,30 @@ void TiltrotorPawnSimApi::updateRenderedState(float dt)
         return;
     }
 
-    //move collision info from rendering engine to vehicle
-    const CollisionInfo& collision_info = getCollisionInfo();
-    aero_physics_body_->setCollisionInfo(collision_info);
-
-    last_phys_pose_ = aero_physics_body_->getPose();
-
-    collision_response = aero_physics_body_->getCollisionResponseInfo();
-
-    updateRotors();
+    //move collision info and RC from rendering engine to vehicle, applied on the next physics step
+    publishRenderInputs();
+
+    //vehicle state as of the last physics step, handed over without locking the world
+    const bool has_state = aero_physics_body_->getRenderStates().getState(clock()->nowNanos(), isRenderInterpolated(), render_state_);
+    if (has_state)
+        collision_response = render_state_.collision_response;
+
+    if (pending_pose_status_ == PendingPoseStatus::RenderPending) {
+        //pose and tilts were set rather than simulated, show them right away as the physics may be paused
+        aero_physics_body_->lock();
+        last_phys_pose_ = aero_physics_body_->getPose();
+        for (uint i = 0; i < rotor_count_; ++i)
+            updateRotorInfo(i, aero_physics_body_->getRotorOutput(i));
+        set_pose_time_ = pending_pose_time_;
+        aero_physics_body_->unlock();
+    }
+    else if (has_state && render_state_.time > set_pose_time_) { //states from before the pose was set are stale
+        last_phys_pose_ = render_state_.kinematics.pose;
+        for (uint i = 0; i < rotor_count_; ++i)
+            updateRotorInfo(i, render_state_.outputs.rotors[i]);
+    }
 
     vehicle_api_->getStatusMessages(vehicle_api_messages_);
-
-    if (getRemoteControlID() >= 0)
-        vehicle_api_->setRCData(getRCData());
-    rotor_states_.timestamp = clock()->nowNanos();
-    vehicle_api_->setRotorStates(rotor_states_);
-    vehicle_api_->setCollisionInfo(collision_info);
 }
 
 void TiltrotorPawnSimApi::updateRendering(float dt)
@@ -121,7 +131,7 @@ void TiltrotorPawnSimApi::updateRendering(float dt)
     pawn_events_->getActuatorSignal().emit(rotor_infos_);
 }
 
-// update rotor_states_ and rotor_infos_ from aero_physics_body_
+// update rotor_states_ from aero_physics_body_, on the physics thread
 void TiltrotorPawnSimApi::updateRotors()
 {
     for (uint i = 0; i < rotor_count_; ++i) {
@@ -132,15 +142,20 @@ void TiltrotorPawnSimApi::updateRotors()
             output.rotor_output.torque_scaler,
             output.rotor_output.speed,
             output.angle);
-        // create pointer to rotor_infos_[i] element and update data in-place
-        RotorTiltableInfo* info = &rotor_infos_[i];
-        info->rotor_speed = output.rotor_output.speed;
-        info->rotor_direction = static_cast<int>(output.rotor_output.turning_direction);
-        info->rotor_thrust = output.rotor_output.thrust;
-        info->rotor_control_filtered = output.rotor_output.control_signal_filtered;
-        info->rotor_angle_from_vertical = output.angle_from_vertical;
-        info->is_fixed = output.is_fixed;
     }
+    rotor_states_.timestamp = clock()->nowNanos();
+}
+
+// update rotor_infos_[i] in-place, on the game thread
+void TiltrotorPawnSimApi::updateRotorInfo(unsigned int i, const RotorTiltable::TiltOutput& output)
+{
+    RotorTiltableInfo* info = &rotor_infos_[i];
+    info->rotor_speed = output.rotor_output.speed;
+    info->rotor_direction = static_cast<int>(output.rotor_output.turning_direction);
+    info->rotor_thrust = output.rotor_output.thrust;
+    info->rotor_control_filtered = output.rotor_output.control_signal_filtered;
+    info->rotor_angle_from_vertical = output.angle_from_vertical;
+    info->is_fixed = output.is_fixed;
 }
 
 void TiltrotorPawnSimApi::setPose(const Pose& pose, bool ignore_collision)
@@ -148,6 +163,8 @@ void TiltrotorPawnSimApi::setPose(const Pose& pose, bool ignore_collision)
     aero_physics_body_->lock();
     aero_physics_body_->setPose(pose);
     aero_physics_body_->setGrounded(false);
+    aero_physics_body_->getRenderStates().breakInterpolation();
+    pending_pose_time_ = clock()->nowNanos();
     aero_physics_body_->unlock();
     pending_pose_collisions_ = ignore_collision;
     pending_pose_status_ = PendingPoseStatus::RenderPending;
@@ -163,7 +180,9 @@ void TiltrotorPawnSimApi::setPoseCustom(const Pose& pose, const vector<float>& t
     if (correct_num_angles) {
         aero_physics_body_->overwriteRotorTilts(tilt_angles, spin_props);
     }
-    updateRotors();
+    //rotor states follow on the next physics step, the rendered tilts when the pose is shown
+    aero_physics_body_->getRenderStates().breakInterpolation();
+    pending_pose_time_ = clock()->nowNanos();
     aero_physics_body_->unlock();
 
     // logging done outside of physics lock
@@ -186,17 +205,26 @@ void TiltrotorPawnSimApi::resetImplementation()
     vehicle_api_->reset();
     aero_physics_body_->reset();
     vehicle_api_messages_.clear();
+    set_pose_time_ = 0;
 }
 
 //this is high frequency physics tick, flier gets ticked at rendering frame rate
 void TiltrotorPawnSimApi::update()
 {
+    //collision info and RC the game thread left for this step
+    if (applyRenderInputs(*aero_physics_body_, *vehicle_api_))
+        vehicle_api_->setCollisionInfo(aero_physics_body_->getCollisionInfo());
+
     //environment update for current position
     PawnSimApi::update();
 
     //update forces on vertices
     aero_physics_body_->update();
 
+    //rotor states for the controller, as of this step
+    updateRotors();
+    vehicle_api_->setRotorStates(rotor_states_);
+
     //update to controller must be done after kinematics have been updated by physics engine
 }
 
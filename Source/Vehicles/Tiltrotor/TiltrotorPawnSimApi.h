@@ -9,6 +9,7 @@
 #include "common/CommonStructs.hpp"
 #include "common/common_utils/UniqueValueMap.hpp"
 #include "TiltrotorPawnEvents.h"
+#include <atomic>
 #include <future>
 
 class TiltrotorPawnSimApi : public PawnSimApi
@@ -57,6 +58,9 @@ public:
         return vehicle_api_.get();
     }
 
+private:
+    void updateRotorInfo(unsigned int i, const msr::airlib::RotorTiltable::TiltOutput& output);
+
 private:
     std::unique_ptr<msr::airlib::VtolApiBase> vehicle_api_;
     std::unique_ptr<msr::airlib::AeroBodyParams> vehicle_params_;
@@ -78,6 +82,8 @@ private:
         RenderPending
     } pending_pose_status_;
     Pose pending_phys_pose_; //force new pose through API
+    std::atomic<msr::airlib::TTimePoint> pending_pose_time_{ 0 }; //when the pending pose was set, from the API thread
+    msr::airlib::TTimePoint set_pose_time_ = 0; //when the pose shown was last set rather than simulated
 
     //reset must happen while World is locked so its async task initiated from API thread
     bool reset_pending_;
@@ -85,6 +91,7 @@ private:
     std::packaged_task<void()> reset_task_;
 
     Pose last_phys_pose_; //for trace lines showing vehicle path
+    AeroBody::RenderStates::State render_state_;
     std::vector<std::string> vehicle_api_messages_;
     RotorTiltableStates rotor_states_;
 };
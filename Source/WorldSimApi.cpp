@@ -1,6 +1,8 @@
 #include "WorldSimApi.h"
 #include "common/common_utils/Utils.hpp"
 #include "AirBlueprintLib.h"
+#include "ObjectNameIndex.h"
+#include "DetectionBroadphase.h"
 #include "TextureShuffleActor.h"
 #include "common/common_utils/Utils.hpp"
 #include "Weather/WeatherLib.h"
@@ -149,6 +151,10 @@ AActor* WorldSimApi::createNewActor(const FActorSpawnParameters& spawn_params, c
         ObjectComponent->RegisterComponent();
         NewActor->SetRootComponent(ObjectComponent);
         NewActor->SetActorLocationAndRotation(actor_transform.GetLocation(), actor_transform.GetRotation(), false, nullptr, ETeleportType::TeleportPhysics);
+
+        //the mesh was added after spawning, when the name index and detection broadphase saw the actor
+        ObjectNameIndex::get(simmode_->GetWorld()).refreshActor(NewActor);
+        DetectionBroadphase::get(simmode_->GetWorld()).refreshActor(NewActor);
     }
     return NewActor;
 }
@@ -268,8 +274,8 @@ bool WorldSimApi::addVehicle(const std::string& vehicle_name, const std::string&
 bool WorldSimApi::setSegmentationObjectID(const std::string& mesh_name, int object_id, bool is_name_regex)
 {
     bool success;
-    UAirBlueprintLib::RunCommandOnGameThread([mesh_name, object_id, is_name_regex, &success]() {
-        success = UAirBlueprintLib::SetMeshStencilID(mesh_name, object_id, is_name_regex);
+    UAirBlueprintLib::RunCommandOnGameThread([this, mesh_name, object_id, is_name_regex, &success]() {
+        success = UAirBlueprintLib::SetMeshStencilID(simmode_, mesh_name, object_id, is_name_regex);
     },
                                              true);
     return success;
@@ -278,8 +284,8 @@ bool WorldSimApi::setSegmentationObjectID(const std::string& mesh_name, int obje
 int WorldSimApi::getSegmentationObjectID(const std::string& mesh_name) const
 {
     int result;
-    UAirBlueprintLib::RunCommandOnGameThread([&mesh_name, &result]() {
-        result = UAirBlueprintLib::GetMeshStencilID(mesh_name);
+    UAirBlueprintLib::RunCommandOnGameThread([this, &mesh_name, &result]() {
+        result = UAirBlueprintLib::GetMeshStencilID(simmode_, mesh_name);
     },
                                              true);
     return result;